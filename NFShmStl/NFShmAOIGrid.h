@@ -0,0 +1,563 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmAOIGrid.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmAOIGrid
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief 一次移动, 给NFShmAOIGrid::move_batch用
+ */
+struct NFShmAOIMove
+{
+    int m_handle;
+    float m_x;
+    float m_y;
+};
+
+/**
+ * @brief 视野变化, m_watcher进入/离开了m_target的视野. 视野按距离判断, 是对称的:
+ * 如果m_target没有在同一批里移动, m_target看m_watcher也发生了同样的变化, 需要的话由调用者反过来通知
+ */
+struct NFShmAOIEvent
+{
+    int m_watcher;
+    int m_target;
+    bool m_enter;
+};
+
+/**
+ * @brief 格子式的视野(AOI)空间索引, 放在共享内存里, 代替 NFShmHashMap<格子, NFShmList<id> > 的做法.
+ * 地图切成CELLS_X * CELLS_Y个正方形格子, 每个实体是一个定长节点, 按下标串在所在格子的双向链表里(侵入式),
+ * 换格子只是两次O(1)的摘链和挂链, 不分配也不释放任何节点.
+ *
+ * 格子的链表头按8x8分块, 块内按Morton(Z序)编号, 相邻格子的链表头在内存中也相邻, 半径查询扫的几行格子集中在少数cache行里.
+ * 实体的坐标和链接放在同一个16字节节点里, 遍历格子时读坐标不会再跳一次; 调用者的数据放在另一个数组, 查询时不读.
+ *
+ * 句柄就是节点下标, 从add返回到remove为止不变. 坐标超出地图时归到边上的格子, 查询仍按真实坐标判断距离.
+ * 移动时可以同时算出视野的进入/离开集合(move的带半径版本), 一批移动可以用move_batch一起算,
+ * 批内两个实体同时移动时按双方的旧位置/新位置判断, 不会因为先后顺序漏掉或多出事件.
+ *
+ * 全是POD, 恢复时先校验, 链表在挂链/摘链的中途崩溃时按节点的坐标重建.
+ *
+ * 用法:
+ * NFShmAOIGrid<20000, 512, 512> m_aoi;
+ * m_aoi.set_geometry(0.0f, 0.0f, 16.0f);   //原点和格子边长, 只能在空的时候设置
+ * int h = m_aoi.add(x, y, roleId);
+ * m_aoi.move(h, x2, y2, 30.0f, enter, leave);
+ * m_aoi.for_each_in_radius(x, y, 30.0f, [&](int other) { ... });
+ */
+template<int MAX_ENTITIES, int CELLS_X, int CELLS_Y>
+class NFShmAOIGrid
+{
+public:
+    static_assert(MAX_ENTITIES > 0 && CELLS_X > 0 && CELLS_Y > 0, "NFShmAOIGrid bad size");
+
+    enum
+    {
+        TILES_X = (CELLS_X + 7) / 8,
+        TILES_Y = (CELLS_Y + 7) / 8,
+        CELL_COUNT = TILES_X * TILES_Y * 64,
+    };
+
+private:
+    enum { FREE_NODE = -2 };
+
+    /**
+     * @brief 16字节, 一个cache行放4个. 所在格子不存, 由坐标算出; 空闲节点的m_prev为FREE_NODE, 用m_next串成空闲链表
+     */
+    struct _Node
+    {
+        float m_x;
+        float m_y;
+        int m_prev;
+        int m_next;
+    };
+
+public:
+    NFShmAOIGrid()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        m_originX = 0.0f;
+        m_originY = 0.0f;
+        m_cellSize = 1.0f;
+        m_invCellSize = 1.0f;
+        memset(m_mark, 0, sizeof(m_mark));
+        m_markBase = 1;
+        clear();
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (!verify())
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmAOIGrid inconsistent after resume, rebuild cells, size:{}", m_size);
+            rebuild();
+        }
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 设置地图原点和格子边长, 格子(cx, cy)覆盖 [originX + cx * cellSize, originX + (cx + 1) * cellSize)
+     */
+    int set_geometry(float __originX, float __originY, float __cellSize)
+    {
+        CHECK_EXPR(m_size == 0, -1, "NFShmAOIGrid set_geometry while not empty, size:{}", m_size);
+        CHECK_EXPR(__cellSize > 0.0f, -1, "NFShmAOIGrid bad cell size:{}", __cellSize);
+        m_originX = __originX;
+        m_originY = __originY;
+        m_cellSize = __cellSize;
+        m_invCellSize = 1.0f / __cellSize;
+        return 0;
+    }
+
+    size_t size() const { return m_size; }
+
+    size_t max_size() const { return MAX_ENTITIES; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_ENTITIES; }
+
+    float cell_size() const { return m_cellSize; }
+
+    /**
+     * @brief 加入一个实体, 返回句柄, 满了返回-1
+     */
+    int add(float __x, float __y, uint64_t __data = 0)
+    {
+        if (m_free == -1)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmAOIGrid No Enough Space! MAX_ENTITIES:{}", MAX_ENTITIES);
+            return -1;
+        }
+        int __h = m_free;
+        _Node &__n = m_nodes[__h];
+        m_free = __n.m_next;
+        __n.m_x = __x;
+        __n.m_y = __y;
+        m_data[__h] = __data;
+        _M_link(__h, _M_cell_of(__x, __y));
+        ++m_size;
+        return __h;
+    }
+
+    bool remove(int __h)
+    {
+        CHECK_EXPR(valid(__h), false, "NFShmAOIGrid remove invalid handle:{}", __h);
+        _M_unlink(__h, _M_node_cell(__h));
+        m_nodes[__h].m_prev = FREE_NODE;
+        m_nodes[__h].m_next = m_free;
+        m_free = __h;
+        --m_size;
+        return true;
+    }
+
+    bool valid(int __h) const { return __h >= 0 && __h < MAX_ENTITIES && m_nodes[__h].m_prev != FREE_NODE; }
+
+    float x(int __h) const { return m_nodes[__h].m_x; }
+
+    float y(int __h) const { return m_nodes[__h].m_y; }
+
+    uint64_t data(int __h) const { return m_data[__h]; }
+
+    void set_data(int __h, uint64_t __data) { m_data[__h] = __data; }
+
+    /**
+     * @brief 移动到(x, y), 只有换了格子才动链表
+     */
+    bool move(int __h, float __x, float __y)
+    {
+        CHECK_EXPR(valid(__h), false, "NFShmAOIGrid move invalid handle:{}", __h);
+        _M_move(__h, __x, __y);
+        return true;
+    }
+
+    /**
+     * @brief 移动到(x, y), 并按视野半径算出新看到的实体(enter)和看不到的实体(leave), 结果追加到两个vector里.
+     * 旧视野只扫旧位置周围的格子, 新视野只扫新位置周围的格子, 瞬移时不会扫两点之间的格子
+     */
+    bool move(int __h, float __x, float __y, float __radius, std::vector<int> &__enter, std::vector<int> &__leave)
+    {
+        CHECK_EXPR(valid(__h), false, "NFShmAOIGrid move invalid handle:{}", __h);
+        const float __ox = m_nodes[__h].m_x;
+        const float __oy = m_nodes[__h].m_y;
+        const float __r2 = __radius * __radius;
+        for_each_in_radius(__ox, __oy, __radius, [&](int __o)
+        {
+            if (__o != __h && _M_dist2(__o, __x, __y) > __r2)
+                __leave.push_back(__o);
+        });
+        for_each_in_radius(__x, __y, __radius, [&](int __o)
+        {
+            if (__o != __h && _M_dist2(__o, __ox, __oy) > __r2)
+                __enter.push_back(__o);
+        });
+        _M_move(__h, __x, __y);
+        return true;
+    }
+
+    /**
+     * @brief 一批移动, 不算视野变化, 只有换了格子的实体才重新挂链
+     * @return 成功移动的个数, 无效句柄会跳过
+     */
+    int move_batch(const NFShmAOIMove *__moves, int __n)
+    {
+        int __done = 0;
+        for (int i = 0; i < __n; ++i)
+        {
+            if (valid(__moves[i].m_handle))
+            {
+                _M_move(__moves[i].m_handle, __moves[i].m_x, __moves[i].m_y);
+                ++__done;
+            }
+        }
+        return __done;
+    }
+
+    /**
+     * @brief 一批移动, 并给每个移动的实体算出视野变化, 按批内顺序追加到__events.
+     * 先在移动前查出每个实体的旧视野, 全部移动后再查新视野, 用按句柄的标记数组m_mark求差, 所以两个实体同时移动时
+     * 也是按双方的旧位置和新位置判断; 两个都在批内时, 两个方向的事件各出现一次.
+     * 同一个句柄在一批里只能出现一次
+     */
+    int move_batch(const NFShmAOIMove *__moves, int __n, float __radius, std::vector<NFShmAOIEvent> &__events)
+    {
+        std::vector<int> __old;
+        std::vector<int> __start(__n + 1);
+        for (int i = 0; i < __n; ++i)
+        {
+            __start[i] = (int) __old.size();
+            int __h = __moves[i].m_handle;
+            if (!valid(__h))
+                continue;
+            for_each_in_radius(m_nodes[__h].m_x, m_nodes[__h].m_y, __radius, [&](int __o)
+            {
+                if (__o != __h)
+                    __old.push_back(__o);
+            });
+        }
+        __start[__n] = (int) __old.size();
+        int __done = move_batch(__moves, __n);
+
+        // m_mark[o] == __base + i 表示o在第i个实体的旧视野里且还没在新视野里见到.
+        // 每批用一段新的编号, 以前批次留下的值都比__base小, 不用清; 编号快溢出时才整个清零
+        if (m_markBase > UINT32_MAX - (uint32_t) __n - 1)
+        {
+            memset(m_mark, 0, sizeof(m_mark));
+            m_markBase = 1;
+        }
+        const uint32_t __base = m_markBase;
+        m_markBase += (uint32_t) __n;
+        for (int i = 0; i < __n; ++i)
+        {
+            int __h = __moves[i].m_handle;
+            if (!valid(__h))
+                continue;
+            const uint32_t __stamp = __base + (uint32_t) i;
+            for (int k = __start[i]; k < __start[i + 1]; ++k)
+                m_mark[__old[k]] = __stamp;
+            for_each_in_radius(m_nodes[__h].m_x, m_nodes[__h].m_y, __radius, [&](int __o)
+            {
+                if (__o == __h)
+                    return;
+                if (m_mark[__o] == __stamp)
+                {
+                    m_mark[__o] = 0;
+                }
+                else
+                {
+                    NFShmAOIEvent __ev = {__h, __o, true};
+                    __events.push_back(__ev);
+                }
+            });
+            for (int k = __start[i]; k < __start[i + 1]; ++k)
+            {
+                if (m_mark[__old[k]] == __stamp)
+                {
+                    NFShmAOIEvent __ev = {__h, __old[k], false};
+                    __events.push_back(__ev);
+                }
+            }
+        }
+        return __done;
+    }
+
+public:
+    /**
+     * @brief 对(x, y)半径radius以内(含边界)的每个实体调用__f(handle).
+     * 完全落在圆内的格子不逐个判断距离, 完全在圆外的格子不遍历; 边上的格子里可能有地图外的实体, 总是逐个判断
+     */
+    template<class F>
+    void for_each_in_radius(float __x, float __y, float __radius, F __f) const
+    {
+        const float __r2 = __radius * __radius;
+        const float __pad = m_cellSize * (1.0f / 1024);    //格子范围放宽一点, 抵消坐标换算格子时的舍入
+        int __cx0 = _M_cell_x(__x - __radius), __cx1 = _M_cell_x(__x + __radius);
+        int __cy0 = _M_cell_y(__y - __radius), __cy1 = _M_cell_y(__y + __radius);
+        for (int __cy = __cy0; __cy <= __cy1; ++__cy)
+        {
+            const float __y0 = m_originY + __cy * m_cellSize - __y - __pad, __y1 = __y0 + m_cellSize + 2 * __pad;
+            const float __near_y = __y0 > 0 ? __y0 : (__y1 < 0 ? __y1 : 0.0f);
+            const float __far_y = std::max(__y0 * __y0, __y1 * __y1);
+            const bool __edge_y = __cy == 0 || __cy == CELLS_Y - 1;
+            for (int __cx = __cx0; __cx <= __cx1; ++__cx)
+            {
+                int __n = m_head[_M_cell_index(__cx, __cy)];
+                if (__n == -1)
+                    continue;
+                const float __x0 = m_originX + __cx * m_cellSize - __x - __pad, __x1 = __x0 + m_cellSize + 2 * __pad;
+                const bool __edge = __edge_y || __cx == 0 || __cx == CELLS_X - 1;
+                if (!__edge)
+                {
+                    const float __near_x = __x0 > 0 ? __x0 : (__x1 < 0 ? __x1 : 0.0f);
+                    if (__near_x * __near_x + __near_y * __near_y > __r2)
+                        continue;
+                    if (std::max(__x0 * __x0, __x1 * __x1) + __far_y <= __r2)
+                    {
+                        for (; __n != -1; __n = m_nodes[__n].m_next)
+                            __f(__n);
+                        continue;
+                    }
+                }
+                for (; __n != -1; __n = m_nodes[__n].m_next)
+                {
+                    if (_M_dist2(__n, __x, __y) <= __r2)
+                        __f(__n);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 对矩形[x0, x1] x [y0, y1]内(含边界)的每个实体调用__f(handle)
+     */
+    template<class F>
+    void for_each_in_rect(float __x0, float __y0, float __x1, float __y1, F __f) const
+    {
+        int __cx0 = _M_cell_x(__x0), __cx1 = _M_cell_x(__x1);
+        int __cy0 = _M_cell_y(__y0), __cy1 = _M_cell_y(__y1);
+        for (int __cy = __cy0; __cy <= __cy1; ++__cy)
+        {
+            for (int __cx = __cx0; __cx <= __cx1; ++__cx)
+            {
+                int __n = m_head[_M_cell_index(__cx, __cy)];
+                bool __inner = __cx > __cx0 && __cx < __cx1 && __cy > __cy0 && __cy < __cy1;
+                for (; __n != -1; __n = m_nodes[__n].m_next)
+                {
+                    const _Node &__node = m_nodes[__n];
+                    if (__inner || (__node.m_x >= __x0 && __node.m_x <= __x1 && __node.m_y >= __y0 && __node.m_y <= __y1))
+                        __f(__n);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 半径以内的实体句柄追加到__out, __exclude(通常是自己)不输出
+     */
+    size_t query_radius(float __x, float __y, float __radius, std::vector<int> &__out, int __exclude = -1) const
+    {
+        size_t __old = __out.size();
+        for_each_in_radius(__x, __y, __radius, [&](int __n)
+        {
+            if (__n != __exclude)
+                __out.push_back(__n);
+        });
+        return __out.size() - __old;
+    }
+
+    size_t query_rect(float __x0, float __y0, float __x1, float __y1, std::vector<int> &__out) const
+    {
+        size_t __old = __out.size();
+        for_each_in_rect(__x0, __y0, __x1, __y1, [&](int __n) { __out.push_back(__n); });
+        return __out.size() - __old;
+    }
+
+    /**
+     * @brief 格子(cx, cy)里的实体个数
+     */
+    int cell_count(int __cx, int __cy) const { return m_count[_M_cell_index(__cx, __cy)]; }
+
+    void clear()
+    {
+        memset(m_head, -1, sizeof(m_head));
+        memset(m_count, 0, sizeof(m_count));
+        for (int i = 0; i < MAX_ENTITIES; ++i)
+        {
+            m_nodes[i].m_prev = FREE_NODE;
+            m_nodes[i].m_next = i + 1 < MAX_ENTITIES ? i + 1 : -1;
+        }
+        m_free = 0;
+        m_size = 0;
+    }
+
+    /**
+     * @brief 按每个节点记录的格子重建所有格子链表和空闲链表
+     */
+    void rebuild()
+    {
+        memset(m_head, -1, sizeof(m_head));
+        memset(m_count, 0, sizeof(m_count));
+        m_free = -1;
+        m_size = 0;
+        for (int i = MAX_ENTITIES - 1; i >= 0; --i)
+        {
+            if (m_nodes[i].m_prev != FREE_NODE)
+            {
+                _M_link(i, _M_cell_of(m_nodes[i].m_x, m_nodes[i].m_y));
+                ++m_size;
+            }
+            else
+            {
+                m_nodes[i].m_next = m_free;
+                m_free = i;
+            }
+        }
+    }
+
+    bool verify() const;
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(_Node), m_size, MAX_ENTITIES); }
+
+private:
+    void _M_move(int __h, float __x, float __y)
+    {
+        _Node &__n = m_nodes[__h];
+        int __old = _M_cell_of(__n.m_x, __n.m_y);
+        int __cell = _M_cell_of(__x, __y);
+        if (__cell != __old)
+            _M_unlink(__h, __old);
+        __n.m_x = __x;
+        __n.m_y = __y;
+        if (__cell != __old)
+            _M_link(__h, __cell);
+    }
+
+    /**
+     * @brief 挂到格子链表头. 挂链/摘链中途崩溃时, 节点的坐标总是已经写好, 恢复时按坐标重建
+     */
+    void _M_link(int __h, int __cell)
+    {
+        _Node &__n = m_nodes[__h];
+        __n.m_prev = -1;
+        __n.m_next = m_head[__cell];
+        if (__n.m_next != -1)
+            m_nodes[__n.m_next].m_prev = __h;
+        m_head[__cell] = __h;
+        ++m_count[__cell];
+    }
+
+    void _M_unlink(int __h, int __cell)
+    {
+        _Node &__n = m_nodes[__h];
+        if (__n.m_prev != -1)
+            m_nodes[__n.m_prev].m_next = __n.m_next;
+        else
+            m_head[__cell] = __n.m_next;
+        if (__n.m_next != -1)
+            m_nodes[__n.m_next].m_prev = __n.m_prev;
+        --m_count[__cell];
+    }
+
+    int _M_node_cell(int __h) const { return _M_cell_of(m_nodes[__h].m_x, m_nodes[__h].m_y); }
+
+    float _M_dist2(int __h, float __x, float __y) const
+    {
+        float __dx = m_nodes[__h].m_x - __x, __dy = m_nodes[__h].m_y - __y;
+        return __dx * __dx + __dy * __dy;
+    }
+
+    int _M_cell_x(float __x) const
+    {
+        float __f = (__x - m_originX) * m_invCellSize;
+        return __f <= 0.0f ? 0 : (__f >= (float) (CELLS_X - 1) ? CELLS_X - 1 : (int) __f);
+    }
+
+    int _M_cell_y(float __y) const
+    {
+        float __f = (__y - m_originY) * m_invCellSize;
+        return __f <= 0.0f ? 0 : (__f >= (float) (CELLS_Y - 1) ? CELLS_Y - 1 : (int) __f);
+    }
+
+    int _M_cell_of(float __x, float __y) const { return _M_cell_index(_M_cell_x(__x), _M_cell_y(__y)); }
+
+    /**
+     * @brief 8x8块按行排列, 块内6位Morton编号: x和y的低3位交错
+     */
+    static int _M_cell_index(int __cx, int __cy)
+    {
+        int __lx = __cx & 7, __ly = __cy & 7;
+        int __morton = (__lx & 1) | ((__ly & 1) << 1) | ((__lx & 2) << 1) | ((__ly & 2) << 2) | ((__lx & 4) << 2) | ((__ly & 4) << 3);
+        return (((__cy >> 3) * TILES_X + (__cx >> 3)) << 6) | __morton;
+    }
+
+    int m_head[CELL_COUNT];
+    int m_count[CELL_COUNT];
+    _Node m_nodes[MAX_ENTITIES];
+    uint64_t m_data[MAX_ENTITIES];  //!<调用者的数据, 比如角色id
+    float m_originX;
+    float m_originY;
+    float m_cellSize;
+    float m_invCellSize;
+    int m_free;
+    int m_size;
+    uint32_t m_markBase;            //!<move_batch下一批标记的起始编号
+    uint32_t m_mark[MAX_ENTITIES];  //!<move_batch求视野差用的标记, 按句柄, 只有写进程用
+};
+
+template<int MAX_ENTITIES, int CELLS_X, int CELLS_Y>
+bool NFShmAOIGrid<MAX_ENTITIES, CELLS_X, CELLS_Y>::verify() const
+{
+    int __total = 0;
+    for (int __cell = 0; __cell < CELL_COUNT; ++__cell)
+    {
+        int __count = 0;
+        int __prev = -1;
+        for (int __n = m_head[__cell]; __n != -1; __n = m_nodes[__n].m_next)
+        {
+            CHECK_EXPR(__n >= 0 && __n < MAX_ENTITIES && __count < MAX_ENTITIES, false, "NFShmAOIGrid verify failed, bad link in cell:{}", __cell);
+            CHECK_EXPR(m_nodes[__n].m_prev == __prev, false, "NFShmAOIGrid verify failed, node:{} prev:{} != {} in cell:{}", __n, m_nodes[__n].m_prev, __prev, __cell);
+            CHECK_EXPR(_M_node_cell(__n) == __cell, false, "NFShmAOIGrid verify failed, node:{} in wrong cell:{}", __n, __cell);
+            __prev = __n;
+            ++__count;
+        }
+        CHECK_EXPR(__count == m_count[__cell], false, "NFShmAOIGrid verify failed, cell:{} count:{} != {}", __cell, m_count[__cell], __count);
+        __total += __count;
+    }
+    CHECK_EXPR(__total == m_size, false, "NFShmAOIGrid verify failed, linked:{} != size:{}", __total, m_size);
+    int __free = 0;
+    for (int __n = m_free; __n != -1; __n = m_nodes[__n].m_next)
+    {
+        CHECK_EXPR(__n >= 0 && __n < MAX_ENTITIES && __free < MAX_ENTITIES && m_nodes[__n].m_prev == FREE_NODE, false, "NFShmAOIGrid verify failed, bad free node:{}", __n);
+        ++__free;
+    }
+    CHECK_EXPR(__free + m_size == MAX_ENTITIES, false, "NFShmAOIGrid verify failed, free:{} + size:{} != {}", __free, m_size, MAX_ENTITIES);
+    return true;
+}
@@ -0,0 +1,416 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmAhoCorasick.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmAhoCorasick
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmString.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+
+/**
+ * @brief 双数组trie中的一个状态
+ * 状态s经过字节c转移到t = m_base[s] + c, 当且仅当m_check[t] == s时转移存在
+ */
+struct NFShmAhoCorasickState
+{
+    int32_t m_base;
+    int32_t m_check; //!<父状态, 空闲槽位为INVALID_ID
+    int32_t m_fail; //!<失败指针
+    int32_t m_output; //!<以该状态结尾的模式串编号, 没有为INVALID_ID
+    int32_t m_outLink; //!<沿失败指针能到达的下一个有输出的状态, 没有为0(根)
+};
+
+/**
+ * @brief 共享内存Aho-Corasick自动机, 用于屏蔽字过滤
+ * trie用双数组(base/check)存储, 失败指针和输出链接都是槽位下标, 整个结构没有指针,
+ * 一个进程build一次后, 其他进程ResumeInit挂上去就能直接scan, 不需要每个进程在堆上各建一份.
+ *
+ * 按字节匹配, 所以UTF-8的模式串和文本不需要额外处理, 匹配到的位置一定在字符边界上.
+ * 不做大小写/全半角转换, 需要的话在build和scan之前自己归一化.
+ *
+ * MAX_SLOTS是双数组的槽位数, 一般要比所有模式串的字节数之和大10%~20%, 不够时build失败.
+ * 注意build会原地重建, 其他进程正在scan时不要build, 需要热更新的话用两份实例切换.
+ */
+template<int MAX_SLOTS, int MAX_PATTERNS>
+class NFShmAhoCorasick
+{
+public:
+    typedef size_t size_type;
+
+public:
+    NFShmAhoCorasick()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    ~NFShmAhoCorasick()
+    {
+    }
+
+    int CreateInit()
+    {
+        for (int i = 0; i < MAX_SLOTS; ++i)
+        {
+            m_states[i].m_base = 0;
+            m_states[i].m_check = INVALID_ID;
+            m_states[i].m_fail = 0;
+            m_states[i].m_output = INVALID_ID;
+            m_states[i].m_outLink = 0;
+        }
+        m_states[0].m_base = 1;
+        m_states[0].m_check = 0;
+        m_numStates = 1;
+        m_slotsUsed = 1;
+        m_numPatterns = 0;
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 用__patterns重建自动机, 模式串编号就是在__patterns中的下标
+     * 空串会被忽略, 重复的模式串只保留第一个编号.
+     * @return 成功返回0, 模式串太多或者槽位不够返回-1, 此时自动机为空
+     */
+    template<class _Container>
+    int build(const _Container &__patterns);
+
+    /**
+     * @brief 扫描文本, 每找到一个匹配调用一次__f(pos, len, pattern_id)
+     * 匹配按结束位置从前往后回调, 同一个位置结束的多个匹配按从长到短回调.
+     * __f返回bool时, 返回false停止扫描.
+     * @return 回调的次数
+     */
+    template<class _Func>
+    size_type scan(std::string_view __text, _Func &&__f) const;
+
+    template<int MAX_SIZE, class _Func>
+    size_type scan(const NFShmString<MAX_SIZE> &__text, _Func &&__f) const
+    {
+        return scan(std::string_view(__text.data(), __text.size()), std::forward<_Func>(__f));
+    }
+
+    /**
+     * @brief 文本中是否包含任意一个模式串, 找到第一个就返回
+     */
+    bool contains(std::string_view __text) const
+    {
+        bool __found = false;
+        scan(__text, [&__found](size_type, size_type, int) {
+            __found = true;
+            return false;
+        });
+        return __found;
+    }
+
+    template<int MAX_SIZE>
+    bool contains(const NFShmString<MAX_SIZE> &__text) const
+    {
+        return contains(std::string_view(__text.data(), __text.size()));
+    }
+
+    /**
+     * @brief 把[__data, __data + __n)中匹配到的字节原地替换成__mask_char, 长度不变
+     * @return 匹配的次数
+     */
+    size_type replace(char *__data, size_type __n, char __mask_char) const;
+
+    size_type replace(std::string &__text, char __mask_char) const
+    {
+        return replace(&__text[0], __text.size(), __mask_char);
+    }
+
+    template<int MAX_SIZE>
+    size_type replace(NFShmString<MAX_SIZE> &__text, char __mask_char) const
+    {
+        return replace(__text.begin(), __text.size(), __mask_char);
+    }
+
+    void clear() { CreateInit(); }
+
+public:
+    bool empty() const { return m_numPatterns == 0; }
+
+    size_type pattern_count() const { return m_numPatterns; }
+
+    size_type state_count() const { return m_numStates; }
+
+    size_type slots_used() const { return m_slotsUsed; }
+
+    size_type max_slots() const { return MAX_SLOTS; }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 以状态槽为元素, 模式串长度表算作额外开销
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(NFShmAhoCorasickState), m_slotsUsed, MAX_SLOTS); }
+
+    /**
+     * @brief 模式串的长度, 编号无效时返回0
+     */
+    size_type pattern_length(int __id) const
+    {
+        if (__id < 0 || __id >= m_numPatterns)
+            return 0;
+        return m_patternLen[__id];
+    }
+
+private:
+    int _M_goto(int __s, uint8_t __c) const
+    {
+        uint32_t __t = (uint32_t) m_states[__s].m_base + __c;
+        if (__t < (uint32_t) MAX_SLOTS && m_states[__t].m_check == __s)
+            return (int) __t;
+        return INVALID_ID;
+    }
+
+    int _M_next(int __s, uint8_t __c) const
+    {
+        while (true)
+        {
+            int __t = _M_goto(__s, __c);
+            if (__t != INVALID_ID)
+                return __t;
+            if (__s == 0)
+                return 0;
+            __s = m_states[__s].m_fail;
+        }
+    }
+
+    /**
+     * @brief 给一组子节点找一个base, 使所有m_base + c都是空闲槽位
+     */
+    int _M_find_base(const std::vector<uint8_t> &__labels, int &__nextCheckPos) const;
+
+private:
+    NFShmAhoCorasickState m_states[MAX_SLOTS];
+    int32_t m_patternLen[MAX_PATTERNS];
+    int m_numStates;
+    int m_slotsUsed; //!<用到的最大槽位下标+1
+    int m_numPatterns;
+};
+
+template<int MAX_SLOTS, int MAX_PATTERNS>
+int NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::_M_find_base(const std::vector<uint8_t> &__labels, int &__nextCheckPos) const
+{
+    // __labels已排序, 从第一个空闲槽位开始找, 首个子节点落在空闲槽位上再检查其余的
+    int __pos = std::max(__nextCheckPos, (int) __labels[0] + 1);
+    bool __first = true;
+    for (; __pos < MAX_SLOTS; ++__pos)
+    {
+        if (m_states[__pos].m_check != INVALID_ID)
+            continue;
+        if (__first)
+        {
+            __nextCheckPos = __pos;
+            __first = false;
+        }
+
+        int __base = __pos - __labels[0];
+        if (__base + __labels.back() >= MAX_SLOTS)
+            return INVALID_ID;
+
+        bool __ok = true;
+        for (size_t i = 1; i < __labels.size(); ++i)
+        {
+            if (m_states[__base + __labels[i]].m_check != INVALID_ID)
+            {
+                __ok = false;
+                break;
+            }
+        }
+        if (__ok)
+            return __base;
+    }
+    return INVALID_ID;
+}
+
+template<int MAX_SLOTS, int MAX_PATTERNS>
+template<class _Container>
+int NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::build(const _Container &__patterns)
+{
+    CreateInit();
+    if (__patterns.size() > (size_t) MAX_PATTERNS)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmAhoCorasick No Enough Space! MAX_PATTERNS:{} patterns:{}", MAX_PATTERNS, __patterns.size());
+        return -1;
+    }
+
+    // 先在堆上建普通的trie, 子节点按字节排序, 再按层序搬到双数组里
+    struct TrieNode
+    {
+        std::vector<std::pair<uint8_t, int> > m_children;
+        int m_output;
+    };
+    std::vector<TrieNode> __trie(1);
+    __trie[0].m_output = INVALID_ID;
+
+    int __count = 0;
+    for (const auto &__p : __patterns)
+    {
+        std::string_view __pat(__p);
+        int __id = __count++;
+        m_patternLen[__id] = (int32_t) __pat.size();
+        if (__pat.empty())
+            continue;
+
+        int __node = 0;
+        for (size_t i = 0; i < __pat.size(); ++i)
+        {
+            uint8_t __c = (uint8_t) __pat[i];
+            auto &__children = __trie[__node].m_children;
+            auto __it = std::lower_bound(__children.begin(), __children.end(), std::make_pair(__c, 0));
+            if (__it != __children.end() && __it->first == __c)
+            {
+                __node = __it->second;
+            }
+            else
+            {
+                int __child = (int) __trie.size();
+                __children.insert(__it, std::make_pair(__c, __child));
+                __trie.push_back(TrieNode());
+                __trie.back().m_output = INVALID_ID;
+                __node = __child;
+            }
+        }
+        if (__trie[__node].m_output == INVALID_ID)
+            __trie[__node].m_output = __id;
+    }
+
+    std::vector<int> __slotOf(__trie.size(), INVALID_ID);
+    std::vector<int> __queue;
+    __queue.reserve(__trie.size());
+    __queue.push_back(0);
+    __slotOf[0] = 0;
+
+    int __nextCheckPos = 1;
+    std::vector<uint8_t> __labels;
+    for (size_t __head = 0; __head < __queue.size(); ++__head)
+    {
+        int __node = __queue[__head];
+        int __s = __slotOf[__node];
+        m_states[__s].m_output = __trie[__node].m_output;
+
+        const auto &__children = __trie[__node].m_children;
+        if (__children.empty())
+        {
+            m_states[__s].m_base = 0;
+            continue;
+        }
+
+        __labels.clear();
+        for (size_t i = 0; i < __children.size(); ++i)
+        {
+            __labels.push_back(__children[i].first);
+        }
+
+        int __base = _M_find_base(__labels, __nextCheckPos);
+        if (__base == INVALID_ID)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmAhoCorasick No Enough Space! MAX_SLOTS:{} trie nodes:{}", MAX_SLOTS, __trie.size());
+            CreateInit();
+            return -1;
+        }
+
+        m_states[__s].m_base = __base;
+        for (size_t i = 0; i < __children.size(); ++i)
+        {
+            int __t = __base + __children[i].first;
+            m_states[__t].m_check = __s;
+            __slotOf[__children[i].second] = __t;
+            __queue.push_back(__children[i].second);
+            if (__t + 1 > m_slotsUsed)
+                m_slotsUsed = __t + 1;
+        }
+    }
+
+    // 层序计算失败指针, 父节点的失败指针一定已经算好了
+    for (size_t __head = 0; __head < __queue.size(); ++__head)
+    {
+        int __node = __queue[__head];
+        int __s = __slotOf[__node];
+        const auto &__children = __trie[__node].m_children;
+        for (size_t i = 0; i < __children.size(); ++i)
+        {
+            uint8_t __c = __children[i].first;
+            int __t = __slotOf[__children[i].second];
+            int __f = __s == 0 ? 0 : _M_next(m_states[__s].m_fail, __c);
+            m_states[__t].m_fail = __f;
+            m_states[__t].m_outLink = m_states[__f].m_output != INVALID_ID ? __f : m_states[__f].m_outLink;
+        }
+    }
+
+    m_numStates = (int) __trie.size();
+    m_numPatterns = __count;
+    return 0;
+}
+
+template<int MAX_SLOTS, int MAX_PATTERNS>
+template<class _Func>
+typename NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::size_type
+NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::scan(std::string_view __text, _Func &&__f) const
+{
+    size_type __matches = 0;
+    int __s = 0;
+    for (size_type i = 0; i < __text.size(); ++i)
+    {
+        __s = _M_next(__s, (uint8_t) __text[i]);
+
+        int __o = m_states[__s].m_output != INVALID_ID ? __s : m_states[__s].m_outLink;
+        while (__o != 0)
+        {
+            int __id = m_states[__o].m_output;
+            size_type __len = m_patternLen[__id];
+            ++__matches;
+            if constexpr (std::is_same<decltype(__f(i, __len, __id)), bool>::value)
+            {
+                if (!__f(i + 1 - __len, __len, __id))
+                    return __matches;
+            }
+            else
+            {
+                __f(i + 1 - __len, __len, __id);
+            }
+            __o = m_states[__o].m_outLink;
+        }
+    }
+    return __matches;
+}
+
+template<int MAX_SLOTS, int MAX_PATTERNS>
+typename NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::size_type
+NFShmAhoCorasick<MAX_SLOTS, MAX_PATTERNS>::replace(char *__data, size_type __n, char __mask_char) const
+{
+    // 同一个位置结束的匹配先回调最长的, 后面短的都已经被覆盖, 直接跳过
+    size_type __lastEnd = (size_type) -1;
+    return scan(std::string_view(__data, __n), [&](size_type __pos, size_type __len, int) {
+        size_type __end = __pos + __len;
+        if (__end == __lastEnd)
+            return;
+        __lastEnd = __end;
+        memset(__data + __pos, __mask_char, __len);
+    });
+}
@@ -0,0 +1,373 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBitSet.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmBitSet
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief 位操作的公共函数, NFShmBitSet和NFShmHierBitmap共用
+ */
+struct NFShmBitOps
+{
+    static int ctz(uint64_t __v)
+    {
+#if defined(_MSC_VER)
+        unsigned long __i;
+        _BitScanForward64(&__i, __v);
+        return (int) __i;
+#else
+        return __builtin_ctzll(__v);
+#endif
+    }
+
+    static int popcount(uint64_t __v)
+    {
+#if defined(_MSC_VER)
+        return (int) __popcnt64(__v);
+#else
+        return __builtin_popcountll(__v);
+#endif
+    }
+
+    /**
+     * @brief __n个uint64的popcount之和. AVX2下用pshufb查4位表(Mula), 每次数256位, 比逐字popcnt快;
+     * __a和__b都不为NULL时数 __a & __b, 不用先算出交集
+     */
+    static size_t count(const uint64_t *__a, const uint64_t *__b, size_t __n)
+    {
+        size_t __sum = 0;
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i __lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                               0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i __low = _mm256_set1_epi8(0x0f);
+        __m256i __acc = _mm256_setzero_si256();
+        for (; i + 4 <= __n; i += 4)
+        {
+            __m256i __v = _mm256_loadu_si256((const __m256i *) (__a + i));
+            if (__b)
+                __v = _mm256_and_si256(__v, _mm256_loadu_si256((const __m256i *) (__b + i)));
+            __m256i __cnt = _mm256_add_epi8(_mm256_shuffle_epi8(__lut, _mm256_and_si256(__v, __low)),
+                                            _mm256_shuffle_epi8(__lut, _mm256_and_si256(_mm256_srli_epi16(__v, 4), __low)));
+            __acc = _mm256_add_epi64(__acc, _mm256_sad_epu8(__cnt, _mm256_setzero_si256()));
+        }
+        __sum = (size_t) _mm256_extract_epi64(__acc, 0) + (size_t) _mm256_extract_epi64(__acc, 1)
+                + (size_t) _mm256_extract_epi64(__acc, 2) + (size_t) _mm256_extract_epi64(__acc, 3);
+#endif
+        for (; i < __n; ++i)
+            __sum += popcount(__b ? __a[i] & __b[i] : __a[i]);
+        return __sum;
+    }
+};
+
+/**
+ * @brief 定长位集合, 放在共享内存里, 代替NFShmVector<bool>和存小整数的NFShmHashSet<int>:
+ * 每个元素1位, 一百万个标记只占128KB, 交并差都是按字(AVX2下按256位)整块算.
+ * 字数向上补齐到4的倍数并按32字节对齐, AVX2路径没有尾巴要处理; 最后一个字里超出BITS的位始终为0.
+ * find_first/find_next按字跳过全0的部分, 稀疏集合遍历很快; 需要在几百万位里反复找第一个0(分配id)时用NFShmHierBitmap.
+ *
+ * 用法:
+ * NFShmBitSet<4096> m_achievements;
+ * m_achievements.set(id);
+ * size_t done = m_achievements.count_and(m_seasonAchievements);     //不生成临时集合
+ * for (size_t i = s.find_first(); i < s.size(); i = s.find_next(i + 1)) {...}
+ */
+template<size_t BITS>
+class NFShmBitSet
+{
+public:
+    static_assert(BITS > 0, "NFShmBitSet BITS must be positive");
+
+    enum
+    {
+        WORDS = (BITS + 63) / 64,
+        PADDED_WORDS = (WORDS + 3) & ~3,
+    };
+
+public:
+    NFShmBitSet()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        memset(m_words, 0, sizeof(m_words));
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    static size_t size() { return BITS; }
+
+    bool test(size_t __pos) const { return (m_words[__pos >> 6] >> (__pos & 63)) & 1; }
+
+    bool operator[](size_t __pos) const { return test(__pos); }
+
+    NFShmBitSet &set(size_t __pos)
+    {
+        CHECK_EXPR(__pos < BITS, *this, "NFShmBitSet set pos:{} >= BITS:{}", __pos, BITS);
+        m_words[__pos >> 6] |= 1ull << (__pos & 63);
+        return *this;
+    }
+
+    NFShmBitSet &set(size_t __pos, bool __val) { return __val ? set(__pos) : reset(__pos); }
+
+    NFShmBitSet &reset(size_t __pos)
+    {
+        CHECK_EXPR(__pos < BITS, *this, "NFShmBitSet reset pos:{} >= BITS:{}", __pos, BITS);
+        m_words[__pos >> 6] &= ~(1ull << (__pos & 63));
+        return *this;
+    }
+
+    NFShmBitSet &flip(size_t __pos)
+    {
+        CHECK_EXPR(__pos < BITS, *this, "NFShmBitSet flip pos:{} >= BITS:{}", __pos, BITS);
+        m_words[__pos >> 6] ^= 1ull << (__pos & 63);
+        return *this;
+    }
+
+    NFShmBitSet &set()
+    {
+        memset(m_words, 0xff, sizeof(uint64_t) * WORDS);
+        _M_trim();
+        return *this;
+    }
+
+    NFShmBitSet &reset()
+    {
+        memset(m_words, 0, sizeof(m_words));
+        return *this;
+    }
+
+    NFShmBitSet &flip()
+    {
+        for (size_t i = 0; i < WORDS; ++i)
+            m_words[i] = ~m_words[i];
+        _M_trim();
+        return *this;
+    }
+
+    size_t count() const { return NFShmBitOps::count(m_words, NULL, PADDED_WORDS); }
+
+    /**
+     * @brief (*this & __x).count(), 不生成临时集合
+     */
+    size_t count_and(const NFShmBitSet &__x) const { return NFShmBitOps::count(m_words, __x.m_words, PADDED_WORDS); }
+
+    bool any() const
+    {
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            if (m_words[i])
+                return true;
+        }
+        return false;
+    }
+
+    bool none() const { return !any(); }
+
+    bool all() const { return count() == BITS; }
+
+    bool intersects(const NFShmBitSet &__x) const
+    {
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            if (m_words[i] & __x.m_words[i])
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief *this是否是__x的子集
+     */
+    bool is_subset_of(const NFShmBitSet &__x) const
+    {
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            if (m_words[i] & ~__x.m_words[i])
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 第一个为1的位, 没有时返回size()
+     */
+    size_t find_first() const { return find_next(0); }
+
+    /**
+     * @brief 下标 >= __pos 的第一个为1的位, 没有时返回size()
+     */
+    size_t find_next(size_t __pos) const
+    {
+        if (__pos >= BITS)
+            return BITS;
+        size_t __w = __pos >> 6;
+        uint64_t __bits = m_words[__w] & (~0ull << (__pos & 63));
+        while (__bits == 0)
+        {
+            if (++__w >= WORDS)
+                return BITS;
+            __bits = m_words[__w];
+        }
+        return (__w << 6) + NFShmBitOps::ctz(__bits);
+    }
+
+    size_t find_first_zero() const { return find_next_zero(0); }
+
+    /**
+     * @brief 下标 >= __pos 的第一个为0的位, 没有时返回size()
+     */
+    size_t find_next_zero(size_t __pos) const
+    {
+        if (__pos >= BITS)
+            return BITS;
+        size_t __w = __pos >> 6;
+        uint64_t __bits = ~m_words[__w] & (~0ull << (__pos & 63));
+        while (__bits == 0)
+        {
+            if (++__w >= WORDS)
+                return BITS;
+            __bits = ~m_words[__w];
+        }
+        size_t __r = (__w << 6) + NFShmBitOps::ctz(__bits);
+        return __r < BITS ? __r : BITS;
+    }
+
+    /**
+     * @brief 对每个为1的位调用__f(pos), 按下标从小到大
+     */
+    template<class F>
+    void for_each_set(F __f) const
+    {
+        for (size_t __w = 0; __w < WORDS; ++__w)
+        {
+            for (uint64_t __bits = m_words[__w]; __bits != 0; __bits &= __bits - 1)
+                __f((__w << 6) + NFShmBitOps::ctz(__bits));
+        }
+    }
+
+    NFShmBitSet &operator&=(const NFShmBitSet &__x) { return _M_bitop<_OP_AND>(__x); }
+
+    NFShmBitSet &operator|=(const NFShmBitSet &__x) { return _M_bitop<_OP_OR>(__x); }
+
+    NFShmBitSet &operator^=(const NFShmBitSet &__x) { return _M_bitop<_OP_XOR>(__x); }
+
+    /**
+     * @brief *this &= ~__x, 差集
+     */
+    NFShmBitSet &and_not(const NFShmBitSet &__x) { return _M_bitop<_OP_ANDNOT>(__x); }
+
+    NFShmBitSet operator~() const
+    {
+        NFShmBitSet __r(*this);
+        __r.flip();
+        return __r;
+    }
+
+    bool operator==(const NFShmBitSet &__x) const { return memcmp(m_words, __x.m_words, sizeof(uint64_t) * WORDS) == 0; }
+
+    bool operator!=(const NFShmBitSet &__x) const { return !(*this == __x); }
+
+    /**
+     * @brief 直接访问底层的字, 第i位在words()[i / 64]的第i % 64位
+     */
+    const uint64_t *words() const { return m_words; }
+
+    uint64_t *words() { return m_words; }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(uint64_t), WORDS, WORDS); }
+
+private:
+    enum { _OP_AND, _OP_OR, _OP_XOR, _OP_ANDNOT };
+
+    template<int OP>
+    NFShmBitSet &_M_bitop(const NFShmBitSet &__x)
+    {
+#if defined(__AVX2__)
+        for (size_t i = 0; i < PADDED_WORDS; i += 4)
+        {
+            __m256i __a = _mm256_loadu_si256((const __m256i *) (m_words + i));
+            __m256i __b = _mm256_loadu_si256((const __m256i *) (__x.m_words + i));
+            __m256i __r = OP == _OP_AND ? _mm256_and_si256(__a, __b)
+                        : OP == _OP_OR ? _mm256_or_si256(__a, __b)
+                        : OP == _OP_XOR ? _mm256_xor_si256(__a, __b)
+                        : _mm256_andnot_si256(__b, __a);
+            _mm256_storeu_si256((__m256i *) (m_words + i), __r);
+        }
+#else
+        for (size_t i = 0; i < WORDS; ++i)
+        {
+            uint64_t __a = m_words[i], __b = __x.m_words[i];
+            m_words[i] = OP == _OP_AND ? (__a & __b) : OP == _OP_OR ? (__a | __b) : OP == _OP_XOR ? (__a ^ __b) : (__a & ~__b);
+        }
+#endif
+        return *this;
+    }
+
+    void _M_trim()
+    {
+        if (BITS & 63)
+            m_words[WORDS - 1] &= (1ull << (BITS & 63)) - 1;
+        for (size_t i = WORDS; i < PADDED_WORDS; ++i)
+            m_words[i] = 0;
+    }
+
+    alignas(32) uint64_t m_words[PADDED_WORDS];
+};
+
+template<size_t BITS>
+inline NFShmBitSet<BITS> operator&(const NFShmBitSet<BITS> &__x, const NFShmBitSet<BITS> &__y)
+{
+    NFShmBitSet<BITS> __r(__x);
+    __r &= __y;
+    return __r;
+}
+
+template<size_t BITS>
+inline NFShmBitSet<BITS> operator|(const NFShmBitSet<BITS> &__x, const NFShmBitSet<BITS> &__y)
+{
+    NFShmBitSet<BITS> __r(__x);
+    __r |= __y;
+    return __r;
+}
+
+template<size_t BITS>
+inline NFShmBitSet<BITS> operator^(const NFShmBitSet<BITS> &__x, const NFShmBitSet<BITS> &__y)
+{
+    NFShmBitSet<BITS> __r(__x);
+    __r ^= __y;
+    return __r;
+}
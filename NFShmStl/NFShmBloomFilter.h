@@ -0,0 +1,584 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBloomFilter.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmBloomFilter
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include "NFShmCuckooHashMap.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <functional>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief 过滤器统一的接口, 参数都是key的hash值(hasher()(key)), 过滤器内部再做一次混合, 所以std::hash<int>这种恒等hash也能用:
+ * bool insert_hash(uint64_t), bool contains_hash(uint64_t) const, bool erase_hash(uint64_t), void clear().
+ * contains_hash返回false时key一定不在集合里, 返回true时可能误判.
+ * 多个进程可以同时读, 写进程之间需要外部互斥. 读的同时有写入时, 正在插入的key可能短暂地查不到.
+ */
+
+#define NFSHM_BLOOM_BLOCK_WORDS 8       //!<每块8个uint64, 正好一条64字节的cache line
+
+/**
+ * @brief 分块布隆过滤器(blocked bloom filter), 一个key的K个bit都落在同一条cache line里,
+ * 查询只访问一条cache line, 而普通布隆过滤器要访问K条.
+ * 块内把K个bit平均分到8个uint64里(K=8时每个字一个bit), 查询时8个字的掩码和块做一次整体比较.
+ * 开启AVX2(-mavx2)时掩码用256位的乘法和变长移位一次算出, 再用两条testc比较, 否则是8次标量乘法和与或.
+ * 同样的位数下误判率比普通布隆过滤器略高, BITS/n=10, K=8时约1%(普通的约0.8%).
+ * 不支持删除, 删除很多的场景用NFShmCuckooFilter.
+ * @tparam BITS 总位数, 向上取整到512的倍数
+ * @tparam K 每个key设置的位数, 1~16
+ */
+template<int BITS, int K = 8>
+class NFShmBloomFilter
+{
+public:
+    static_assert(K >= 1 && K <= 16, "NFShmBloomFilter K must be in [1, 16]");
+
+    enum
+    {
+        BLOCK_BITS = NFSHM_BLOOM_BLOCK_WORDS * 64,
+        BLOCK_COUNT = (BITS + BLOCK_BITS - 1) / BLOCK_BITS > 0 ? (BITS + BLOCK_BITS - 1) / BLOCK_BITS : 1,
+    };
+
+    static const bool deletable = false;
+
+    NFShmBloomFilter()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        clear();
+        return 0;
+    }
+
+    /**
+     * @brief 全是POD, 恢复时什么都不用做
+     */
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 加入一个key, 总是成功
+     */
+    bool insert_hash(uint64_t __hash)
+    {
+        uint32_t __lo, __rot;
+        uint64_t *__blk = m_blocks[_M_block(__hash, __lo, __rot)].m_word;
+        for (int i = 0; i < NFSHM_BLOOM_BLOCK_WORDS; ++i)
+        {
+            __blk[i] |= _M_word(__lo, __rot, i);
+        }
+        ++m_count;
+        return true;
+    }
+
+    bool contains_hash(uint64_t __hash) const
+    {
+        uint32_t __lo, __rot;
+        const uint64_t *__blk = m_blocks[_M_block(__hash, __lo, __rot)].m_word;
+#if defined(__AVX2__)
+        __m256i __m0, __m1;
+        _M_mask_avx2(__lo, __rot, __m0, __m1);
+        return _mm256_testc_si256(_mm256_loadu_si256((const __m256i *) __blk), __m0) &
+               _mm256_testc_si256(_mm256_loadu_si256((const __m256i *) (__blk + 4)), __m1);
+#else
+        uint64_t __miss = 0;
+        for (int i = 0; i < NFSHM_BLOOM_BLOCK_WORDS; ++i)
+        {
+            __miss |= _M_word(__lo, __rot, i) & ~__blk[i];
+        }
+        return __miss == 0;
+#endif
+    }
+
+    /**
+     * @brief 布隆过滤器不能删除, 返回false, 调用方需要在删除较多时重建
+     */
+    bool erase_hash(uint64_t) { return false; }
+
+    template<class Key, class HashFcn = std::hash<Key> >
+    bool insert(const Key &__key) { return insert_hash((uint64_t) HashFcn()(__key)); }
+
+    template<class Key, class HashFcn = std::hash<Key> >
+    bool contains(const Key &__key) const { return contains_hash((uint64_t) HashFcn()(__key)); }
+
+    void clear()
+    {
+        memset(m_blocks, 0, sizeof(m_blocks));
+        m_count = 0;
+    }
+
+    /**
+     * @brief insert的次数, 重复加入的key会重复计数
+     */
+    size_t size() const { return m_count; }
+
+    static size_t bit_count() { return (size_t) BLOCK_COUNT * BLOCK_BITS; }
+
+    /**
+     * @brief 为1的bit占的比例, 遍历所有块, 用来监控
+     */
+    double fill_ratio() const
+    {
+        size_t __ones = 0;
+        for (int i = 0; i < BLOCK_COUNT; ++i)
+        {
+            for (int j = 0; j < NFSHM_BLOOM_BLOCK_WORDS; ++j)
+            {
+                __ones += (size_t) _M_popcount(m_blocks[i].m_word[j]);
+            }
+        }
+        return (double) __ones / (double) bit_count();
+    }
+
+    /**
+     * @brief 按普通布隆过滤器的公式(1 - e^(-Kn/m))^K估算当前的误判率, 分块的实际值略高
+     */
+    double false_positive_rate() const
+    {
+        return pow(1.0 - exp(-(double) K * (double) m_count / (double) bit_count()), (double) K);
+    }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), 0, m_count, 0); }
+
+private:
+    /**
+     * @brief 用hash的高32位选块, 低32位__lo用来生成块内的bit.
+     * K<8时只有K个字有bit, __rot决定从哪个字开始, 让块里8个字用得一样多
+     */
+    static int _M_block(uint64_t __hash, uint32_t &__lo, uint32_t &__rot)
+    {
+        uint64_t __h = _NFShmHashMix(__hash, 0x9E3779B97F4A7C15ull);
+        __lo = (uint32_t) __h;
+        __rot = (uint32_t) (__h >> 32) & (NFSHM_BLOOM_BLOCK_WORDS - 1);
+        return (int) (((__h >> 32) * (uint64_t) BLOCK_COUNT) >> 32);
+    }
+
+    /**
+     * @brief 第__w个字的掩码, 字的序号r = (__w - __rot) % 8, r < K时有一个bit, r + 8 < K时再加一个,
+     * bit的位置是__lo乘一个奇数常数后的高6位.
+     * 直接在寄存器里算, 不先写到数组里再读, 避免8字节写后16字节读的store forwarding失败
+     */
+    static uint64_t _M_word(uint32_t __lo, uint32_t __rot, int __w)
+    {
+        int __r = (int) (((uint32_t) __w - __rot) & (NFSHM_BLOOM_BLOCK_WORDS - 1));
+        uint64_t __m = __r < K ? 1ull << ((__lo * _M_salt(__w)) >> 26) : 0;
+        if (__r + NFSHM_BLOOM_BLOCK_WORDS < K)
+            __m |= 1ull << ((__lo * _M_salt(__w + NFSHM_BLOOM_BLOCK_WORDS)) >> 26);
+        return __m;
+    }
+
+    static uint32_t _M_salt(int __i)
+    {
+        static const uint32_t __salt[16] = {
+            0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+            0x2e1c7d6bU, 0xb1d1e2a7U, 0x6a9c33f5U, 0xd3f0b4e9U, 0x19a8c1ddU, 0x8f2e7c53U, 0x4d6b29a1U, 0xe7a5f30fU,
+        };
+        return __salt[__i];
+    }
+
+#if defined(__AVX2__)
+    /**
+     * @brief AVX2版本的_M_word, 8个字的掩码一次算出: 8路32位乘法, 右移26位, 再用变长左移生成bit
+     */
+    static void _M_mask_avx2(uint32_t __lo, uint32_t __rot, __m256i &__m0, __m256i &__m1)
+    {
+        _M_lanes_avx2(__lo, __rot, 0, K, __m0, __m1);
+        if (K > NFSHM_BLOOM_BLOCK_WORDS)
+        {
+            __m256i __h0, __h1;
+            _M_lanes_avx2(__lo, __rot, NFSHM_BLOOM_BLOCK_WORDS, K - NFSHM_BLOOM_BLOCK_WORDS, __h0, __h1);
+            __m0 = _mm256_or_si256(__m0, __h0);
+            __m1 = _mm256_or_si256(__m1, __h1);
+        }
+    }
+
+    /**
+     * @brief 用第__base~__base+7个常数生成8个字各一个bit, 只保留序号(__w - __rot) % 8小于__count的字
+     */
+    static void _M_lanes_avx2(uint32_t __lo, uint32_t __rot, int __base, int __count, __m256i &__m0, __m256i &__m1)
+    {
+        const __m256i __one = _mm256_set1_epi64x(1);
+        __m256i __salt = _mm256_setr_epi32((int) _M_salt(__base), (int) _M_salt(__base + 1), (int) _M_salt(__base + 2), (int) _M_salt(__base + 3),
+                                           (int) _M_salt(__base + 4), (int) _M_salt(__base + 5), (int) _M_salt(__base + 6), (int) _M_salt(__base + 7));
+        __m256i __idx = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((int) __lo), __salt), 26);
+        __m0 = _mm256_sllv_epi64(__one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(__idx)));
+        __m1 = _mm256_sllv_epi64(__one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(__idx, 1)));
+        if (__count < NFSHM_BLOOM_BLOCK_WORDS)
+        {
+            __m256i __k = _mm256_set1_epi64x(__count);
+            __m256i __r = _mm256_set1_epi64x(__rot);
+            __m256i __w7 = _mm256_set1_epi64x(NFSHM_BLOOM_BLOCK_WORDS - 1);
+            __m256i __r0 = _mm256_and_si256(_mm256_sub_epi64(_mm256_setr_epi64x(0, 1, 2, 3), __r), __w7);
+            __m256i __r1 = _mm256_and_si256(_mm256_sub_epi64(_mm256_setr_epi64x(4, 5, 6, 7), __r), __w7);
+            __m0 = _mm256_and_si256(__m0, _mm256_cmpgt_epi64(__k, __r0));
+            __m1 = _mm256_and_si256(__m1, _mm256_cmpgt_epi64(__k, __r1));
+        }
+    }
+#endif
+
+    static int _M_popcount(uint64_t __v)
+    {
+#if defined(_MSC_VER)
+        return (int) __popcnt64(__v);
+#else
+        return __builtin_popcountll(__v);
+#endif
+    }
+
+    struct alignas(64) _Block
+    {
+        uint64_t m_word[NFSHM_BLOOM_BLOCK_WORDS];
+    };
+
+    _Block m_blocks[BLOCK_COUNT];
+    size_t m_count;
+};
+
+/**
+ * @brief 桶数取不小于__n的2的幂(至少为__p), 布谷鸟过滤器用异或计算备用桶, 要求桶数是2的幂
+ */
+constexpr int NFShmCuckooFilterPow2(int __n, int __p = 1)
+{
+    return __p >= __n ? __p : NFShmCuckooFilterPow2(__n, __p * 2);
+}
+
+#define NFSHM_CUCKOO_FILTER_SLOTS 4         //!<每个桶4个16位指纹, 正好一个uint64
+#define NFSHM_CUCKOO_FILTER_MAX_KICKS 500   //!<插入时最多踢出的次数
+
+/**
+ * @brief 布谷鸟过滤器(cuckoo filter), 支持删除的近似集合.
+ * 每个key存一个16位指纹, 可以放在两个桶之一: i1 = hash, i2 = i1 ^ hash(指纹), 只凭指纹就能算出另一个桶, 所以能踢出.
+ * 一个桶4个指纹正好是一个uint64, 查询时用SWAR一次比较4个指纹, 只访问两个uint64.
+ * 按MAX_SIZE / 0.95 计算桶数再取2的幂, 实际负载在50%~95%之间, 误判率约 8 / 2^16 = 0.012%.
+ * 插入时先找出踢出路径再从末端往回搬, 每个指纹先写新位置再覆盖旧位置; 插入期间版本号是奇数,
+ * 读进程没找到且版本号变过时重读, 所以不会查不到早已加入的key.
+ * 路径长到NFSHM_CUCKOO_FILTER_MAX_KICKS仍找不到空槽时, 新的指纹存到m_victim里不会丢,
+ * 此后的insert都返回false, 直到有删除腾出位置.
+ * 只能删除加入过的key, 否则可能删掉别的key的指纹造成漏判. 同一个key加入两次要删除两次.
+ * @tparam MAX_SIZE 预计的最多key数
+ */
+template<int MAX_SIZE>
+class NFShmCuckooFilter
+{
+public:
+    enum
+    {
+        BUCKET_COUNT = NFShmCuckooFilterPow2((MAX_SIZE + MAX_SIZE / 19 + NFSHM_CUCKOO_FILTER_SLOTS - 1) / NFSHM_CUCKOO_FILTER_SLOTS, 2),
+        BUCKET_MASK = BUCKET_COUNT - 1,
+    };
+
+    static const bool deletable = true;
+
+    NFShmCuckooFilter()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        clear();
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 加入一个key, 过滤器满了返回false, 此时key没有加入
+     */
+    bool insert_hash(uint64_t __hash)
+    {
+        if (m_victimUsed)
+        {
+            return false;
+        }
+        uint16_t __fp;
+        uint32_t __i1, __i2;
+        _M_hash(__hash, __fp, __i1, __i2);
+        NFShmCuckooVersioned::write_begin(&m_version);
+        if (!_M_insert(__fp, __i1, __i2))
+        {
+            m_victimFp = __fp;
+            m_victimIndex = __i1;
+            m_victimUsed = true;
+        }
+        NFShmCuckooVersioned::write_end(&m_version);
+        ++m_count;
+        return true;
+    }
+
+    bool contains_hash(uint64_t __hash) const
+    {
+        uint16_t __fp;
+        uint32_t __i1, __i2;
+        _M_hash(__hash, __fp, __i1, __i2);
+        //两个桶不是同时读的, 指纹恰好在两个桶之间搬动时会都看不到, 没找到时版本号变过就重读
+        while (true)
+        {
+            uint32_t __ver = NFShmCuckooVersioned::read_begin(&m_version);
+            if (_M_has(m_buckets[__i1], __fp) | _M_has(m_buckets[__i2], __fp))
+            {
+                return true;
+            }
+            if (m_victimUsed && m_victimFp == __fp && (m_victimIndex == __i1 || m_victimIndex == __i2))
+            {
+                return true;
+            }
+            if (!NFShmCuckooVersioned::read_retry(&m_version, __ver))
+            {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief 删除一个加入过的key, 找不到指纹返回false
+     */
+    bool erase_hash(uint64_t __hash)
+    {
+        uint16_t __fp;
+        uint32_t __i1, __i2;
+        _M_hash(__hash, __fp, __i1, __i2);
+        if (m_victimUsed && m_victimFp == __fp && (m_victimIndex == __i1 || m_victimIndex == __i2))
+        {
+            m_victimUsed = false;
+            --m_count;
+            return true;
+        }
+        if (!_M_remove(__i1, __fp) && !_M_remove(__i2, __fp))
+        {
+            return false;
+        }
+        --m_count;
+        //先把m_victim放回表里再清标记, 中间读进程仍能在m_victim里查到它
+        if (m_victimUsed)
+        {
+            NFShmCuckooVersioned::write_begin(&m_version);
+            if (_M_insert(m_victimFp, m_victimIndex, m_victimIndex ^ _M_alt(m_victimFp)))
+            {
+                m_victimUsed = false;
+            }
+            NFShmCuckooVersioned::write_end(&m_version);
+        }
+        return true;
+    }
+
+    template<class Key, class HashFcn = std::hash<Key> >
+    bool insert(const Key &__key) { return insert_hash((uint64_t) HashFcn()(__key)); }
+
+    template<class Key, class HashFcn = std::hash<Key> >
+    bool contains(const Key &__key) const { return contains_hash((uint64_t) HashFcn()(__key)); }
+
+    template<class Key, class HashFcn = std::hash<Key> >
+    bool erase(const Key &__key) { return erase_hash((uint64_t) HashFcn()(__key)); }
+
+    void clear()
+    {
+        memset(m_buckets, 0, sizeof(m_buckets));
+        m_count = 0;
+        m_victimUsed = false;
+        m_victimFp = 0;
+        m_victimIndex = 0;
+        m_seed = 2463534242U;
+        m_version.m_version = 0;
+    }
+
+    size_t size() const { return m_count; }
+
+    bool full() const { return m_victimUsed; }
+
+    static size_t slot_count() { return (size_t) BUCKET_COUNT * NFSHM_CUCKOO_FILTER_SLOTS; }
+
+    double load_factor() const { return (double) m_count / (double) slot_count(); }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(uint16_t), m_count, slot_count()); }
+
+private:
+    /**
+     * @brief 指纹取混合后hash的高16位(0表示空槽, 改成1), 桶取低位
+     */
+    static void _M_hash(uint64_t __hash, uint16_t &__fp, uint32_t &__i1, uint32_t &__i2)
+    {
+        uint64_t __h = _NFShmHashMix(__hash, 0x9E3779B97F4A7C15ull);
+        __fp = (uint16_t) (__h >> 48);
+        if (__fp == 0)
+            __fp = 1;
+        __i1 = (uint32_t) __h & BUCKET_MASK;
+        __i2 = __i1 ^ _M_alt(__fp);
+    }
+
+    static uint32_t _M_alt(uint16_t __fp) { return ((uint32_t) __fp * 0x5bd1e995U) & BUCKET_MASK; }
+
+    /**
+     * @brief 桶里是否有指纹__fp, 4个16位槽与指纹异或后用"是否有全0的16位"技巧一次判断
+     */
+    static bool _M_has(uint64_t __bucket, uint16_t __fp)
+    {
+        uint64_t __x = __bucket ^ (0x0001000100010001ull * __fp);
+        return ((__x - 0x0001000100010001ull) & ~__x & 0x8000800080008000ull) != 0;
+    }
+
+    uint16_t _M_get(uint32_t __i, int __slot) const { return (uint16_t) (m_buckets[__i] >> (__slot * 16)); }
+
+    void _M_set(uint32_t __i, int __slot, uint16_t __fp)
+    {
+        m_buckets[__i] = (m_buckets[__i] & ~(0xFFFFull << (__slot * 16))) | ((uint64_t) __fp << (__slot * 16));
+    }
+
+    bool _M_put(uint32_t __i, uint16_t __fp)
+    {
+        int __s = _M_empty_slot(__i);
+        if (__s < 0)
+        {
+            return false;
+        }
+        _M_set(__i, __s, __fp);
+        return true;
+    }
+
+    bool _M_remove(uint32_t __i, uint16_t __fp)
+    {
+        for (int __s = 0; __s < NFSHM_CUCKOO_FILTER_SLOTS; ++__s)
+        {
+            if (_M_get(__i, __s) == __fp)
+            {
+                _M_set(__i, __s, 0);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 两个桶都满时先随机游走找一条踢出路径(只读不写), 找到有空槽的桶后再从路径末端往回搬指纹:
+     * 每个指纹先写进新的槽位, 再被前一个指纹覆盖旧槽位, 任何时刻已加入的key都至少在一个槽位里, 读进程不会漏判.
+     * 路径上不重复走同一个槽位, 否则后面的搬动会覆盖还没搬走的指纹.
+     * 随机数状态放在共享内存里, 恢复后序列不变
+     * @return 找不到路径时返回false, 表里什么都没改
+     */
+    bool _M_insert(uint16_t __fp, uint32_t __i1, uint32_t __i2)
+    {
+        if (_M_put(__i1, __fp) || _M_put(__i2, __fp))
+        {
+            return true;
+        }
+
+        uint32_t __pathBucket[NFSHM_CUCKOO_FILTER_MAX_KICKS];
+        uint8_t __pathSlot[NFSHM_CUCKOO_FILTER_MAX_KICKS];
+        int __len = 0;
+        int __empty = -1;
+        uint32_t __i = (_M_rand() & 1) ? __i1 : __i2;
+        while (__empty < 0 && __len < NFSHM_CUCKOO_FILTER_MAX_KICKS)
+        {
+            int __s = _M_pick_slot(__i, __pathBucket, __pathSlot, __len);
+            if (__s < 0)
+            {
+                break;
+            }
+            __pathBucket[__len] = __i;
+            __pathSlot[__len] = (uint8_t) __s;
+            ++__len;
+            __i ^= _M_alt(_M_get(__i, __s));
+            __empty = _M_empty_slot(__i);
+        }
+        if (__empty < 0)
+        {
+            return false;
+        }
+
+        for (int __k = __len - 1; __k >= 0; --__k)
+        {
+            _M_set(__i, __empty, _M_get(__pathBucket[__k], __pathSlot[__k]));
+            __i = __pathBucket[__k];
+            __empty = __pathSlot[__k];
+        }
+        _M_set(__i, __empty, __fp);
+        return true;
+    }
+
+    int _M_empty_slot(uint32_t __i) const
+    {
+        for (int __s = 0; __s < NFSHM_CUCKOO_FILTER_SLOTS; ++__s)
+        {
+            if (_M_get(__i, __s) == 0)
+            {
+                return __s;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief 从随机位置开始在桶__i里挑一个不在路径上的槽位, 4个都走过了返回-1
+     */
+    int _M_pick_slot(uint32_t __i, const uint32_t *__pathBucket, const uint8_t *__pathSlot, int __len)
+    {
+        int __start = (int) (_M_rand() & (NFSHM_CUCKOO_FILTER_SLOTS - 1));
+        for (int __t = 0; __t < NFSHM_CUCKOO_FILTER_SLOTS; ++__t)
+        {
+            int __s = (__start + __t) & (NFSHM_CUCKOO_FILTER_SLOTS - 1);
+            bool __used = false;
+            for (int __k = 0; __k < __len && !__used; ++__k)
+            {
+                __used = __pathBucket[__k] == __i && __pathSlot[__k] == __s;
+            }
+            if (!__used)
+            {
+                return __s;
+            }
+        }
+        return -1;
+    }
+
+    uint32_t _M_rand()
+    {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    uint64_t m_buckets[BUCKET_COUNT];
+    size_t m_count;
+    uint32_t m_victimIndex;
+    uint32_t m_seed;
+    NFShmCuckooVersioned::version_type m_version; //!<插入搬动指纹时的版本号(seqlock), 读进程没找到时用它判断要不要重读
+    uint16_t m_victimFp;
+    bool m_victimUsed;
+};
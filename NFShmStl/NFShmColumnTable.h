@@ -0,0 +1,538 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmColumnTable.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmColumnTable
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <vector>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief 列存(structure-of-arrays)的共享内存表, 给定期扫描一两个字段的统计任务用.
+ * 每一列是一段连续的数组(按64字节对齐), 扫描level时只读level那一列, 不会把整个结构体拖进cache.
+ * 行号就是槽位下标, 插入后直到删除都不变, 可以保存在别的容器里. 行是否有效记录在位图里, 每64行一个uint64.
+ *
+ * 统计函数(sum/min_value/max_value/count_where/sum_where/filter)按位图一次处理64行:
+ * 整字全有效时是没有分支的连续循环, 编译器可以向量化; 大部分有效时照样连续扫完再扣掉少数无效行;
+ * 其余部分有效的字用掩码选择, 也没有分支; 整字无效直接跳过.
+ * 开-O3或-mavx2时向量化效果更好.
+ *
+ * 列的类型必须可以按字节拷贝(整数, 浮点, 定长数组/结构体), 恢复时不需要做任何事.
+ *
+ * 用法:
+ * enum { COL_ID = 0, COL_LEVEL = 1, COL_LAST_LOGIN = 2 };
+ * NFShmColumnTable<1000000, uint64_t, int, uint32_t> m_players;
+ * int row = m_players.insert(playerId, level, now);
+ * m_players.get<COL_LEVEL>(row) = 10;
+ * int64_t total = m_players.sum<COL_LEVEL>();
+ * size_t active = m_players.count_where<COL_LAST_LOGIN>([=](uint32_t t) { return t > now - 86400; });
+ */
+
+/**
+ * @brief 列求和时的累加类型: 浮点用double, 有符号整数用int64_t, 无符号用uint64_t
+ */
+template<class T>
+struct NFShmColumnSumType
+{
+    typedef typename std::conditional<std::is_floating_point<T>::value, double,
+            typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type type;
+};
+
+/**
+ * @brief 列的递归存储, 不用std::tuple是因为它的默认构造会值初始化, 恢复时会清掉共享内存
+ */
+template<int MAX_ROWS, class... Columns>
+struct _NFShmColumnList
+{
+    enum { ROW_BYTES = 0 };
+
+    _NFShmColumnList() {}
+
+    void _M_set(int) {}
+
+#if NF_SHM_ZERO_ON_CREATE
+    void _M_zero() {}
+#endif
+};
+
+template<int MAX_ROWS, class Head, class... Tail>
+struct _NFShmColumnList<MAX_ROWS, Head, Tail...>
+{
+    static_assert(std::is_trivially_copyable<Head>::value, "NFShmColumnTable columns must be trivially copyable");
+
+    typedef Head value_type;
+    typedef _NFShmColumnList<MAX_ROWS, Tail...> tail_type;
+
+    enum { ROW_BYTES = sizeof(Head) + tail_type::ROW_BYTES };
+
+    _NFShmColumnList() {}
+
+    template<class... Args>
+    void _M_set(int __row, const Head &__v, const Args &... __rest)
+    {
+        m_data[__row] = __v;
+        m_tail._M_set(__row, __rest...);
+    }
+
+#if NF_SHM_ZERO_ON_CREATE
+    void _M_zero()
+    {
+        memset(m_data, 0, sizeof(m_data));
+        m_tail._M_zero();
+    }
+#endif
+
+    alignas(64) Head m_data[MAX_ROWS];
+    tail_type m_tail;
+};
+
+template<int I, class List>
+struct _NFShmColumnGet
+{
+    typedef _NFShmColumnGet<I - 1, typename List::tail_type> _Next;
+    typedef typename _Next::type type;
+
+    static type *get(List *__l) { return _Next::get(&__l->m_tail); }
+
+    static const type *get(const List *__l) { return _Next::get(&__l->m_tail); }
+};
+
+template<class List>
+struct _NFShmColumnGet<0, List>
+{
+    typedef typename List::value_type type;
+
+    static type *get(List *__l) { return __l->m_data; }
+
+    static const type *get(const List *__l) { return __l->m_data; }
+};
+
+template<int MAX_ROWS, class... Columns>
+class NFShmColumnTable
+{
+public:
+    typedef _NFShmColumnList<MAX_ROWS, Columns...> _ColumnList;
+
+    enum
+    {
+        COLUMN_COUNT = sizeof...(Columns),
+        WORD_COUNT = (MAX_ROWS + 63) / 64,
+    };
+
+    template<int I>
+    struct column_type
+    {
+        typedef typename _NFShmColumnGet<I, _ColumnList>::type type;
+    };
+
+    static_assert(MAX_ROWS > 0, "NFShmColumnTable MAX_ROWS must be positive");
+    static_assert(sizeof...(Columns) > 0, "NFShmColumnTable needs at least one column");
+
+public:
+    NFShmColumnTable()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+#if NF_SHM_ZERO_ON_CREATE
+        m_columns._M_zero();
+#endif
+        memset(m_valid, 0, sizeof(m_valid));
+        m_size = 0;
+        m_freeHint = 0;
+        return 0;
+    }
+
+    /**
+     * @brief 全是POD, 恢复时什么都不用做
+     */
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    size_t size() const { return m_size; }
+
+    size_t max_size() const { return MAX_ROWS; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_ROWS; }
+
+    size_t left_size() const { return MAX_ROWS - m_size; }
+
+    /**
+     * @brief 插入一行, 每列一个值, 返回行号, 满了返回-1. 总是使用最小的空闲行号, 让有效行尽量集中
+     */
+    int insert(const Columns &... __values)
+    {
+        if (m_size >= MAX_ROWS)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmColumnTable No Enough Space! MAX_ROWS:{}", MAX_ROWS);
+            return -1;
+        }
+        int __w = m_freeHint;
+        while (m_valid[__w] == ~0ull)
+            ++__w;
+        int __row = __w * 64 + _M_ctz(~m_valid[__w]);
+        m_columns._M_set(__row, __values...);
+        m_valid[__w] |= 1ull << (__row & 63);
+        m_freeHint = __w;
+        ++m_size;
+        return __row;
+    }
+
+    bool erase(int __row)
+    {
+        CHECK_EXPR(valid(__row), false, "NFShmColumnTable erase invalid row:{}", __row);
+        m_valid[__row >> 6] &= ~(1ull << (__row & 63));
+        if ((__row >> 6) < m_freeHint)
+            m_freeHint = __row >> 6;
+        --m_size;
+        return true;
+    }
+
+    bool valid(int __row) const { return __row >= 0 && __row < MAX_ROWS && (m_valid[__row >> 6] >> (__row & 63)) & 1; }
+
+    void clear()
+    {
+        memset(m_valid, 0, sizeof(m_valid));
+        m_size = 0;
+        m_freeHint = 0;
+    }
+
+    /**
+     * @brief 第一个有效行, 没有时返回-1, 和next_row一起遍历: for (int r = t.first_row(); r != -1; r = t.next_row(r))
+     */
+    int first_row() const { return _M_next_valid(0); }
+
+    int next_row(int __row) const { return _M_next_valid(__row + 1); }
+
+    template<class F>
+    void for_each_row(F __f) const
+    {
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            for (uint64_t __bits = m_valid[__w]; __bits != 0; __bits &= __bits - 1)
+                __f(__w * 64 + _M_ctz(__bits));
+        }
+    }
+
+    template<int I>
+    typename column_type<I>::type &get(int __row) { return column<I>()[__row]; }
+
+    template<int I>
+    const typename column_type<I>::type &get(int __row) const { return column<I>()[__row]; }
+
+    /**
+     * @brief 整列的数组, 长度为MAX_ROWS, 无效行的值没有意义
+     */
+    template<int I>
+    typename column_type<I>::type *column() { return _NFShmColumnGet<I, _ColumnList>::get(&m_columns); }
+
+    template<int I>
+    const typename column_type<I>::type *column() const { return _NFShmColumnGet<I, _ColumnList>::get(&m_columns); }
+
+    /**
+     * @brief 有效行位图, 第r行有效 <=> (valid_bitmap()[r / 64] >> (r % 64)) & 1
+     */
+    const uint64_t *valid_bitmap() const { return m_valid; }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), _ColumnList::ROW_BYTES, m_size, MAX_ROWS); }
+
+    /**
+     * @brief 检查位图和m_size, m_freeHint是否一致
+     */
+    bool verify() const
+    {
+        int __count = 0;
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            __count += _M_popcount(m_valid[__w]);
+            CHECK_EXPR(__w >= m_freeHint || m_valid[__w] == ~0ull, false, "NFShmColumnTable verify failed, word:{} before free hint:{} not full", __w, m_freeHint);
+        }
+        CHECK_EXPR(__count == m_size, false, "NFShmColumnTable verify failed, bitmap count:{} != size:{}", __count, m_size);
+        CHECK_EXPR((MAX_ROWS & 63) == 0 || (m_valid[WORD_COUNT - 1] >> (MAX_ROWS & 63)) == 0, false, "NFShmColumnTable verify failed, rows beyond MAX_ROWS:{} marked valid", MAX_ROWS);
+        return true;
+    }
+
+public:
+    /**
+     * @brief 第I列所有有效行的和
+     */
+    template<int I>
+    typename NFShmColumnSumType<typename column_type<I>::type>::type sum() const
+    {
+        typedef typename column_type<I>::type T;
+        typedef typename NFShmColumnSumType<T>::type S;
+        const T *__col = column<I>();
+        S __acc = 0;
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            uint64_t __bits = m_valid[__w];
+            if (__bits == 0)
+                continue;
+            const T *__v = __col + __w * 64;
+            if (__bits == ~0ull)
+            {
+                for (int i = 0; i < 64; ++i)
+                    __acc += (S) __v[i];
+            }
+            else if (std::is_integral<T>::value && _M_mostly_valid(__w, __bits))
+            {
+                // 整数按模2^64累加是精确的: 先连续加完64行, 再减掉少数无效行(它们的值可能是任意的)
+                uint64_t __part = 0;
+                for (int i = 0; i < 64; ++i)
+                    __part += (uint64_t) __v[i];
+                for (uint64_t __hole = ~__bits; __hole != 0; __hole &= __hole - 1)
+                    __part -= (uint64_t) __v[_M_ctz(__hole)];
+                __acc += (S) (int64_t) __part;
+            }
+            else
+            {
+                int __n = _M_word_rows(__w);
+                for (int i = 0; i < __n; ++i)
+                    __acc += ((__bits >> i) & 1) ? (S) __v[i] : (S) 0;
+            }
+        }
+        return __acc;
+    }
+
+    /**
+     * @brief 第I列有效行的最小值, 没有有效行时返回false
+     */
+    template<int I>
+    bool min_value(typename column_type<I>::type &__out) const
+    {
+        return _M_reduce<I>(__out, std::numeric_limits<typename column_type<I>::type>::max(), _MinOp());
+    }
+
+    template<int I>
+    bool max_value(typename column_type<I>::type &__out) const
+    {
+        return _M_reduce<I>(__out, std::numeric_limits<typename column_type<I>::type>::lowest(), _MaxOp());
+    }
+
+    /**
+     * @brief 第I列满足__pred的有效行数
+     */
+    template<int I, class Pred>
+    size_t count_where(Pred __pred) const
+    {
+        typedef typename column_type<I>::type T;
+        const T *__col = column<I>();
+        size_t __count = 0;
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            uint64_t __bits = m_valid[__w];
+            if (__bits == 0)
+                continue;
+            const T *__v = __col + __w * 64;
+            int __n = _M_word_rows(__w);
+            if (__bits == ~0ull)
+            {
+                for (int i = 0; i < 64; ++i)
+                    __count += __pred(__v[i]) ? 1 : 0;
+            }
+            else if (_M_mostly_valid(__w, __bits))
+            {
+                for (int i = 0; i < 64; ++i)
+                    __count += __pred(__v[i]) ? 1 : 0;
+                for (uint64_t __hole = ~__bits; __hole != 0; __hole &= __hole - 1)
+                    __count -= __pred(__v[_M_ctz(__hole)]) ? 1 : 0;
+            }
+            else
+            {
+                for (int i = 0; i < __n; ++i)
+                    __count += (__pred(__v[i]) ? 1 : 0) & (int) ((__bits >> i) & 1);
+            }
+        }
+        return __count;
+    }
+
+    /**
+     * @brief 第J列满足__pred的有效行, 第I列的和. 比如 sum_where<COL_GOLD, COL_LEVEL>([](int lv) { return lv >= 50; })
+     */
+    template<int I, int J, class Pred>
+    typename NFShmColumnSumType<typename column_type<I>::type>::type sum_where(Pred __pred) const
+    {
+        typedef typename column_type<I>::type T;
+        typedef typename column_type<J>::type U;
+        typedef typename NFShmColumnSumType<T>::type S;
+        const T *__col = column<I>();
+        const U *__key = column<J>();
+        S __acc = 0;
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            uint64_t __bits = m_valid[__w];
+            if (__bits == 0)
+                continue;
+            const T *__v = __col + __w * 64;
+            const U *__k = __key + __w * 64;
+            int __n = _M_word_rows(__w);
+            for (int i = 0; i < __n; ++i)
+                __acc += (__pred(__k[i]) && ((__bits >> i) & 1)) ? (S) __v[i] : (S) 0;
+        }
+        return __acc;
+    }
+
+    /**
+     * @brief 第I列满足__pred的有效行号, 按行号从小到大追加到__rows.
+     * 每64行先算出满足条件的掩码, 再和有效位图与, 最后逐位取出
+     */
+    template<int I, class Pred>
+    size_t filter(Pred __pred, std::vector<int> &__rows) const
+    {
+        typedef typename column_type<I>::type T;
+        const T *__col = column<I>();
+        size_t __old = __rows.size();
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            uint64_t __bits = m_valid[__w];
+            if (__bits == 0)
+                continue;
+            const T *__v = __col + __w * 64;
+            int __n = _M_word_rows(__w);
+            uint64_t __match = 0;
+            for (int i = 0; i < __n; ++i)
+                __match |= (uint64_t) (__pred(__v[i]) ? 1 : 0) << i;
+            for (__match &= __bits; __match != 0; __match &= __match - 1)
+                __rows.push_back(__w * 64 + _M_ctz(__match));
+        }
+        return __rows.size() - __old;
+    }
+
+private:
+    struct _MinOp
+    {
+        template<class T>
+        T operator()(T __a, T __b) const { return __b < __a ? __b : __a; }
+    };
+
+    struct _MaxOp
+    {
+        template<class T>
+        T operator()(T __a, T __b) const { return __a < __b ? __b : __a; }
+    };
+
+    template<int I, class Op>
+    bool _M_reduce(typename column_type<I>::type &__out, typename column_type<I>::type __init, Op __op) const
+    {
+        typedef typename column_type<I>::type T;
+        if (m_size == 0)
+            return false;
+        const T *__col = column<I>();
+        T __acc = __init;
+        for (int __w = 0; __w < WORD_COUNT; ++__w)
+        {
+            uint64_t __bits = m_valid[__w];
+            if (__bits == 0)
+                continue;
+            const T *__v = __col + __w * 64;
+            if (__bits == ~0ull)
+            {
+                for (int i = 0; i < 64; ++i)
+                    __acc = __op(__acc, __v[i]);
+                continue;
+            }
+            if (_M_mostly_valid(__w, __bits))
+            {
+                // 先连续扫完64行, 只有某个无效行的值正好等于结果时它才可能影响结果, 这时才退回逐行掩码
+                T __part = __init;
+                for (int i = 0; i < 64; ++i)
+                    __part = __op(__part, __v[i]);
+                bool __hit = false;
+                for (uint64_t __hole = ~__bits; __hole != 0; __hole &= __hole - 1)
+                    __hit |= __v[_M_ctz(__hole)] == __part;
+                if (!__hit)
+                {
+                    __acc = __op(__acc, __part);
+                    continue;
+                }
+            }
+            {
+                int __n = _M_word_rows(__w);
+                for (int i = 0; i < __n; ++i)
+                    __acc = __op(__acc, ((__bits >> i) & 1) ? __v[i] : __init);
+            }
+        }
+        __out = __acc;
+        return true;
+    }
+
+    /**
+     * @brief 满64行的字里有效行不少于3/4时, 连续扫完整个字再扣掉无效行, 比逐行取掩码快
+     */
+    static bool _M_mostly_valid(int __w, uint64_t __bits) { return _M_word_rows(__w) == 64 && _M_popcount(__bits) >= 48; }
+
+    static int _M_popcount(uint64_t __v)
+    {
+#if defined(_MSC_VER)
+        return (int) __popcnt64(__v);
+#else
+        return __builtin_popcountll(__v);
+#endif
+    }
+
+    /**
+     * @brief 第__w个字对应的行数, 只有最后一个字可能不满64
+     */
+    static int _M_word_rows(int __w) { return __w == WORD_COUNT - 1 && (MAX_ROWS & 63) ? (MAX_ROWS & 63) : 64; }
+
+    int _M_next_valid(int __row) const
+    {
+        if (__row >= MAX_ROWS)
+            return -1;
+        int __w = __row >> 6;
+        uint64_t __bits = m_valid[__w] & (~0ull << (__row & 63));
+        while (__bits == 0)
+        {
+            if (++__w >= WORD_COUNT)
+                return -1;
+            __bits = m_valid[__w];
+        }
+        return __w * 64 + _M_ctz(__bits);
+    }
+
+    static int _M_ctz(uint64_t __v)
+    {
+#if defined(_MSC_VER)
+        unsigned long __i;
+        _BitScanForward64(&__i, __v);
+        return (int) __i;
+#else
+        return __builtin_ctzll(__v);
+#endif
+    }
+
+    _ColumnList m_columns;
+    uint64_t m_valid[WORD_COUNT];
+    int m_size;
+    int m_freeHint;     //!<第一个可能有空闲行的字, 之前的字都是满的
+};
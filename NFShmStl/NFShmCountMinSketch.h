@@ -0,0 +1,336 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmCountMinSketch.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmCountMinSketch
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Count-Min Sketch, 固定大小的近似计数器, 放在共享内存里, 代替会在MAX_SIZE处溢出的NFShmHashMap计数.
+ * DEPTH行, 每行WIDTH个uint32计数器, 每个key在每行落一个计数器, 估计值取DEPTH个计数器的最小值.
+ * 估计值只会偏大: 至少以 1 - e^(-DEPTH) 的概率, 估计值 <= 真实值 + e / WIDTH * total(), 见error_bound().
+ * 比如WIDTH=2720, DEPTH=5(约53KB), 误差不超过总数的0.1%的概率大于99.3%.
+ *
+ * 两种更新方式:
+ * add: 保守更新(conservative update), 只把小于 最小值+c 的计数器抬到 最小值+c, 误差比普通更新小很多,
+ *      但"读最小值再写"不是原子的, 只能由一个写进程调用(或外部加锁).
+ * add_atomic: 普通更新, 每行原子加c, 多个进程可以同时调用.
+ * 同一个sketch只用其中一种: add的普通写会覆盖并发add_atomic的加法, 使估计值偏小.
+ *
+ * TOPK > 0 时记录估计值最大的TOPK个key(heavy hitters), 每次更新后用新的估计值刷新.
+ * 刷新用共享内存里的一个try-lock保护, add_atomic抢不到锁时跳过这次刷新, 不会阻塞, 热点key下次更新时还会进来.
+ * Key必须是可以直接按字节拷贝的类型(整数, 定长id等).
+ *
+ * 用法:
+ * NFShmCountMinSketch<uint64_t, 4096, 4, 16> m_itemSold;
+ * m_itemSold.add_atomic(itemId, count);
+ * std::vector<std::pair<uint64_t, uint64_t> > top; m_itemSold.top_k(top);
+ */
+template<class Key, int WIDTH, int DEPTH = 4, int TOPK = 0, class HashFcn = std::hash<Key> >
+class NFShmCountMinSketch
+{
+public:
+    static_assert(WIDTH > 0 && DEPTH > 0 && TOPK >= 0, "NFShmCountMinSketch bad size");
+    static_assert(std::is_trivially_copyable<Key>::value, "NFShmCountMinSketch Key must be trivially copyable");
+
+    typedef Key key_type;
+    typedef HashFcn hasher;
+
+    NFShmCountMinSketch()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        clear();
+        m_topLock = 0;
+        return 0;
+    }
+
+    /**
+     * @brief 计数器都是POD, 只需要放掉崩溃前可能没释放的top-K锁
+     */
+    int ResumeInit()
+    {
+        m_topLock = 0;
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 保守更新, 只能单写
+     * @return 更新后的估计值
+     */
+    uint32_t add(const Key &__key, uint32_t __c = 1)
+    {
+        uint32_t __idx[DEPTH];
+        _M_index(__key, __idx);
+        uint32_t __min = m_table[0][__idx[0]];
+        for (int i = 1; i < DEPTH; ++i)
+        {
+            if (m_table[i][__idx[i]] < __min)
+                __min = m_table[i][__idx[i]];
+        }
+        uint32_t __target = _M_sat_add(__min, __c);
+        for (int i = 0; i < DEPTH; ++i)
+        {
+            if (m_table[i][__idx[i]] < __target)
+                m_table[i][__idx[i]] = __target;
+        }
+        m_total += __c;
+        if (TOPK > 0)
+        {
+            _M_update_top(__key, __target);
+        }
+        return __target;
+    }
+
+    /**
+     * @brief 原子更新, 多进程安全, 计数器饱和前(2^32)不会回绕
+     * @return 更新后的估计值
+     */
+    uint32_t add_atomic(const Key &__key, uint32_t __c = 1)
+    {
+        uint32_t __idx[DEPTH];
+        _M_index(__key, __idx);
+        uint32_t __est = UINT32_MAX;
+        for (int i = 0; i < DEPTH; ++i)
+        {
+            uint32_t __v = _M_atomic_add(&m_table[i][__idx[i]], __c);
+            if (__v < __est)
+                __est = __v;
+        }
+        _M_atomic_add64(&m_total, __c);
+        if (TOPK > 0 && _M_try_lock())
+        {
+            _M_update_top(__key, __est);
+            _M_unlock();
+        }
+        return __est;
+    }
+
+    /**
+     * @brief 估计值, 不小于真实值
+     */
+    uint32_t estimate(const Key &__key) const
+    {
+        uint32_t __idx[DEPTH];
+        _M_index(__key, __idx);
+        uint32_t __min = m_table[0][__idx[0]];
+        for (int i = 1; i < DEPTH; ++i)
+        {
+            if (m_table[i][__idx[i]] < __min)
+                __min = m_table[i][__idx[i]];
+        }
+        return __min;
+    }
+
+    /**
+     * @brief 所有add的c之和
+     */
+    uint64_t total() const { return m_total; }
+
+    /**
+     * @brief 单个key估计值的误差上界 e / WIDTH * total(), 超过这个误差的概率不大于 e^(-DEPTH)
+     */
+    double error_bound() const { return 2.718281828459045 / (double) WIDTH * (double) m_total; }
+
+    static double error_probability() { return exp(-(double) DEPTH); }
+
+    /**
+     * @brief 按当前估计值从大到小输出top-K
+     */
+    void top_k(std::vector<std::pair<Key, uint64_t> > &__out) const
+    {
+        __out.clear();
+        for (int i = 0; i < m_topSize; ++i)
+        {
+            __out.push_back(std::make_pair(m_top[i].m_key, (uint64_t) estimate(m_top[i].m_key)));
+        }
+        std::sort(__out.begin(), __out.end(), [](const std::pair<Key, uint64_t> &__a, const std::pair<Key, uint64_t> &__b) { return __a.second > __b.second; });
+    }
+
+    /**
+     * @brief 把另一个同样大小的sketch加进来(比如各个进程各自统计, 定时汇总), 两边都不能有并发写
+     */
+    void merge(const NFShmCountMinSketch &__x)
+    {
+        for (int i = 0; i < DEPTH; ++i)
+        {
+            for (int j = 0; j < WIDTH; ++j)
+            {
+                m_table[i][j] = _M_sat_add(m_table[i][j], __x.m_table[i][j]);
+            }
+        }
+        m_total += __x.m_total;
+        for (int i = 0; i < m_topSize; ++i)
+        {
+            m_top[i].m_count = estimate(m_top[i].m_key);
+        }
+        _M_reset_top_min();
+        for (int i = 0; i < __x.m_topSize; ++i)
+        {
+            _M_update_top(__x.m_top[i].m_key, estimate(__x.m_top[i].m_key));
+        }
+    }
+
+    void clear()
+    {
+        memset(m_table, 0, sizeof(m_table));
+        memset(m_top, 0, sizeof(m_top));
+        m_total = 0;
+        m_topSize = 0;
+        m_topMin = 0;
+    }
+
+    static int width() { return WIDTH; }
+
+    static int depth() { return DEPTH; }
+
+    NFShmMemoryStats memory_stats() const
+    {
+        return NFShmMakeMemoryStats(sizeof(*this), sizeof(uint32_t) * DEPTH, WIDTH, WIDTH);
+    }
+
+private:
+    /**
+     * @brief 一次混合得到两个32位hash, 第i行用 h1 + i * h2 (Kirsch-Mitzenmacher), 再用乘法映射到[0, WIDTH)
+     */
+    static void _M_index(const Key &__key, uint32_t *__idx)
+    {
+        uint64_t __h = _NFShmHashFmix64((uint64_t) hasher()(__key));
+        uint32_t __h1 = (uint32_t) __h;
+        uint32_t __h2 = (uint32_t) (__h >> 32) | 1;
+        for (int i = 0; i < DEPTH; ++i)
+        {
+            __idx[i] = (uint32_t) (((uint64_t) (__h1 + (uint32_t) i * __h2) * (uint64_t) WIDTH) >> 32);
+        }
+    }
+
+    /**
+     * @brief 刷新top-K, 调用者保证只有一个线程在执行.
+     * 表满且估计值不超过表中最小值时直接返回: 这时key即使在表里, 记录的值也不会更小
+     */
+    void _M_update_top(const Key &__key, uint64_t __est)
+    {
+        if (m_topSize == TOPK && __est <= m_topMin)
+        {
+            return;
+        }
+        int __minPos = 0;
+        for (int i = 0; i < m_topSize; ++i)
+        {
+            if (memcmp(&m_top[i].m_key, &__key, sizeof(Key)) == 0)
+            {
+                if (__est > m_top[i].m_count)
+                {
+                    m_top[i].m_count = __est;
+                    _M_reset_top_min();
+                }
+                return;
+            }
+            if (m_top[i].m_count < m_top[__minPos].m_count)
+                __minPos = i;
+        }
+        if (m_topSize < TOPK)
+        {
+            __minPos = m_topSize++;
+        }
+        memcpy(&m_top[__minPos].m_key, &__key, sizeof(Key));
+        m_top[__minPos].m_count = __est;
+        _M_reset_top_min();
+    }
+
+    void _M_reset_top_min()
+    {
+        if (m_topSize < TOPK)
+        {
+            m_topMin = 0;
+            return;
+        }
+        m_topMin = m_top[0].m_count;
+        for (int i = 1; i < m_topSize; ++i)
+        {
+            if (m_top[i].m_count < m_topMin)
+                m_topMin = m_top[i].m_count;
+        }
+    }
+
+    static uint32_t _M_sat_add(uint32_t __a, uint32_t __b) { return __a > UINT32_MAX - __b ? UINT32_MAX : __a + __b; }
+
+    static uint32_t _M_atomic_add(uint32_t *__p, uint32_t __c)
+    {
+#if defined(_MSC_VER)
+        return (uint32_t) _InterlockedExchangeAdd((volatile long *) __p, (long) __c) + __c;
+#else
+        return __atomic_add_fetch(__p, __c, __ATOMIC_RELAXED);
+#endif
+    }
+
+    static void _M_atomic_add64(uint64_t *__p, uint64_t __c)
+    {
+#if defined(_MSC_VER)
+        _InterlockedExchangeAdd64((volatile long long *) __p, (long long) __c);
+#else
+        __atomic_add_fetch(__p, __c, __ATOMIC_RELAXED);
+#endif
+    }
+
+    bool _M_try_lock()
+    {
+#if defined(_MSC_VER)
+        return _InterlockedExchange((volatile long *) &m_topLock, 1) == 0;
+#else
+        return __atomic_exchange_n(&m_topLock, 1u, __ATOMIC_ACQUIRE) == 0;
+#endif
+    }
+
+    void _M_unlock()
+    {
+#if defined(_MSC_VER)
+        _InterlockedExchange((volatile long *) &m_topLock, 0);
+#else
+        __atomic_store_n(&m_topLock, 0u, __ATOMIC_RELEASE);
+#endif
+    }
+
+    struct _TopItem
+    {
+        Key m_key;
+        uint64_t m_count;
+    };
+
+    uint32_t m_table[DEPTH][WIDTH];
+    uint64_t m_total;
+    _TopItem m_top[TOPK > 0 ? TOPK : 1];
+    uint64_t m_topMin;
+    int m_topSize;
+    uint32_t m_topLock;
+};
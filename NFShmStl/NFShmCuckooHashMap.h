@@ -0,0 +1,657 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmCuckooHashMap.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmCuckooHashMap
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmPair.h"
+#include <iterator>
+#include <utility>
+#include <functional>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define NFSHM_CUCKOO_SLOTS 4            //!<每个桶的槽位数
+#define NFSHM_CUCKOO_BFS_DEPTH 5        //!<插入时BFS搜索的最大踢出次数
+#define NFSHM_CUCKOO_BFS_QUEUE 512      //!<BFS队列的大小, 2个起点每层最多扩展4倍, 深度5时约为2*(4^5-1)/3
+
+/**
+ * @brief 不支持并发读, 默认策略, 桶里没有版本号
+ */
+struct NFShmCuckooNoVersion
+{
+    struct version_type
+    {
+    };
+
+    static const bool enabled = false;
+
+    static void write_begin(version_type *) {}
+
+    static void write_end(version_type *) {}
+
+    static uint32_t read_begin(const version_type *) { return 0; }
+
+    static bool read_retry(const version_type *, uint32_t) { return false; }
+};
+
+/**
+ * @brief 每个桶一个版本号(seqlock), 允许一个写进程和多个读进程同时访问.
+ * 写之前版本号加1(变成奇数), 写完再加1. 读进程用find_copy, 读前后两个桶的版本号都没变才算读成功, 否则重读.
+ * 写进程之间仍然需要外部互斥.
+ */
+struct NFShmCuckooVersioned
+{
+    struct version_type
+    {
+        uint32_t m_version;
+    };
+
+    static const bool enabled = true;
+
+    static void write_begin(version_type *__v)
+    {
+#if defined(_MSC_VER)
+        _InterlockedIncrement((volatile long *) &__v->m_version);
+#else
+        __atomic_store_n(&__v->m_version, __v->m_version + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+#endif
+    }
+
+    static void write_end(version_type *__v)
+    {
+#if defined(_MSC_VER)
+        _InterlockedIncrement((volatile long *) &__v->m_version);
+#else
+        __atomic_store_n(&__v->m_version, __v->m_version + 1, __ATOMIC_RELEASE);
+#endif
+    }
+
+    /**
+     * @brief 等到桶没有在写, 返回当前版本号
+     */
+    static uint32_t read_begin(const version_type *__v)
+    {
+        while (true)
+        {
+#if defined(_MSC_VER)
+            uint32_t __ver = (uint32_t) _InterlockedOr((volatile long *) &__v->m_version, 0);
+#else
+            uint32_t __ver = __atomic_load_n(&__v->m_version, __ATOMIC_ACQUIRE);
+#endif
+            if ((__ver & 1) == 0)
+                return __ver;
+        }
+    }
+
+    /**
+     * @brief 读完之后检查版本号是否变化, 变化了需要重读
+     */
+    static bool read_retry(const version_type *__v, uint32_t __ver)
+    {
+#if defined(_MSC_VER)
+        return (uint32_t) _InterlockedOr((volatile long *) &__v->m_version, 0) != __ver;
+#else
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&__v->m_version, __ATOMIC_RELAXED) != __ver;
+#endif
+    }
+};
+
+/**
+ * @brief 一个桶: 4个槽位的指纹和元素放在一起, 查找一个桶只访问连续的一段内存
+ */
+template<class Value, class VersionPolicy>
+struct NFShmCuckooBucket : public VersionPolicy::version_type
+{
+    uint8_t m_tag[NFSHM_CUCKOO_SLOTS]; //!<槽位中元素hash值的8位指纹, 0表示空槽
+    alignas(Value) int8_t m_mem[sizeof(Value) * NFSHM_CUCKOO_SLOTS];
+
+    Value *slot(int __s) { return reinterpret_cast<Value *>(m_mem) + __s; }
+
+    const Value *slot(int __s) const { return reinterpret_cast<const Value *>(m_mem) + __s; }
+};
+
+template<class Value, class Ref, class Ptr, class Container>
+struct NFShmCuckooHashMapIterator
+{
+    typedef NFShmCuckooHashMapIterator<Value, Value &, Value *, Container> iterator;
+    typedef NFShmCuckooHashMapIterator<Value, const Value &, const Value *, Container> const_iterator;
+    typedef NFShmCuckooHashMapIterator<Value, Ref, Ptr, Container> _Self;
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    Container *m_pContainer;
+    int m_pos; //!<桶下标 * NFSHM_CUCKOO_SLOTS + 槽位
+
+    NFShmCuckooHashMapIterator(const Container *pContainer, int iPos) : m_pContainer(const_cast<Container *>(pContainer)), m_pos(iPos) {}
+
+    NFShmCuckooHashMapIterator() : m_pContainer(NULL), m_pos(0) {}
+
+    NFShmCuckooHashMapIterator(const iterator &__it) : m_pContainer(__it.m_pContainer), m_pos(__it.m_pos) {}
+
+    reference operator*() const { return *m_pContainer->_M_slot(m_pos); }
+
+    pointer operator->() const { return &(operator*()); }
+
+    _Self &operator++()
+    {
+        m_pos = m_pContainer->_M_next_used(m_pos + 1);
+        return *this;
+    }
+
+    _Self operator++(int)
+    {
+        _Self __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    bool operator==(const _Self &__it) const { return m_pos == __it.m_pos; }
+
+    bool operator!=(const _Self &__it) const { return m_pos != __it.m_pos; }
+};
+
+/**
+ * @brief 分桶的cuckoo哈希表, 每个桶4个槽位, 每个key只可能在两个桶中, 查找最多访问两个桶, 没有长链.
+ * 适合对查找延迟有硬性要求的场景(比如按连接ID路由消息), 即使std::hash比较弱, 最坏情况也只是比较8个槽位.
+ *
+ * - 两个桶由hash值分别用两个不同的乘数打散后映射得到, 每个槽位保存8位指纹, 指纹相同才比较key;
+ * - 插入时两个桶都满了, 用BFS找一条最短的踢出路径(最多NFSHM_CUCKOO_BFS_DEPTH步), 从路径末端往回移动元素;
+ * - 桶的个数约为MAX_SIZE * 1.06 / 4, 接近满时可能找不到踢出路径, insert返回(end(), false), 调用者需要处理插入失败;
+ * - VersionPolicy为NFShmCuckooVersioned时每个桶有版本号, 读进程可以在写进程修改时用find_copy无锁读取.
+ *
+ * 注意插入时会移动其他元素, 插入和删除都会使迭代器和元素的引用失效.
+ */
+template<class Key, class Tp, int MAX_SIZE, class HashFcn = std::hash<Key>, class EqualKey = std::equal_to<Key>, class VersionPolicy = NFShmCuckooNoVersion>
+class NFShmCuckooHashMap
+{
+public:
+    typedef Key key_type;
+    typedef Tp data_type;
+    typedef Tp mapped_type;
+    typedef NFShmPair<Key, Tp> value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy> _Self;
+    typedef NFShmCuckooHashMapIterator<value_type, value_type &, value_type *, _Self> iterator;
+    typedef NFShmCuckooHashMapIterator<value_type, const value_type &, const value_type *, _Self> const_iterator;
+    typedef NFShmCuckooBucket<value_type, VersionPolicy> _Bucket;
+
+    friend struct NFShmCuckooHashMapIterator<value_type, value_type &, value_type *, _Self>;
+    friend struct NFShmCuckooHashMapIterator<value_type, const value_type &, const value_type *, _Self>;
+
+    static_assert(MAX_SIZE > 0, "NFShmCuckooHashMap MAX_SIZE must be positive");
+
+    static const int BUCKET_COUNT = (MAX_SIZE + MAX_SIZE / 16 + NFSHM_CUCKOO_SLOTS - 1) / NFSHM_CUCKOO_SLOTS + 1;
+    static const int SLOT_COUNT = BUCKET_COUNT * NFSHM_CUCKOO_SLOTS;
+
+public:
+    NFShmCuckooHashMap()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    NFShmCuckooHashMap(const NFShmCuckooHashMap &__x)
+    {
+        CreateInit();
+        insert(__x.begin(), __x.end());
+    }
+
+    ~NFShmCuckooHashMap()
+    {
+        clear();
+    }
+
+    int CreateInit()
+    {
+#if NF_SHM_ZERO_ON_CREATE
+        memset(m_buckets, 0, sizeof(m_buckets));
+#endif
+        for (int i = 0; i < BUCKET_COUNT; ++i)
+        {
+            memset(m_buckets[i].m_tag, 0, sizeof(m_buckets[i].m_tag));
+            if (VersionPolicy::enabled)
+                memset(static_cast<typename VersionPolicy::version_type *>(&m_buckets[i]), 0, sizeof(typename VersionPolicy::version_type));
+        }
+        m_size = 0;
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (NFShmResumeConstruct<value_type>::value)
+        {
+            for (int i = 0; i < SLOT_COUNT; ++i)
+            {
+                if (_M_tag(i) != 0)
+                {
+                    std::_Construct(_M_slot(i));
+                }
+            }
+        }
+        return 0;
+    }
+
+    NFShmCuckooHashMap &operator=(const NFShmCuckooHashMap &__x)
+    {
+        if (this != &__x)
+        {
+            clear();
+            insert(__x.begin(), __x.end());
+        }
+        return *this;
+    }
+
+public:
+    size_type size() const { return m_size; }
+
+    size_type max_size() const { return MAX_SIZE; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_SIZE; }
+
+    size_t left_size() const { return MAX_SIZE - m_size; }
+
+    size_type bucket_count() const { return BUCKET_COUNT; }
+
+    /**
+     * @brief 槽位的使用率
+     */
+    double load_factor() const { return (double) m_size / (double) SLOT_COUNT; }
+
+    iterator begin() { return iterator(this, _M_next_used(0)); }
+
+    iterator end() { return iterator(this, SLOT_COUNT); }
+
+    const_iterator begin() const { return const_iterator(this, _M_next_used(0)); }
+
+    const_iterator end() const { return const_iterator(this, SLOT_COUNT); }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 为了降低插入失败率多分配的槽位算作额外开销
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(value_type), m_size, MAX_SIZE); }
+
+public:
+    /**
+     * @brief 插入, key已存在时不修改, 返回已有的元素
+     * @return 元素个数达到MAX_SIZE或者找不到踢出路径时返回(end(), false)
+     */
+    std::pair<iterator, bool> insert(const value_type &__obj);
+
+    std::pair<iterator, bool> emplace(const key_type &__key, const data_type &__data) { return insert(value_type(__key, __data)); }
+
+    template<class _InputIterator>
+    void insert(_InputIterator __f, _InputIterator __l)
+    {
+        for (; __f != __l; ++__f)
+        {
+            insert(*__f);
+        }
+    }
+
+    iterator find(const key_type &__key) { return iterator(this, _M_find_pos(__key)); }
+
+    const_iterator find(const key_type &__key) const { return const_iterator(this, _M_find_pos(__key)); }
+
+    size_type count(const key_type &__key) const { return _M_find_pos(__key) != SLOT_COUNT ? 1 : 0; }
+
+    /**
+     * @brief 读进程使用的查找, 把value拷贝出来. VersionPolicy为NFShmCuckooVersioned时可以和一个写进程并发,
+     * 读的过程中桶被修改会自动重读. Key和Tp需要能安全地读取一个正在被修改的对象(一般是POD).
+     */
+    bool find_copy(const key_type &__key, Tp &__out) const;
+
+    Tp &operator[](const key_type &__key)
+    {
+        std::pair<iterator, bool> __ret = insert(value_type(__key, Tp()));
+        NF_ASSERT(__ret.first != end());
+        return __ret.first->second;
+    }
+
+    size_type erase(const key_type &__key)
+    {
+        int __pos = _M_find_pos(__key);
+        if (__pos == SLOT_COUNT)
+            return 0;
+        _M_erase_pos(__pos);
+        return 1;
+    }
+
+    /**
+     * @brief 删除迭代器指向的元素, 不移动其他元素
+     * @return 下一个元素
+     */
+    iterator erase(iterator __it)
+    {
+        if (__it.m_pos >= 0 && __it.m_pos < SLOT_COUNT && _M_tag(__it.m_pos) != 0)
+        {
+            _M_erase_pos(__it.m_pos);
+            return iterator(this, _M_next_used(__it.m_pos + 1));
+        }
+        return end();
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < SLOT_COUNT; ++i)
+        {
+            if (_M_tag(i) != 0)
+            {
+                std::_Destroy(_M_slot(i));
+            }
+        }
+        for (int i = 0; i < BUCKET_COUNT; ++i)
+        {
+            VersionPolicy::write_begin(&m_buckets[i]);
+            memset(m_buckets[i].m_tag, 0, sizeof(m_buckets[i].m_tag));
+            VersionPolicy::write_end(&m_buckets[i]);
+        }
+        m_size = 0;
+    }
+
+    /**
+     * @brief 检查每个元素都在自己的两个桶之一中, 并且指纹正确, 用于共享内存恢复后的检查
+     */
+    bool verify() const;
+
+protected:
+    uint8_t &_M_tag(int __pos) { return m_buckets[__pos / NFSHM_CUCKOO_SLOTS].m_tag[__pos % NFSHM_CUCKOO_SLOTS]; }
+
+    uint8_t _M_tag(int __pos) const { return m_buckets[__pos / NFSHM_CUCKOO_SLOTS].m_tag[__pos % NFSHM_CUCKOO_SLOTS]; }
+
+    value_type *_M_slot(int __pos) { return m_buckets[__pos / NFSHM_CUCKOO_SLOTS].slot(__pos % NFSHM_CUCKOO_SLOTS); }
+
+    const value_type *_M_slot(int __pos) const { return m_buckets[__pos / NFSHM_CUCKOO_SLOTS].slot(__pos % NFSHM_CUCKOO_SLOTS); }
+
+    int _M_next_used(int __pos) const
+    {
+        while (__pos < SLOT_COUNT && _M_tag(__pos) == 0)
+            ++__pos;
+        return __pos;
+    }
+
+    /**
+     * @brief 由key计算两个桶和指纹, 两个桶一定不同
+     */
+    static void _M_hash(const key_type &__key, int &__b1, int &__b2, uint8_t &__tag)
+    {
+        uint64_t __h = (uint64_t) hasher()(__key);
+        uint64_t __h1 = __h * 0x9E3779B97F4A7C15ull;
+        uint64_t __h2 = (__h ^ (__h >> 29)) * 0xBF58476D1CE4E5B9ull;
+        __b1 = (int) (((__h1 >> 32) * (uint64_t) BUCKET_COUNT) >> 32);
+        __b2 = (int) (((__h2 >> 32) * (uint64_t) BUCKET_COUNT) >> 32);
+        if (__b2 == __b1)
+            __b2 = __b1 + 1 == BUCKET_COUNT ? 0 : __b1 + 1;
+        __tag = (uint8_t) (__h1 >> 24);
+        if (__tag == 0)
+            __tag = 1;
+    }
+
+    int _M_find_in_bucket(int __b, uint8_t __tag, const key_type &__key) const
+    {
+        const _Bucket &__bucket = m_buckets[__b];
+        for (int __s = 0; __s < NFSHM_CUCKOO_SLOTS; ++__s)
+        {
+            if (__bucket.m_tag[__s] == __tag && key_equal()(__bucket.slot(__s)->first, __key))
+                return __b * NFSHM_CUCKOO_SLOTS + __s;
+        }
+        return SLOT_COUNT;
+    }
+
+    int _M_find_pos(const key_type &__key) const
+    {
+        int __b1, __b2;
+        uint8_t __tag;
+        _M_hash(__key, __b1, __b2, __tag);
+        int __pos = _M_find_in_bucket(__b1, __tag, __key);
+        if (__pos != SLOT_COUNT)
+            return __pos;
+        return _M_find_in_bucket(__b2, __tag, __key);
+    }
+
+    static int _M_empty_slot(const _Bucket &__bucket)
+    {
+        for (int __s = 0; __s < NFSHM_CUCKOO_SLOTS; ++__s)
+        {
+            if (__bucket.m_tag[__s] == 0)
+                return __s;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief BFS队列中的一项, 表示把父节点桶中m_slot槽位的元素踢到m_bucket
+     */
+    struct _BfsEntry
+    {
+        int m_bucket;
+        int m_parent;
+        int m_slot;
+        int m_depth;
+    };
+
+    /**
+     * @brief 在__b1或__b2中腾出一个空槽
+     * @return 空槽的位置, 失败返回SLOT_COUNT
+     */
+    int _M_make_room(int __b1, int __b2);
+
+    void _M_erase_pos(int __pos);
+
+protected:
+    _Bucket m_buckets[BUCKET_COUNT];
+    int m_size;
+};
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class VersionPolicy>
+std::pair<typename NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::iterator, bool>
+NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::insert(const value_type &__obj)
+{
+    int __b1, __b2;
+    uint8_t __tag;
+    _M_hash(__obj.first, __b1, __b2, __tag);
+    int __pos = _M_find_in_bucket(__b1, __tag, __obj.first);
+    if (__pos == SLOT_COUNT)
+        __pos = _M_find_in_bucket(__b2, __tag, __obj.first);
+    if (__pos != SLOT_COUNT)
+        return std::pair<iterator, bool>(iterator(this, __pos), false);
+
+    if (m_size >= MAX_SIZE)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmCuckooHashMap No Enough Space! MAX_SIZE:{}", MAX_SIZE);
+        return std::pair<iterator, bool>(end(), false);
+    }
+
+    __pos = _M_make_room(__b1, __b2);
+    if (__pos == SLOT_COUNT)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmCuckooHashMap insert failed, no cuckoo path, size:{} MAX_SIZE:{}", m_size, MAX_SIZE);
+        return std::pair<iterator, bool>(end(), false);
+    }
+
+    _Bucket &__bucket = m_buckets[__pos / NFSHM_CUCKOO_SLOTS];
+    VersionPolicy::write_begin(&__bucket);
+    std::_Construct(_M_slot(__pos), __obj);
+    _M_tag(__pos) = __tag;
+    VersionPolicy::write_end(&__bucket);
+    ++m_size;
+    return std::pair<iterator, bool>(iterator(this, __pos), true);
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class VersionPolicy>
+int NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::_M_make_room(int __b1, int __b2)
+{
+    int __s = _M_empty_slot(m_buckets[__b1]);
+    if (__s >= 0)
+        return __b1 * NFSHM_CUCKOO_SLOTS + __s;
+    __s = _M_empty_slot(m_buckets[__b2]);
+    if (__s >= 0)
+        return __b2 * NFSHM_CUCKOO_SLOTS + __s;
+
+    _BfsEntry __queue[NFSHM_CUCKOO_BFS_QUEUE];
+    __queue[0].m_bucket = __b1;
+    __queue[0].m_parent = -1;
+    __queue[0].m_slot = -1;
+    __queue[0].m_depth = 0;
+    __queue[1].m_bucket = __b2;
+    __queue[1].m_parent = -1;
+    __queue[1].m_slot = -1;
+    __queue[1].m_depth = 0;
+
+    int __tail = 2;
+    int __found = -1;
+    int __emptySlot = -1;
+    for (int __head = 0; __head < __tail && __found < 0; ++__head)
+    {
+        const _BfsEntry &__e = __queue[__head];
+        if (__e.m_depth >= NFSHM_CUCKOO_BFS_DEPTH)
+            continue;
+        const _Bucket &__bucket = m_buckets[__e.m_bucket];
+        for (int __k = 0; __k < NFSHM_CUCKOO_SLOTS && __tail < NFSHM_CUCKOO_BFS_QUEUE; ++__k)
+        {
+            int __x1, __x2;
+            uint8_t __tag;
+            _M_hash(__bucket.slot(__k)->first, __x1, __x2, __tag);
+            int __alt = __x1 == __e.m_bucket ? __x2 : __x1;
+
+            _BfsEntry &__child = __queue[__tail++];
+            __child.m_bucket = __alt;
+            __child.m_parent = __head;
+            __child.m_slot = __k;
+            __child.m_depth = __e.m_depth + 1;
+
+            __emptySlot = _M_empty_slot(m_buckets[__alt]);
+            if (__emptySlot >= 0)
+            {
+                __found = __tail - 1;
+                break;
+            }
+        }
+    }
+    if (__found < 0)
+        return SLOT_COUNT;
+
+    // 从路径末端往回, 每次把父桶中的元素移到子桶的空槽, 父桶中腾出的槽位就是下一步的空槽.
+    // 路径上同一个桶出现两次时, 前面的移动可能已经换掉了要踢的元素, 这时检查到元素不属于目标桶就放弃
+    int __idx = __found;
+    while (__queue[__idx].m_parent >= 0)
+    {
+        const _BfsEntry &__e = __queue[__idx];
+        int __from = __queue[__e.m_parent].m_bucket;
+        _Bucket &__src = m_buckets[__from];
+        _Bucket &__dst = m_buckets[__e.m_bucket];
+
+        int __x1, __x2;
+        uint8_t __tag;
+        _M_hash(__src.slot(__e.m_slot)->first, __x1, __x2, __tag);
+        if ((__x1 != __e.m_bucket && __x2 != __e.m_bucket) || __src.m_tag[__e.m_slot] == 0 || __dst.m_tag[__emptySlot] != 0)
+            return SLOT_COUNT;
+
+        // 先写入新位置再从旧位置删除, 读进程检查两个桶的版本号, 不会漏读
+        VersionPolicy::write_begin(&__dst);
+        std::_Construct(__dst.slot(__emptySlot), std::move(*__src.slot(__e.m_slot)));
+        __dst.m_tag[__emptySlot] = __tag;
+        VersionPolicy::write_end(&__dst);
+
+        VersionPolicy::write_begin(&__src);
+        std::_Destroy(__src.slot(__e.m_slot));
+        __src.m_tag[__e.m_slot] = 0;
+        VersionPolicy::write_end(&__src);
+
+        __emptySlot = __e.m_slot;
+        __idx = __e.m_parent;
+    }
+    return __queue[__idx].m_bucket * NFSHM_CUCKOO_SLOTS + __emptySlot;
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class VersionPolicy>
+void NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::_M_erase_pos(int __pos)
+{
+    _Bucket &__bucket = m_buckets[__pos / NFSHM_CUCKOO_SLOTS];
+    VersionPolicy::write_begin(&__bucket);
+    std::_Destroy(_M_slot(__pos));
+    _M_tag(__pos) = 0;
+    VersionPolicy::write_end(&__bucket);
+    --m_size;
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class VersionPolicy>
+bool NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::find_copy(const key_type &__key, Tp &__out) const
+{
+    int __b1, __b2;
+    uint8_t __tag;
+    _M_hash(__key, __b1, __b2, __tag);
+    const _Bucket &__bucket1 = m_buckets[__b1];
+    const _Bucket &__bucket2 = m_buckets[__b2];
+    while (true)
+    {
+        uint32_t __v1 = VersionPolicy::read_begin(&__bucket1);
+        uint32_t __v2 = VersionPolicy::read_begin(&__bucket2);
+        bool __found = false;
+        int __pos = _M_find_in_bucket(__b1, __tag, __key);
+        if (__pos == SLOT_COUNT)
+            __pos = _M_find_in_bucket(__b2, __tag, __key);
+        if (__pos != SLOT_COUNT)
+        {
+            __out = _M_slot(__pos)->second;
+            __found = true;
+        }
+        if (!VersionPolicy::read_retry(&__bucket1, __v1) && !VersionPolicy::read_retry(&__bucket2, __v2))
+            return __found;
+    }
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class VersionPolicy>
+bool NFShmCuckooHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, VersionPolicy>::verify() const
+{
+    int __count = 0;
+    for (int i = 0; i < SLOT_COUNT; ++i)
+    {
+        if (_M_tag(i) == 0)
+            continue;
+        ++__count;
+        int __b1, __b2;
+        uint8_t __tag;
+        _M_hash(_M_slot(i)->first, __b1, __b2, __tag);
+        int __b = i / NFSHM_CUCKOO_SLOTS;
+        CHECK_EXPR(__b == __b1 || __b == __b2, false, "NFShmCuckooHashMap verify failed, slot:{} in wrong bucket, b1:{} b2:{}", i, __b1, __b2);
+        CHECK_EXPR(__tag == _M_tag(i), false, "NFShmCuckooHashMap verify failed, slot:{} tag:{} real:{}", i, _M_tag(i), __tag);
+    }
+    CHECK_EXPR(__count == m_size, false, "NFShmCuckooHashMap verify failed, used slots:{} size:{}", __count, m_size);
+    return true;
+}
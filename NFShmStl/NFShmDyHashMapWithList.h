@@ -14,15 +14,16 @@
 
 template<class Key, class Tp,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashMapWithList;
 
-template<class Key, class Tp, class HashFcn, class EqualKey>
+template<class Key, class Tp, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmDyHashMapWithList
 {
 private:
     typedef NFShmDyHashTableWithList<NFShmPair<Key, Tp>, Key, HashFcn,
-            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -70,14 +71,14 @@ public:
         return 0;
     }
 
-    static size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
         return _Ht::CountSize(iObjectCount);
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
-        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm);
+        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm, iAdvise);
     }
 
 public:
@@ -122,6 +123,16 @@ public:
     const NFShmDyList<int>& get_list() const { return m_hashTable.get_list(); }
 
     void debug_string() { m_hashTable.debug_string(); }
+
+    bool verify() const { return m_hashTable.verify(); }
+
+    NFShmHashTableStats stats() const { return m_hashTable.stats(); }
+
+    void reset_stats() { m_hashTable.reset_stats(); }
+
+    std::string profile_report(const char *__name) const { return m_hashTable.profile_report(__name); }
+
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
 public:
     std::pair<iterator, bool> insert(const value_type &__obj) { return m_hashTable.insert_unique(__obj); }
     std::pair<iterator, bool> emplace(const key_type&__key, const data_type& __data) { return m_hashTable.insert_unique(MakePair(__key, __data)); }
@@ -157,6 +168,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     iterator erase(iterator __it) { return m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -174,15 +207,16 @@ public:
 
 template<class Key, class Tp,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashMultiMapWithList;
 
-template<class Key, class Tp, class HashFcn, class EqualKey>
+template<class Key, class Tp, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmDyHashMultiMapWithList
 {
 private:
     typedef NFShmDyHashTableWithList<NFShmPair<const Key, Tp>, Key, HashFcn,
-            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -234,14 +268,14 @@ public:
         return 0;
     }
 
-    size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
-        return m_hashTable.CountSize(iObjectCount);
+        return _Ht::CountSize(iObjectCount);
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
-        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm);
+        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm, iAdvise);
     }
 public:
     size_type size() const { return m_hashTable.size(); }
@@ -264,6 +298,8 @@ public:
 
     size_t left_size() const { return m_hashTable.left_size(); }
 
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     bool is_get_list() const { return m_hashTable.is_get_list(); }
     void set_get_list(bool flag) { m_hashTable.set_get_list(flag); }
 
@@ -311,6 +347,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     void erase(iterator __it) { m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
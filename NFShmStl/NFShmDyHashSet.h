@@ -11,11 +11,11 @@
 
 #include "NFShmDyHashTable.h"
 
-template<class Value, class HashFcn, class EqualKey>
+template<class Value, class HashFcn, class EqualKey, class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashSet
 {
 private:
-    typedef NFShmDyHashTable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey> _Ht;
+    typedef NFShmDyHashTable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -61,14 +61,14 @@ public:
         return 0;
     }
 
-    size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
-        return m_hashTable.CountSize(iObjectCount);
+        return _Ht::CountSize(iObjectCount);
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
-        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm);
+        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm, iAdvise);
     }
 
 public:
@@ -89,6 +89,16 @@ public:
     size_t left_size() const { return m_hashTable.left_size(); }
 
     void debug_string() { m_hashTable.debug_string(); }
+
+    bool verify() const { return m_hashTable.verify(); }
+
+    NFShmHashTableStats stats() const { return m_hashTable.stats(); }
+
+    void reset_stats() { m_hashTable.reset_stats(); }
+
+    std::string profile_report(const char *__name) const { return m_hashTable.profile_report(__name); }
+
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
 public:
     pair<iterator, bool> insert(const value_type &__obj)
     {
@@ -121,6 +131,21 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    pair<iterator, iterator> equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     iterator erase(iterator __it) { return m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -137,11 +162,11 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class Value, class HashFcn, class EqualKey>
+template<class Value, class HashFcn, class EqualKey, class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashMultiSet
 {
 private:
-    typedef NFShmDyHashTable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey> _Ht;
+    typedef NFShmDyHashTable<Value, Value, HashFcn, std::_Identity<Value>, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -189,20 +214,22 @@ public:
         return 0;
     }
 
-    size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
-        return m_hashTable.CountSize(iObjectCount);
+        return _Ht::CountSize(iObjectCount);
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
-        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm);
+        return m_hashTable.Init(pBuffer, bufSize, iObjectCount, bResetShm, iAdvise);
     }
 public:
     size_type size() const { return m_hashTable.size(); }
 
     size_type max_size() const { return m_hashTable.max_size(); }
 
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     bool empty() const { return m_hashTable.empty(); }
 
     void swap(NFShmDyHashMultiSet &hs) { m_hashTable.swap(hs.m_hashTable); }
@@ -234,6 +261,21 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    pair<iterator, iterator> equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     void erase(iterator __it) { m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -13,6 +13,7 @@
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFComm/NFPluginModule/NFCheck.h"
 #include "NFShmVector.h"
+#include "NFShmHashTableStats.h"
 #include <iterator>
 #include <algorithm>
 #include <vector>
@@ -62,29 +63,38 @@ struct NFShmDyHashTableNode
     size_t m_self;
 };
 
+/**
+ * @brief 节点数组不在容器层逐个重新构造, 由哈希表恢复时只对有效节点处理, 见_M_resume_values
+ */
+template<class Val>
+struct NFShmResumeConstruct<NFShmDyHashTableNode<Val> >
+{
+    static const bool value = false;
+};
+
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashTable;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableIterator;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableConstIterator;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableIterator
 {
-    typedef NFShmDyHashTable<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTable<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmDyHashTableIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmDyHashTableConstIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmDyHashTableNode<Val> _Node;
 
@@ -118,16 +128,16 @@ struct NFShmDyHashTableIterator
 
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableConstIterator
 {
-    typedef NFShmDyHashTable<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTable<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmDyHashTableIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmDyHashTableConstIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmDyHashTableNode<Val> _Node;
 
@@ -163,7 +173,7 @@ struct NFShmDyHashTableConstIterator
 };
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 class NFShmDyHashTable
 {
 public:
@@ -223,16 +233,17 @@ private:
     size_t* m_pMaxSize;
     NFShmDyVector<_Node> m_buckets;
     NFShmDyVector<int> m_bucketsFirstIdx;
+    typename StatsPolicy::counter_type *m_pStatsCounter; //!<统计计数, 在buffer末尾, 不统计时为NULL
 public:
-    typedef NFShmDyHashTableIterator<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             iterator;
-    typedef NFShmDyHashTableConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
 
     friend struct
-            NFShmDyHashTableIterator<Val, Key, HashFcn, ExtractKey, EqualKey>;
+            NFShmDyHashTableIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
     friend struct
-            NFShmDyHashTableConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey>;
+            NFShmDyHashTableConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
 
 public:
     NFShmDyHashTable()
@@ -262,6 +273,7 @@ public:
         m_pFirstFreeIdx = NULL;
         m_pNumElements = NULL;
         m_pMaxSize = NULL;
+        m_pStatsCounter = NULL;
         return 0;
     }
 
@@ -271,28 +283,33 @@ public:
         m_pFirstFreeIdx = NULL;
         m_pNumElements = NULL;
         m_pMaxSize = NULL;
+        m_pStatsCounter = NULL;
         return 0;
     }
 
     /**
     * 计算所用内存的大小
     */
-    size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
         //    int *m_pFirstFreeIdx; //!<空闲链表头节点
         //    size_t *m_pNumElements;
         //    size_t* m_pMaxSize;
         //NFShmDyVector<_Node> m_buckets;
         //NFShmDyVector<int> m_bucketsFirstIdx;
-        return sizeof(int) + sizeof(size_type) + sizeof(size_t) + m_buckets.CountSize(iObjectCount) + m_bucketsFirstIdx.CountSize(iObjectCount);
+        return sizeof(int) + sizeof(size_type) + sizeof(size_t) + NFShmDyVector<_Node>::CountSize(iObjectCount) + NFShmDyVector<int>::CountSize(iObjectCount) + NFShmHashTableStatsSize<StatsPolicy>::value;
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
         CHECK_NULL(pBuffer);
         CHECK_EXPR(iObjectCount >= 0, -1, "iObjectCount:{}",iObjectCount);
         int iCountSize = CountSize(iObjectCount);
         NF_ASSERT_MSG(bufSize >= iCountSize, "bufSize:{} iCountSize:{}", bufSize, iCountSize);
+        if (iAdvise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(pBuffer, bufSize, iAdvise);
+        }
 
         m_pBuffer = (char*)pBuffer;
         m_pFirstFreeIdx = (int*)pBuffer;
@@ -300,7 +317,9 @@ public:
         m_pMaxSize = (size_t*)(pBuffer+sizeof(int)+sizeof(size_type));
         if (bResetShm)
         {
+#if NF_SHM_ZERO_ON_CREATE
             memset((void*)pBuffer, 0, bufSize);
+#endif
             *m_pFirstFreeIdx = 0;
             *m_pNumElements = 0;
             *m_pMaxSize = iObjectCount;
@@ -316,15 +335,40 @@ public:
         size_t bucketsFirstIdxSize = m_bucketsFirstIdx.CountSize(iObjectCount);
         m_buckets.Init(pBucketsBuffer, bucketsSize, iObjectCount, bResetShm);
         m_bucketsFirstIdx.Init(pBucketsFirstIDxBuffer, bucketsFirstIdxSize, iObjectCount, bResetShm);
+        m_pStatsCounter = StatsPolicy::enabled ? (typename StatsPolicy::counter_type *) (pBucketsFirstIDxBuffer + bucketsFirstIdxSize) : NULL;
 
         if (bResetShm)
         {
+            StatsPolicy::reset(m_pStatsCounter);
             _M_initialize_buckets();
         }
+        else
+        {
+            _M_resume_values();
+        }
 
         return 0;
     }
 
+    /**
+     * @brief 恢复时只对桶链上的有效节点重新构造m_value, 空闲节点在插入时才会构造, 不需要遍历整个节点数组.
+     * 没有已用链表, 只能扫描桶的下标数组(每个桶4字节), 找齐size()个节点后就停
+     */
+    void _M_resume_values()
+    {
+        if (!NFShmResumeConstruct<Val>::value)
+            return;
+
+        size_type __left = size();
+        for (size_type __n = 0; __left > 0 && __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            for (_Node *__cur = get_node(m_bucketsFirstIdx[__n]); __cur && __left > 0; __cur = get_node(__cur->m_next), --__left)
+            {
+                std::_Construct(&__cur->m_value);
+            }
+        }
+    }
+
     size_type size() const { return *m_pNumElements; }
 
     size_type max_size() const { return *m_pMaxSize; }
@@ -335,6 +379,16 @@ public:
 
     size_t left_size() const { return size() >= *m_pMaxSize ? 0 : *m_pMaxSize - size(); }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, m_totalBytes是buffer中用到的字节数, 没有Init时全为0
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        if (m_pBuffer == NULL)
+            return NFShmMakeMemoryStats(0, 0, 0, 0);
+        return NFShmMakeMemoryStats(CountSize(*m_pMaxSize), sizeof(value_type), size(), *m_pMaxSize);
+    }
+
     _Node *get_node(int idx)
     {
         if (idx >= 0 && idx < (int) m_buckets.size())
@@ -528,59 +582,44 @@ public:
 
     reference find_or_insert(const value_type &__obj);
 
-    iterator find(const key_type &__key)
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    iterator find(const key_type &__key) { return _M_find(__key); }
 
-        _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    const_iterator find(const key_type &__key) const { return _M_find(__key); }
 
-        return iterator(__first, this);
-    }
+    size_type count(const key_type &__key) const { return _M_count(__key); }
 
-    const_iterator find(const key_type &__key) const
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    std::pair<iterator, iterator>
+    equal_range(const key_type &__key) { return _M_equal_range(__key); }
 
-        const _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type &__key) const { return _M_equal_range(__key); }
 
-        return const_iterator(__first, this);
-    }
+    size_type erase(const key_type &__key) { return _M_erase_key(__key); }
 
-    size_type count(const key_type &__key) const
-    {
-        const size_type __n = _M_bkt_num_key(__key);
-        size_type __result = 0;
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    /**
+     * @brief 异构查找, HashFcn和EqualKey都定义了is_transparent时才启用.
+     * __key不需要是key_type, 只要能被HashFcn求hash, 并且能和key_type用EqualKey比较(EqualKey(key, __key)),
+     * 同时相同内容的hash值要和对应key_type的hash值一致. 比如用std::string_view, const char*查找NFShmString的key.
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    iterator find(const _Kt &__key) { return _M_find(__key); }
 
-        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
-        {
-            if (m_equals(m_get_key(__cur->m_value), __key))
-            {
-                ++__result;
-            }
-        }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    const_iterator find(const _Kt &__key) const { return _M_find(__key); }
 
-        return __result;
-    }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type count(const _Kt &__key) const { return _M_count(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<iterator, iterator>
-    equal_range(const key_type &__key);
+    equal_range(const _Kt &__key) { return _M_equal_range(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<const_iterator, const_iterator>
-    equal_range(const key_type &__key) const;
+    equal_range(const _Kt &__key) const { return _M_equal_range(__key); }
 
-    size_type erase(const key_type &__key);
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type erase(const _Kt &__key) { return _M_erase_key(__key); }
 
     iterator erase(const iterator &__it);
 
@@ -594,6 +633,75 @@ public:
 
     void clear();
 
+    /**
+     * @brief 检查内部结构是否完整, 用于进程崩溃后ResumeInit或者多进程压测结束时校验共享内存中的数据
+     * 每个桶链表中的节点都有效且hash到这个桶, 元素个数和size()一致, 空闲链表和有效节点正好覆盖所有节点.
+     * 遍历所有节点, 只用于调试和校验, 不要在正常逻辑中调用.
+     * @return 结构完整返回true, 否则打印第一个错误并返回false
+     */
+    bool verify() const
+    {
+        size_type __max = m_buckets.size();
+        size_type __count = 0;
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            for (int __idx = m_bucketsFirstIdx[__n]; __idx != -1;)
+            {
+                const _Node *__cur = get_node(__idx);
+                CHECK_EXPR(__cur && __cur->m_valid && __cur->m_self == (size_t) __idx, false, "NFShmDyHashTable verify failed, bucket:{} invalid node:{}", __n, __idx);
+                CHECK_EXPR(_M_bkt_num(__cur->m_value) == __n, false, "NFShmDyHashTable verify failed, node:{} in wrong bucket:{}", __idx, __n);
+                CHECK_EXPR(++__count <= __max, false, "NFShmDyHashTable verify failed, bucket:{} has a loop", __n);
+                __idx = __cur->m_next;
+            }
+        }
+        CHECK_EXPR(__count == size(), false, "NFShmDyHashTable verify failed, nodes in buckets:{} size:{}", __count, size());
+
+        size_type __free = 0;
+        for (int __idx = *m_pFirstFreeIdx; __idx != -1;)
+        {
+            const _Node *__cur = get_node(__idx);
+            CHECK_EXPR(__cur && !__cur->m_valid, false, "NFShmDyHashTable verify failed, invalid free node:{}", __idx);
+            CHECK_EXPR(++__free <= __max, false, "NFShmDyHashTable verify failed, free list has a loop");
+            __idx = __cur->m_next;
+        }
+        CHECK_EXPR(__count + __free == __max, false, "NFShmDyHashTable verify failed, size:{} free:{} max:{}", __count, __free, __max);
+        return true;
+    }
+
+    /**
+     * @brief 统计链长分布, 最长链, 负载因子, 空桶比例, 再加上运行时计数(StatsPolicy为NFShmHashTableCountStats时).
+     * 只遍历桶和链, 不打日志, 可以在线上对大表调用
+     */
+    NFShmHashTableStats stats() const
+    {
+        NFShmHashTableStats __st;
+        memset(&__st, 0, sizeof(__st));
+        StatsPolicy::copy(_M_stats_counter(), &__st.m_counter);
+        __st.m_size = size();
+        __st.m_bucketCount = m_bucketsFirstIdx.size();
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            size_t __len = 0;
+            for (const _Node *__cur = get_node(m_bucketsFirstIdx[__n]); __cur && __len <= __st.m_size; __cur = get_node(__cur->m_next))
+            {
+                ++__len;
+            }
+            NFShmHashTableStatsAddChain(__st, __len);
+        }
+        NFShmHashTableStatsFinish(__st);
+        return __st;
+    }
+
+    /**
+     * @brief 运行时计数清零
+     */
+    void reset_stats() { StatsPolicy::reset(_M_stats_counter()); }
+
+    /**
+     * @brief 输出find/insert/erase的耗时分布(p50/p99/max), StatsPolicy不是NFShmHashTableProfileStats时返回空串
+     */
+    std::string profile_report(const char *__name) const { return StatsPolicy::report(__name, _M_stats_counter()); }
+
     void debug_string()
     {
         NFLogInfo(NF_LOG_SYSTEMLOG, 0, "----------------NFShmDyHashTable begin size:{} MAX_SIZE:{}----------------", size(),
@@ -672,7 +780,80 @@ private:
         }
     }
 
-    size_type _M_bkt_num_key(const key_type &__key) const
+    template<class _Kt>
+    iterator _M_find(const _Kt &__key)
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        return iterator(__first, this);
+    }
+
+    template<class _Kt>
+    const_iterator _M_find(const _Kt &__key) const
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        const _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        return const_iterator(__first, this);
+    }
+
+    template<class _Kt>
+    size_type _M_count(const _Kt &__key) const
+    {
+        const size_type __n = _M_bkt_num_key(__key);
+        size_type __result = 0;
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
+        {
+            if (m_equals(m_get_key(__cur->m_value), __key))
+            {
+                ++__result;
+            }
+        }
+
+        return __result;
+    }
+
+    template<class _Kt>
+    std::pair<iterator, iterator>
+    _M_equal_range(const _Kt &__key);
+
+    template<class _Kt>
+    std::pair<const_iterator, const_iterator>
+    _M_equal_range(const _Kt &__key) const;
+
+    template<class _Kt>
+    size_type _M_erase_key(const _Kt &__key);
+
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key) const
     {
         return _M_bkt_num_key(__key, m_bucketsFirstIdx.size());
     }
@@ -682,7 +863,8 @@ private:
         return _M_bkt_num_key(m_get_key(__obj));
     }
 
-    size_type _M_bkt_num_key(const key_type &__key, size_t __n) const
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key, size_t __n) const
     {
         return m_hash(__key) % __n;
     }
@@ -710,6 +892,7 @@ private:
             std::_Construct(&pNode->m_value, __obj);
         }
 
+        StatsPolicy::on_insert(_M_stats_counter(), pNode != NULL);
         return pNode;
     }
 
@@ -724,8 +907,11 @@ private:
         std::_Destroy(&__n->m_value);
 
         _M_put_node(__n);
+        StatsPolicy::on_erase(_M_stats_counter());
     }
 
+    typename StatsPolicy::counter_type *_M_stats_counter() const { return m_pStatsCounter; }
+
     void _M_erase_bucket(const size_type __n, _Node *__first, _Node *__last);
 
     void _M_erase_bucket(const size_type __n, _Node *__last);
@@ -734,9 +920,9 @@ private:
 
 };
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK> &
-NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &
+NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -750,18 +936,18 @@ NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK>
-NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St>
+NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK> &
-NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &
+NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -775,60 +961,60 @@ NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK>
-NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>
+NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     const_iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+value_type(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmDyHashTableIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+value_type(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmDyHashTableConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmDyHashTable<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _Extract, class _EqKey>
-inline void swap(NFShmDyHashTable<_Val, _Key, _HF, _Extract, _EqKey> &__ht1,
-                 NFShmDyHashTable<_Val, _Key, _HF, _Extract, _EqKey> &__ht2)
+template<class _Val, class _Key, class _HF, class _Extract, class _EqKey, class _St>
+inline void swap(NFShmDyHashTable<_Val, _Key, _HF, _Extract, _EqKey, _St> &__ht1,
+                 NFShmDyHashTable<_Val, _Key, _HF, _Extract, _EqKey, _St> &__ht2)
 {
     __ht1.swap(__ht2);
 }
@@ -849,11 +1035,12 @@ inline void swap(NFShmDyHashTable<_Val, _Key, _HF, _Extract, _EqKey> &__ht1,
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator, bool>
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator, bool>
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::insert_unique_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -892,11 +1079,12 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::insert_equal_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     //已经没有可用的节点了
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
@@ -944,10 +1132,11 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::reference
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::find_or_insert(const value_type &__obj)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::reference
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::find_or_insert(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -968,10 +1157,11 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::find_or_insert(const value_type &__
     return __tmp->m_value;
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator,
-        typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator>
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::equal_range(const key_type &__key)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator,
+        typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator>
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::_M_equal_range(const _Kt &__key)
 {
     typedef std::pair<iterator, iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
@@ -1002,22 +1192,23 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::equal_range(const key_type &__key)
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::const_iterator,
-        typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::const_iterator>
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
-::equal_range(const key_type &__key) const
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator,
+        typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator>
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
+::_M_equal_range(const _Kt &__key) const
 {
     typedef std::pair<const_iterator, const_iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
     int iFirstIndex = m_bucketsFirstIdx[__n];
-    for (_Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+    for (const _Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
     {
         if (m_equals(m_get_key(__first->m_value), __key))
         {
-            for (_Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
+            for (const _Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
             {
                 if (!m_equals(m_get_key(__cur->m_value), __key))
                 {
@@ -1037,10 +1228,12 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::size_type
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const key_type &__key)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::size_type
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::_M_erase_key(const _Kt &__key)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
     int iFirstIndex = m_bucketsFirstIdx[__n];
@@ -1076,9 +1269,10 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const key_type &__key)
     return __erased;
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const iterator &__it)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const iterator &__it)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     _Node *__p = __it.m_curNode;
     if (__p)
     {
@@ -1119,8 +1313,8 @@ typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::iterator NFShmDyHashTable<
     return iterator(nullptr, this);
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::erase(iterator __first, iterator __last)
 {
     size_type __f_bucket = __first.m_curNode ?
@@ -1142,9 +1336,9 @@ void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
 inline void
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const_iterator __first,
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const_iterator __first,
                                                            const_iterator __last)
 {
     erase(iterator(const_cast<_Node *>(__first.m_curNode),
@@ -1153,9 +1347,9 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const_iterator __first,
                    const_cast<NFShmDyHashTable *>(__last.m_hashTable)));
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-inline typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::const_iterator
-NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const const_iterator &__it)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+inline typename NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator
+NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const const_iterator &__it)
 {
     return erase(iterator(const_cast<_Node *>(__it.m_curNode),
                    const_cast<NFShmDyHashTable *>(__it.m_hashTable)));
@@ -1171,15 +1365,15 @@ NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::erase(const const_iterator &__it)
  * @tparam _Eq
  * @param __num_elements_hint
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::resize(size_type __num_elements_hint)
 {
 
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__first, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1201,8 +1395,8 @@ void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1216,8 +1410,8 @@ void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq>::clear()
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTable<_Val, _Key, _HF, _Ex, _Eq, _St>::clear()
 {
     m_buckets.clear();
     m_bucketsFirstIdx.clear();
@@ -13,6 +13,7 @@
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFComm/NFPluginModule/NFCheck.h"
 #include "NFShmVector.h"
+#include "NFShmHashTableStats.h"
 #include "NFShmList.h"
 #include <iterator>
 #include <algorithm>
@@ -65,29 +66,38 @@ struct NFShmDyHashTableWithListNode
     int m_list_pos;
 };
 
+/**
+ * @brief 节点数组不在容器层逐个重新构造, 由哈希表恢复时只对有效节点处理, 见_M_resume_values
+ */
+template<class Val>
+struct NFShmResumeConstruct<NFShmDyHashTableWithListNode<Val> >
+{
+    static const bool value = false;
+};
+
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy = NFShmHashTableNoStats>
 class NFShmDyHashTableWithList;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableWithListIterator;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableWithListConstIterator;
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableWithListIterator
 {
-    typedef NFShmDyHashTableWithList<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableWithList<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmDyHashTableWithListIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmDyHashTableWithListNode<Val> _Node;
 
@@ -121,16 +131,16 @@ struct NFShmDyHashTableWithListIterator
 
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmDyHashTableWithListConstIterator
 {
-    typedef NFShmDyHashTableWithList<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableWithList<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmDyHashTableWithListIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmDyHashTableWithListNode<Val> _Node;
 
@@ -166,7 +176,7 @@ struct NFShmDyHashTableWithListConstIterator
 };
 
 template<class Val, class Key, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 class NFShmDyHashTableWithList
 {
 public:
@@ -229,16 +239,17 @@ private:
     NFShmDyVector<int> m_bucketsFirstIdx;
     NFShmDyList<int> m_bucketsListIdx;
 
+    typename StatsPolicy::counter_type *m_pStatsCounter; //!<统计计数, 在buffer末尾, 不统计时为NULL
 public:
-    typedef NFShmDyHashTableWithListIterator<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableWithListIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             iterator;
-    typedef NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
 
     friend struct
-            NFShmDyHashTableWithListIterator<Val, Key, HashFcn, ExtractKey, EqualKey>;
+            NFShmDyHashTableWithListIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
     friend struct
-            NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey>;
+            NFShmDyHashTableWithListConstIterator<Val, Key, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
 
 public:
     NFShmDyHashTableWithList()
@@ -269,6 +280,7 @@ public:
         m_pNumElements = NULL;
         m_pMaxSize = NULL;
         m_pGetList = NULL;
+        m_pStatsCounter = NULL;
         return 0;
     }
 
@@ -279,13 +291,14 @@ public:
         m_pNumElements = NULL;
         m_pMaxSize = NULL;
         m_pGetList = NULL;
+        m_pStatsCounter = NULL;
         return 0;
     }
 
     /**
     * 计算所用内存的大小
     */
-    static size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
         //    int *m_pFirstFreeIdx; //!<空闲链表头节点
         //    size_t *m_pNumElements;
@@ -294,15 +307,19 @@ public:
         //NFShmDyVector<_Node> m_buckets;
         //NFShmDyVector<int> m_bucketsFirstIdx;
         // NFShmDyList<int> m_bucketsListIdx;
-        return sizeof(int) + sizeof(size_type) + sizeof(size_t) + sizeof(bool) + NFShmDyVector<_Node>::CountSize(iObjectCount) + NFShmDyVector<int>::CountSize(iObjectCount) + NFShmDyList<int>::CountSize(iObjectCount);
+        return sizeof(int) + sizeof(size_type) + sizeof(size_t) + sizeof(bool) + NFShmDyVector<_Node>::CountSize(iObjectCount) + NFShmDyVector<int>::CountSize(iObjectCount) + NFShmDyList<int>::CountSize(iObjectCount) + NFShmHashTableStatsSize<StatsPolicy>::value;
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
         CHECK_NULL(pBuffer);
         CHECK_EXPR(iObjectCount >= 0, -1, "iObjectCount:{}",iObjectCount);
         int iCountSize = CountSize(iObjectCount);
         NF_ASSERT_MSG(bufSize >= iCountSize, "bufSize:{} iCountSize:{}", bufSize, iCountSize);
+        if (iAdvise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(pBuffer, bufSize, iAdvise);
+        }
 
         m_pBuffer = (char*)pBuffer;
         m_pFirstFreeIdx = (int*)pBuffer;
@@ -311,7 +328,9 @@ public:
         m_pGetList = (bool*)(pBuffer+sizeof(int)+sizeof(size_type)+sizeof(size_t));
         if (bResetShm)
         {
+#if NF_SHM_ZERO_ON_CREATE
             memset((void*)pBuffer, 0, bufSize);
+#endif
             *m_pFirstFreeIdx = 0;
             *m_pNumElements = 0;
             *m_pMaxSize = iObjectCount;
@@ -331,14 +350,39 @@ public:
         m_buckets.Init(pBucketsBuffer, bucketsSize, iObjectCount, bResetShm);
         m_bucketsFirstIdx.Init(pBucketsFirstIDxBuffer, bucketsFirstIdxSize, iObjectCount, bResetShm);
         m_bucketsListIdx.Init(pBucketsListIdxBuffer, bucketsListIdxSize, iObjectCount, bResetShm);
+        m_pStatsCounter = StatsPolicy::enabled ? (typename StatsPolicy::counter_type *) (pBucketsListIdxBuffer + bucketsListIdxSize) : NULL;
         if (bResetShm)
         {
+            StatsPolicy::reset(m_pStatsCounter);
             _M_initialize_buckets();
         }
+        else
+        {
+            _M_resume_values();
+        }
 
         return 0;
     }
 
+    /**
+     * @brief 恢复时沿m_bucketsListIdx(所有有效节点都在上面)对有效节点重新构造m_value, 只和元素个数有关,
+     * 空闲节点在插入时才会构造
+     */
+    void _M_resume_values()
+    {
+        if (!NFShmResumeConstruct<Val>::value)
+            return;
+
+        for (auto __it = m_bucketsListIdx.begin(); __it != m_bucketsListIdx.end(); ++__it)
+        {
+            _Node *__cur = get_node(*__it);
+            if (__cur)
+            {
+                std::_Construct(&__cur->m_value);
+            }
+        }
+    }
+
     size_type size() const { return *m_pNumElements; }
 
     size_type max_size() const { return *m_pMaxSize; }
@@ -349,6 +393,16 @@ public:
 
     size_t left_size() const { return size() >= *m_pMaxSize ? 0 : *m_pMaxSize - size(); }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, m_totalBytes是buffer中用到的字节数, 没有Init时全为0
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        if (m_pBuffer == NULL)
+            return NFShmMakeMemoryStats(0, 0, 0, 0);
+        return NFShmMakeMemoryStats(CountSize(*m_pMaxSize), sizeof(value_type), size(), *m_pMaxSize);
+    }
+
     bool is_get_list() const { return *m_pGetList; }
     void set_get_list(bool flag) { *m_pGetList = flag; }
 
@@ -566,69 +620,44 @@ public:
 
     reference find_or_insert(const value_type &__obj);
 
-    iterator find(const key_type &__key)
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    iterator find(const key_type &__key) { return _M_find(__key); }
 
-        _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    const_iterator find(const key_type &__key) const { return _M_find(__key); }
 
-        if (*m_pGetList && __first)
-        {
-            NF_ASSERT(*m_bucketsListIdx.GetIterator(__first->m_list_pos) == (int)__first->m_self);
-            m_bucketsListIdx.splice(m_bucketsListIdx.end(), m_bucketsListIdx.GetIterator(__first->m_list_pos));
-        }
-        return iterator(__first, this);
-    }
+    size_type count(const key_type &__key) const { return _M_count(__key); }
 
-    const_iterator find(const key_type &__key) const
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    std::pair<iterator, iterator>
+    equal_range(const key_type &__key) { return _M_equal_range(__key); }
 
-        const _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type &__key) const { return _M_equal_range(__key); }
 
-        if (*m_pGetList && __first)
-        {
-            NF_ASSERT(*m_bucketsListIdx.GetIterator(__first->m_list_pos) == (int)__first->m_self);
-            m_bucketsListIdx.splice(m_bucketsListIdx.end(), m_bucketsListIdx.GetIterator(__first->m_list_pos));
-        }
-        return const_iterator(__first, this);
-    }
+    size_type erase(const key_type &__key) { return _M_erase_key(__key); }
 
-    size_type count(const key_type &__key) const
-    {
-        const size_type __n = _M_bkt_num_key(__key);
-        size_type __result = 0;
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    /**
+     * @brief 异构查找, HashFcn和EqualKey都定义了is_transparent时才启用.
+     * __key不需要是key_type, 只要能被HashFcn求hash, 并且能和key_type用EqualKey比较(EqualKey(key, __key)),
+     * 同时相同内容的hash值要和对应key_type的hash值一致. 比如用std::string_view, const char*查找NFShmString的key.
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    iterator find(const _Kt &__key) { return _M_find(__key); }
 
-        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
-        {
-            if (m_equals(m_get_key(__cur->m_value), __key))
-            {
-                ++__result;
-            }
-        }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    const_iterator find(const _Kt &__key) const { return _M_find(__key); }
 
-        return __result;
-    }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type count(const _Kt &__key) const { return _M_count(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<iterator, iterator>
-    equal_range(const key_type &__key);
+    equal_range(const _Kt &__key) { return _M_equal_range(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<const_iterator, const_iterator>
-    equal_range(const key_type &__key) const;
+    equal_range(const _Kt &__key) const { return _M_equal_range(__key); }
 
-    size_type erase(const key_type &__key);
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type erase(const _Kt &__key) { return _M_erase_key(__key); }
 
     iterator erase(const iterator &__it);
 
@@ -642,6 +671,84 @@ public:
 
     void clear();
 
+    /**
+     * @brief 检查内部结构是否完整, 用于进程崩溃后ResumeInit或者多进程压测结束时校验共享内存中的数据
+     * 每个桶链表中的节点都有效且hash到这个桶, 元素个数和size()一致, 空闲链表和有效节点正好覆盖所有节点, 插入顺序链表和有效节点一一对应.
+     * 遍历所有节点, 只用于调试和校验, 不要在正常逻辑中调用.
+     * @return 结构完整返回true, 否则打印第一个错误并返回false
+     */
+    bool verify() const
+    {
+        size_type __max = m_buckets.size();
+        size_type __count = 0;
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            for (int __idx = m_bucketsFirstIdx[__n]; __idx != -1;)
+            {
+                const _Node *__cur = get_node(__idx);
+                CHECK_EXPR(__cur && __cur->m_valid && __cur->m_self == (size_t) __idx, false, "NFShmDyHashTableWithList verify failed, bucket:{} invalid node:{}", __n, __idx);
+                CHECK_EXPR(_M_bkt_num(__cur->m_value) == __n, false, "NFShmDyHashTableWithList verify failed, node:{} in wrong bucket:{}", __idx, __n);
+                CHECK_EXPR(++__count <= __max, false, "NFShmDyHashTableWithList verify failed, bucket:{} has a loop", __n);
+                __idx = __cur->m_next;
+            }
+        }
+        CHECK_EXPR(__count == size(), false, "NFShmDyHashTableWithList verify failed, nodes in buckets:{} size:{}", __count, size());
+
+        size_type __free = 0;
+        for (int __idx = *m_pFirstFreeIdx; __idx != -1;)
+        {
+            const _Node *__cur = get_node(__idx);
+            CHECK_EXPR(__cur && !__cur->m_valid, false, "NFShmDyHashTableWithList verify failed, invalid free node:{}", __idx);
+            CHECK_EXPR(++__free <= __max, false, "NFShmDyHashTableWithList verify failed, free list has a loop");
+            __idx = __cur->m_next;
+        }
+        CHECK_EXPR(__count + __free == __max, false, "NFShmDyHashTableWithList verify failed, size:{} free:{} max:{}", __count, __free, __max);
+
+        size_type __listCount = 0;
+        for (auto __it = m_bucketsListIdx.begin(); __it != m_bucketsListIdx.end(); ++__it)
+        {
+            const _Node *__cur = get_node(*__it);
+            CHECK_EXPR(__cur && __cur->m_valid && __cur->m_list_pos == (int) __it.m_node->m_self, false, "NFShmDyHashTableWithList verify failed, list node:{} bad node:{}", __it.m_node->m_self, *__it);
+            CHECK_EXPR(++__listCount <= __max, false, "NFShmDyHashTableWithList verify failed, list has a loop");
+        }
+        CHECK_EXPR(__listCount == size(), false, "NFShmDyHashTableWithList verify failed, list size:{} size:{}", __listCount, size());
+        return true;
+    }
+
+    /**
+     * @brief 统计链长分布, 最长链, 负载因子, 空桶比例, 再加上运行时计数(StatsPolicy为NFShmHashTableCountStats时).
+     * 只遍历桶和链, 不打日志, 可以在线上对大表调用
+     */
+    NFShmHashTableStats stats() const
+    {
+        NFShmHashTableStats __st;
+        memset(&__st, 0, sizeof(__st));
+        StatsPolicy::copy(_M_stats_counter(), &__st.m_counter);
+        __st.m_size = size();
+        __st.m_bucketCount = m_bucketsFirstIdx.size();
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            size_t __len = 0;
+            for (const _Node *__cur = get_node(m_bucketsFirstIdx[__n]); __cur && __len <= __st.m_size; __cur = get_node(__cur->m_next))
+            {
+                ++__len;
+            }
+            NFShmHashTableStatsAddChain(__st, __len);
+        }
+        NFShmHashTableStatsFinish(__st);
+        return __st;
+    }
+
+    /**
+     * @brief 运行时计数清零
+     */
+    void reset_stats() { StatsPolicy::reset(_M_stats_counter()); }
+
+    /**
+     * @brief 输出find/insert/erase的耗时分布(p50/p99/max), StatsPolicy不是NFShmHashTableProfileStats时返回空串
+     */
+    std::string profile_report(const char *__name) const { return StatsPolicy::report(__name, _M_stats_counter()); }
+
     void debug_string()
     {
         NFLogInfo(NF_LOG_SYSTEMLOG, 0, "----------------NFShmHashTable begin size:{} MAX_SIZE:{}----------------", size(),
@@ -720,7 +827,90 @@ private:
         }
     }
 
-    size_type _M_bkt_num_key(const key_type &__key) const
+    template<class _Kt>
+    iterator _M_find(const _Kt &__key)
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        if (*m_pGetList && __first)
+        {
+            NF_ASSERT(*m_bucketsListIdx.GetIterator(__first->m_list_pos) == (int)__first->m_self);
+            m_bucketsListIdx.splice(m_bucketsListIdx.end(), m_bucketsListIdx.GetIterator(__first->m_list_pos));
+        }
+        return iterator(__first, this);
+    }
+
+    template<class _Kt>
+    const_iterator _M_find(const _Kt &__key) const
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        const _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        if (*m_pGetList && __first)
+        {
+            NF_ASSERT(*m_bucketsListIdx.GetIterator(__first->m_list_pos) == (int)__first->m_self);
+            m_bucketsListIdx.splice(m_bucketsListIdx.end(), m_bucketsListIdx.GetIterator(__first->m_list_pos));
+        }
+        return const_iterator(__first, this);
+    }
+
+    template<class _Kt>
+    size_type _M_count(const _Kt &__key) const
+    {
+        const size_type __n = _M_bkt_num_key(__key);
+        size_type __result = 0;
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
+        {
+            if (m_equals(m_get_key(__cur->m_value), __key))
+            {
+                ++__result;
+            }
+        }
+
+        return __result;
+    }
+
+    template<class _Kt>
+    std::pair<iterator, iterator>
+    _M_equal_range(const _Kt &__key);
+
+    template<class _Kt>
+    std::pair<const_iterator, const_iterator>
+    _M_equal_range(const _Kt &__key) const;
+
+    template<class _Kt>
+    size_type _M_erase_key(const _Kt &__key);
+
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key) const
     {
         return _M_bkt_num_key(__key, m_bucketsFirstIdx.size());
     }
@@ -730,7 +920,8 @@ private:
         return _M_bkt_num_key(m_get_key(__obj));
     }
 
-    size_type _M_bkt_num_key(const key_type &__key, size_t __n) const
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key, size_t __n) const
     {
         return m_hash(__key) % __n;
     }
@@ -764,6 +955,7 @@ private:
             std::_Construct(&pNode->m_value, __obj);
         }
 
+        StatsPolicy::on_insert(_M_stats_counter(), pNode != NULL);
         return pNode;
     }
 
@@ -783,8 +975,11 @@ private:
         std::_Destroy(&__n->m_value);
 
         _M_put_node(__n);
+        StatsPolicy::on_erase(_M_stats_counter());
     }
 
+    typename StatsPolicy::counter_type *_M_stats_counter() const { return m_pStatsCounter; }
+
     void _M_erase_bucket(const size_type __n, _Node *__first, _Node *__last);
 
     void _M_erase_bucket(const size_type __n, _Node *__last);
@@ -793,9 +988,9 @@ private:
 
 };
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK> &
-NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &
+NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -809,18 +1004,18 @@ NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK>
-NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St>
+NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK> &
-NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &
+NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -834,55 +1029,55 @@ NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK>
-NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>
+NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     const_iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+value_type(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmDyHashTableWithListIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+value_type(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, class _HF, class _ExK, class _EqK>
-inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmDyHashTableWithList<_Val, _Key, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
 
@@ -901,11 +1096,12 @@ distance_type(const NFShmDyHashTableWithListConstIterator<_Val, _Key, _HF, _ExK,
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator, bool>
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator, bool>
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::insert_unique_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -944,11 +1140,12 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::insert_equal_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     //已经没有可用的节点了
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
@@ -996,10 +1193,11 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::reference
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::find_or_insert(const value_type &__obj)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::reference
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::find_or_insert(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -1025,10 +1223,11 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::find_or_insert(const value_
     return __tmp->m_value;
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator,
-        typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator>
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::equal_range(const key_type &__key)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator,
+        typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator>
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::_M_equal_range(const _Kt &__key)
 {
     typedef std::pair<iterator, iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
@@ -1071,18 +1270,19 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::equal_range(const key_type
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::const_iterator,
-        typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::const_iterator>
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
-::equal_range(const key_type &__key) const
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator,
+        typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator>
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
+::_M_equal_range(const _Kt &__key) const
 {
     typedef std::pair<const_iterator, const_iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
     int iFirstIndex = m_bucketsFirstIdx[__n];
-    for (_Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+    for (const _Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
     {
         if (m_equals(m_get_key(__first->m_value), __key))
         {
@@ -1092,7 +1292,7 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
                 m_bucketsListIdx.splice(m_bucketsListIdx.end(), m_bucketsListIdx.GetIterator(__first->m_list_pos));
             }
 
-            for (_Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
+            for (const _Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
             {
                 if (!m_equals(m_get_key(__cur->m_value), __key))
                 {
@@ -1118,10 +1318,12 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::size_type
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const key_type &__key)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::size_type
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::_M_erase_key(const _Kt &__key)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
     int iFirstIndex = m_bucketsFirstIdx[__n];
@@ -1157,9 +1359,10 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const key_type &__key
     return __erased;
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const iterator &__it)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::iterator NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const iterator &__it)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     _Node *__p = __it.m_curNode;
     if (__p)
     {
@@ -1200,8 +1403,8 @@ typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::iterator NFShmDyHa
     return iterator(nullptr, this);
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::erase(iterator __first, iterator __last)
 {
     size_type __f_bucket = __first.m_curNode ?
@@ -1223,9 +1426,9 @@ void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
 inline void
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const_iterator __first,
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const_iterator __first,
                                                                    const_iterator __last)
 {
     erase(iterator(const_cast<_Node *>(__first.m_curNode),
@@ -1234,9 +1437,9 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const_iterator __firs
                    const_cast<NFShmDyHashTableWithList *>(__last.m_hashTable)));
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::const_iterator
-NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const const_iterator &__it)
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+inline typename NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::const_iterator
+NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::erase(const const_iterator &__it)
 {
     return erase(iterator(const_cast<_Node *>(__it.m_curNode),
                    const_cast<NFShmDyHashTableWithList *>(__it.m_hashTable)));
@@ -1252,15 +1455,15 @@ NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::erase(const const_iterator
  * @tparam _Eq
  * @param __num_elements_hint
  */
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::resize(size_type __num_elements_hint)
 {
 
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__first, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1282,8 +1485,8 @@ void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1297,11 +1500,12 @@ void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, class _HF, class _Ex, class _Eq>
-void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq>::clear()
+template<class _Val, class _Key, class _HF, class _Ex, class _Eq, class _St>
+void NFShmDyHashTableWithList<_Val, _Key, _HF, _Ex, _Eq, _St>::clear()
 {
     m_buckets.clear();
     m_bucketsFirstIdx.clear();
+    m_bucketsListIdx.clear();
     _M_initialize_buckets();
 }
 
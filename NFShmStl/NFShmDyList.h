@@ -258,18 +258,22 @@ public:
     /**
     * 计算所用内存的大小
     */
-    static size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
         //size + maxSize + freeStart + sizeof(NFShmDyListNode<Tp>) * (iObjectCount + 1)
         return sizeof(size_t) + sizeof(size_t) + sizeof(ptrdiff_t) + sizeof(NFShmDyListNode<Tp>) * (iObjectCount+1);
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
         CHECK_NULL(pBuffer);
         CHECK_EXPR(iObjectCount >= 0, -1, "iObjectCount:{}",iObjectCount);
         int iCountSize = CountSize(iObjectCount);
         NF_ASSERT_MSG(bufSize >= iCountSize, "bufSize:{} iCountSize:{}", bufSize, iCountSize);
+        if (iAdvise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(pBuffer, bufSize, iAdvise);
+        }
 
         m_pBuffer = (char*)pBuffer;
         m_pSize = (size_t*)pBuffer;
@@ -279,7 +283,11 @@ public:
 
         if (bResetShm)
         {
+#if NF_SHM_ZERO_ON_CREATE
             memset((void*)pBuffer, 0, bufSize);
+#endif
+            *m_pSize = 0;
+            *m_pFreeStart = 0;
             *m_pMaxSize = iObjectCount;
             size_t MAX_SIZE = *m_pMaxSize;
             for (size_t i = 0; i < MAX_SIZE; i++)
@@ -299,15 +307,14 @@ public:
         {
             NF_ASSERT_MSG(*m_pSize <= *m_pMaxSize, "size:{} max_size:{}", *m_pSize, *m_pMaxSize);
             NF_ASSERT_MSG(*m_pMaxSize == iObjectCount, "max size:{} object count:{}", *m_pMaxSize, iObjectCount);
-            if (!std::numeric_limits<Tp>::is_specialized)
+            if (NFShmResumeConstruct<Tp>::value)
             {
-                size_t MAX_SIZE = *m_pMaxSize;
-                for (size_t i = 0; i < MAX_SIZE; i++)
+                // 只沿已用链表走, 不扫描整个节点数组; 最多走size步, 崩溃时损坏的链表也不会死循环
+                ptrdiff_t MAX_SIZE = (ptrdiff_t) *m_pMaxSize;
+                size_t __n = 0;
+                for (ptrdiff_t i = m_node[MAX_SIZE].m_next; i >= 0 && i < MAX_SIZE && __n < *m_pSize; i = m_node[i].m_next, ++__n)
                 {
-                    if (m_node[i].m_valid)
-                    {
-                        std::_Construct(&m_node[i].m_data);
-                    }
+                    std::_Construct(&m_node[i].m_data);
                 }
             }
         }
@@ -347,6 +354,7 @@ public:
     typedef std::reverse_iterator<iterator> reverse_iterator;
 
 protected:
+    using _Base::m_pBuffer;
     using _Base::m_node;
     using _Base::m_pFreeStart;
     using _Base::m_pSize;
@@ -477,6 +485,16 @@ public:
 
     size_type capacity() const { return *m_pMaxSize; }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, m_totalBytes是buffer中用到的字节数, 没有Init时全为0
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        if (m_pBuffer == NULL)
+            return NFShmMakeMemoryStats(0, 0, 0, 0);
+        return NFShmMakeMemoryStats(_Base::CountSize(*m_pMaxSize), sizeof(Tp), *m_pSize, *m_pMaxSize);
+    }
+
     reference front() { return *begin(); }
 
     const_reference front() const { return *begin(); }
@@ -0,0 +1,560 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmDyString.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmDyString
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include <string>
+#include <string_view>
+
+#define NFSHM_DYSTRING_MIN_CLASS_SHIFT 5 //!<最小的块32字节
+#define NFSHM_DYSTRING_CLASS_NUM 12 //!<32字节到64K字节, 共12种块大小
+
+/**
+ * @brief NFShmDyStringHeap在共享内存中的头部, 放在buffer的最前面
+ */
+struct NFShmDyStringHeapHead
+{
+    uint32_t m_bufSize; //!<整个buffer的大小
+    uint32_t m_top; //!<还没有分配过的位置, 从这里往后切新块
+    uint32_t m_freeList[NFSHM_DYSTRING_CLASS_NUM]; //!<每种块大小的空闲链表, 0表示空
+    uint64_t m_usedBytes; //!<已分配块的大小总和(包括块头)
+    uint64_t m_requestBytes; //!<已分配块中字符串实际使用的字节数(包括结束符)
+    uint32_t m_blockNum; //!<已分配的块数
+    uint32_t m_failNum; //!<分配失败次数
+};
+
+/**
+ * @brief 块头, 后面紧跟着字符串数据
+ */
+struct NFShmDyStringBlock
+{
+    uint32_t m_class; //!<块大小为(1 << (m_class + NFSHM_DYSTRING_MIN_CLASS_SHIFT))
+    uint32_t m_next; //!<空闲时为空闲链表的下一个块
+};
+
+/**
+ * @brief NFShmDyString使用的共享内存字节堆
+ * 和NFShmDyVector一样, 数据放在外部传入的buffer中(一般是在共享内存上分配的一块内存), 本对象只保存指针.
+ * buffer内部全部用偏移表示, 进程重启后用Init(pBuffer, bufSize, false)重新挂上即可, 所有NFShmDyString依然有效.
+ *
+ * 按2的幂分成12种块大小(32字节到64K), 每种块大小一个空闲链表, 释放的块只会被相同大小的请求复用,
+ * 分配和释放都是O(1)的. 通过bytes_used/bytes_requested/bytes_free等接口可以统计内存使用情况.
+ */
+class NFShmDyStringHeap
+{
+public:
+    NFShmDyStringHeap() : m_pBuffer(NULL), m_pHead(NULL)
+    {
+    }
+
+    static NFShmDyStringHeap *Instance()
+    {
+        static NFShmDyStringHeap s_instance;
+        return &s_instance;
+    }
+
+    static constexpr size_t CountSize(size_t heapBytes)
+    {
+        return sizeof(NFShmDyStringHeapHead) + heapBytes;
+    }
+
+    /**
+     * @brief 挂上共享内存buffer
+     * @param pBuffer
+     * @param bufSize
+     * @param bResetShm 第一次创建时为true, 进程重启恢复共享内存时为false
+     * @param iAdvise NFShmAdviseMode, 挂上之前对整个buffer调用NFShmAdvise, 默认不调用
+     * @return
+     */
+    int Init(const char *pBuffer, size_t bufSize, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
+    {
+        CHECK_NULL(pBuffer);
+        CHECK_EXPR(bufSize > sizeof(NFShmDyStringHeapHead) && bufSize <= 0xFFFFFFFFu, -1, "bufSize:{}", bufSize);
+        if (iAdvise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(pBuffer, bufSize, iAdvise);
+        }
+
+        m_pBuffer = (char *) pBuffer;
+        m_pHead = (NFShmDyStringHeapHead *) pBuffer;
+        if (bResetShm)
+        {
+            memset(m_pHead, 0, sizeof(NFShmDyStringHeapHead));
+            m_pHead->m_bufSize = (uint32_t) bufSize;
+            m_pHead->m_top = sizeof(NFShmDyStringHeapHead);
+        }
+        else
+        {
+            CHECK_EXPR(m_pHead->m_bufSize == bufSize, -1, "NFShmDyStringHeap resume bufSize not match, shm:{} now:{}", m_pHead->m_bufSize, bufSize);
+        }
+        return 0;
+    }
+
+    bool IsInited() const { return m_pHead != NULL; }
+
+    /**
+     * @brief 分配能放下__n字节的块
+     * @param __n
+     * @param __capacity 实际可用的字节数
+     * @return 块的偏移, 失败返回0
+     */
+    uint32_t allocate(size_t __n, size_t &__capacity)
+    {
+        if (m_pHead == NULL)
+        {
+            return 0;
+        }
+
+        uint32_t __class = _S_class_of(__n + sizeof(NFShmDyStringBlock));
+        if (__class >= NFSHM_DYSTRING_CLASS_NUM)
+        {
+            ++m_pHead->m_failNum;
+            return 0;
+        }
+
+        uint32_t __blockSize = _S_class_size(__class);
+        uint32_t __offset = m_pHead->m_freeList[__class];
+        if (__offset != 0)
+        {
+            m_pHead->m_freeList[__class] = _M_block(__offset)->m_next;
+        }
+        else
+        {
+            if ((size_t) m_pHead->m_top + __blockSize > m_pHead->m_bufSize)
+            {
+                ++m_pHead->m_failNum;
+                return 0;
+            }
+            __offset = m_pHead->m_top;
+            m_pHead->m_top += __blockSize;
+        }
+
+        NFShmDyStringBlock *__block = _M_block(__offset);
+        __block->m_class = __class;
+        __block->m_next = 0;
+
+        __capacity = __blockSize - sizeof(NFShmDyStringBlock);
+        m_pHead->m_usedBytes += __blockSize;
+        m_pHead->m_requestBytes += __n;
+        ++m_pHead->m_blockNum;
+        return __offset;
+    }
+
+    void deallocate(uint32_t __offset, size_t __n)
+    {
+        if (m_pHead == NULL || __offset == 0)
+        {
+            return;
+        }
+
+        NFShmDyStringBlock *__block = _M_block(__offset);
+        NF_ASSERT(__block->m_class < NFSHM_DYSTRING_CLASS_NUM);
+        m_pHead->m_usedBytes -= _S_class_size(__block->m_class);
+        m_pHead->m_requestBytes -= __n;
+        --m_pHead->m_blockNum;
+
+        __block->m_next = m_pHead->m_freeList[__block->m_class];
+        m_pHead->m_freeList[__block->m_class] = __offset;
+    }
+
+    /**
+     * @brief 申请字节数变化时修正统计, 块不变
+     */
+    void adjust_request(size_t __old, size_t __new)
+    {
+        if (m_pHead)
+        {
+            m_pHead->m_requestBytes = m_pHead->m_requestBytes - __old + __new;
+        }
+    }
+
+    char *data(uint32_t __offset) { return m_pBuffer + __offset + sizeof(NFShmDyStringBlock); }
+
+    const char *data(uint32_t __offset) const { return m_pBuffer + __offset + sizeof(NFShmDyStringBlock); }
+
+    /**
+     * @brief 一次分配最多能放下的字节数
+     */
+    static size_t max_alloc_size() { return _S_class_size(NFSHM_DYSTRING_CLASS_NUM - 1) - sizeof(NFShmDyStringBlock); }
+
+public:
+    size_t bytes_total() const { return m_pHead ? m_pHead->m_bufSize - sizeof(NFShmDyStringHeapHead) : 0; }
+
+    /**
+     * @brief 已分配块的大小总和(包括块头和块内浪费的部分)
+     */
+    size_t bytes_used() const { return m_pHead ? m_pHead->m_usedBytes : 0; }
+
+    /**
+     * @brief 已分配块中字符串实际使用的字节数, bytes_used() - bytes_requested()是块内浪费的字节
+     */
+    size_t bytes_requested() const { return m_pHead ? m_pHead->m_requestBytes : 0; }
+
+    /**
+     * @brief 还没有切分过的字节数, 不包括空闲链表上的块
+     */
+    size_t bytes_untouched() const { return m_pHead ? m_pHead->m_bufSize - m_pHead->m_top : 0; }
+
+    /**
+     * @brief 空闲链表上的块 + 还没有切分过的字节数
+     */
+    size_t bytes_free() const { return m_pHead ? m_pHead->m_bufSize - sizeof(NFShmDyStringHeapHead) - m_pHead->m_usedBytes : 0; }
+
+    size_t block_count() const { return m_pHead ? m_pHead->m_blockNum : 0; }
+
+    size_t fail_count() const { return m_pHead ? m_pHead->m_failNum : 0; }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats. 以字节为单位: 字符串实际使用的是m_liveBytes, 空闲链表和没有切分过的是m_freeBytes,
+     * 头部/块头/块内浪费的是m_overheadBytes. m_size是已分配的块数, m_capacity为0.
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        NFShmMemoryStats __st = NFShmMakeMemoryStats(m_pHead ? m_pHead->m_bufSize : 0, 1, bytes_requested(), bytes_requested() + bytes_free());
+        __st.m_size = block_count();
+        __st.m_capacity = 0;
+        return __st;
+    }
+
+private:
+    static uint32_t _S_class_size(uint32_t __class) { return 1u << (__class + NFSHM_DYSTRING_MIN_CLASS_SHIFT); }
+
+    static uint32_t _S_class_of(size_t __bytes)
+    {
+        uint32_t __class = 0;
+        while (__class < NFSHM_DYSTRING_CLASS_NUM && _S_class_size(__class) < __bytes)
+        {
+            ++__class;
+        }
+        return __class;
+    }
+
+    NFShmDyStringBlock *_M_block(uint32_t __offset) { return (NFShmDyStringBlock *) (m_pBuffer + __offset); }
+
+private:
+    char *m_pBuffer;
+    NFShmDyStringHeapHead *m_pHead;
+};
+
+/**
+ * @brief 变长的共享内存字符串
+ * 不超过SSO_SIZE的字符串直接存在对象内部, 更长的存在NFShmDyStringHeap::Instance()中, 对象只保存偏移.
+ * 所以对象本身可以放在共享内存的任何地方(NFShmHashMap/NFShmVector的value, 共享内存结构的成员),
+ * 进程重启后只要heap重新Init(pBuffer, bufSize, false), 字符串内容不变.
+ *
+ * heap没有初始化或者空间不够时, 字符串被截断到当前容量; 超过单块上限(NFShmDyStringHeap::max_alloc_size())时截断到上限. 都会打印错误日志.
+ * 内存使用: heap_bytes()是本字符串在heap中占用的块大小, 整体统计见NFShmDyStringHeap.
+ */
+template<int SSO_SIZE = 23>
+class NFShmDyString
+{
+public:
+    typedef char value_type;
+    typedef size_t size_type;
+    typedef const char *const_iterator;
+    typedef char *iterator;
+
+    static const size_type npos = (size_type) -1;
+
+public:
+    NFShmDyString()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    NFShmDyString(const NFShmDyString &__s)
+    {
+        CreateInit();
+        assign(__s.data(), __s.size());
+    }
+
+    NFShmDyString(std::string_view __s)
+    {
+        CreateInit();
+        assign(__s.data(), __s.size());
+    }
+
+    NFShmDyString(const char *__s)
+    {
+        CreateInit();
+        assign(__s, strlen(__s));
+    }
+
+    NFShmDyString(const std::string &__s)
+    {
+        CreateInit();
+        assign(__s.data(), __s.size());
+    }
+
+    ~NFShmDyString()
+    {
+        _M_free();
+    }
+
+    int CreateInit()
+    {
+        m_size = 0;
+        m_capacity = SSO_SIZE;
+        m_offset = 0;
+        m_sso[0] = '\0';
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+    NFShmDyString &operator=(const NFShmDyString &__s)
+    {
+        if (&__s != this)
+            assign(__s.data(), __s.size());
+        return *this;
+    }
+
+    NFShmDyString &operator=(std::string_view __s) { return assign(__s.data(), __s.size()); }
+
+    NFShmDyString &operator=(const char *__s) { return assign(__s, strlen(__s)); }
+
+    NFShmDyString &operator=(const std::string &__s) { return assign(__s.data(), __s.size()); }
+
+public:
+    size_type size() const { return m_size; }
+
+    size_type length() const { return m_size; }
+
+    bool empty() const { return m_size == 0; }
+
+    size_type capacity() const { return m_capacity; }
+
+    /**
+     * @brief 是否存在对象内部(没有使用heap)
+     */
+    bool is_inline() const { return m_offset == 0; }
+
+    /**
+     * @brief 在heap中占用的字节数(块大小, 包括块头), 内部存储时为0
+     */
+    size_type heap_bytes() const { return m_offset == 0 ? 0 : m_capacity + 1 + sizeof(NFShmDyStringBlock); }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, m_totalBytes是对象本身加上heap_bytes()
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this) + heap_bytes(), 1, m_size, m_capacity); }
+
+    const char *data() const { return m_offset == 0 ? m_sso : NFShmDyStringHeap::Instance()->data(m_offset); }
+
+    const char *c_str() const { return data(); }
+
+    const_iterator begin() const { return data(); }
+
+    const_iterator end() const { return data() + m_size; }
+
+    char operator[](size_type __n) const { return data()[__n]; }
+
+    std::string_view view() const { return std::string_view(data(), m_size); }
+
+    operator std::string_view() const { return view(); }
+
+    std::string GetString() const { return std::string(data(), m_size); }
+
+    std::string ToString() const { return GetString(); }
+
+public:
+    NFShmDyString &assign(const char *__s, size_type __n)
+    {
+        if (!_M_reserve(__n, false))
+        {
+            __n = m_capacity;
+        }
+        char *__p = _M_data();
+        memmove(__p, __s, __n);
+        __p[__n] = '\0';
+        _M_set_size(__n);
+        return *this;
+    }
+
+    NFShmDyString &assign(std::string_view __s) { return assign(__s.data(), __s.size()); }
+
+    NFShmDyString &append(const char *__s, size_type __n)
+    {
+        if (!_M_reserve(m_size + __n, true))
+        {
+            __n = m_capacity - m_size;
+        }
+        char *__p = _M_data();
+        memcpy(__p + m_size, __s, __n);
+        __p[m_size + __n] = '\0';
+        _M_set_size(m_size + __n);
+        return *this;
+    }
+
+    NFShmDyString &append(std::string_view __s) { return append(__s.data(), __s.size()); }
+
+    NFShmDyString &operator+=(std::string_view __s) { return append(__s.data(), __s.size()); }
+
+    NFShmDyString &operator+=(char __c)
+    {
+        push_back(__c);
+        return *this;
+    }
+
+    void push_back(char __c) { append(&__c, 1); }
+
+    void clear()
+    {
+        _M_free();
+        CreateInit();
+    }
+
+    /**
+     * @brief 字符串变短后, 把heap中的块换成合适的大小, 能放进对象内部时释放heap块
+     */
+    void shrink_to_fit()
+    {
+        if (m_offset == 0)
+            return;
+
+        NFShmDyString __tmp(view());
+        swap(__tmp);
+    }
+
+    void swap(NFShmDyString &__s)
+    {
+        char __sso[SSO_SIZE + 1];
+        memcpy(__sso, m_sso, sizeof(m_sso));
+        memcpy(m_sso, __s.m_sso, sizeof(m_sso));
+        memcpy(__s.m_sso, __sso, sizeof(m_sso));
+        std::swap(m_size, __s.m_size);
+        std::swap(m_capacity, __s.m_capacity);
+        std::swap(m_offset, __s.m_offset);
+    }
+
+    int compare(std::string_view __s) const { return view().compare(__s); }
+
+private:
+    char *_M_data() { return m_offset == 0 ? m_sso : NFShmDyStringHeap::Instance()->data(m_offset); }
+
+    void _M_set_size(size_type __n)
+    {
+        if (m_offset != 0)
+        {
+            NFShmDyStringHeap::Instance()->adjust_request(m_size + 1, __n + 1);
+        }
+        m_size = (uint32_t) __n;
+    }
+
+    /**
+     * @brief 保证能放下__n个字符
+     * @param __n
+     * @param __keep 是否保留原来的内容
+     * @return 放不下__n个时返回false, 调用者截断到m_capacity. 超过单块上限时仍会扩到上限,
+     *         heap没有初始化或者没有空间时原来的存储不变
+     */
+    bool _M_reserve(size_type __n, bool __keep)
+    {
+        if (__n <= m_capacity)
+            return true;
+
+        bool __clamped = false;
+        size_t __max = NFShmDyStringHeap::max_alloc_size() - 1;
+        if (__n > __max)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmDyString length:{} exceeds the largest heap block, truncate to:{}", __n, __max);
+            __n = __max;
+            __clamped = true;
+            if (__n <= m_capacity)
+                return false;
+        }
+
+        size_t __capacity = 0;
+        uint32_t __offset = NFShmDyStringHeap::Instance()->allocate(__n + 1, __capacity);
+        if (__offset == 0)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmDyStringHeap not initialized or out of space, need:{} free:{} truncate to:{}", __n + 1,
+                       NFShmDyStringHeap::Instance()->bytes_free(), m_capacity);
+            return false;
+        }
+
+        char *__p = NFShmDyStringHeap::Instance()->data(__offset);
+        if (__keep)
+        {
+            memcpy(__p, data(), m_size + 1);
+        }
+        else
+        {
+            __p[0] = '\0';
+        }
+
+        // 新块的统计按当前长度记, 之后由_M_set_size修正
+        NFShmDyStringHeap::Instance()->adjust_request(__n + 1, m_size + 1);
+        _M_free();
+        m_offset = __offset;
+        m_capacity = (uint32_t) (__capacity - 1);
+        return !__clamped;
+    }
+
+    void _M_free()
+    {
+        if (m_offset != 0)
+        {
+            NFShmDyStringHeap::Instance()->deallocate(m_offset, m_size + 1);
+            m_offset = 0;
+            m_capacity = SSO_SIZE;
+        }
+    }
+
+private:
+    char m_sso[SSO_SIZE + 1];
+    uint32_t m_size;
+    uint32_t m_capacity; //!<不包括结束符
+    uint32_t m_offset; //!<heap中块的偏移, 0表示存在m_sso中
+};
+
+template<int SSO_SIZE>
+inline bool operator==(const NFShmDyString<SSO_SIZE> &__x, const NFShmDyString<SSO_SIZE> &__y) { return __x.view() == __y.view(); }
+
+template<int SSO_SIZE>
+inline bool operator!=(const NFShmDyString<SSO_SIZE> &__x, const NFShmDyString<SSO_SIZE> &__y) { return !(__x == __y); }
+
+template<int SSO_SIZE>
+inline bool operator<(const NFShmDyString<SSO_SIZE> &__x, const NFShmDyString<SSO_SIZE> &__y) { return __x.view() < __y.view(); }
+
+template<int SSO_SIZE>
+inline bool operator==(const NFShmDyString<SSO_SIZE> &__x, std::string_view __s) { return __x.view() == __s; }
+
+template<int SSO_SIZE>
+inline bool operator==(std::string_view __s, const NFShmDyString<SSO_SIZE> &__y) { return __s == __y.view(); }
+
+template<int SSO_SIZE>
+inline bool operator==(const NFShmDyString<SSO_SIZE> &__x, const char *__s) { return __x.view() == __s; }
+
+namespace std
+{
+    template<int SSO_SIZE>
+    struct hash<NFShmDyString<SSO_SIZE>>
+    {
+        size_t operator()(const NFShmDyString <SSO_SIZE> &eventKey) const
+        {
+            return NFShmHashBytes(eventKey.data(), eventKey.size());
+        }
+    };
+}
@@ -59,12 +59,16 @@ public:
         return 0;
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
         CHECK_NULL(pBuffer);
         CHECK_EXPR(iObjectCount >= 0, -1, "iObjectCount:{}",iObjectCount);
         int iCountSize = CountSize(iObjectCount);
         NF_ASSERT_MSG(bufSize >= iCountSize, "bufSize:{} iCountSize:{}", bufSize, iCountSize);
+        if (iAdvise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(pBuffer, bufSize, iAdvise);
+        }
         
         m_pBuffer = (char*)pBuffer;
         m_pSize = (size_t*)pBuffer;
@@ -75,14 +79,17 @@ public:
 
         if (bResetShm)
         {
+#if NF_SHM_ZERO_ON_CREATE
             memset((void*)pBuffer, 0, bufSize);
+#endif
+            *m_pSize = 0;
             *m_pMaxSize = iObjectCount;
         }
         else
         {
             NF_ASSERT_MSG(*m_pSize <= *m_pMaxSize, "size:{} max_size:{}", *m_pSize, *m_pMaxSize);
             NF_ASSERT_MSG(*m_pMaxSize == iObjectCount, "max size:{} object count:{}", *m_pMaxSize, iObjectCount);
-            if (!std::numeric_limits<Tp>::is_specialized)
+            if (NFShmResumeConstruct<Tp>::value)
             {
                 for(size_t i = 0; i < *m_pSize; i++)
                 {
@@ -97,7 +104,7 @@ public:
     /**
     * 计算所用内存的大小
     */
-    static size_t CountSize(int iObjectCount)
+    static constexpr size_t CountSize(int iObjectCount)
     {
         //size + maxSize + sizeof(Tp) * iObjectCount
         return sizeof(size_t) + sizeof(size_t) + sizeof(Tp) * iObjectCount;
@@ -116,6 +123,7 @@ class NFShmDyVector : public NFShmDyVectorBase<Tp>
 private:
     typedef NFShmDyVectorBase<Tp> _Base;
 protected:
+    using _Base::m_pBuffer;
     using _Base::m_pData;
     using _Base::m_pSize;
     using _Base::m_pMaxSize;
@@ -160,9 +168,9 @@ public:
         clear();
     }
 
-    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true)
+    virtual int Init(const char* pBuffer, int bufSize, int iObjectCount, bool bResetShm = true, int iAdvise = NFSHM_ADVISE_NONE)
     {
-        return NFShmDyVectorBase<Tp>::Init(pBuffer, bufSize, iObjectCount, bResetShm);
+        return NFShmDyVectorBase<Tp>::Init(pBuffer, bufSize, iObjectCount, bResetShm, iAdvise);
     }
 
     NFShmDyVector<Tp> &operator=(const NFShmDyVector<Tp> &__x);
@@ -190,6 +198,16 @@ public:
 
     size_type capacity() const { return max_size(); }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, m_totalBytes是buffer中用到的字节数, 没有Init时全为0
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        if (m_pBuffer == NULL)
+            return NFShmMakeMemoryStats(0, 0, 0, 0);
+        return NFShmMakeMemoryStats(_Base::CountSize(max_size()), sizeof(Tp), size(), max_size());
+    }
+
     bool empty() const { return begin() == end(); }
 
     reference operator[](size_type __n)
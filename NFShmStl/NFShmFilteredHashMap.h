@@ -0,0 +1,235 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmFilteredHashMap.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmFilteredHashMap
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFShmHashMap.h"
+#include "NFShmBloomFilter.h"
+
+/**
+ * @brief 前面带过滤器的NFShmHashMap, 用于查找大多数不命中的场景(封禁名单, 已处理的订单号等).
+ * find/count先查过滤器, 过滤器说不在就直接返回, 不访问哈希表的桶和链.
+ * Filter可以是NFShmCuckooFilter(默认, 支持删除)或NFShmBloomFilter(不能删除, 删除的key留在过滤器里只会增加误判,
+ * 删除次数超过元素个数时自动重建).
+ * 过滤器插入失败(布谷鸟过滤器满了)时标记m_bypass, 之后查找直接查哈希表保证正确, 直到rebuild_filter成功.
+ * 过滤器和哈希表都在共享内存里, 恢复后直接可用.
+ */
+template<class Key, class Tp, int MAX_SIZE,
+        class Filter = NFShmCuckooFilter<MAX_SIZE>,
+        class HashFcn = std::hash<Key>,
+        class EqualKey = std::equal_to<Key> >
+class NFShmFilteredHashMap
+{
+private:
+    typedef NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey> _Hm;
+    _Hm m_map;
+    Filter m_filter;
+    int m_staleCount;   //!<不能删除的过滤器里残留的已删除key个数
+    bool m_bypass;      //!<过滤器不完整, 查找时跳过过滤器
+
+public:
+    typedef typename _Hm::key_type key_type;
+    typedef typename _Hm::mapped_type mapped_type;
+    typedef typename _Hm::value_type value_type;
+    typedef typename _Hm::hasher hasher;
+    typedef typename _Hm::key_equal key_equal;
+    typedef typename _Hm::size_type size_type;
+    typedef typename _Hm::iterator iterator;
+    typedef typename _Hm::const_iterator const_iterator;
+    typedef Filter filter_type;
+
+public:
+    NFShmFilteredHashMap()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        m_staleCount = 0;
+        m_bypass = false;
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    size_type size() const { return m_map.size(); }
+
+    size_type max_size() const { return m_map.max_size(); }
+
+    bool empty() const { return m_map.empty(); }
+
+    bool full() const { return m_map.full(); }
+
+    iterator begin() { return m_map.begin(); }
+
+    iterator end() { return m_map.end(); }
+
+    const_iterator begin() const { return m_map.begin(); }
+
+    const_iterator end() const { return m_map.end(); }
+
+    const Filter &filter() const { return m_filter; }
+
+    /**
+     * @brief 过滤器是否被跳过
+     */
+    bool filter_bypassed() const { return m_bypass; }
+
+    NFShmHashTableStats stats() const { return m_map.stats(); }
+
+    NFShmMemoryStats memory_stats() const
+    {
+        NFShmMemoryStats __st = m_map.memory_stats();
+        __st.m_totalBytes = sizeof(*this);
+        __st.m_overheadBytes = __st.m_totalBytes - __st.m_liveBytes - __st.m_freeBytes;
+        return __st;
+    }
+
+    bool verify() const;
+
+public:
+    std::pair<iterator, bool> insert(const value_type &__obj)
+    {
+        std::pair<iterator, bool> __ret = m_map.insert(__obj);
+        if (__ret.second)
+        {
+            _M_filter_insert(__obj.first);
+        }
+        return __ret;
+    }
+
+    std::pair<iterator, bool> emplace(const key_type &__key, const mapped_type &__data) { return insert(value_type(__key, __data)); }
+
+    Tp &operator[](const key_type &__key)
+    {
+        iterator __it = find(__key);
+        if (__it != end())
+        {
+            return __it->second;
+        }
+        return insert(value_type(__key, Tp())).first->second;
+    }
+
+    iterator find(const key_type &__key)
+    {
+        if (!m_bypass && !m_filter.contains_hash((uint64_t) hasher()(__key)))
+        {
+            return m_map.end();
+        }
+        return m_map.find(__key);
+    }
+
+    const_iterator find(const key_type &__key) const
+    {
+        if (!m_bypass && !m_filter.contains_hash((uint64_t) hasher()(__key)))
+        {
+            return m_map.end();
+        }
+        return m_map.find(__key);
+    }
+
+    size_type count(const key_type &__key) const { return find(__key) != end() ? 1 : 0; }
+
+    size_type erase(const key_type &__key)
+    {
+        if (m_map.erase(__key) == 0)
+        {
+            return 0;
+        }
+        _M_filter_erase(__key);
+        return 1;
+    }
+
+    iterator erase(iterator __it)
+    {
+        key_type __key = __it->first;
+        iterator __next = m_map.erase(__it);
+        _M_filter_erase(__key);
+        return __next;
+    }
+
+    void clear()
+    {
+        m_map.clear();
+        m_filter.clear();
+        m_staleCount = 0;
+        m_bypass = false;
+    }
+
+    /**
+     * @brief 用哈希表里的key重建过滤器, 布隆过滤器残留太多或布谷鸟过滤器插入失败后调用
+     * @return 重建后过滤器是否完整
+     */
+    bool rebuild_filter()
+    {
+        m_filter.clear();
+        m_staleCount = 0;
+        m_bypass = false;
+        for (iterator __it = m_map.begin(); __it != m_map.end() && !m_bypass; ++__it)
+        {
+            _M_filter_insert(__it->first);
+        }
+        return !m_bypass;
+    }
+
+private:
+    void _M_filter_insert(const key_type &__key)
+    {
+        if (!m_bypass && !m_filter.insert_hash((uint64_t) hasher()(__key)))
+        {
+            m_bypass = true;
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmFilteredHashMap filter full, size:{}, lookups bypass the filter until rebuild", m_map.size());
+        }
+    }
+
+    void _M_filter_erase(const key_type &__key)
+    {
+        if (Filter::deletable)
+        {
+            if (!m_bypass)
+            {
+                m_filter.erase_hash((uint64_t) hasher()(__key));
+            }
+        }
+        else if (++m_staleCount > (int) m_map.size() && m_staleCount > 64)
+        {
+            rebuild_filter();
+        }
+    }
+};
+
+template<class Key, class Tp, int MAX_SIZE, class Filter, class HashFcn, class EqualKey>
+bool NFShmFilteredHashMap<Key, Tp, MAX_SIZE, Filter, HashFcn, EqualKey>::verify() const
+{
+    if (!m_map.verify())
+    {
+        return false;
+    }
+    if (m_bypass)
+    {
+        return true;
+    }
+    for (const_iterator __it = m_map.begin(); __it != m_map.end(); ++__it)
+    {
+        CHECK_EXPR(m_filter.contains_hash((uint64_t) hasher()(__it->first)), false, "NFShmFilteredHashMap verify failed, key missing from filter");
+    }
+    return true;
+}
@@ -0,0 +1,149 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmHash.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmHash
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#endif
+
+/**
+ * @brief 字节串hash, 基于wyhash(final4)实现
+ * 不分配内存, 对短key(<=16字节)只需一次128位乘法, 用于NFShmString等共享内存容器的key.
+ * 结果只依赖于字节内容和长度, 所以NFShmString, std::string, const char *, std::string_view
+ * 对相同内容会得到相同的hash值, 可以用于异构查找.
+ */
+
+static const uint64_t NFSHM_HASH_SECRET[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+inline void _NFShmHashMum(uint64_t *__a, uint64_t *__b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t __r = *__a;
+    __r *= *__b;
+    *__a = (uint64_t) __r;
+    *__b = (uint64_t) (__r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *__a = _umul128(*__a, *__b, __b);
+#else
+    uint64_t __ha = *__a >> 32, __hb = *__b >> 32, __la = (uint32_t) *__a, __lb = (uint32_t) *__b;
+    uint64_t __rh = __ha * __hb, __rm0 = __ha * __lb, __rm1 = __hb * __la, __rl = __la * __lb;
+    uint64_t __t = __rl + (__rm0 << 32);
+    uint64_t __c = __t < __rl;
+    uint64_t __lo = __t + (__rm1 << 32);
+    __c += __lo < __t;
+    uint64_t __hi = __rh + (__rm0 >> 32) + (__rm1 >> 32) + __c;
+    *__a = __lo;
+    *__b = __hi;
+#endif
+}
+
+inline uint64_t _NFShmHashMix(uint64_t __a, uint64_t __b)
+{
+    _NFShmHashMum(&__a, &__b);
+    return __a ^ __b;
+}
+
+/**
+ * @brief murmur3的fmix64, 每个输入位都会影响每个输出位. 连续或等间隔的整数key(std::hash<int>就是原值)
+ * 要先过一遍才能当随机位用
+ */
+inline uint64_t _NFShmHashFmix64(uint64_t __k)
+{
+    __k ^= __k >> 33;
+    __k *= 0xff51afd7ed558ccdull;
+    __k ^= __k >> 33;
+    __k *= 0xc4ceb9fe1a85ec53ull;
+    __k ^= __k >> 33;
+    return __k;
+}
+
+inline uint64_t _NFShmHashRead8(const uint8_t *__p)
+{
+    uint64_t __v;
+    memcpy(&__v, __p, 8);
+    return __v;
+}
+
+inline uint64_t _NFShmHashRead4(const uint8_t *__p)
+{
+    uint32_t __v;
+    memcpy(&__v, __p, 4);
+    return __v;
+}
+
+inline uint64_t _NFShmHashRead3(const uint8_t *__p, size_t __k)
+{
+    return (((uint64_t) __p[0]) << 16) | (((uint64_t) __p[__k >> 1]) << 8) | __p[__k - 1];
+}
+
+/**
+ * @brief 计算[__key, __key + __len)的64位hash值
+ * @param __key
+ * @param __len
+ * @param __seed
+ * @return
+ */
+inline uint64_t NFShmHashBytes(const void *__key, size_t __len, uint64_t __seed = 0)
+{
+    const uint8_t *__p = (const uint8_t *) __key;
+    __seed ^= _NFShmHashMix(__seed ^ NFSHM_HASH_SECRET[0], NFSHM_HASH_SECRET[1]);
+    uint64_t __a, __b;
+    if (__len <= 16)
+    {
+        if (__len >= 4)
+        {
+            __a = (_NFShmHashRead4(__p) << 32) | _NFShmHashRead4(__p + ((__len >> 3) << 2));
+            __b = (_NFShmHashRead4(__p + __len - 4) << 32) | _NFShmHashRead4(__p + __len - 4 - ((__len >> 3) << 2));
+        }
+        else if (__len > 0)
+        {
+            __a = _NFShmHashRead3(__p, __len);
+            __b = 0;
+        }
+        else
+        {
+            __a = __b = 0;
+        }
+    }
+    else
+    {
+        size_t __i = __len;
+        if (__i >= 48)
+        {
+            uint64_t __see1 = __seed, __see2 = __seed;
+            do
+            {
+                __seed = _NFShmHashMix(_NFShmHashRead8(__p) ^ NFSHM_HASH_SECRET[1], _NFShmHashRead8(__p + 8) ^ __seed);
+                __see1 = _NFShmHashMix(_NFShmHashRead8(__p + 16) ^ NFSHM_HASH_SECRET[2], _NFShmHashRead8(__p + 24) ^ __see1);
+                __see2 = _NFShmHashMix(_NFShmHashRead8(__p + 32) ^ NFSHM_HASH_SECRET[3], _NFShmHashRead8(__p + 40) ^ __see2);
+                __p += 48;
+                __i -= 48;
+            } while (__i >= 48);
+            __seed ^= __see1 ^ __see2;
+        }
+        while (__i > 16)
+        {
+            __seed = _NFShmHashMix(_NFShmHashRead8(__p) ^ NFSHM_HASH_SECRET[1], _NFShmHashRead8(__p + 8) ^ __seed);
+            __i -= 16;
+            __p += 16;
+        }
+        __a = _NFShmHashRead8(__p + __i - 16);
+        __b = _NFShmHashRead8(__p + __i - 8);
+    }
+    __a ^= NFSHM_HASH_SECRET[1];
+    __b ^= __seed;
+    _NFShmHashMum(&__a, &__b);
+    return _NFShmHashMix(__a ^ NFSHM_HASH_SECRET[0] ^ __len, __b ^ NFSHM_HASH_SECRET[1]);
+}
@@ -18,19 +18,20 @@
 
 template<class Key, class Tp, int MAX_SIZE,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashMap;
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HashFn, class _EqKey>
-inline bool operator==(const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey> &,
-                       const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey> &);
+template<class _Key, class _Tp, int MAX_SIZE, class _HashFn, class _EqKey, class _St>
+inline bool operator==(const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey, _St> &,
+                       const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey, _St> &);
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashMap
 {
 private:
     typedef NFShmHashTable<NFShmPair<Key, Tp>, Key, MAX_SIZE, HashFcn,
-            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -91,9 +92,9 @@ public:
         return 0;
     }
     
-    NFShmHashMap<Key, Tp, MAX_SIZE> &operator=(const NFShmHashMap<Key, Tp, MAX_SIZE> &__x);
-    NFShmHashMap<Key, Tp, MAX_SIZE> &operator=(const std::unordered_map<Key, Tp> &__x);
-    NFShmHashMap<Key, Tp, MAX_SIZE> &operator=(const std::map<Key, Tp> &__x);
+    NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &__x);
+    NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const std::unordered_map<Key, Tp> &__x);
+    NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const std::map<Key, Tp> &__x);
 public:
     size_type size() const { return m_hashTable.size(); }
 
@@ -103,9 +104,9 @@ public:
 
     void swap(NFShmHashMap &__hs) { m_hashTable.swap(__hs.m_hashTable); }
 
-    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashMap<_K1, _T1, _MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashMap<_K1, _T1, _MAX_SIZE, _HF, _EqK> &);
+    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashMap<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashMap<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() { return m_hashTable.begin(); }
 
@@ -121,6 +122,16 @@ public:
 
     void debug_string() { m_hashTable.debug_string(); }
 
+    bool verify() const { return m_hashTable.verify(); }
+
+    NFShmHashTableStats stats() const { return m_hashTable.stats(); }
+
+    void reset_stats() { m_hashTable.reset_stats(); }
+
+    std::string profile_report(const char *__name) const { return m_hashTable.profile_report(__name); }
+
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     iterator get_iterator(int idx)
     {
         return m_hashTable.get_iterator(idx);
@@ -165,6 +176,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     iterator erase(iterator __it) { return m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -180,51 +213,52 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashMap<Key, Tp, MAX_SIZE> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::operator=(const map<Key, Tp> &__x)
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const map<Key, Tp> &__x)
 {
     m_hashTable.insert_equal(__x.begin(), __x.end());
     return *this;
 }
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashMap<Key, Tp, MAX_SIZE> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::operator=(const unordered_map<Key, Tp> &__x)
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const unordered_map<Key, Tp> &__x)
 {
     m_hashTable.insert_equal(__x.begin(), __x.end());
     return *this;
 }
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashMap<Key, Tp, MAX_SIZE> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::operator=(const NFShmHashMap<Key, Tp, MAX_SIZE> &__x)
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const NFShmHashMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &__x)
 {
     m_hashTable = __x.m_hashTable;
     return *this;
 }
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HashFcn, class _EqlKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HashFcn, class _EqlKey, class _St>
 inline bool
-operator==(const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey> &__hm1,
-           const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey> &__hm2)
+operator==(const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey, _St> &__hm1,
+           const NFShmHashMap<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey, _St> &__hm2)
 {
     return __hm1.m_hashTable == __hm2.m_hashTable;
 }
 
 template<class Key, class Tp, int MAX_SIZE,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashMultiMap;
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey, class _St>
 inline bool
-operator==(const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm1,
-           const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm2);
+operator==(const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm1,
+           const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm2);
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashMultiMap
 {
 private:
     typedef NFShmHashTable<NFShmPair<const Key, Tp>, Key, MAX_SIZE, HashFcn,
-            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -292,9 +326,9 @@ public:
 
     void swap(NFShmHashMultiMap &__hs) { m_hashTable.swap(__hs.m_hashTable); }
 
-    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashMultiMap<_K1, _T1, _MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashMultiMap<_K1, _T1, _MAX_SIZE, _HF, _EqK> &);
+    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashMultiMap<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashMultiMap<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() { return m_hashTable.begin(); }
 
@@ -308,6 +342,8 @@ public:
 
     size_t left_size() const { return m_hashTable.left_size(); }
 
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     iterator get_iterator(int idx)
     {
         return m_hashTable.get_iterator(idx);
@@ -345,6 +381,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     void erase(iterator __it) { m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -361,10 +419,10 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey, class _St>
 inline bool
-operator==(const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm1,
-           const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm2)
+operator==(const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm1,
+           const NFShmHashMultiMap<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm2)
 {
     return __hm1.m_hashTable == __hm2.m_hashTable;
 }
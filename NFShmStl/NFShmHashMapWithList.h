@@ -14,19 +14,20 @@
 
 template<class Key, class Tp, int MAX_SIZE,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashMapWithList;
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HashFn, class _EqKey>
-inline bool operator==(const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey> &,
-                       const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey> &);
+template<class _Key, class _Tp, int MAX_SIZE, class _HashFn, class _EqKey, class _St>
+inline bool operator==(const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey, _St> &,
+                       const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFn, _EqKey, _St> &);
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashMapWithList
 {
 private:
     typedef NFShmHashTableWithList<NFShmPair<Key, Tp>, Key, MAX_SIZE, HashFcn,
-            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -92,9 +93,9 @@ public:
 
     void swap(NFShmHashMapWithList &__hs) { m_hashTable.swap(__hs.m_hashTable); }
 
-    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK> &);
+    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() { return m_hashTable.begin(); }
 
@@ -129,6 +130,16 @@ public:
     const NFShmList<int, MAX_SIZE>& get_list() const { return m_hashTable.get_list(); }
 
     void debug_string() { m_hashTable.debug_string(); }
+
+    bool verify() const { return m_hashTable.verify(); }
+
+    NFShmHashTableStats stats() const { return m_hashTable.stats(); }
+
+    void reset_stats() { m_hashTable.reset_stats(); }
+
+    std::string profile_report(const char *__name) const { return m_hashTable.profile_report(__name); }
+
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
 public:
     std::pair<iterator, bool> insert(const value_type &__obj) { return m_hashTable.insert_unique(__obj); }
     std::pair<iterator, bool> emplace(const key_type&__key, const data_type& __data) { return m_hashTable.insert_unique(MakePair(__key, __data)); }
@@ -164,6 +175,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     iterator erase(iterator __it) { return m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -179,30 +212,31 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HashFcn, class _EqlKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HashFcn, class _EqlKey, class _St>
 inline bool
-operator==(const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey> &__hm1,
-           const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey> &__hm2)
+operator==(const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey, _St> &__hm1,
+           const NFShmHashMapWithList<_Key, _Tp, MAX_SIZE, _HashFcn, _EqlKey, _St> &__hm2)
 {
     return __hm1.m_hashTable == __hm2.m_hashTable;
 }
 
 template<class Key, class Tp, int MAX_SIZE,
         class HashFcn = std::hash<Key>,
-        class EqualKey = std::equal_to<Key>>
+        class EqualKey = std::equal_to<Key>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashMultiMapWithList;
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey, class _St>
 inline bool
-operator==(const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm1,
-           const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm2);
+operator==(const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm1,
+           const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm2);
 
-template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashMultiMapWithList
 {
 private:
     typedef NFShmHashTableWithList<NFShmPair<const Key, Tp>, Key, MAX_SIZE, HashFcn,
-            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey> _Ht;
+            std::_Select1st<NFShmPair<const Key, Tp> >, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -270,9 +304,9 @@ public:
 
     void swap(NFShmHashMultiMapWithList &__hs) { m_hashTable.swap(__hs.m_hashTable); }
 
-    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashMultiMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashMultiMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK> &);
+    template<class _K1, class _T1, int _MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashMultiMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashMultiMapWithList<_K1, _T1, _MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() { return m_hashTable.begin(); }
 
@@ -286,6 +320,8 @@ public:
 
     size_t left_size() const { return m_hashTable.left_size(); }
 
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     bool is_get_list() const { return m_hashTable.is_get_list(); }
     void set_get_list(bool flag) { m_hashTable.set_get_list(flag); }
 
@@ -333,6 +369,28 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    const_iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<iterator, iterator> equal_range(const _Kt &__key) { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    std::pair<const_iterator, const_iterator>
+    equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     void erase(iterator __it) { m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -349,10 +407,10 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey>
+template<class _Key, class _Tp, int MAX_SIZE, class _HF, class _EqKey, class _St>
 inline bool
-operator==(const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm1,
-           const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey> &__hm2)
+operator==(const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm1,
+           const NFShmHashMultiMapWithList<_Key, _Tp, MAX_SIZE, _HF, _EqKey, _St> &__hm2)
 {
     return __hm1.m_hashTable == __hm2.m_hashTable;
 }
@@ -15,19 +15,20 @@
 
 template<class Value, int MAX_SIZE,
         class HashFcn = std::hash<Value>,
-        class EqualKey = std::equal_to<Value>>
+        class EqualKey = std::equal_to<Value>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashSet;
 
-template<class _Value, int MAX_SIZE, class _HashFcn, class _EqualKey>
+template<class _Value, int MAX_SIZE, class _HashFcn, class _EqualKey, class _St>
 inline bool
-operator==(const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey> &__hs1,
-           const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey> &__hs2);
+operator==(const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs1,
+           const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs2);
 
-template<class Value, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Value, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashSet
 {
 private:
-    typedef NFShmHashTable<Value, Value, MAX_SIZE, HashFcn, std::_Identity<Value>, EqualKey> _Ht;
+    typedef NFShmHashTable<Value, Value, MAX_SIZE, HashFcn, std::_Identity<Value>, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -84,9 +85,9 @@ public:
         return 0;
     }
     
-    NFShmHashSet<Value, MAX_SIZE> &operator=(const NFShmHashSet<Value, MAX_SIZE> &__x);
-    NFShmHashSet<Value, MAX_SIZE> &operator=(const std::unordered_set<Value> &__x);
-    NFShmHashSet<Value, MAX_SIZE> &operator=(const std::set<Value> &__x);
+    NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &__x);
+    NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const std::unordered_set<Value> &__x);
+    NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &operator=(const std::set<Value> &__x);
 public:
     size_type size() const { return m_hashTable.size(); }
 
@@ -96,9 +97,9 @@ public:
 
     void swap(NFShmHashSet &__hs) { m_hashTable.swap(__hs.m_hashTable); }
 
-    template<class _Val, int X_MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashSet<_Val, X_MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashSet<_Val, X_MAX_SIZE, _HF, _EqK> &);
+    template<class _Val, int X_MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashSet<_Val, X_MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashSet<_Val, X_MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() const { return m_hashTable.begin(); }
 
@@ -110,6 +111,16 @@ public:
 
     void debug_string() { m_hashTable.debug_string(); }
 
+    bool verify() const { return m_hashTable.verify(); }
+
+    NFShmHashTableStats stats() const { return m_hashTable.stats(); }
+
+    void reset_stats() { m_hashTable.reset_stats(); }
+
+    std::string profile_report(const char *__name) const { return m_hashTable.profile_report(__name); }
+
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     iterator get_iterator(int idx)
     {
         return m_hashTable.get_iterator(idx);
@@ -151,6 +162,21 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    pair<iterator, iterator> equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     iterator erase(iterator __it) { return m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -167,51 +193,52 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class Value, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashSet<Value, MAX_SIZE> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey>::operator=(const set<Value> &__x)
+template<class Value, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const set<Value> &__x)
 {
     m_hashTable.insert_equal(__x.begin(), __x.end());
     return *this;
 }
 
-template<class Value, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashSet<Value, MAX_SIZE> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey>::operator=(const unordered_set<Value> &__x)
+template<class Value, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const unordered_set<Value> &__x)
 {
     m_hashTable.insert_equal(__x.begin(), __x.end());
     return *this;
 }
 
-template<class Value, int MAX_SIZE, class HashFcn, class EqualKey>
-NFShmHashSet<Value, MAX_SIZE> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey>::operator=(const NFShmHashSet<Value, MAX_SIZE> &__x)
+template<class Value, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
+NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy>::operator=(const NFShmHashSet<Value, MAX_SIZE, HashFcn, EqualKey, StatsPolicy> &__x)
 {
     m_hashTable = __x.m_hashTable;
     return *this;
 }
 
-template<class _Value, int MAX_SIZE, class _HashFcn, class _EqualKey>
+template<class _Value, int MAX_SIZE, class _HashFcn, class _EqualKey, class _St>
 inline bool
-operator==(const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey> &__hs1,
-           const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey> &__hs2)
+operator==(const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs1,
+           const NFShmHashSet<_Value, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs2)
 {
     return __hs1.m_hashTable == __hs2.m_hashTable;
 }
 
 template<class Value, int MAX_SIZE,
         class HashFcn = std::hash<Value>,
-        class EqualKey = std::equal_to<Value>>
+        class EqualKey = std::equal_to<Value>,
+        class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashMultiSet;
 
-template<class _Val, int MAX_SIZE, class _HashFcn, class _EqualKey>
+template<class _Val, int MAX_SIZE, class _HashFcn, class _EqualKey, class _St>
 inline bool
-operator==(const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey> &__hs1,
-           const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey> &__hs2);
+operator==(const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs1,
+           const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs2);
 
 
-template<class Value, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class Value, int MAX_SIZE, class HashFcn, class EqualKey, class StatsPolicy>
 class NFShmHashMultiSet
 {
 private:
-    typedef NFShmHashTable<Value, Value, MAX_SIZE, HashFcn, std::_Identity<Value>, EqualKey> _Ht;
+    typedef NFShmHashTable<Value, Value, MAX_SIZE, HashFcn, std::_Identity<Value>, EqualKey, StatsPolicy> _Ht;
     _Ht m_hashTable;
 
 public:
@@ -271,13 +298,15 @@ public:
 
     size_type max_size() const { return m_hashTable.max_size(); }
 
+    NFShmMemoryStats memory_stats() const { return m_hashTable.memory_stats(); }
+
     bool empty() const { return m_hashTable.empty(); }
 
     void swap(NFShmHashMultiSet &hs) { m_hashTable.swap(hs.m_hashTable); }
 
-    template<class _Val, int _MAX_SIZE, class _HF, class _EqK>
-    friend bool operator==(const NFShmHashMultiSet<_Val, _MAX_SIZE, _HF, _EqK> &,
-                           const NFShmHashMultiSet<_Val, _MAX_SIZE, _HF, _EqK> &);
+    template<class _Val, int _MAX_SIZE, class _HF, class _EqK, class _St>
+    friend bool operator==(const NFShmHashMultiSet<_Val, _MAX_SIZE, _HF, _EqK, _St> &,
+                           const NFShmHashMultiSet<_Val, _MAX_SIZE, _HF, _EqK, _St> &);
 
     iterator begin() const { return m_hashTable.begin(); }
 
@@ -315,6 +344,21 @@ public:
 
     size_type erase(const key_type &__key) { return m_hashTable.erase(__key); }
 
+    /**
+     * @brief 异构查找, 需要hasher和key_equal都定义is_transparent
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    iterator find(const _Kt &__key) const { return m_hashTable.find(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type count(const _Kt &__key) const { return m_hashTable.count(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    pair<iterator, iterator> equal_range(const _Kt &__key) const { return m_hashTable.equal_range(__key); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<hasher, _Kt>, class = NFShmHasIsTransparent_t<key_equal, _Kt> >
+    size_type erase(const _Kt &__key) { return m_hashTable.erase(__key); }
+
     void erase(iterator __it) { m_hashTable.erase(__it); }
 
     void erase(iterator __f, iterator __l) { m_hashTable.erase(__f, __l); }
@@ -331,10 +375,10 @@ public:
     size_type elems_in_bucket(size_type __n) const { return m_hashTable.elems_in_bucket(__n); }
 };
 
-template<class _Val, int MAX_SIZE, class _HashFcn, class _EqualKey, class _Alloc>
+template<class _Val, int MAX_SIZE, class _HashFcn, class _EqualKey, class _St>
 inline bool
-operator==(const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey> &__hs1,
-           const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey> &__hs2)
+operator==(const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs1,
+           const NFShmHashMultiSet<_Val, MAX_SIZE, _HashFcn, _EqualKey, _St> &__hs2)
 {
     return __hs1.m_hashTable == __hs2.m_hashTable;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFComm/NFPluginModule/NFCheck.h"
 #include "NFShmVector.h"
+#include "NFShmHashTableStats.h"
 #include <iterator>
 #include <algorithm>
 #include <vector>
@@ -62,29 +63,38 @@ struct NFShmHashTableNode
     size_t m_self;
 };
 
+/**
+ * @brief 节点数组不在容器层逐个重新构造, 由哈希表恢复时只对有效节点处理, 见_M_resume_values
+ */
+template<class Val>
+struct NFShmResumeConstruct<NFShmHashTableNode<Val> >
+{
+    static const bool value = false;
+};
+
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy = NFShmHashTableNoStats>
 class NFShmHashTable;
 
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmHashTableIterator;
 
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmHashTableConstIterator;
 
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmHashTableIterator
 {
-    typedef NFShmHashTable<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmHashTable<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmHashTableNode<Val> _Node;
 
@@ -118,16 +128,16 @@ struct NFShmHashTableIterator
 
 
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
+        class ExtractKey, class EqualKey, class StatsPolicy>
 struct NFShmHashTableConstIterator
 {
-    typedef NFShmHashTable<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmHashTable<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             _Hashtable;
     typedef NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             iterator;
     typedef NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn,
-            ExtractKey, EqualKey>
+            ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
     typedef NFShmHashTableNode<Val> _Node;
 
@@ -162,16 +172,16 @@ struct NFShmHashTableConstIterator
     bool operator!=(const const_iterator &__it) const { return m_curNode != __it.m_curNode; }
 };
 
-template<class Val, class Key, int MAX_SIZE, class HF, class Ex, class Eq>
+template<class Val, class Key, int MAX_SIZE, class HF, class Ex, class Eq, class St>
 class NFShmHashTable;
 
-template<class Val, class Key, int MAX_SIZE, class HF, class Ex, class Eq>
-bool operator==(const NFShmHashTable<Val, Key, MAX_SIZE, HF, Ex, Eq> &__ht1,
-                const NFShmHashTable<Val, Key, MAX_SIZE, HF, Ex, Eq> &__ht2);
+template<class Val, class Key, int MAX_SIZE, class HF, class Ex, class Eq, class St>
+bool operator==(const NFShmHashTable<Val, Key, MAX_SIZE, HF, Ex, Eq, St> &__ht1,
+                const NFShmHashTable<Val, Key, MAX_SIZE, HF, Ex, Eq, St> &__ht2);
 
 template<class Val, class Key, int MAX_SIZE, class HashFcn,
-        class ExtractKey, class EqualKey>
-class NFShmHashTable
+        class ExtractKey, class EqualKey, class StatsPolicy>
+class NFShmHashTable : private StatsPolicy::counter_type
 {
 public:
     typedef Key key_type;
@@ -224,17 +234,16 @@ private:
     size_type m_num_elements;
     NFShmVector<_Node, MAX_SIZE> m_buckets;
     NFShmVector<int, MAX_SIZE> m_bucketsFirstIdx;
-
 public:
-    typedef NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             iterator;
-    typedef NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>
+    typedef NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>
             const_iterator;
 
     friend struct
-            NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>;
+            NFShmHashTableIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
     friend struct
-            NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey>;
+            NFShmHashTableConstIterator<Val, Key, MAX_SIZE, HashFcn, ExtractKey, EqualKey, StatsPolicy>;
 
 public:
     NFShmHashTable()
@@ -255,6 +264,7 @@ public:
 
     NFShmHashTable(const NFShmHashTable &__ht) : m_hash(__ht.m_hash), m_equals(__ht.m_equals), m_get_key(__ht.m_get_key), m_num_elements(0)
     {
+        StatsPolicy::reset(_M_stats_counter());
         _M_copy_from(__ht);
     }
 
@@ -277,15 +287,36 @@ public:
 
     int CreateInit()
     {
+        StatsPolicy::reset(_M_stats_counter());
         _M_initialize_buckets();
         return 0;
     }
 
     int ResumeInit()
     {
+        _M_resume_values();
         return 0;
     }
 
+    /**
+     * @brief 恢复时只对桶链上的有效节点重新构造m_value, 空闲节点在插入时才会构造, 不需要遍历整个节点数组.
+     * 没有已用链表, 只能扫描桶的下标数组(每个桶4字节), 找齐size()个节点后就停
+     */
+    void _M_resume_values()
+    {
+        if (!NFShmResumeConstruct<Val>::value)
+            return;
+
+        size_type __left = size();
+        for (size_type __n = 0; __left > 0 && __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            for (_Node *__cur = get_node(m_bucketsFirstIdx[__n]); __cur && __left > 0; __cur = get_node(__cur->m_next), --__left)
+            {
+                std::_Construct(&__cur->m_value);
+            }
+        }
+    }
+
     size_type size() const { return m_num_elements; }
 
     size_type max_size() const { return MAX_SIZE; }
@@ -296,6 +327,11 @@ public:
 
     size_t left_size() const { return size() >= MAX_SIZE ? 0 : MAX_SIZE - size(); }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 每个节点除了value_type之外的部分和桶头都算作额外开销
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(value_type), size(), MAX_SIZE); }
+
     _Node *get_node(int idx)
     {
         if (idx >= 0 && idx < (int) m_buckets.size())
@@ -349,9 +385,9 @@ public:
 
     const_iterator end() const { return const_iterator(0, this); }
 
-    template<class _Vl, class _Ky, int _MAX_SIZE, class _HF, class _Ex, class _Eq>
-    friend bool operator==(const NFShmHashTable<_Vl, _Ky, _MAX_SIZE, _HF, _Ex, _Eq> &,
-                           const NFShmHashTable<_Vl, _Ky, _MAX_SIZE, _HF, _Ex, _Eq> &);
+    template<class _Vl, class _Ky, int _MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+    friend bool operator==(const NFShmHashTable<_Vl, _Ky, _MAX_SIZE, _HF, _Ex, _Eq, _St> &,
+                           const NFShmHashTable<_Vl, _Ky, _MAX_SIZE, _HF, _Ex, _Eq, _St> &);
 
 public:
 
@@ -494,59 +530,44 @@ public:
 
     reference find_or_insert(const value_type &__obj);
 
-    iterator find(const key_type &__key)
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    iterator find(const key_type &__key) { return _M_find(__key); }
 
-        _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    const_iterator find(const key_type &__key) const { return _M_find(__key); }
 
-        return iterator(__first, this);
-    }
+    size_type count(const key_type &__key) const { return _M_count(__key); }
 
-    const_iterator find(const key_type &__key) const
-    {
-        size_type __n = _M_bkt_num_key(__key);
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    std::pair<iterator, iterator>
+    equal_range(const key_type &__key) { return _M_equal_range(__key); }
 
-        const _Node *__first;
-        for (__first = get_node(iFirstIndex);
-             __first && !m_equals(m_get_key(__first->m_value), __key);
-             __first = get_node(__first->m_next)) {}
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type &__key) const { return _M_equal_range(__key); }
 
-        return const_iterator(__first, this);
-    }
+    size_type erase(const key_type &__key) { return _M_erase_key(__key); }
 
-    size_type count(const key_type &__key) const
-    {
-        const size_type __n = _M_bkt_num_key(__key);
-        size_type __result = 0;
-        NF_ASSERT(__n < m_bucketsFirstIdx.size());
-        int iFirstIndex = m_bucketsFirstIdx[__n];
+    /**
+     * @brief 异构查找, HashFcn和EqualKey都定义了is_transparent时才启用.
+     * __key不需要是key_type, 只要能被HashFcn求hash, 并且能和key_type用EqualKey比较(EqualKey(key, __key)),
+     * 同时相同内容的hash值要和对应key_type的hash值一致. 比如用std::string_view, const char*查找NFShmString的key.
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    iterator find(const _Kt &__key) { return _M_find(__key); }
 
-        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
-        {
-            if (m_equals(m_get_key(__cur->m_value), __key))
-            {
-                ++__result;
-            }
-        }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    const_iterator find(const _Kt &__key) const { return _M_find(__key); }
 
-        return __result;
-    }
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type count(const _Kt &__key) const { return _M_count(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<iterator, iterator>
-    equal_range(const key_type &__key);
+    equal_range(const _Kt &__key) { return _M_equal_range(__key); }
 
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
     std::pair<const_iterator, const_iterator>
-    equal_range(const key_type &__key) const;
+    equal_range(const _Kt &__key) const { return _M_equal_range(__key); }
 
-    size_type erase(const key_type &__key);
+    template<class _Kt, class = NFShmHasIsTransparent_t<HashFcn, _Kt>, class = NFShmHasIsTransparent_t<EqualKey, _Kt> >
+    size_type erase(const _Kt &__key) { return _M_erase_key(__key); }
 
     iterator erase(const iterator &__it);
 
@@ -560,6 +581,75 @@ public:
 
     void clear();
 
+    /**
+     * @brief 检查内部结构是否完整, 用于进程崩溃后ResumeInit或者多进程压测结束时校验共享内存中的数据
+     * 每个桶链表中的节点都有效且hash到这个桶, 元素个数和size()一致, 空闲链表和有效节点正好覆盖所有节点.
+     * 遍历所有节点, 只用于调试和校验, 不要在正常逻辑中调用.
+     * @return 结构完整返回true, 否则打印第一个错误并返回false
+     */
+    bool verify() const
+    {
+        size_type __max = m_buckets.size();
+        size_type __count = 0;
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            for (int __idx = m_bucketsFirstIdx[__n]; __idx != -1;)
+            {
+                const _Node *__cur = get_node(__idx);
+                CHECK_EXPR(__cur && __cur->m_valid && __cur->m_self == (size_t) __idx, false, "NFShmHashTable verify failed, bucket:{} invalid node:{}", __n, __idx);
+                CHECK_EXPR(_M_bkt_num(__cur->m_value) == __n, false, "NFShmHashTable verify failed, node:{} in wrong bucket:{}", __idx, __n);
+                CHECK_EXPR(++__count <= __max, false, "NFShmHashTable verify failed, bucket:{} has a loop", __n);
+                __idx = __cur->m_next;
+            }
+        }
+        CHECK_EXPR(__count == size(), false, "NFShmHashTable verify failed, nodes in buckets:{} size:{}", __count, size());
+
+        size_type __free = 0;
+        for (int __idx = m_firstFreeIdx; __idx != -1;)
+        {
+            const _Node *__cur = get_node(__idx);
+            CHECK_EXPR(__cur && !__cur->m_valid, false, "NFShmHashTable verify failed, invalid free node:{}", __idx);
+            CHECK_EXPR(++__free <= __max, false, "NFShmHashTable verify failed, free list has a loop");
+            __idx = __cur->m_next;
+        }
+        CHECK_EXPR(__count + __free == __max, false, "NFShmHashTable verify failed, size:{} free:{} max:{}", __count, __free, __max);
+        return true;
+    }
+
+    /**
+     * @brief 统计链长分布, 最长链, 负载因子, 空桶比例, 再加上运行时计数(StatsPolicy为NFShmHashTableCountStats时).
+     * 只遍历桶和链, 不打日志, 可以在线上对大表调用
+     */
+    NFShmHashTableStats stats() const
+    {
+        NFShmHashTableStats __st;
+        memset(&__st, 0, sizeof(__st));
+        StatsPolicy::copy(_M_stats_counter(), &__st.m_counter);
+        __st.m_size = size();
+        __st.m_bucketCount = m_bucketsFirstIdx.size();
+        for (size_type __n = 0; __n < m_bucketsFirstIdx.size(); ++__n)
+        {
+            size_t __len = 0;
+            for (const _Node *__cur = get_node(m_bucketsFirstIdx[__n]); __cur && __len <= __st.m_size; __cur = get_node(__cur->m_next))
+            {
+                ++__len;
+            }
+            NFShmHashTableStatsAddChain(__st, __len);
+        }
+        NFShmHashTableStatsFinish(__st);
+        return __st;
+    }
+
+    /**
+     * @brief 运行时计数清零
+     */
+    void reset_stats() { StatsPolicy::reset(_M_stats_counter()); }
+
+    /**
+     * @brief 输出find/insert/erase的耗时分布(p50/p99/max), StatsPolicy不是NFShmHashTableProfileStats时返回空串
+     */
+    std::string profile_report(const char *__name) const { return StatsPolicy::report(__name, _M_stats_counter()); }
+
     void debug_string()
     {
         NFLogInfo(NF_LOG_SYSTEMLOG, 0, "----------------NFShmHashTable begin size:{} MAX_SIZE:{}----------------", size(),
@@ -638,7 +728,80 @@ private:
         }
     }
 
-    size_type _M_bkt_num_key(const key_type &__key) const
+    template<class _Kt>
+    iterator _M_find(const _Kt &__key)
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        return iterator(__first, this);
+    }
+
+    template<class _Kt>
+    const_iterator _M_find(const _Kt &__key) const
+    {
+        typename StatsPolicy::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_FIND);
+        size_type __n = _M_bkt_num_key(__key);
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        const _Node *__first;
+        size_type __steps = 0;
+        for (__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+        {
+            ++__steps;
+            if (m_equals(m_get_key(__first->m_value), __key))
+                break;
+        }
+        StatsPolicy::on_find(_M_stats_counter(), __first != NULL, __steps);
+
+        return const_iterator(__first, this);
+    }
+
+    template<class _Kt>
+    size_type _M_count(const _Kt &__key) const
+    {
+        const size_type __n = _M_bkt_num_key(__key);
+        size_type __result = 0;
+        NF_ASSERT(__n < m_bucketsFirstIdx.size());
+        int iFirstIndex = m_bucketsFirstIdx[__n];
+
+        for (const _Node *__cur = get_node(iFirstIndex); __cur; __cur = get_node(__cur->m_next))
+        {
+            if (m_equals(m_get_key(__cur->m_value), __key))
+            {
+                ++__result;
+            }
+        }
+
+        return __result;
+    }
+
+    template<class _Kt>
+    std::pair<iterator, iterator>
+    _M_equal_range(const _Kt &__key);
+
+    template<class _Kt>
+    std::pair<const_iterator, const_iterator>
+    _M_equal_range(const _Kt &__key) const;
+
+    template<class _Kt>
+    size_type _M_erase_key(const _Kt &__key);
+
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key) const
     {
         return _M_bkt_num_key(__key, m_bucketsFirstIdx.size());
     }
@@ -648,7 +811,8 @@ private:
         return _M_bkt_num_key(m_get_key(__obj));
     }
 
-    size_type _M_bkt_num_key(const key_type &__key, size_t __n) const
+    template<class _Kt>
+    size_type _M_bkt_num_key(const _Kt &__key, size_t __n) const
     {
         return m_hash(__key) % __n;
     }
@@ -676,6 +840,7 @@ private:
             std::_Construct(&pNode->m_value, __obj);
         }
 
+        StatsPolicy::on_insert(_M_stats_counter(), pNode != NULL);
         return pNode;
     }
 
@@ -690,6 +855,15 @@ private:
         std::_Destroy(&__n->m_value);
 
         _M_put_node(__n);
+        StatsPolicy::on_erase(_M_stats_counter());
+    }
+
+    /**
+     * @brief 计数块是私有基类, 不统计时是空基类, 不占空间, 共享内存布局和不带统计时一样
+     */
+    typename StatsPolicy::counter_type *_M_stats_counter() const
+    {
+        return const_cast<typename StatsPolicy::counter_type *>(static_cast<const typename StatsPolicy::counter_type *>(this));
     }
 
     void _M_erase_bucket(const size_type __n, _Node *__first, _Node *__last);
@@ -700,9 +874,9 @@ private:
 
 };
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &
-NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &
+NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -716,18 +890,18 @@ NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-inline NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>
-NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>
+NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &
-NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++()
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &
+NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::operator++()
 {
     const _Node *__old = m_curNode;
     m_curNode = m_hashTable->get_node(m_curNode->m_next);
@@ -741,62 +915,62 @@ NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++()
     return *this;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-inline NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>
-NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::operator++(int)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+inline NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>
+NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::operator++(int)
 {
     const_iterator __tmp = *this;
     ++*this;
     return __tmp;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+value_type(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmHashTableIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
 inline std::forward_iterator_tag
-iterator_category(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+iterator_category(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
     return std::forward_iterator_tag();
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
 inline _Val *
-value_type(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+value_type(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
     return (_Val *) 0;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK>
-inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::difference_type *
-distance_type(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK> &)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _ExK, class _EqK, class _St>
+inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::difference_type *
+distance_type(const NFShmHashTableConstIterator<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St> &)
 {
-    return (typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK>::difference_type *) 0;
+    return (typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _ExK, _EqK, _St>::difference_type *) 0;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-bool operator==(const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq> &__ht1,
-                const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq> &__ht2)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+bool operator==(const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St> &__ht1,
+                const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St> &__ht2)
 {
-    typedef typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::_Node _Node;
+    typedef typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::_Node _Node;
     if (__ht1.m_bucketsFirstIdx.size() != __ht2.m_bucketsFirstIdx.size())
         return false;
     for (int __n = 0; __n < (int) __ht1.m_bucketsFirstIdx.size(); ++__n)
@@ -811,16 +985,16 @@ bool operator==(const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq> &__ht1
     return true;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-inline bool operator!=(const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq> &__ht1,
-                       const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq> &__ht2)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+inline bool operator!=(const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St> &__ht1,
+                       const NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St> &__ht2)
 {
     return !(__ht1 == __ht2);
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Extract, class _EqKey>
-inline void swap(NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Extract, _EqKey> &__ht1,
-                 NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Extract, _EqKey> &__ht2)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Extract, class _EqKey, class _St>
+inline void swap(NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Extract, _EqKey, _St> &__ht1,
+                 NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Extract, _EqKey, _St> &__ht2)
 {
     __ht1.swap(__ht2);
 }
@@ -841,11 +1015,12 @@ inline void swap(NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Extract, _EqKey> &__
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator, bool>
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::iterator, bool>
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::insert_unique_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -884,11 +1059,12 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::iterator
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::insert_equal_noresize(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     //已经没有可用的节点了
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
@@ -936,10 +1112,11 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
  * @param __obj
  * @return
  */
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::reference
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::find_or_insert(const value_type &__obj)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::reference
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::find_or_insert(const value_type &__obj)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_INSERT);
     const size_type __n = _M_bkt_num(__obj);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
@@ -960,10 +1137,11 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::find_or_insert(const value_
     return __tmp->m_value;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator,
-        typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator>
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::equal_range(const key_type &__key)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::iterator,
+        typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::iterator>
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::_M_equal_range(const _Kt &__key)
 {
     typedef std::pair<iterator, iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
@@ -994,22 +1172,23 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::equal_range(const key_type
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::const_iterator,
-        typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::const_iterator>
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
-::equal_range(const key_type &__key) const
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+std::pair<typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::const_iterator,
+        typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::const_iterator>
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
+::_M_equal_range(const _Kt &__key) const
 {
     typedef std::pair<const_iterator, const_iterator> _Pii;
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
 
     int iFirstIndex = m_bucketsFirstIdx[__n];
-    for (_Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
+    for (const _Node *__first = get_node(iFirstIndex); __first; __first = get_node(__first->m_next))
     {
         if (m_equals(m_get_key(__first->m_value), __key))
         {
-            for (_Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
+            for (const _Node *__cur = get_node(__first->m_next); __cur; __cur = get_node(__cur->m_next))
             {
                 if (!m_equals(m_get_key(__cur->m_value), __key))
                 {
@@ -1029,10 +1208,12 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
     return _Pii(end(), end());
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::size_type
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const key_type &__key)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+template<class _Kt>
+typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::size_type
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::_M_erase_key(const _Kt &__key)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     const size_type __n = _M_bkt_num_key(__key);
     NF_ASSERT(__n < m_bucketsFirstIdx.size());
     int iFirstIndex = m_bucketsFirstIdx[__n];
@@ -1068,9 +1249,10 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const key_type &__key
     return __erased;
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const iterator &__it)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::iterator NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::erase(const iterator &__it)
 {
+    typename _St::scope __prof(_M_stats_counter(), NFSHM_HASH_PROFILE_ERASE);
     _Node *__p = __it.m_curNode;
     if (__p)
     {
@@ -1111,8 +1293,8 @@ typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::iterator NFShmHash
     return iterator(nullptr, this);
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::erase(iterator __first, iterator __last)
 {
     size_type __f_bucket = __first.m_curNode ?
@@ -1134,9 +1316,9 @@ void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
 inline void
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const_iterator __first,
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::erase(const_iterator __first,
                                                            const_iterator __last)
 {
     erase(iterator(const_cast<_Node *>(__first.m_curNode),
@@ -1145,9 +1327,9 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const_iterator __firs
                    const_cast<NFShmHashTable *>(__last.m_hashTable)));
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::const_iterator
-NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const const_iterator &__it)
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+inline typename NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::const_iterator
+NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::erase(const const_iterator &__it)
 {
     return erase(iterator(const_cast<_Node *>(__it.m_curNode),
                    const_cast<NFShmHashTable *>(__it.m_hashTable)));
@@ -1163,15 +1345,15 @@ NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::erase(const const_iterator
  * @tparam _Eq
  * @param __num_elements_hint
  */
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::resize(size_type __num_elements_hint)
 {
 
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__first, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1193,8 +1375,8 @@ void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::_M_erase_bucket(const size_type __n, _Node *__last)
 {
     _Node *__cur = get_node(m_bucketsFirstIdx[__n]);
@@ -1208,8 +1390,8 @@ void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
     }
 }
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::clear()
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>::clear()
 {
     m_buckets.clear();
     m_bucketsFirstIdx.clear();
@@ -1217,8 +1399,8 @@ void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>::clear()
 }
 
 
-template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq>
-void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq>
+template<class _Val, class _Key, int MAX_SIZE, class _HF, class _Ex, class _Eq, class _St>
+void NFShmHashTable<_Val, _Key, MAX_SIZE, _HF, _Ex, _Eq, _St>
 ::_M_copy_from(const NFShmHashTable &__ht)
 {
     m_buckets.clear();
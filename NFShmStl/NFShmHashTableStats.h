@@ -0,0 +1,212 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmHashTableStats.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmHashTableStats
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFShmProfile.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+/**
+ * @brief 哈希表统计策略, 作为NFShmHashTable系列的最后一个模板参数.
+ * 默认的NFShmHashTableNoStats所有回调都是空的内联函数, 计数块是空结构, 编译后和没有统计的代码一样.
+ * NFShmHashTableCountStats在查找/插入/删除时累加计数, 计数块放在共享内存里
+ * (定长的表是表的成员, Dy表放在Init传入的buffer末尾), 外部进程挂上共享内存就能直接读取.
+ * NFShmHashTableProfileStats在计数之外再用NFShmProfilePolicy的直方图统计find/insert/erase的耗时, 用profile_report输出.
+ *
+ * 用法:
+ * NFShmHashMap<int, Player, 10000, std::hash<int>, std::equal_to<int>, NFShmHashTableCountStats> m_players;
+ * NFShmHashTableStats st = m_players.stats();
+ * NFShmHashMap<int, Player, 10000, std::hash<int>, std::equal_to<int>, NFShmHashTableProfileStats> m_timedPlayers;
+ * NFLogInfo(NF_LOG_SYSTEMLOG, 0, "{}", m_timedPlayers.profile_report("m_timedPlayers"));
+ */
+
+#define NFSHM_HASH_STATS_CHAIN_HIST 16
+
+/**
+ * @brief 哈希表在StatsPolicy为NFShmHashTableProfileStats时统计耗时的操作
+ */
+enum NFShmHashTableProfileOp
+{
+    NFSHM_HASH_PROFILE_FIND = 0,    //!<find
+    NFSHM_HASH_PROFILE_INSERT = 1,  //!<insert_unique/insert_equal/find_or_insert
+    NFSHM_HASH_PROFILE_ERASE = 2,   //!<按key删除和按迭代器删除
+    NFSHM_HASH_PROFILE_OPS = 3,
+};
+
+/**
+ * @brief 运行时计数, 只在使用NFShmHashTableCountStats时存在
+ */
+struct NFShmHashTableCounter
+{
+    uint64_t m_find;       //!<find次数
+    uint64_t m_findHit;    //!<find命中次数
+    uint64_t m_findMiss;   //!<find未命中次数
+    uint64_t m_insert;     //!<新插入的节点数, 插入时key已存在不算
+    uint64_t m_insertFull; //!<没有空闲节点导致插入失败的次数
+    uint64_t m_erase;      //!<删除的节点数, 包括clear
+    uint64_t m_chainSteps; //!<find时比较过的节点总数, 除以m_find就是平均探测长度
+};
+
+/**
+ * @brief stats()的结果, 只遍历桶和链, 不打日志, 可以在线上调用
+ */
+struct NFShmHashTableStats
+{
+    NFShmHashTableCounter m_counter;                    //!<运行时计数, 不开启统计时全为0
+    size_t m_size;                                      //!<元素个数
+    size_t m_bucketCount;                               //!<桶个数
+    size_t m_emptyBuckets;                              //!<空桶个数
+    size_t m_maxChain;                                  //!<最长的链
+    double m_loadFactor;                                //!<元素个数/桶个数
+    double m_emptyBucketRatio;                          //!<空桶个数/桶个数
+    size_t m_chainHist[NFSHM_HASH_STATS_CHAIN_HIST];    //!<m_chainHist[i]为链长为i的桶个数, 最后一项为链长>=NFSHM_HASH_STATS_CHAIN_HIST-1的桶个数
+};
+
+/**
+ * @brief 统计一条链, 由各个哈希表的stats()调用
+ */
+inline void NFShmHashTableStatsAddChain(NFShmHashTableStats &__st, size_t __len)
+{
+    if (__len == 0)
+    {
+        ++__st.m_emptyBuckets;
+    }
+    if (__len > __st.m_maxChain)
+    {
+        __st.m_maxChain = __len;
+    }
+    ++__st.m_chainHist[__len < NFSHM_HASH_STATS_CHAIN_HIST ? __len : NFSHM_HASH_STATS_CHAIN_HIST - 1];
+}
+
+/**
+ * @brief 所有链统计完后计算比例
+ */
+inline void NFShmHashTableStatsFinish(NFShmHashTableStats &__st)
+{
+    if (__st.m_bucketCount > 0)
+    {
+        __st.m_loadFactor = (double) __st.m_size / (double) __st.m_bucketCount;
+        __st.m_emptyBucketRatio = (double) __st.m_emptyBuckets / (double) __st.m_bucketCount;
+    }
+}
+
+/**
+ * @brief 不统计, 默认策略
+ */
+struct NFShmHashTableNoStats
+{
+    struct counter_type
+    {
+    };
+
+    static const bool enabled = false;
+
+    struct scope
+    {
+        scope(counter_type *, int) {}
+    };
+
+    static void on_find(counter_type *, bool, size_t) {}
+
+    static void on_insert(counter_type *, bool) {}
+
+    static void on_erase(counter_type *) {}
+
+    static void reset(counter_type *) {}
+
+    static void copy(const counter_type *, NFShmHashTableCounter *) {}
+
+    static std::string report(const char *, const counter_type *) { return std::string(); }
+};
+
+/**
+ * @brief 计数策略, 每次操作只是几个整数自增, 不加锁, 多进程同时写时计数可能不精确
+ */
+struct NFShmHashTableCountStats
+{
+    typedef NFShmHashTableCounter counter_type;
+
+    static const bool enabled = true;
+
+    struct scope
+    {
+        scope(counter_type *, int) {}
+    };
+
+    static void on_find(counter_type *__c, bool __hit, size_t __steps)
+    {
+        ++__c->m_find;
+        if (__hit)
+            ++__c->m_findHit;
+        else
+            ++__c->m_findMiss;
+        __c->m_chainSteps += __steps;
+    }
+
+    static void on_insert(counter_type *__c, bool __ok)
+    {
+        if (__ok)
+            ++__c->m_insert;
+        else
+            ++__c->m_insertFull;
+    }
+
+    static void on_erase(counter_type *__c) { ++__c->m_erase; }
+
+    static void reset(counter_type *__c) { memset(__c, 0, sizeof(counter_type)); }
+
+    static void copy(const counter_type *__c, NFShmHashTableCounter *__out) { *__out = *__c; }
+
+    static std::string report(const char *, const counter_type *) { return std::string(); }
+};
+
+/**
+ * @brief 计数 + 耗时策略, 计数同NFShmHashTableCountStats, find/insert/erase再按NFShmProfilePolicy采样计时,
+ * 直方图和计数一起放在共享内存的计数块里
+ */
+struct NFShmHashTableProfileStats
+{
+    struct counter_type
+    {
+        NFShmHashTableCounter m_counter;
+        NFShmProfileHistogram m_hist[NFSHM_HASH_PROFILE_OPS];
+    };
+
+    static const bool enabled = true;
+
+    typedef NFShmProfilePolicy::scope scope;
+
+    static void on_find(counter_type *__c, bool __hit, size_t __steps) { NFShmHashTableCountStats::on_find(&__c->m_counter, __hit, __steps); }
+
+    static void on_insert(counter_type *__c, bool __ok) { NFShmHashTableCountStats::on_insert(&__c->m_counter, __ok); }
+
+    static void on_erase(counter_type *__c) { NFShmHashTableCountStats::on_erase(&__c->m_counter); }
+
+    static void reset(counter_type *__c) { memset(__c, 0, sizeof(counter_type)); }
+
+    static void copy(const counter_type *__c, NFShmHashTableCounter *__out) { *__out = __c->m_counter; }
+
+    static std::string report(const char *__name, const counter_type *__c)
+    {
+        static const char *const __names[NFSHM_HASH_PROFILE_OPS] = {"find", "insert", "erase"};
+        return NFShmProfileReport(__name, __c->m_hist, NFSHM_HASH_PROFILE_OPS, __names);
+    }
+};
+
+/**
+ * @brief Dy哈希表在buffer中为计数块预留的大小, 不统计时为0, 不改变原来的内存布局
+ */
+template<class StatsPolicy>
+struct NFShmHashTableStatsSize
+{
+    static const size_t value = StatsPolicy::enabled ? sizeof(typename StatsPolicy::counter_type) : 0;
+};
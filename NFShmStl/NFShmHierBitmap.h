@@ -0,0 +1,355 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmHierBitmap.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmHierBitmap
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFShmBitSet.h"
+#include <vector>
+
+/**
+ * @brief 第k层的字数, 第0层是位本身, 第k层的每一位对应第k-1层的一个字
+ */
+constexpr size_t NFShmHierBitmapWords(size_t __bits, int __k)
+{
+    return __k == 0 ? (__bits + 63) / 64 : (NFShmHierBitmapWords(__bits, __k - 1) + 63) / 64;
+}
+
+/**
+ * @brief 层数, 最上层只有一个字
+ */
+constexpr int NFShmHierBitmapLevels(size_t __bits, int __k = 0)
+{
+    return NFShmHierBitmapWords(__bits, __k) <= 1 ? __k + 1 : NFShmHierBitmapLevels(__bits, __k + 1);
+}
+
+/**
+ * @brief 第k层(k >= 1)在摘要数组中的起始位置
+ */
+constexpr size_t NFShmHierBitmapOffset(size_t __bits, int __k)
+{
+    return __k <= 1 ? 0 : NFShmHierBitmapOffset(__bits, __k - 1) + NFShmHierBitmapWords(__bits, __k - 1);
+}
+
+/**
+ * @brief 分层位图, 放在共享内存里. 在底层的位之上加两套摘要:
+ * m_any的每一位表示下一层对应的字里有1, m_open的每一位表示下一层对应的字里有0.
+ * 每层64倍, 1600万位只有4层, find_first_set/find_first_zero/find_next_*都是从上往下每层一次ctz,
+ * 不会在大片全0或全1的区域逐字扫描. 适合在几百万个id里分配最小的空闲id, 以及遍历很稀疏的集合.
+ * set/reset只在底层的字由空变非空, 由满变不满(或反过来)时才往上更新摘要, 一般只写一个字.
+ * 额外内存是底层的2/63.
+ *
+ * 全是POD, 恢复时校验摘要, 更新摘要的中途崩溃时按底层重建.
+ *
+ * 用法:
+ * NFShmHierBitmap<4 * 1024 * 1024> m_roleIds;
+ * size_t id = m_roleIds.allocate();    //最小的空闲id, 满了返回size()
+ * m_roleIds.reset(id);                //释放
+ */
+template<size_t BITS>
+class NFShmHierBitmap
+{
+public:
+    static_assert(BITS > 0, "NFShmHierBitmap BITS must be positive");
+
+    enum
+    {
+        LEVELS = NFShmHierBitmapLevels(BITS),
+        LEAF_WORDS = NFShmHierBitmapWords(BITS, 0),
+        SUMMARY_WORDS = NFShmHierBitmapOffset(BITS, LEVELS),
+    };
+
+public:
+    NFShmHierBitmap()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        clear();
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (!verify())
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmHierBitmap summary inconsistent after resume, rebuild, count:{}", m_count);
+            rebuild();
+        }
+        return 0;
+    }
+
+public:
+    static size_t size() { return BITS; }
+
+    size_t count() const { return m_count; }
+
+    bool none() const { return m_count == 0; }
+
+    bool all() const { return m_count == BITS; }
+
+    bool test(size_t __pos) const { return (m_leaf[__pos >> 6] >> (__pos & 63)) & 1; }
+
+    bool operator[](size_t __pos) const { return test(__pos); }
+
+    /**
+     * @brief 置1, 原来就是1时返回false
+     */
+    bool set(size_t __pos)
+    {
+        CHECK_EXPR(__pos < BITS, false, "NFShmHierBitmap set pos:{} >= BITS:{}", __pos, BITS);
+        size_t __w = __pos >> 6;
+        uint64_t __old = m_leaf[__w];
+        uint64_t __new = __old | (1ull << (__pos & 63));
+        if (__new == __old)
+            return false;
+        m_leaf[__w] = __new;
+        ++m_count;
+        if (__old == 0)
+            _M_up_set(m_any, __w);
+        if (_M_full(__w, __new))
+            _M_up_clear(m_open, __w);
+        return true;
+    }
+
+    /**
+     * @brief 清0, 原来就是0时返回false
+     */
+    bool reset(size_t __pos)
+    {
+        CHECK_EXPR(__pos < BITS, false, "NFShmHierBitmap reset pos:{} >= BITS:{}", __pos, BITS);
+        size_t __w = __pos >> 6;
+        uint64_t __old = m_leaf[__w];
+        uint64_t __new = __old & ~(1ull << (__pos & 63));
+        if (__new == __old)
+            return false;
+        m_leaf[__w] = __new;
+        --m_count;
+        if (_M_full(__w, __old))
+            _M_up_set(m_open, __w);
+        if (__new == 0)
+            _M_up_clear(m_any, __w);
+        return true;
+    }
+
+    /**
+     * @brief 找到最小的0并置1, 用于分配id, 满了返回size()
+     */
+    size_t allocate()
+    {
+        size_t __pos = find_first_zero();
+        if (__pos < BITS)
+            set(__pos);
+        return __pos;
+    }
+
+    /**
+     * @brief 第一个为1的位, 没有时返回size()
+     */
+    size_t find_first_set() const { return _M_find_next(0, false); }
+
+    /**
+     * @brief 下标 >= __pos 的第一个为1的位, 没有时返回size()
+     */
+    size_t find_next_set(size_t __pos) const { return _M_find_next(__pos, false); }
+
+    size_t find_first_zero() const { return _M_find_next(0, true); }
+
+    size_t find_next_zero(size_t __pos) const { return _M_find_next(__pos, true); }
+
+    /**
+     * @brief 对每个为1的位调用__f(pos), 按下标从小到大, 全0的字靠摘要跳过
+     */
+    template<class F>
+    void for_each_set(F __f) const
+    {
+        for (size_t __pos = find_first_set(); __pos < BITS; __pos = find_next_set(__pos + 1))
+        {
+            uint64_t __bits = m_leaf[__pos >> 6] >> (__pos & 63) << (__pos & 63);
+            size_t __base = __pos & ~(size_t) 63;
+            for (; __bits != 0; __bits &= __bits - 1)
+                __f(__base + NFShmBitOps::ctz(__bits));
+            __pos = __base + 63;
+        }
+    }
+
+    void clear()
+    {
+        memset(m_leaf, 0, sizeof(m_leaf));
+        memset(m_any, 0, sizeof(m_any));
+        memset(m_open, 0, sizeof(m_open));
+        size_t __words = LEAF_WORDS;
+        for (int __k = 1; __k < LEVELS; ++__k)
+        {
+            uint64_t *__level = m_open + NFShmHierBitmapOffset(BITS, __k);
+            for (size_t j = 0; j < __words; ++j)
+                __level[j >> 6] |= 1ull << (j & 63);
+            __words = (__words + 63) / 64;
+        }
+        m_count = 0;
+    }
+
+    /**
+     * @brief 按底层的位重新计算两套摘要和计数
+     */
+    void rebuild()
+    {
+        std::vector<uint64_t> __any, __open;
+        size_t __count = 0;
+        _M_compute(__any, __open, __count);
+        if (SUMMARY_WORDS > 0)
+        {
+            memcpy(m_any, &__any[0], sizeof(uint64_t) * SUMMARY_WORDS);
+            memcpy(m_open, &__open[0], sizeof(uint64_t) * SUMMARY_WORDS);
+        }
+        m_count = __count;
+    }
+
+    bool verify() const
+    {
+        std::vector<uint64_t> __any, __open;
+        size_t __count = 0;
+        _M_compute(__any, __open, __count);
+        CHECK_EXPR(__count == m_count, false, "NFShmHierBitmap verify failed, count:{} != {}", m_count, __count);
+        CHECK_EXPR(SUMMARY_WORDS == 0 || memcmp(m_any, &__any[0], sizeof(uint64_t) * SUMMARY_WORDS) == 0, false, "NFShmHierBitmap verify failed, set summary mismatch");
+        CHECK_EXPR(SUMMARY_WORDS == 0 || memcmp(m_open, &__open[0], sizeof(uint64_t) * SUMMARY_WORDS) == 0, false, "NFShmHierBitmap verify failed, zero summary mismatch");
+        return true;
+    }
+
+    const uint64_t *words() const { return m_leaf; }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(uint64_t), LEAF_WORDS, LEAF_WORDS); }
+
+private:
+    /**
+     * @brief 底层的字是否全1, 最后一个字里超出BITS的位当作1
+     */
+    static bool _M_full(size_t __w, uint64_t __v) { return (__v | _M_phantom(__w)) == ~0ull; }
+
+    static uint64_t _M_phantom(size_t __w) { return (BITS & 63) && __w == LEAF_WORDS - 1 ? ~((1ull << (BITS & 63)) - 1) : 0; }
+
+    uint64_t _M_leaf_bits(size_t __w, bool __zero) const { return __zero ? ~(m_leaf[__w] | _M_phantom(__w)) : m_leaf[__w]; }
+
+    /**
+     * @brief 在摘要里把第1层的第__idx位置1, 那个字原来是0时继续往上
+     */
+    static void _M_up_set(uint64_t *__summary, size_t __idx)
+    {
+        size_t __off = 0, __words = NFShmHierBitmapWords(BITS, 1);
+        for (int __k = 1; __k < LEVELS; ++__k)
+        {
+            uint64_t &__word = __summary[__off + (__idx >> 6)];
+            uint64_t __old = __word;
+            __word = __old | (1ull << (__idx & 63));
+            if (__old != 0)
+                return;
+            __idx >>= 6;
+            __off += __words;
+            __words = (__words + 63) / 64;
+        }
+    }
+
+    /**
+     * @brief 在摘要里把第1层的第__idx位清0, 那个字变成0时继续往上
+     */
+    static void _M_up_clear(uint64_t *__summary, size_t __idx)
+    {
+        size_t __off = 0, __words = NFShmHierBitmapWords(BITS, 1);
+        for (int __k = 1; __k < LEVELS; ++__k)
+        {
+            uint64_t &__word = __summary[__off + (__idx >> 6)];
+            __word &= ~(1ull << (__idx & 63));
+            if (__word != 0)
+                return;
+            __idx >>= 6;
+            __off += __words;
+            __words = (__words + 63) / 64;
+        }
+    }
+
+    /**
+     * @brief 先看__pos所在的字; 没有就往上找第一个在当前位置之后、摘要位为1的字, 再从那里每层取最低位下降
+     */
+    size_t _M_find_next(size_t __pos, bool __zero) const
+    {
+        if (__pos >= BITS)
+            return BITS;
+        const uint64_t *__summary = __zero ? m_open : m_any;
+        size_t __idx = __pos >> 6;
+        uint64_t __bits = _M_leaf_bits(__idx, __zero) & (~0ull << (__pos & 63));
+        if (__bits != 0)
+            return (__idx << 6) + NFShmBitOps::ctz(__bits);
+
+        size_t __off[LEVELS > 1 ? LEVELS : 2];
+        size_t __o = 0, __words = NFShmHierBitmapWords(BITS, 1);
+        for (int __k = 1; __k < LEVELS; ++__k)
+        {
+            __off[__k] = __o;
+            // 第k层中, 在第k-1层第__idx个字之后的位
+            uint64_t __s = __summary[__o + (__idx >> 6)] & ((~0ull << (__idx & 63)) << 1);
+            if (__s != 0)
+            {
+                __idx = (__idx & ~(size_t) 63) + NFShmBitOps::ctz(__s);
+                for (int __d = __k - 1; __d >= 1; --__d)
+                    __idx = (__idx << 6) + NFShmBitOps::ctz(__summary[__off[__d] + __idx]);
+                return (__idx << 6) + NFShmBitOps::ctz(_M_leaf_bits(__idx, __zero));
+            }
+            __idx >>= 6;
+            __o += __words;
+            __words = (__words + 63) / 64;
+        }
+        return BITS;
+    }
+
+    void _M_compute(std::vector<uint64_t> &__any, std::vector<uint64_t> &__open, size_t &__count) const
+    {
+        __any.assign(SUMMARY_WORDS > 0 ? SUMMARY_WORDS : 1, 0);
+        __open.assign(SUMMARY_WORDS > 0 ? SUMMARY_WORDS : 1, 0);
+        __count = 0;
+        for (size_t __w = 0; __w < LEAF_WORDS; ++__w)
+            __count += NFShmBitOps::popcount(m_leaf[__w]);
+        if (LEVELS == 1)
+            return;
+        for (size_t __w = 0; __w < LEAF_WORDS; ++__w)
+        {
+            if (m_leaf[__w] != 0)
+                __any[__w >> 6] |= 1ull << (__w & 63);
+            if (!_M_full(__w, m_leaf[__w]))
+                __open[__w >> 6] |= 1ull << (__w & 63);
+        }
+        size_t __words = NFShmHierBitmapWords(BITS, 1);
+        for (int __k = 2; __k < LEVELS; ++__k)
+        {
+            size_t __below = NFShmHierBitmapOffset(BITS, __k - 1);
+            size_t __here = NFShmHierBitmapOffset(BITS, __k);
+            for (size_t j = 0; j < __words; ++j)
+            {
+                if (__any[__below + j] != 0)
+                    __any[__here + (j >> 6)] |= 1ull << (j & 63);
+                if (__open[__below + j] != 0)
+                    __open[__here + (j >> 6)] |= 1ull << (j & 63);
+            }
+            __words = (__words + 63) / 64;
+        }
+    }
+
+    uint64_t m_leaf[LEAF_WORDS];
+    uint64_t m_any[SUMMARY_WORDS > 0 ? SUMMARY_WORDS : 1];
+    uint64_t m_open[SUMMARY_WORDS > 0 ? SUMMARY_WORDS : 1];
+    size_t m_count;
+};
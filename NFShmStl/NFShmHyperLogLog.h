@@ -0,0 +1,556 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmHyperLogLog.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmHyperLogLog
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#define NFSHM_HLL_SPARSE_BITS 25        //!<稀疏表示用的索引位数, 相当于2^25个寄存器, 小基数时几乎没有误差
+
+/**
+ * @brief HyperLogLog基数估计, 统计"有多少个不同的key"(每个区的独立访客等), 固定大小, 放在共享内存里.
+ * 2^P个寄存器, 标准误差约 1.04 / sqrt(2^P), P=14时16KB, 误差约0.81%.
+ * 两种表示共用同一块内存:
+ * 稀疏: 刚开始时是一个以25位索引为key的开放寻址表, 每项32位(索引 << 6 | rho), 基数很小时用线性计数几乎精确.
+ *       表用到3/4(2^P * 3 / 16项)时转成稠密.
+ * 稠密: 每个寄存器一个uint8, 估计值用Ertl(2017)的改进估计, 不需要经验偏差表, 全区间误差一致.
+ * 多进程: add可以多个进程同时调用. 稠密时寄存器用CAS取最大值, 绝大多数add只读不写;
+ * 稀疏时用共享内存里的自旋锁串行化(只在基数很小时, 持锁时间很短), 转稠密也在锁内完成.
+ * merge用SIMD按字节取最大值(AVX2一次32个, SSE2一次16个), 合并期间目标不能有并发的add.
+ *
+ * 用法:
+ * NFShmHyperLogLog<14> m_zoneVisitors;
+ * m_zoneVisitors.add(playerId);
+ * uint64_t uv = (uint64_t) m_zoneVisitors.estimate();
+ */
+template<int P = 14>
+class NFShmHyperLogLog
+{
+public:
+    static_assert(P >= 4 && P <= 18, "NFShmHyperLogLog P must be in [4, 18]");
+
+    enum
+    {
+        REGISTER_COUNT = 1 << P,
+        SPARSE_CAPACITY = REGISTER_COUNT / 4,           //!<稀疏表的槽数, 和稠密寄存器占同样的字节
+        SPARSE_LIMIT = SPARSE_CAPACITY * 3 / 4,         //!<稀疏表的项数达到这个值时转成稠密
+        MAX_RHO = 64 - P + 1,                           //!<寄存器的最大值
+    };
+
+    NFShmHyperLogLog()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    int CreateInit()
+    {
+        clear();
+        m_lock = 0;
+        return 0;
+    }
+
+    /**
+     * @brief 寄存器都是POD, 只需要放掉崩溃前可能没释放的锁
+     */
+    int ResumeInit()
+    {
+        m_lock = 0;
+        return 0;
+    }
+
+public:
+    template<class Key, class HashFcn = std::hash<Key> >
+    void add(const Key &__key) { add_hash((uint64_t) HashFcn()(__key)); }
+
+    /**
+     * @brief 加入一个hash值, 多进程安全. 先过fmix64, 整数key的std::hash是原值, 不打散的话索引和rho都不随机
+     */
+    void add_hash(uint64_t __hash)
+    {
+        uint64_t __h = _NFShmHashFmix64(__hash);
+        if (!_M_is_dense())
+        {
+            _M_lock();
+            if (!_M_is_dense())
+            {
+                _M_sparse_add(_M_sparse_encode(__h));
+                if (m_sparseSize >= SPARSE_LIMIT)
+                {
+                    _M_to_dense();
+                }
+                _M_unlock();
+                return;
+            }
+            _M_unlock();
+        }
+        _M_dense_max((int) (__h >> (64 - P)), _M_rho(__h << P, 64 - P));
+    }
+
+    /**
+     * @brief 估计的不同key个数
+     */
+    double estimate() const
+    {
+        if (!_M_is_dense())
+        {
+            _M_lock();
+            double __est = _M_is_dense() ? _M_dense_estimate() : _M_sparse_estimate();
+            _M_unlock();
+            return __est;
+        }
+        return _M_dense_estimate();
+    }
+
+    /**
+     * @brief 合并另一个同样精度的HLL(比如多个区汇总), 结果等于两边key的并集的HLL
+     */
+    void merge(const NFShmHyperLogLog &__x)
+    {
+        _M_lock();
+        if (!__x._M_is_dense())
+        {
+            for (int i = 0; i < SPARSE_CAPACITY; ++i)
+            {
+                uint32_t __e = __x.m_sparse[i];
+                if (__e == 0)
+                    continue;
+                if (_M_is_dense())
+                {
+                    _M_dense_put(__e);
+                }
+                else
+                {
+                    _M_sparse_add(__e);
+                    if (m_sparseSize >= SPARSE_LIMIT)
+                        _M_to_dense();
+                }
+            }
+            _M_unlock();
+            return;
+        }
+        if (!_M_is_dense())
+        {
+            _M_to_dense();
+        }
+        _M_merge_max(m_reg, __x.m_reg);
+        _M_unlock();
+    }
+
+    void clear()
+    {
+        memset(m_reg, 0, sizeof(m_reg));
+        m_sparseSize = 0;
+        m_dense = 0;
+    }
+
+    bool is_sparse() const { return !_M_is_dense(); }
+
+    /**
+     * @brief 理论标准误差 1.04 / sqrt(2^P)
+     */
+    static double relative_error() { return 1.04 / sqrt((double) REGISTER_COUNT); }
+
+    NFShmMemoryStats memory_stats() const
+    {
+        return NFShmMakeMemoryStats(sizeof(*this), 1, REGISTER_COUNT, REGISTER_COUNT);
+    }
+
+private:
+    /**
+     * @brief __w的前导0个数+1, 最多__bits+1
+     */
+    static int _M_rho(uint64_t __w, int __bits)
+    {
+        if (__w == 0)
+            return __bits + 1;
+#if defined(_MSC_VER)
+        unsigned long __msb;
+        _BitScanReverse64(&__msb, __w);
+        int __clz = 63 - (int) __msb;
+#else
+        int __clz = __builtin_clzll(__w);
+#endif
+        return __clz < __bits ? __clz + 1 : __bits + 1;
+    }
+
+    /**
+     * @brief 稀疏项: 高25位作索引, 剩下39位算rho(最大40), 编码为 索引 << 6 | rho, rho >= 1所以项不为0
+     */
+    static uint32_t _M_sparse_encode(uint64_t __h)
+    {
+        uint32_t __idx = (uint32_t) (__h >> (64 - NFSHM_HLL_SPARSE_BITS));
+        int __rho = _M_rho(__h << NFSHM_HLL_SPARSE_BITS, 64 - NFSHM_HLL_SPARSE_BITS);
+        return (__idx << 6) | (uint32_t) __rho;
+    }
+
+    /**
+     * @brief 稀疏项换算成稠密寄存器: 25位索引的高P位是寄存器号, 低25-P位不全为0时rho由它们决定, 否则再加上稀疏的rho
+     * @return 寄存器号 << 8 | rho
+     */
+    static uint32_t _M_dense_entry(uint32_t __e)
+    {
+        uint32_t __idx = __e >> 6;
+        int __rho = (int) (__e & 63);
+        const int __low = NFSHM_HLL_SPARSE_BITS - P;
+        uint64_t __lowBits = __idx & ((1u << __low) - 1);
+        if (__lowBits != 0)
+            __rho = _M_rho(__lowBits << (64 - __low), __low);
+        else
+            __rho += __low;
+        return ((__idx >> __low) << 8) | (uint32_t) __rho;
+    }
+
+    void _M_dense_put(uint32_t __e)
+    {
+        uint32_t __d = _M_dense_entry(__e);
+        _M_dense_max((int) (__d >> 8), (int) (__d & 0xFF));
+    }
+
+    void _M_sparse_add(uint32_t __e)
+    {
+        uint32_t __idx = __e >> 6;
+        uint32_t __pos = (__idx * 0x9E3779B1u) >> (32 - (P - 2));
+        while (true)
+        {
+            uint32_t __old = m_sparse[__pos];
+            if (__old == 0)
+            {
+                m_sparse[__pos] = __e;
+                ++m_sparseSize;
+                return;
+            }
+            if ((__old >> 6) == __idx)
+            {
+                if ((__e & 63) > (__old & 63))
+                    m_sparse[__pos] = __e;
+                return;
+            }
+            __pos = (__pos + 1) & (SPARSE_CAPACITY - 1);
+        }
+    }
+
+    /**
+     * @brief 稀疏转稠密, 在锁内调用, 不分配内存. 两种表示共用内存, 原地转换:
+     * 1. 稀疏项压到表头, 换算成 寄存器号 << 8 | rho, 按寄存器号的高8位原地分到256个桶里(American flag sort);
+     * 2. 逐桶在栈上展开成这一段寄存器(最多1KB, 另有一个非0位图), 从前往后编码: 非0寄存器写一个字节的rho(1~MAX_RHO, 最高位0),
+     *    之前连续的0寄存器写成1~3个最高位为1的字节(每字节7位长度). 每个非0寄存器最多写4个字节,
+     *    一个桶的项都读完了才写它的编码, 写的位置不会超过下一个桶没读的项;
+     * 3. 从后往前解码: 每个编码字节至少展开成一个寄存器, 写的位置总在没读的编码之后.
+     */
+    void _M_to_dense()
+    {
+        enum
+        {
+            BUCKET_SHIFT = P > 8 ? P - 8 : 0,
+            BUCKET_REGS = 1 << BUCKET_SHIFT,
+        };
+        int __n = 0;
+        for (int i = 0; i < SPARSE_CAPACITY; ++i)
+        {
+            if (m_sparse[i] != 0)
+                m_sparse[__n++] = _M_dense_entry(m_sparse[i]);
+        }
+
+        int __end[256];
+        int __next[256];
+        memset(__end, 0, sizeof(__end));
+        for (int i = 0; i < __n; ++i)
+            ++__end[m_sparse[i] >> (8 + BUCKET_SHIFT)];
+        int __sum = 0;
+        for (int b = 0; b < 256; ++b)
+        {
+            __next[b] = __sum;
+            __sum += __end[b];
+            __end[b] = __sum;
+        }
+        for (int b = 0; b < 256; ++b)
+        {
+            while (__next[b] < __end[b])
+            {
+                uint32_t __v = m_sparse[__next[b]];
+                int __d = (int) (__v >> (8 + BUCKET_SHIFT));
+                while (__d != b)
+                {
+                    std::swap(__v, m_sparse[__next[__d]++]);
+                    __d = (int) (__v >> (8 + BUCKET_SHIFT));
+                }
+                m_sparse[__next[b]++] = __v;
+            }
+        }
+
+        uint8_t *__code = m_reg;
+        int __len = 0;
+        int __last = -1;
+        uint8_t __local[BUCKET_REGS];
+        uint64_t __used[(BUCKET_REGS + 63) / 64];
+        for (int b = 0, __begin = 0; b < 256; __begin = __end[b++])
+        {
+            if (__begin == __end[b])
+                continue;
+            memset(__used, 0, sizeof(__used));
+            for (int i = __begin; i < __end[b]; ++i)
+            {
+                uint32_t __e = m_sparse[i];
+                int r = (int) ((__e >> 8) & (BUCKET_REGS - 1));
+                uint64_t __bit = 1ull << (r & 63);
+                if ((__used[r >> 6] & __bit) == 0 || (__e & 0xFF) > __local[r])
+                    __local[r] = (uint8_t) (__e & 0xFF);
+                __used[r >> 6] |= __bit;
+            }
+            //只走有值的寄存器
+            for (int w = 0; w < (BUCKET_REGS + 63) / 64; ++w)
+            {
+                for (uint64_t __m = __used[w]; __m != 0; __m &= __m - 1)
+                {
+                    int r = w * 64 + _M_ctz(__m);
+                    int __reg = b * BUCKET_REGS + r;
+                    __len = _M_code_zeros(__code, __len, __reg - __last - 1);
+                    __code[__len++] = __local[r];
+                    __last = __reg;
+                }
+            }
+        }
+
+        int __p = __last;
+        memset(m_reg + __last + 1, 0, REGISTER_COUNT - __last - 1);
+        for (int __c = __len - 1; __c >= 0;)
+        {
+            if ((__code[__c] & 0x80) == 0)
+            {
+                m_reg[__p--] = __code[__c--];
+                continue;
+            }
+            int __c0 = __c;
+            while (__c0 > 0 && (__code[__c0 - 1] & 0x80) != 0)
+                --__c0;
+            int __zeros = 0;
+            for (int k = __c0; k <= __c; ++k)
+                __zeros = (__zeros << 7) | (__code[k] & 0x7F);
+            for (; __zeros > 0; --__zeros)
+                m_reg[__p--] = 0;
+            __c = __c0 - 1;
+        }
+        m_sparseSize = 0;
+#if defined(_MSC_VER)
+        _InterlockedExchange((volatile long *) &m_dense, 1);
+#else
+        __atomic_store_n(&m_dense, 1u, __ATOMIC_RELEASE);
+#endif
+    }
+
+    static int _M_ctz(uint64_t __w)
+    {
+#if defined(_MSC_VER)
+        unsigned long __lsb;
+        _BitScanForward64(&__lsb, __w);
+        return (int) __lsb;
+#else
+        return __builtin_ctzll(__w);
+#endif
+    }
+
+    /**
+     * @brief 写__zeros个0寄存器的游程长度, 高位在前, 字节数不超过__zeros(1字节<128, 2字节<16384, 3字节<2^21)
+     */
+    static int _M_code_zeros(uint8_t *__code, int __len, int __zeros)
+    {
+        if (__zeros <= 0)
+            return __len;
+        if (__zeros >= (1 << 14))
+            __code[__len++] = (uint8_t) (0x80 | ((__zeros >> 14) & 0x7F));
+        if (__zeros >= (1 << 7))
+            __code[__len++] = (uint8_t) (0x80 | ((__zeros >> 7) & 0x7F));
+        __code[__len++] = (uint8_t) (0x80 | (__zeros & 0x7F));
+        return __len;
+    }
+
+    /**
+     * @brief 寄存器取最大值, 先读一次, 只有变大时才CAS
+     */
+    void _M_dense_max(int __i, int __rho)
+    {
+        uint8_t *__p = &m_reg[__i];
+#if defined(_MSC_VER)
+        uint8_t __old = *(volatile uint8_t *) __p;
+        while (__rho > __old)
+        {
+            uint8_t __cur = (uint8_t) _InterlockedCompareExchange8((volatile char *) __p, (char) __rho, (char) __old);
+            if (__cur == __old)
+                break;
+            __old = __cur;
+        }
+#else
+        uint8_t __old = __atomic_load_n(__p, __ATOMIC_RELAXED);
+        while (__rho > __old)
+        {
+            if (__atomic_compare_exchange_n(__p, &__old, (uint8_t) __rho, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+#endif
+    }
+
+    static void _M_merge_max(uint8_t *__dst, const uint8_t *__src)
+    {
+        int i = 0;
+#if defined(__AVX2__)
+        for (; i + 32 <= REGISTER_COUNT; i += 32)
+        {
+            __m256i __a = _mm256_loadu_si256((const __m256i *) (__dst + i));
+            __m256i __b = _mm256_loadu_si256((const __m256i *) (__src + i));
+            _mm256_storeu_si256((__m256i *) (__dst + i), _mm256_max_epu8(__a, __b));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 16 <= REGISTER_COUNT; i += 16)
+        {
+            __m128i __a = _mm_loadu_si128((const __m128i *) (__dst + i));
+            __m128i __b = _mm_loadu_si128((const __m128i *) (__src + i));
+            _mm_storeu_si128((__m128i *) (__dst + i), _mm_max_epu8(__a, __b));
+        }
+#endif
+        for (; i < REGISTER_COUNT; ++i)
+        {
+            if (__src[i] > __dst[i])
+                __dst[i] = __src[i];
+        }
+    }
+
+    /**
+     * @brief 稀疏时相当于2^25个寄存器的线性计数, 项数远小于2^25, 误差可以忽略
+     */
+    double _M_sparse_estimate() const
+    {
+        double __m = (double) (1u << NFSHM_HLL_SPARSE_BITS);
+        return __m * log(__m / (__m - (double) m_sparseSize));
+    }
+
+    /**
+     * @brief Ertl, "New cardinality estimation algorithms for HyperLogLog sketches"(2017)中的改进估计
+     */
+    double _M_dense_estimate() const
+    {
+        uint32_t __hist[MAX_RHO + 1];
+        memset(__hist, 0, sizeof(__hist));
+        for (int i = 0; i < REGISTER_COUNT; ++i)
+        {
+            ++__hist[m_reg[i]];
+        }
+        const double __m = (double) REGISTER_COUNT;
+        double __z = __m * _M_tau(1.0 - (double) __hist[MAX_RHO] / __m);
+        for (int k = MAX_RHO - 1; k >= 1; --k)
+        {
+            __z += __hist[k];
+            __z *= 0.5;
+        }
+        __z += __m * _M_sigma((double) __hist[0] / __m);
+        return 0.5 / log(2.0) * __m * __m / __z;
+    }
+
+    static double _M_sigma(double __x)
+    {
+        if (__x == 1.0)
+            return INFINITY;
+        double __y = 1.0;
+        double __z = __x;
+        double __old;
+        do
+        {
+            __x *= __x;
+            __old = __z;
+            __z += __x * __y;
+            __y += __y;
+        } while (__z != __old);
+        return __z;
+    }
+
+    static double _M_tau(double __x)
+    {
+        if (__x == 0.0 || __x == 1.0)
+            return 0.0;
+        double __y = 1.0;
+        double __z = 1.0 - __x;
+        double __old;
+        do
+        {
+            __x = sqrt(__x);
+            __old = __z;
+            __y *= 0.5;
+            __z -= (1.0 - __x) * (1.0 - __x) * __y;
+        } while (__z != __old);
+        return __z / 3.0;
+    }
+
+    bool _M_is_dense() const
+    {
+#if defined(_MSC_VER)
+        return *(volatile const uint32_t *) &m_dense != 0;
+#else
+        return __atomic_load_n(&m_dense, __ATOMIC_ACQUIRE) != 0;
+#endif
+    }
+
+    void _M_lock() const
+    {
+#if defined(_MSC_VER)
+        while (_InterlockedExchange((volatile long *) &m_lock, 1) != 0)
+        {
+            while (*(volatile uint32_t *) &m_lock != 0)
+            {
+            }
+        }
+#else
+        while (__atomic_exchange_n(&m_lock, 1u, __ATOMIC_ACQUIRE) != 0)
+        {
+            while (__atomic_load_n(&m_lock, __ATOMIC_RELAXED) != 0)
+            {
+            }
+        }
+#endif
+    }
+
+    void _M_unlock() const
+    {
+#if defined(_MSC_VER)
+        _InterlockedExchange((volatile long *) &m_lock, 0);
+#else
+        __atomic_store_n(&m_lock, 0u, __ATOMIC_RELEASE);
+#endif
+    }
+
+    union
+    {
+        alignas(64) uint8_t m_reg[REGISTER_COUNT];     //!<稠密寄存器
+        uint32_t m_sparse[SPARSE_CAPACITY];             //!<稀疏表
+    };
+    uint32_t m_sparseSize;
+    uint32_t m_dense;
+    mutable uint32_t m_lock;
+};
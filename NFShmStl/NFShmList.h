@@ -13,10 +13,22 @@
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFComm/NFPluginModule/NFCheck.h"
 #include "NFComm/NFShmStl/NFShmStl.h"
+#include "NFShmProfile.h"
 #include <iterator>
 #include <algorithm>
 #include <vector>
 
+/**
+ * @brief NFShmList在ProfilePolicy为NFShmProfilePolicy时统计耗时的操作
+ */
+enum NFShmListProfileOp
+{
+    NFSHM_LIST_PROFILE_INSERT = 0,
+    NFSHM_LIST_PROFILE_ERASE = 1,
+    NFSHM_LIST_PROFILE_SPLICE = 2,
+    NFSHM_LIST_PROFILE_OPS = 3,
+};
+
 struct NFShmListNodeBase
 {
     NFShmListNodeBase()
@@ -210,7 +222,9 @@ public:
     {
         m_size = 0;
         m_freeStart = 0;
+#if NF_SHM_ZERO_ON_CREATE
         memset(m_mem, 0, sizeof(m_mem));
+#endif
         m_node = (NFShmListNode<Tp>*)m_mem;
 
         for (size_t i = 0; i < MAX_SIZE; i++)
@@ -232,14 +246,13 @@ public:
     int ResumeInit()
     {
         m_node = (NFShmListNode<Tp>*)m_mem;
-        if (!std::numeric_limits<Tp>::is_specialized)
+        if (NFShmResumeConstruct<Tp>::value)
         {
-            for (size_t i = 0; i < MAX_SIZE; i++)
+            // 只沿已用链表走, 不扫描整个节点数组; 最多走m_size步, 崩溃时损坏的链表也不会死循环
+            size_t __n = 0;
+            for (ptrdiff_t i = m_node[MAX_SIZE].m_next; i >= 0 && i < (ptrdiff_t) MAX_SIZE && __n < m_size; i = m_node[i].m_next, ++__n)
             {
-                if (m_node[i].m_valid)
-                {
-                    std::_Construct(&m_node[i].m_data);
-                }
+                std::_Construct(&m_node[i].m_data);
             }
         }
 
@@ -280,14 +293,15 @@ protected:
     size_t m_size;
 };
 
-template<class Tp, size_t MAX_SIZE>
-class NFShmList : protected NFShmListBase<Tp, MAX_SIZE>
+template<class Tp, size_t MAX_SIZE, class ProfilePolicy = NFShmProfileNone>
+class NFShmList : protected NFShmListBase<Tp, MAX_SIZE>, private ProfilePolicy::template data_type<NFSHM_LIST_PROFILE_OPS>
 {
     typedef NFShmListBase<Tp, MAX_SIZE> _Base;
+    typedef typename ProfilePolicy::template data_type<NFSHM_LIST_PROFILE_OPS> _Profile;
 protected:
     typedef void *_Void_pointer;
 public:
-    typedef NFShmList<Tp, MAX_SIZE> ListType;
+    typedef NFShmList<Tp, MAX_SIZE, ProfilePolicy> ListType;
     typedef Tp value_type;
     typedef value_type *pointer;
     typedef const value_type *const_pointer;
@@ -408,13 +422,13 @@ public:
         this->insert(begin(), __first, __last);
     }
 
-    template<size_t X_MAX_SIZE>
-    NFShmList(const NFShmList<Tp, X_MAX_SIZE> &__x)
+    template<size_t X_MAX_SIZE, class X_ProfilePolicy>
+    NFShmList(const NFShmList<Tp, X_MAX_SIZE, X_ProfilePolicy> &__x)
     {
         insert(begin(), __x.begin(), __x.end());
     }
 
-    NFShmList(const NFShmList<Tp, MAX_SIZE> &__x)
+    NFShmList(const NFShmList<Tp, MAX_SIZE, ProfilePolicy> &__x)
     {
         insert(begin(), __x.begin(), __x.end());
     }
@@ -432,7 +446,7 @@ public:
 
     }
 
-    NFShmList<Tp, MAX_SIZE> &operator=(const NFShmList<Tp, MAX_SIZE> &__x);
+    NFShmList<Tp, MAX_SIZE, ProfilePolicy> &operator=(const NFShmList<Tp, MAX_SIZE, ProfilePolicy> &__x);
 
 public:
     iterator begin() { return iterator(this, m_node[MAX_SIZE].m_next); }
@@ -479,6 +493,11 @@ public:
 
     size_type capacity() const { return MAX_SIZE; }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(Tp), m_size, MAX_SIZE); }
+
     reference front() { return *begin(); }
 
     const_reference front() const { return *begin(); }
@@ -487,7 +506,7 @@ public:
 
     const_reference back() const { return *(--end()); }
 
-    void swap(NFShmList<Tp, MAX_SIZE> &__x) {}
+    void swap(NFShmList<Tp, MAX_SIZE, ProfilePolicy> &__x) {}
 
     _Node *GetNode(size_t index)
     {
@@ -521,6 +540,7 @@ public:
     */
     iterator insert(iterator __position, const Tp &__x)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_LIST_PROFILE_INSERT);
         if (full())
         {
             NFLogWarning(NF_LOG_SYSTEMLOG, 0, "The List Space Not Enough, Insert Failed");
@@ -576,6 +596,7 @@ public:
      */
     iterator erase(iterator __position)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_LIST_PROFILE_ERASE);
         if (__position == end())
         {
             return end();
@@ -635,12 +656,14 @@ protected:
     }
 public:
     void splice(iterator __position, iterator __i) {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_LIST_PROFILE_SPLICE);
         iterator __j = __i;
         ++__j;
         if (__position == __i || __position == __j) return;
         this->transfer(__position, __i, __j);
     }
     void splice(iterator __position, iterator __first, iterator __last) {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_LIST_PROFILE_SPLICE);
         if (__first != __last)
             this->transfer(__position, __first, __last);
     }
@@ -673,7 +696,20 @@ public:
     template<class _BinaryPredicate>
     void unique(_BinaryPredicate);
 
+    /**
+     * @brief 输出各操作的耗时分布(p50/p99/max), ProfilePolicy为NFShmProfileNone时返回空串
+     */
+    std::string profile_report(const char *__name) const
+    {
+        static const char *const __names[NFSHM_LIST_PROFILE_OPS] = {"insert", "erase", "splice"};
+        return ProfilePolicy::report(__name, _M_profile(), NFSHM_LIST_PROFILE_OPS, __names);
+    }
+
+    void reset_profile() { ProfilePolicy::reset(_M_profile()); }
+
 protected:
+    _Profile *_M_profile() const { return const_cast<_Profile *>(static_cast<const _Profile *>(this)); }
+
     template<class _Integer>
     void _M_insert_dispatch(iterator __pos, _Integer __n, _Integer __x, std::__true_type)
     {
@@ -695,10 +731,10 @@ protected:
     void _M_fill_insert(iterator __pos, size_type __n, const Tp &__x);
 };
 
-template<class Tp, size_t MAX_SIZE>
-inline bool operator==(const NFShmList<Tp, MAX_SIZE> &__x, const NFShmList<Tp, MAX_SIZE> &__y)
+template<class Tp, size_t MAX_SIZE, class _Pp>
+inline bool operator==(const NFShmList<Tp, MAX_SIZE, _Pp> &__x, const NFShmList<Tp, MAX_SIZE, _Pp> &__y)
 {
-    typedef typename NFShmList<Tp, MAX_SIZE>::const_iterator const_iterator;
+    typedef typename NFShmList<Tp, MAX_SIZE, _Pp>::const_iterator const_iterator;
     const_iterator __end1 = __x.end();
     const_iterator __end2 = __y.end();
 
@@ -712,48 +748,48 @@ inline bool operator==(const NFShmList<Tp, MAX_SIZE> &__x, const NFShmList<Tp, M
     return __i1 == __end1 && __i2 == __end2;
 }
 
-template<class Tp, size_t MAX_SIZE>
-inline bool operator<(const NFShmList<Tp, MAX_SIZE> &__x,
-                      const NFShmList<Tp, MAX_SIZE> &__y)
+template<class Tp, size_t MAX_SIZE, class _Pp>
+inline bool operator<(const NFShmList<Tp, MAX_SIZE, _Pp> &__x,
+                      const NFShmList<Tp, MAX_SIZE, _Pp> &__y)
 {
     return std::lexicographical_compare(__x.begin(), __x.end(),
                                         __y.begin(), __y.end());
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _InputIter>
-void NFShmList<_Tp, MAX_SIZE>::_M_insert_dispatch(iterator __position, _InputIter __first, _InputIter __last, std::__false_type)
+void NFShmList<_Tp, MAX_SIZE, _Pp>::_M_insert_dispatch(iterator __position, _InputIter __first, _InputIter __last, std::__false_type)
 {
     for (; __first != __last; ++__first)
         insert(__position, *__first);
 }
 
-template<class Tp, size_t MAX_SIZE>
-void NFShmList<Tp, MAX_SIZE>::insert(iterator __position,
+template<class Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<Tp, MAX_SIZE, _Pp>::insert(iterator __position,
                                      const Tp *__first, const Tp *__last)
 {
     for (; __first != __last; ++__first)
         insert(__position, *__first);
 }
 
-template<class Tp, size_t MAX_SIZE>
-void NFShmList<Tp, MAX_SIZE>::insert(iterator __position,
+template<class Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<Tp, MAX_SIZE, _Pp>::insert(iterator __position,
                                      const_iterator __first, const_iterator __last)
 {
     for (; __first != __last; ++__first)
         insert(__position, *__first);
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmList<_Tp, MAX_SIZE>::_M_fill_insert(iterator __position,
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<_Tp, MAX_SIZE, _Pp>::_M_fill_insert(iterator __position,
                                               size_type __n, const _Tp &__x)
 {
     for (; __n > 0; --__n)
         insert(__position, __x);
 }
 
-template<class _Tp, size_t MAX_SIZE>
-typename NFShmList<_Tp, MAX_SIZE>::iterator NFShmList<_Tp, MAX_SIZE>::erase(iterator __first,
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+typename NFShmList<_Tp, MAX_SIZE, _Pp>::iterator NFShmList<_Tp, MAX_SIZE, _Pp>::erase(iterator __first,
                                                                             iterator __last)
 {
     while (__first != __last)
@@ -761,8 +797,8 @@ typename NFShmList<_Tp, MAX_SIZE>::iterator NFShmList<_Tp, MAX_SIZE>::erase(iter
     return __last;
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmList<_Tp, MAX_SIZE>::resize(size_type __new_size, const _Tp &__x)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<_Tp, MAX_SIZE, _Pp>::resize(size_type __new_size, const _Tp &__x)
 {
     iterator __i = begin();
     size_type __len = 0;
@@ -773,8 +809,8 @@ void NFShmList<_Tp, MAX_SIZE>::resize(size_type __new_size, const _Tp &__x)
         insert(end(), __new_size - __len, __x);
 }
 
-template<class _Tp, size_t MAX_SIZE>
-NFShmList<_Tp, MAX_SIZE> &NFShmList<_Tp, MAX_SIZE>::operator=(const NFShmList<_Tp, MAX_SIZE> &__x)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+NFShmList<_Tp, MAX_SIZE, _Pp> &NFShmList<_Tp, MAX_SIZE, _Pp>::operator=(const NFShmList<_Tp, MAX_SIZE, _Pp> &__x)
 {
     if (this != &__x)
     {
@@ -792,8 +828,8 @@ NFShmList<_Tp, MAX_SIZE> &NFShmList<_Tp, MAX_SIZE>::operator=(const NFShmList<_T
     return *this;
 }
 
-template<class _Tp, size_t MAX_SIZEc>
-void NFShmList<_Tp, MAX_SIZEc>::_M_fill_assign(size_type __n, const _Tp &__val)
+template<class _Tp, size_t MAX_SIZEc, class _Pp>
+void NFShmList<_Tp, MAX_SIZEc, _Pp>::_M_fill_assign(size_type __n, const _Tp &__val)
 {
     iterator __i = begin();
     for (; __i != end() && __n > 0; ++__i, --__n)
@@ -804,9 +840,9 @@ void NFShmList<_Tp, MAX_SIZEc>::_M_fill_assign(size_type __n, const _Tp &__val)
         erase(__i, end());
 }
 
-template<class _Tp, size_t MAX_SIZEc>
+template<class _Tp, size_t MAX_SIZEc, class _Pp>
 template<class _InputIter>
-void NFShmList<_Tp, MAX_SIZEc>::_M_assign_dispatch(_InputIter __first2, _InputIter __last2, std::__false_type)
+void NFShmList<_Tp, MAX_SIZEc, _Pp>::_M_assign_dispatch(_InputIter __first2, _InputIter __last2, std::__false_type)
 {
     iterator __first1 = begin();
     iterator __last1 = end();
@@ -819,8 +855,8 @@ void NFShmList<_Tp, MAX_SIZEc>::_M_assign_dispatch(_InputIter __first2, _InputIt
 }
 
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmList<_Tp, MAX_SIZE>::remove(const _Tp &__value)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<_Tp, MAX_SIZE, _Pp>::remove(const _Tp &__value)
 {
     iterator __first = begin();
     iterator __last = end();
@@ -833,8 +869,8 @@ void NFShmList<_Tp, MAX_SIZE>::remove(const _Tp &__value)
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmList<_Tp, MAX_SIZE>::unique()
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmList<_Tp, MAX_SIZE, _Pp>::unique()
 {
     iterator __first = begin();
     iterator __last = end();
@@ -850,15 +886,15 @@ void NFShmList<_Tp, MAX_SIZE>::unique()
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
-inline void NFShmList<_Tp, MAX_SIZE>::reverse()
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+inline void NFShmList<_Tp, MAX_SIZE, _Pp>::reverse()
 {
     std::reverse(begin(), end());
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _Predicate>
-void NFShmList<_Tp, MAX_SIZE>::remove_if(_Predicate __pred)
+void NFShmList<_Tp, MAX_SIZE, _Pp>::remove_if(_Predicate __pred)
 {
     iterator __first = begin();
     iterator __last = end();
@@ -871,9 +907,9 @@ void NFShmList<_Tp, MAX_SIZE>::remove_if(_Predicate __pred)
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _BinaryPredicate>
-void NFShmList<_Tp, MAX_SIZE>::unique(_BinaryPredicate __binary_pred)
+void NFShmList<_Tp, MAX_SIZE, _Pp>::unique(_BinaryPredicate __binary_pred)
 {
     iterator __first = begin();
     iterator __last = end();
@@ -0,0 +1,65 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmMemoryStats.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmMemoryStats
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief 容器的内存使用情况, 由各个容器的memory_stats()返回, 用来规划共享内存段的大小.
+ * 定长容器的m_totalBytes就是sizeof(容器), Dy容器是Init时buffer中用到的字节数(即CountSize(max_size())).
+ * 三部分满足 m_liveBytes + m_overheadBytes + m_freeBytes == m_totalBytes.
+ *
+ * 编译期规划内存用NFShmFootprint:
+ * static_assert(NFShmFootprint<NFShmHashMap<int, Player, 10000> >() < 64 * 1024 * 1024, "player map too big");
+ * size_t bufSize = NFShmFootprint<NFShmDyVector<int> >(10000);
+ */
+struct NFShmMemoryStats
+{
+    size_t m_totalBytes;    //!<容器占用的全部字节
+    size_t m_liveBytes;     //!<存活元素的字节, size() * sizeof(value_type)
+    size_t m_overheadBytes; //!<节点链接, 桶头, 计数等额外开销
+    size_t m_freeBytes;     //!<空闲容量的字节, (max_size() - size()) * sizeof(value_type)
+    size_t m_size;          //!<元素个数
+    size_t m_capacity;      //!<最多能放的元素个数
+};
+
+/**
+ * @brief 按元素大小和个数填充NFShmMemoryStats, 总字节数中除去存活元素和空闲容量的部分都算作额外开销
+ */
+inline NFShmMemoryStats NFShmMakeMemoryStats(size_t __total, size_t __elemBytes, size_t __size, size_t __capacity)
+{
+    NFShmMemoryStats __st;
+    __st.m_totalBytes = __total;
+    __st.m_size = __size;
+    __st.m_capacity = __capacity;
+    __st.m_liveBytes = __elemBytes * __size;
+    __st.m_freeBytes = __capacity > __size ? __elemBytes * (__capacity - __size) : 0;
+    __st.m_overheadBytes = __total > __st.m_liveBytes + __st.m_freeBytes ? __total - __st.m_liveBytes - __st.m_freeBytes : 0;
+    return __st;
+}
+
+/**
+ * @brief 定长容器占用的字节数, 可以用在static_assert中
+ */
+template<class Container>
+constexpr size_t NFShmFootprint()
+{
+    return sizeof(Container);
+}
+
+/**
+ * @brief Dy容器放iObjectCount个元素时Init需要的buffer大小, 不包括容器对象本身
+ */
+template<class Container>
+constexpr size_t NFShmFootprint(int iObjectCount)
+{
+    return Container::CountSize(iObjectCount);
+}
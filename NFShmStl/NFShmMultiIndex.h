@@ -0,0 +1,1228 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmMultiIndex.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmMultiIndex
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+/**
+ * @brief 多索引容器: 每个元素只在节点池里存一份, 在它上面挂多个哈希索引和有序索引, 类似boost::multi_index.
+ * 插入/删除/修改一次调用同时更新所有索引, 不会出现几个容器各存一份, 手工同步不一致的问题.
+ *
+ * 索引只保存节点下标(哈希索引每个节点一个next, 有序索引每个节点left/right/parent), 不复制元素和key.
+ * 有序索引是下标链接的treap, 优先级由节点下标hash得到, 不占内存, 期望O(log n).
+ * 元素只能通过modify/replace修改, 迭代器只给const引用, 否则改了key索引就错了.
+ *
+ * 崩溃恢复: 节点的m_valid是唯一的事实来源, 链表和所有索引都可以由它推出来.
+ * ResumeInit时先校验, 不一致(比如上次在更新索引的中途崩溃)就调用rebuild_indexes重建, 保证恢复后所有索引一致.
+ *
+ * 用法:
+ * typedef NFShmMultiIndex<Player, 10000,
+ *         NFShmHashedUnique<NFShmMemberKey<Player, uint64_t, &Player::m_playerId> >,
+ *         NFShmHashedUnique<NFShmMemberKey<Player, uint64_t, &Player::m_accountId> >,
+ *         NFShmHashedUnique<NFShmMemberKey<Player, NFShmString<32>, &Player::m_name>, NFShmStringHash>,
+ *         NFShmOrderedNonUnique<NFShmMemberKey<Player, int, &Player::m_level> > > PlayerTable;
+ * PlayerTable m_players;
+ * m_players.insert(player);
+ * PlayerTable::iterator it = m_players.get<0>().find(playerId);
+ * m_players.modify(it, [](Player &p) { ++p.m_level; });
+ * for (auto lit = m_players.get<3>().lower_bound(50); lit != m_players.get<3>().end(); ++lit) {...}
+ */
+
+/**
+ * @brief 取成员作为key
+ */
+template<class Val, class Type, Type Val::*PtrToMember>
+struct NFShmMemberKey
+{
+    typedef Type result_type;
+
+    const Type &operator()(const Val &__v) const { return __v.*PtrToMember; }
+};
+
+/**
+ * @brief 模板参数为void时用默认的hash/比较函数
+ */
+template<class Given, class Default>
+struct _NFShmMultiIndexDefault
+{
+    typedef Given type;
+};
+
+template<class Default>
+struct _NFShmMultiIndexDefault<void, Default>
+{
+    typedef Default type;
+};
+
+template<class Container>
+struct NFShmMultiIndexIterator
+{
+    typedef typename Container::value_type value_type;
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef const value_type &reference;
+    typedef const value_type *pointer;
+    typedef NFShmMultiIndexIterator<Container> _Self;
+
+    const Container *m_pContainer;
+    int m_node;
+
+    NFShmMultiIndexIterator(const Container *pContainer, int iNode) : m_pContainer(pContainer), m_node(iNode) {}
+
+    NFShmMultiIndexIterator() : m_pContainer(NULL), m_node(-1) {}
+
+    reference operator*() const { return m_pContainer->_M_value(m_node); }
+
+    pointer operator->() const { return &(operator*()); }
+
+    _Self &operator++()
+    {
+        m_node = m_pContainer->_M_list_next(m_node);
+        return *this;
+    }
+
+    _Self operator++(int)
+    {
+        _Self __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    bool operator==(const _Self &__it) const { return m_node == __it.m_node; }
+
+    bool operator!=(const _Self &__it) const { return m_node != __it.m_node; }
+};
+
+/**
+ * @brief 有序索引的迭代器, 按key从小到大, 可以转换成容器的迭代器传给erase/modify
+ */
+template<class Container, class Index>
+struct NFShmMultiIndexOrderedIterator
+{
+    typedef typename Container::value_type value_type;
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef const value_type &reference;
+    typedef const value_type *pointer;
+    typedef NFShmMultiIndexOrderedIterator<Container, Index> _Self;
+
+    const Container *m_pContainer;
+    const Index *m_pIndex;
+    int m_node;
+
+    NFShmMultiIndexOrderedIterator(const Container *pContainer, const Index *pIndex, int iNode) : m_pContainer(pContainer), m_pIndex(pIndex), m_node(iNode) {}
+
+    NFShmMultiIndexOrderedIterator() : m_pContainer(NULL), m_pIndex(NULL), m_node(-1) {}
+
+    operator typename Container::iterator() const { return typename Container::iterator(m_pContainer, m_node); }
+
+    reference operator*() const { return m_pContainer->_M_value(m_node); }
+
+    pointer operator->() const { return &(operator*()); }
+
+    _Self &operator++()
+    {
+        m_node = m_pIndex->_M_next(m_node);
+        return *this;
+    }
+
+    _Self operator++(int)
+    {
+        _Self __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    _Self &operator--()
+    {
+        m_node = m_node == -1 ? m_pIndex->_M_last() : m_pIndex->_M_prev(m_node);
+        return *this;
+    }
+
+    _Self operator--(int)
+    {
+        _Self __tmp = *this;
+        --*this;
+        return __tmp;
+    }
+
+    bool operator==(const _Self &__it) const { return m_node == __it.m_node; }
+
+    bool operator!=(const _Self &__it) const { return m_node != __it.m_node; }
+};
+
+/**
+ * @brief 哈希索引, 桶数等于MAX_SIZE, 拉链用节点下标链接
+ */
+template<class Val, int MAX_SIZE, class KeyFromValue, class Hash, class Pred, bool UNIQUE>
+class NFShmMultiIndexHashedIndex
+{
+public:
+    typedef typename std::decay<decltype(KeyFromValue()(std::declval<const Val &>()))>::type key_type;
+    typedef typename _NFShmMultiIndexDefault<Hash, std::hash<key_type> >::type hasher;
+    typedef typename _NFShmMultiIndexDefault<Pred, std::equal_to<key_type> >::type key_equal;
+    typedef NFShmMultiIndexHashedIndex<Val, MAX_SIZE, KeyFromValue, Hash, Pred, UNIQUE> _Self;
+
+    NFShmMultiIndexHashedIndex() {}
+
+    /**
+     * @brief 通过容器的get<I>()拿到, 只保存两个指针, 按值传递
+     */
+    template<class Container>
+    class view
+    {
+    public:
+        typedef typename Container::iterator iterator;
+
+        view(Container *pContainer, _Self *pIndex) : m_pContainer(pContainer), m_pIndex(pIndex) {}
+
+        iterator find(const key_type &__k) const { return iterator(m_pContainer, m_pIndex->_M_find(*m_pContainer, __k)); }
+
+        iterator end() const { return m_pContainer->end(); }
+
+        size_t count(const key_type &__k) const { return m_pIndex->_M_count(*m_pContainer, __k); }
+
+        bool contains(const key_type &__k) const { return m_pIndex->_M_find(*m_pContainer, __k) != -1; }
+
+        /**
+         * @brief 删除key等于__k的所有元素
+         */
+        size_t erase(const key_type &__k)
+        {
+            size_t __n = 0;
+            for (int __node = m_pIndex->_M_find(*m_pContainer, __k); __node != -1; __node = m_pIndex->_M_find(*m_pContainer, __k))
+            {
+                m_pContainer->erase(iterator(m_pContainer, __node));
+                ++__n;
+            }
+            return __n;
+        }
+
+    private:
+        Container *m_pContainer;
+        _Self *m_pIndex;
+    };
+
+    void _M_create_init()
+    {
+        memset(m_bucket, -1, sizeof(m_bucket));
+    }
+
+    static int _M_bucket(const key_type &__k)
+    {
+        uint64_t __h = _NFShmHashMix((uint64_t) hasher()(__k), 0x9E3779B97F4A7C15ull);
+        return (int) (((__h >> 32) * (uint64_t) MAX_SIZE) >> 32);
+    }
+
+    template<class Container>
+    int _M_find(const Container &__c, const key_type &__k) const
+    {
+        for (int __n = m_bucket[_M_bucket(__k)]; __n != -1; __n = m_next[__n])
+        {
+            if (key_equal()(KeyFromValue()(__c._M_value(__n)), __k))
+                return __n;
+        }
+        return -1;
+    }
+
+    template<class Container>
+    size_t _M_count(const Container &__c, const key_type &__k) const
+    {
+        size_t __count = 0;
+        for (int __n = m_bucket[_M_bucket(__k)]; __n != -1; __n = m_next[__n])
+        {
+            if (key_equal()(KeyFromValue()(__c._M_value(__n)), __k))
+                ++__count;
+        }
+        return __count;
+    }
+
+    /**
+     * @brief 唯一索引中已有和__v的key相同的元素(不算节点__self)时返回它的下标, 否则返回-1
+     */
+    template<class Container>
+    int _M_conflict(const Container &__c, const Val &__v, int __self) const
+    {
+        if (!UNIQUE)
+            return -1;
+        // modify时__self可能还在同一个桶的链上, 要看完整条链, 不能只看第一个相等的
+        const key_type &__k = KeyFromValue()(__v);
+        for (int __n = m_bucket[_M_bucket(__k)]; __n != -1; __n = m_next[__n])
+        {
+            if (__n != __self && key_equal()(KeyFromValue()(__c._M_value(__n)), __k))
+                return __n;
+        }
+        return -1;
+    }
+
+    template<class Container>
+    void _M_link(const Container &__c, int __n)
+    {
+        int __b = _M_bucket(KeyFromValue()(__c._M_value(__n)));
+        m_next[__n] = m_bucket[__b];
+        m_bucket[__b] = __n;
+    }
+
+    template<class Container>
+    void _M_unlink(const Container &__c, int __n)
+    {
+        int *__p = &m_bucket[_M_bucket(KeyFromValue()(__c._M_value(__n)))];
+        while (*__p != -1)
+        {
+            if (*__p == __n)
+            {
+                *__p = m_next[__n];
+                return;
+            }
+            __p = &m_next[*__p];
+        }
+    }
+
+    /**
+     * @brief modify前记下元素所在的桶
+     */
+    template<class Container>
+    int _M_modify_begin(const Container &__c, int __n) const { return _M_bucket(KeyFromValue()(__c._M_value(__n))); }
+
+    /**
+     * @brief modify后key换了桶才从原来的桶摘下, 返回true表示需要重新挂上
+     */
+    template<class Container>
+    bool _M_modify_check(const Container &__c, int __n, int __oldBucket)
+    {
+        if (_M_bucket(KeyFromValue()(__c._M_value(__n))) == __oldBucket)
+            return false;
+        int *__p = &m_bucket[__oldBucket];
+        while (*__p != -1)
+        {
+            if (*__p == __n)
+            {
+                *__p = m_next[__n];
+                break;
+            }
+            __p = &m_next[*__p];
+        }
+        return true;
+    }
+
+    template<class Container>
+    bool _M_verify(const Container &__c) const
+    {
+        int __count = 0;
+        for (int __b = 0; __b < MAX_SIZE; ++__b)
+        {
+            for (int __n = m_bucket[__b]; __n != -1; __n = m_next[__n])
+            {
+                CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && __c._M_valid(__n), false, "NFShmMultiIndex hashed index verify failed, bucket:{} invalid node:{}", __b, __n);
+                CHECK_EXPR(_M_bucket(KeyFromValue()(__c._M_value(__n))) == __b, false, "NFShmMultiIndex hashed index verify failed, node:{} in wrong bucket:{}", __n, __b);
+                CHECK_EXPR(++__count <= (int) __c.size(), false, "NFShmMultiIndex hashed index verify failed, bucket:{} has a loop", __b);
+                if (UNIQUE)
+                {
+                    for (int __m = m_next[__n]; __m != -1 && __m >= 0 && __m < MAX_SIZE; __m = m_next[__m])
+                    {
+                        CHECK_EXPR(!key_equal()(KeyFromValue()(__c._M_value(__n)), KeyFromValue()(__c._M_value(__m))), false,
+                                   "NFShmMultiIndex hashed index verify failed, duplicate key in unique index, node:{} node:{}", __n, __m);
+                    }
+                }
+            }
+        }
+        CHECK_EXPR(__count == (int) __c.size(), false, "NFShmMultiIndex hashed index verify failed, nodes in buckets:{} size:{}", __count, __c.size());
+        return true;
+    }
+
+private:
+    int m_bucket[MAX_SIZE];
+    int m_next[MAX_SIZE];
+};
+
+/**
+ * @brief 有序索引, 下标链接的treap. 相同key的元素按插入顺序排列
+ */
+template<class Val, int MAX_SIZE, class KeyFromValue, class Compare, bool UNIQUE>
+class NFShmMultiIndexOrderedIndex
+{
+public:
+    typedef typename std::decay<decltype(KeyFromValue()(std::declval<const Val &>()))>::type key_type;
+    typedef typename _NFShmMultiIndexDefault<Compare, std::less<key_type> >::type key_compare;
+    typedef NFShmMultiIndexOrderedIndex<Val, MAX_SIZE, KeyFromValue, Compare, UNIQUE> _Self;
+
+    NFShmMultiIndexOrderedIndex() {}
+
+    template<class Container>
+    class view
+    {
+    public:
+        typedef NFShmMultiIndexOrderedIterator<Container, _Self> iterator;
+        typedef iterator const_iterator;
+
+        view(Container *pContainer, _Self *pIndex) : m_pContainer(pContainer), m_pIndex(pIndex) {}
+
+        iterator begin() const { return _M_it(m_pIndex->_M_first()); }
+
+        iterator end() const { return _M_it(-1); }
+
+        iterator find(const key_type &__k) const { return _M_it(m_pIndex->_M_find(*m_pContainer, __k)); }
+
+        iterator lower_bound(const key_type &__k) const { return _M_it(m_pIndex->_M_lower_bound(*m_pContainer, __k)); }
+
+        iterator upper_bound(const key_type &__k) const { return _M_it(m_pIndex->_M_upper_bound(*m_pContainer, __k)); }
+
+        std::pair<iterator, iterator> equal_range(const key_type &__k) const { return std::make_pair(lower_bound(__k), upper_bound(__k)); }
+
+        size_t count(const key_type &__k) const
+        {
+            size_t __n = 0;
+            for (iterator __it = lower_bound(__k); __it != end() && !key_compare()(__k, KeyFromValue()(*__it)); ++__it)
+                ++__n;
+            return __n;
+        }
+
+        size_t erase(const key_type &__k)
+        {
+            size_t __n = 0;
+            int __node = m_pIndex->_M_lower_bound(*m_pContainer, __k);
+            while (__node != -1 && !key_compare()(__k, KeyFromValue()(m_pContainer->_M_value(__node))))
+            {
+                int __next = m_pIndex->_M_next(__node);
+                m_pContainer->erase(typename Container::iterator(m_pContainer, __node));
+                __node = __next;
+                ++__n;
+            }
+            return __n;
+        }
+
+    private:
+        iterator _M_it(int __n) const { return iterator(m_pContainer, m_pIndex, __n); }
+
+        Container *m_pContainer;
+        _Self *m_pIndex;
+    };
+
+    void _M_create_init()
+    {
+        m_root = -1;
+    }
+
+    /**
+     * @brief 优先级由下标hash得到, 和key无关, 所以树的期望高度是O(log n)
+     */
+    static uint32_t _M_priority(int __n) { return (uint32_t) _NFShmHashMix((uint64_t) __n, 0x9E3779B97F4A7C15ull); }
+
+    template<class Container>
+    int _M_lower_bound(const Container &__c, const key_type &__k) const
+    {
+        int __res = -1;
+        for (int __n = m_root; __n != -1;)
+        {
+            if (!key_compare()(KeyFromValue()(__c._M_value(__n)), __k))
+            {
+                __res = __n;
+                __n = m_link[__n].m_left;
+            }
+            else
+            {
+                __n = m_link[__n].m_right;
+            }
+        }
+        return __res;
+    }
+
+    template<class Container>
+    int _M_upper_bound(const Container &__c, const key_type &__k) const
+    {
+        int __res = -1;
+        for (int __n = m_root; __n != -1;)
+        {
+            if (key_compare()(__k, KeyFromValue()(__c._M_value(__n))))
+            {
+                __res = __n;
+                __n = m_link[__n].m_left;
+            }
+            else
+            {
+                __n = m_link[__n].m_right;
+            }
+        }
+        return __res;
+    }
+
+    template<class Container>
+    int _M_find(const Container &__c, const key_type &__k) const
+    {
+        int __n = _M_lower_bound(__c, __k);
+        if (__n != -1 && !key_compare()(__k, KeyFromValue()(__c._M_value(__n))))
+            return __n;
+        return -1;
+    }
+
+    template<class Container>
+    int _M_conflict(const Container &__c, const Val &__v, int __self) const
+    {
+        if (!UNIQUE)
+            return -1;
+        // modify时__self可能还挂在树上, 排在相同key的最前面, 要看完所有相同key的节点
+        const key_type &__k = KeyFromValue()(__v);
+        for (int __n = _M_lower_bound(__c, __k); __n != -1 && !key_compare()(__k, KeyFromValue()(__c._M_value(__n))); __n = _M_next(__n))
+        {
+            if (__n != __self)
+                return __n;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief 按key下降到叶子插入(相同key往右, 保持插入顺序), 再按优先级向上旋转
+     */
+    template<class Container>
+    void _M_link(const Container &__c, int __n)
+    {
+        const key_type &__k = KeyFromValue()(__c._M_value(__n));
+        int __parent = -1;
+        bool __left = false;
+        for (int __cur = m_root; __cur != -1;)
+        {
+            __parent = __cur;
+            __left = key_compare()(__k, KeyFromValue()(__c._M_value(__cur)));
+            __cur = __left ? m_link[__cur].m_left : m_link[__cur].m_right;
+        }
+        m_link[__n].m_left = -1;
+        m_link[__n].m_right = -1;
+        m_link[__n].m_parent = __parent;
+        if (__parent == -1)
+            m_root = __n;
+        else if (__left)
+            m_link[__parent].m_left = __n;
+        else
+            m_link[__parent].m_right = __n;
+
+        uint32_t __prio = _M_priority(__n);
+        while (m_link[__n].m_parent != -1 && _M_priority(m_link[__n].m_parent) < __prio)
+        {
+            if (m_link[m_link[__n].m_parent].m_left == __n)
+                _M_rotate_right(m_link[__n].m_parent);
+            else
+                _M_rotate_left(m_link[__n].m_parent);
+        }
+    }
+
+    /**
+     * @brief 旋转到叶子再摘掉, 不需要读元素, modify时元素已经改了也能正确摘除
+     */
+    template<class Container>
+    void _M_unlink(const Container &, int __n)
+    {
+        while (m_link[__n].m_left != -1 || m_link[__n].m_right != -1)
+        {
+            if (m_link[__n].m_left == -1)
+                _M_rotate_left(__n);
+            else if (m_link[__n].m_right == -1)
+                _M_rotate_right(__n);
+            else if (_M_priority(m_link[__n].m_left) > _M_priority(m_link[__n].m_right))
+                _M_rotate_right(__n);
+            else
+                _M_rotate_left(__n);
+        }
+        int __p = m_link[__n].m_parent;
+        if (__p == -1)
+            m_root = -1;
+        else if (m_link[__p].m_left == __n)
+            m_link[__p].m_left = -1;
+        else
+            m_link[__p].m_right = -1;
+    }
+
+    template<class Container>
+    int _M_modify_begin(const Container &, int) const { return 0; }
+
+    /**
+     * @brief modify后和前后相邻元素比较, 顺序没变就留在原位, 否则摘下, 返回true表示需要重新挂上
+     */
+    template<class Container>
+    bool _M_modify_check(const Container &__c, int __n, int)
+    {
+        const key_type &__k = KeyFromValue()(__c._M_value(__n));
+        int __prev = _M_prev(__n);
+        int __next = _M_next(__n);
+        bool __inPlace = true;
+        if (__prev != -1)
+        {
+            const key_type &__pk = KeyFromValue()(__c._M_value(__prev));
+            __inPlace = UNIQUE ? key_compare()(__pk, __k) : !key_compare()(__k, __pk);
+        }
+        if (__inPlace && __next != -1)
+        {
+            const key_type &__nk = KeyFromValue()(__c._M_value(__next));
+            __inPlace = UNIQUE ? key_compare()(__k, __nk) : !key_compare()(__nk, __k);
+        }
+        if (__inPlace)
+            return false;
+        _M_unlink(__c, __n);
+        return true;
+    }
+
+    int _M_first() const
+    {
+        int __n = m_root;
+        while (__n != -1 && m_link[__n].m_left != -1)
+            __n = m_link[__n].m_left;
+        return __n;
+    }
+
+    int _M_last() const
+    {
+        int __n = m_root;
+        while (__n != -1 && m_link[__n].m_right != -1)
+            __n = m_link[__n].m_right;
+        return __n;
+    }
+
+    int _M_next(int __n) const
+    {
+        if (m_link[__n].m_right != -1)
+        {
+            __n = m_link[__n].m_right;
+            while (m_link[__n].m_left != -1)
+                __n = m_link[__n].m_left;
+            return __n;
+        }
+        int __p = m_link[__n].m_parent;
+        while (__p != -1 && m_link[__p].m_right == __n)
+        {
+            __n = __p;
+            __p = m_link[__p].m_parent;
+        }
+        return __p;
+    }
+
+    int _M_prev(int __n) const
+    {
+        if (m_link[__n].m_left != -1)
+        {
+            __n = m_link[__n].m_left;
+            while (m_link[__n].m_right != -1)
+                __n = m_link[__n].m_right;
+            return __n;
+        }
+        int __p = m_link[__n].m_parent;
+        while (__p != -1 && m_link[__p].m_left == __n)
+        {
+            __n = __p;
+            __p = m_link[__p].m_parent;
+        }
+        return __p;
+    }
+
+    template<class Container>
+    bool _M_verify(const Container &__c) const
+    {
+        CHECK_EXPR(m_root == -1 || m_link[m_root].m_parent == -1, false, "NFShmMultiIndex ordered index verify failed, root:{} has parent", m_root);
+        int __count = 0;
+        int __prev = -1;
+        for (int __n = _M_first(); __n != -1; __n = _M_next(__n))
+        {
+            CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && __c._M_valid(__n), false, "NFShmMultiIndex ordered index verify failed, invalid node:{}", __n);
+            CHECK_EXPR(++__count <= (int) __c.size(), false, "NFShmMultiIndex ordered index verify failed, more nodes than size:{}", __c.size());
+            CHECK_EXPR(m_link[__n].m_left == -1 || (m_link[m_link[__n].m_left].m_parent == __n && _M_priority(m_link[__n].m_left) <= _M_priority(__n)), false,
+                       "NFShmMultiIndex ordered index verify failed, bad left child of node:{}", __n);
+            CHECK_EXPR(m_link[__n].m_right == -1 || (m_link[m_link[__n].m_right].m_parent == __n && _M_priority(m_link[__n].m_right) <= _M_priority(__n)), false,
+                       "NFShmMultiIndex ordered index verify failed, bad right child of node:{}", __n);
+            if (__prev != -1)
+            {
+                const key_type &__a = KeyFromValue()(__c._M_value(__prev));
+                const key_type &__b = KeyFromValue()(__c._M_value(__n));
+                CHECK_EXPR(!key_compare()(__b, __a), false, "NFShmMultiIndex ordered index verify failed, node:{} before node:{} out of order", __prev, __n);
+                CHECK_EXPR(!UNIQUE || key_compare()(__a, __b), false, "NFShmMultiIndex ordered index verify failed, duplicate key in unique index, node:{} node:{}", __prev, __n);
+            }
+            __prev = __n;
+        }
+        CHECK_EXPR(__count == (int) __c.size(), false, "NFShmMultiIndex ordered index verify failed, nodes in tree:{} size:{}", __count, __c.size());
+        return true;
+    }
+
+private:
+    void _M_replace_child(int __p, int __old, int __new)
+    {
+        if (__p == -1)
+            m_root = __new;
+        else if (m_link[__p].m_left == __old)
+            m_link[__p].m_left = __new;
+        else
+            m_link[__p].m_right = __new;
+    }
+
+    void _M_rotate_left(int __x)
+    {
+        int __y = m_link[__x].m_right;
+        m_link[__x].m_right = m_link[__y].m_left;
+        if (m_link[__y].m_left != -1)
+            m_link[m_link[__y].m_left].m_parent = __x;
+        m_link[__y].m_parent = m_link[__x].m_parent;
+        _M_replace_child(m_link[__x].m_parent, __x, __y);
+        m_link[__y].m_left = __x;
+        m_link[__x].m_parent = __y;
+    }
+
+    void _M_rotate_right(int __x)
+    {
+        int __y = m_link[__x].m_left;
+        m_link[__x].m_left = m_link[__y].m_right;
+        if (m_link[__y].m_right != -1)
+            m_link[m_link[__y].m_right].m_parent = __x;
+        m_link[__y].m_parent = m_link[__x].m_parent;
+        _M_replace_child(m_link[__x].m_parent, __x, __y);
+        m_link[__y].m_right = __x;
+        m_link[__x].m_parent = __y;
+    }
+
+    /**
+     * @brief 一个节点的三个链接放在一起, 下降时每层少一次cache miss
+     */
+    struct _Link
+    {
+        int m_left;
+        int m_right;
+        int m_parent;
+    };
+
+    int m_root;
+    _Link m_link[MAX_SIZE];
+};
+
+/**
+ * @brief 索引声明, 作为NFShmMultiIndex的模板参数. Hash/Pred/Compare为void时用std::hash/std::equal_to/std::less
+ */
+template<class KeyFromValue, class Hash = void, class Pred = void>
+struct NFShmHashedUnique
+{
+    template<class Val, int MAX_SIZE>
+    struct index
+    {
+        typedef NFShmMultiIndexHashedIndex<Val, MAX_SIZE, KeyFromValue, Hash, Pred, true> type;
+    };
+};
+
+template<class KeyFromValue, class Hash = void, class Pred = void>
+struct NFShmHashedNonUnique
+{
+    template<class Val, int MAX_SIZE>
+    struct index
+    {
+        typedef NFShmMultiIndexHashedIndex<Val, MAX_SIZE, KeyFromValue, Hash, Pred, false> type;
+    };
+};
+
+template<class KeyFromValue, class Compare = void>
+struct NFShmOrderedUnique
+{
+    template<class Val, int MAX_SIZE>
+    struct index
+    {
+        typedef NFShmMultiIndexOrderedIndex<Val, MAX_SIZE, KeyFromValue, Compare, true> type;
+    };
+};
+
+template<class KeyFromValue, class Compare = void>
+struct NFShmOrderedNonUnique
+{
+    template<class Val, int MAX_SIZE>
+    struct index
+    {
+        typedef NFShmMultiIndexOrderedIndex<Val, MAX_SIZE, KeyFromValue, Compare, false> type;
+    };
+};
+
+/**
+ * @brief 索引列表, 递归展开模板参数包. 不用std::tuple是因为它的默认构造会值初始化成员, 恢复时会清掉共享内存
+ */
+template<class Val, int MAX_SIZE, class... Indexes>
+struct _NFShmMultiIndexList
+{
+    _NFShmMultiIndexList() {}
+
+    void _M_create_init() {}
+
+    template<class Container>
+    int _M_conflict(const Container &, const Val &, int) const { return -1; }
+
+    template<class Container>
+    void _M_link(const Container &, int) {}
+
+    template<class Container>
+    void _M_unlink(const Container &, int) {}
+
+    template<class Container>
+    void _M_modify_begin(const Container &, int, int *) const {}
+
+    template<class Container>
+    void _M_modify_check(const Container &, int, int *) {}
+
+    template<class Container>
+    void _M_modify_finish(const Container &, int, const int *, bool) {}
+
+    template<class Container>
+    bool _M_verify(const Container &) const { return true; }
+};
+
+template<class Val, int MAX_SIZE, class Head, class... Tail>
+struct _NFShmMultiIndexList<Val, MAX_SIZE, Head, Tail...>
+{
+    typedef typename Head::template index<Val, MAX_SIZE>::type index_type;
+    typedef _NFShmMultiIndexList<Val, MAX_SIZE, Tail...> tail_type;
+
+    _NFShmMultiIndexList() {}
+
+    void _M_create_init()
+    {
+        m_index._M_create_init();
+        m_tail._M_create_init();
+    }
+
+    template<class Container>
+    int _M_conflict(const Container &__c, const Val &__v, int __self) const
+    {
+        int __n = m_index._M_conflict(__c, __v, __self);
+        return __n != -1 ? __n : m_tail._M_conflict(__c, __v, __self);
+    }
+
+    template<class Container>
+    void _M_link(const Container &__c, int __n)
+    {
+        m_index._M_link(__c, __n);
+        m_tail._M_link(__c, __n);
+    }
+
+    template<class Container>
+    void _M_unlink(const Container &__c, int __n)
+    {
+        m_index._M_unlink(__c, __n);
+        m_tail._M_unlink(__c, __n);
+    }
+
+    /**
+     * @brief modify分三步, 每个索引在__st中占一项: begin记下修改前的状态, check把位置失效的索引摘下(__st置1),
+     * finish把摘下的挂回去(__keep)或者把还挂着的也摘下(冲突时删除元素)
+     */
+    template<class Container>
+    void _M_modify_begin(const Container &__c, int __n, int *__st) const
+    {
+        *__st = m_index._M_modify_begin(__c, __n);
+        m_tail._M_modify_begin(__c, __n, __st + 1);
+    }
+
+    template<class Container>
+    void _M_modify_check(const Container &__c, int __n, int *__st)
+    {
+        *__st = m_index._M_modify_check(__c, __n, *__st) ? 1 : 0;
+        m_tail._M_modify_check(__c, __n, __st + 1);
+    }
+
+    template<class Container>
+    void _M_modify_finish(const Container &__c, int __n, const int *__st, bool __keep)
+    {
+        if (__keep && *__st)
+            m_index._M_link(__c, __n);
+        else if (!__keep && !*__st)
+            m_index._M_unlink(__c, __n);
+        m_tail._M_modify_finish(__c, __n, __st + 1, __keep);
+    }
+
+    template<class Container>
+    bool _M_verify(const Container &__c) const { return m_index._M_verify(__c) && m_tail._M_verify(__c); }
+
+    index_type m_index;
+    tail_type m_tail;
+};
+
+template<int I, class List>
+struct _NFShmMultiIndexGet
+{
+    typedef _NFShmMultiIndexGet<I - 1, typename List::tail_type> _Next;
+    typedef typename _Next::type type;
+
+    static type *get(List *__l) { return _Next::get(&__l->m_tail); }
+};
+
+template<class List>
+struct _NFShmMultiIndexGet<0, List>
+{
+    typedef typename List::index_type type;
+
+    static type *get(List *__l) { return &__l->m_index; }
+};
+
+template<class Val, int MAX_SIZE, class... Indexes>
+class NFShmMultiIndex
+{
+public:
+    typedef Val value_type;
+    typedef size_t size_type;
+    typedef const Val &reference;
+    typedef const Val &const_reference;
+    typedef NFShmMultiIndex<Val, MAX_SIZE, Indexes...> _Self;
+    typedef NFShmMultiIndexIterator<_Self> iterator;
+    typedef iterator const_iterator;
+    typedef _NFShmMultiIndexList<Val, MAX_SIZE, Indexes...> _IndexList;
+
+    template<int I>
+    struct nth_index
+    {
+        typedef typename _NFShmMultiIndexGet<I, _IndexList>::type type;
+        typedef typename type::template view<_Self> view;
+    };
+
+    friend struct NFShmMultiIndexIterator<_Self>;
+    template<class, class> friend struct NFShmMultiIndexOrderedIterator;
+    template<class, int, class, class, class, bool> friend class NFShmMultiIndexHashedIndex;
+    template<class, int, class, class, bool> friend class NFShmMultiIndexOrderedIndex;
+
+    static_assert(MAX_SIZE > 0, "NFShmMultiIndex MAX_SIZE must be positive");
+    static_assert(sizeof...(Indexes) > 0, "NFShmMultiIndex needs at least one index");
+
+public:
+    NFShmMultiIndex()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    NFShmMultiIndex(const NFShmMultiIndex &__x)
+    {
+        CreateInit();
+        insert(__x.begin(), __x.end());
+    }
+
+    ~NFShmMultiIndex()
+    {
+        clear();
+    }
+
+    int CreateInit()
+    {
+#if NF_SHM_ZERO_ON_CREATE
+        memset(m_nodes, 0, sizeof(m_nodes));
+#endif
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            m_nodes[i].m_valid = false;
+            m_nodes[i].m_next = i + 1 < MAX_SIZE ? i + 1 : -1;
+        }
+        m_free = 0;
+        m_head = -1;
+        m_tail = -1;
+        m_size = 0;
+        m_indexes._M_create_init();
+        return 0;
+    }
+
+    /**
+     * @brief 链表完好时只遍历存活节点, 链表或索引不一致时按m_valid重建
+     */
+    int ResumeInit()
+    {
+        bool __listOk = _M_verify_list();
+        if (NFShmResumeConstruct<Val>::value)
+        {
+            if (__listOk)
+            {
+                for (int __n = m_head; __n != -1; __n = m_nodes[__n].m_next)
+                    std::_Construct(_M_ptr(__n));
+            }
+            else
+            {
+                for (int __n = 0; __n < MAX_SIZE; ++__n)
+                {
+                    if (m_nodes[__n].m_valid)
+                        std::_Construct(_M_ptr(__n));
+                }
+            }
+        }
+        if (!__listOk || !m_indexes._M_verify(*this))
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmMultiIndex inconsistent after resume, rebuild indexes, size:{}", m_size);
+            rebuild_indexes();
+        }
+        return 0;
+    }
+
+    NFShmMultiIndex &operator=(const NFShmMultiIndex &__x)
+    {
+        if (this != &__x)
+        {
+            clear();
+            insert(__x.begin(), __x.end());
+        }
+        return *this;
+    }
+
+public:
+    size_type size() const { return m_size; }
+
+    size_type max_size() const { return MAX_SIZE; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_SIZE; }
+
+    size_t left_size() const { return MAX_SIZE - m_size; }
+
+    /**
+     * @brief 按插入顺序遍历
+     */
+    iterator begin() const { return iterator(this, m_head); }
+
+    iterator end() const { return iterator(this, -1); }
+
+    /**
+     * @brief 第I个索引的视图, 哈希索引有find/count/erase, 有序索引还有begin/end/lower_bound/upper_bound/equal_range
+     */
+    template<int I>
+    typename nth_index<I>::view get() { return typename nth_index<I>::view(this, _NFShmMultiIndexGet<I, _IndexList>::get(&m_indexes)); }
+
+    template<int I>
+    const typename nth_index<I>::view get() const
+    {
+        _Self *__self = const_cast<_Self *>(this);
+        return typename nth_index<I>::view(__self, _NFShmMultiIndexGet<I, _IndexList>::get(&__self->m_indexes));
+    }
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(Val), m_size, MAX_SIZE); }
+
+public:
+    /**
+     * @brief 插入, 和某个唯一索引冲突时不插入, 返回(冲突的元素, false); 满了返回(end(), false)
+     */
+    std::pair<iterator, bool> insert(const Val &__v)
+    {
+        int __c = m_indexes._M_conflict(*this, __v, -1);
+        if (__c != -1)
+        {
+            return std::make_pair(iterator(this, __c), false);
+        }
+        if (m_free == -1)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmMultiIndex No Enough Space! MAX_SIZE:{}", MAX_SIZE);
+            return std::make_pair(end(), false);
+        }
+        // 顺序保证任何一步中断后, ResumeInit的链表/索引校验都能发现并重建
+        int __n = m_free;
+        int __nextFree = m_nodes[__n].m_next;
+        std::_Construct(_M_ptr(__n), __v);
+        _M_list_push(__n);
+        m_free = __nextFree;
+        m_nodes[__n].m_valid = true;
+        ++m_size;
+        m_indexes._M_link(*this, __n);
+        return std::make_pair(iterator(this, __n), true);
+    }
+
+    template<class _InputIterator>
+    void insert(_InputIterator __f, _InputIterator __l)
+    {
+        for (; __f != __l; ++__f)
+            insert(*__f);
+    }
+
+    /**
+     * @brief 删除, 返回按插入顺序的下一个元素. 有序索引的迭代器可以直接传进来
+     */
+    iterator erase(iterator __it)
+    {
+        int __n = __it.m_node;
+        CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && m_nodes[__n].m_valid, end(), "NFShmMultiIndex erase invalid node:{}", __n);
+        int __next = m_nodes[__n].m_next;
+        m_indexes._M_unlink(*this, __n);
+        _M_free_node(__n);
+        return iterator(this, __next);
+    }
+
+    /**
+     * @brief 原地修改元素. 只有key变了位置的索引才会摘下重挂: 哈希索引看桶有没有变, 有序索引看和前后元素的顺序有没有变,
+     * 只改非key字段时不动任何索引.
+     * 修改后和唯一索引冲突时元素被删除并返回false(和boost::multi_index::modify相同), 不想丢元素用replace
+     */
+    template<class Modifier>
+    bool modify(iterator __it, Modifier __f)
+    {
+        int __n = __it.m_node;
+        CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && m_nodes[__n].m_valid, false, "NFShmMultiIndex modify invalid node:{}", __n);
+        int __st[sizeof...(Indexes)];
+        m_indexes._M_modify_begin(*this, __n, __st);
+        __f(*_M_ptr(__n));
+        m_indexes._M_modify_check(*this, __n, __st);
+        if (m_indexes._M_conflict(*this, *_M_ptr(__n), __n) != -1)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmMultiIndex modify collides with a unique index, node:{} erased", __n);
+            m_indexes._M_modify_finish(*this, __n, __st, false);
+            _M_free_node(__n);
+            return false;
+        }
+        m_indexes._M_modify_finish(*this, __n, __st, true);
+        return true;
+    }
+
+    /**
+     * @brief 整体替换元素, 和唯一索引冲突时什么都不改, 返回false
+     */
+    bool replace(iterator __it, const Val &__v)
+    {
+        int __n = __it.m_node;
+        CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && m_nodes[__n].m_valid, false, "NFShmMultiIndex replace invalid node:{}", __n);
+        if (m_indexes._M_conflict(*this, __v, __n) != -1)
+        {
+            return false;
+        }
+        m_indexes._M_unlink(*this, __n);
+        *_M_ptr(__n) = __v;
+        m_indexes._M_link(*this, __n);
+        return true;
+    }
+
+    void clear()
+    {
+        for (int __n = m_head; __n != -1;)
+        {
+            int __next = m_nodes[__n].m_next;
+            std::_Destroy(_M_ptr(__n));
+            m_nodes[__n].m_valid = false;
+            m_nodes[__n].m_next = m_free;
+            m_free = __n;
+            __n = __next;
+        }
+        m_head = -1;
+        m_tail = -1;
+        m_size = 0;
+        m_indexes._M_create_init();
+    }
+
+    /**
+     * @brief 按m_valid重建存活链表, 空闲链表和所有索引, 唯一索引冲突的元素被删除
+     */
+    void rebuild_indexes()
+    {
+        m_indexes._M_create_init();
+        m_free = -1;
+        m_head = -1;
+        m_tail = -1;
+        m_size = 0;
+        for (int __n = MAX_SIZE - 1; __n >= 0; --__n)
+        {
+            if (!m_nodes[__n].m_valid)
+            {
+                m_nodes[__n].m_next = m_free;
+                m_free = __n;
+            }
+        }
+        for (int __n = 0; __n < MAX_SIZE; ++__n)
+        {
+            if (!m_nodes[__n].m_valid)
+                continue;
+            ++m_size;
+            _M_list_push(__n);
+            if (m_indexes._M_conflict(*this, *_M_ptr(__n), -1) != -1)
+            {
+                NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmMultiIndex rebuild, node:{} collides with a unique index, erased", __n);
+                _M_free_node(__n);
+                continue;
+            }
+            m_indexes._M_link(*this, __n);
+        }
+    }
+
+    bool verify() const { return _M_verify_list() && m_indexes._M_verify(*this); }
+
+private:
+    const Val &_M_value(int __n) const { return *reinterpret_cast<const Val *>(m_nodes[__n].m_data); }
+
+    Val *_M_ptr(int __n) { return reinterpret_cast<Val *>(m_nodes[__n].m_data); }
+
+    bool _M_valid(int __n) const { return m_nodes[__n].m_valid; }
+
+    int _M_list_next(int __n) const { return m_nodes[__n].m_next; }
+
+    void _M_list_push(int __n)
+    {
+        m_nodes[__n].m_prev = m_tail;
+        m_nodes[__n].m_next = -1;
+        if (m_tail == -1)
+            m_head = __n;
+        else
+            m_nodes[m_tail].m_next = __n;
+        m_tail = __n;
+    }
+
+    /**
+     * @brief 节点已经从所有索引摘下, 从存活链表摘下并放回空闲链表
+     */
+    void _M_free_node(int __n)
+    {
+        int __prev = m_nodes[__n].m_prev;
+        int __next = m_nodes[__n].m_next;
+        if (__prev == -1)
+            m_head = __next;
+        else
+            m_nodes[__prev].m_next = __next;
+        if (__next == -1)
+            m_tail = __prev;
+        else
+            m_nodes[__next].m_prev = __prev;
+        m_nodes[__n].m_valid = false;
+        std::_Destroy(_M_ptr(__n));
+        m_nodes[__n].m_next = m_free;
+        m_free = __n;
+        --m_size;
+    }
+
+    bool _M_verify_list() const
+    {
+        CHECK_EXPR(m_size >= 0 && m_size <= MAX_SIZE, false, "NFShmMultiIndex verify failed, size:{}", m_size);
+        int __count = 0;
+        int __prev = -1;
+        for (int __n = m_head; __n != -1; __n = m_nodes[__n].m_next)
+        {
+            CHECK_EXPR(__n >= 0 && __n < MAX_SIZE && m_nodes[__n].m_valid, false, "NFShmMultiIndex verify failed, invalid node:{} in list", __n);
+            CHECK_EXPR(m_nodes[__n].m_prev == __prev, false, "NFShmMultiIndex verify failed, node:{} prev:{} real:{}", __n, m_nodes[__n].m_prev, __prev);
+            CHECK_EXPR(++__count <= m_size, false, "NFShmMultiIndex verify failed, list longer than size:{}", m_size);
+            __prev = __n;
+        }
+        CHECK_EXPR(__count == m_size && __prev == m_tail, false, "NFShmMultiIndex verify failed, nodes in list:{} size:{}", __count, m_size);
+        return true;
+    }
+
+    struct _Node
+    {
+        alignas(Val) int8_t m_data[sizeof(Val)];
+        int m_prev;
+        int m_next;     //!<存活节点是插入顺序链表的next, 空闲节点是空闲链表的next
+        bool m_valid;
+    };
+
+    _Node m_nodes[MAX_SIZE];
+    int m_free;
+    int m_head;
+    int m_tail;
+    int m_size;
+    _IndexList m_indexes;
+};
@@ -0,0 +1,269 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmProfile.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmProfile
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief 容器操作耗时统计, 作为容器的ProfilePolicy模板参数.
+ * 默认的NFShmProfileNone什么都不做, 数据是空的基类, 不占共享内存, 也没有任何运行时开销.
+ * NFShmProfilePolicy对选定的操作用rdtsc计时, 结果累加到共享内存中的对数-线性直方图里(类似HdrHistogram),
+ * 外部进程挂上共享内存就能读取, 用NFShmProfileReport输出p50/p99/max.
+ * 两次rdtsc本身就要十几到几十纳秒, 所以默认每16次操作采样1次, 其余操作只有一次计数自增,
+ * 平均每次操作的开销在10ns以内. 需要每次都计时的话把NFSHM_PROFILE_SAMPLE_SHIFT定义为0.
+ *
+ * 用法:
+ * NFShmVector<int, 1000, NFShmProfilePolicy> m_vec;
+ * NFLogInfo(NF_LOG_SYSTEMLOG, 0, "{}", m_vec.profile_report("m_vec"));
+ */
+
+#define NFSHM_PROFILE_SUB_BITS 4                                                //!<每个2的幂区间分成16个线性子桶, 相对误差不超过1/16
+#define NFSHM_PROFILE_SUB_COUNT (1 << NFSHM_PROFILE_SUB_BITS)
+#define NFSHM_PROFILE_MAX_BITS 32                                               //!<超过2^32个时钟周期的按最大值记录
+#define NFSHM_PROFILE_BUCKETS (NFSHM_PROFILE_SUB_COUNT * (NFSHM_PROFILE_MAX_BITS - NFSHM_PROFILE_SUB_BITS + 1))
+
+#ifndef NFSHM_PROFILE_SAMPLE_SHIFT
+#define NFSHM_PROFILE_SAMPLE_SHIFT 4                                            //!<每2^NFSHM_PROFILE_SAMPLE_SHIFT次操作计时1次
+#endif
+#define NFSHM_PROFILE_SAMPLE_MASK ((1ull << NFSHM_PROFILE_SAMPLE_SHIFT) - 1)
+
+/**
+ * @brief 读时钟周期, x86用rdtsc, arm64读虚拟计数器, 其他平台退化为steady_clock的纳秒数
+ */
+inline uint64_t NFShmProfileClock()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t __v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(__v));
+    return __v;
+#else
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief 每纳秒的时钟周期数, 第一次调用时用steady_clock校准约2ms, 只在输出报告时使用
+ */
+inline double NFShmProfileTicksPerNs()
+{
+    static double __ticks = 0;
+    if (__ticks <= 0)
+    {
+        std::chrono::steady_clock::time_point __t0 = std::chrono::steady_clock::now();
+        uint64_t __c0 = NFShmProfileClock();
+        std::chrono::steady_clock::time_point __t1;
+        do
+        {
+            __t1 = std::chrono::steady_clock::now();
+        } while (__t1 - __t0 < std::chrono::milliseconds(2));
+        uint64_t __c1 = NFShmProfileClock();
+        double __ns = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(__t1 - __t0).count();
+        __ticks = __ns > 0 ? (double) (__c1 - __c0) / __ns : 1.0;
+    }
+    return __ticks;
+}
+
+/**
+ * @brief 对数-线性直方图, 放在共享内存里, 多个进程可以同时记录.
+ * 小于16的值每个值一个桶, 之后每个2的幂区间[2^k, 2^(k+1))均分成16个桶.
+ * 桶计数用原子加, 调用次数和最大值用普通读写(并发时可能少计, 换取不用CAS循环).
+ */
+struct NFShmProfileHistogram
+{
+    uint32_t m_bucket[NFSHM_PROFILE_BUCKETS]; //!<采样到的耗时分布
+    uint64_t m_calls;                         //!<调用次数, 包括没有采样的
+    uint64_t m_max;                           //!<采样到的最大耗时
+
+    static int index(uint64_t __v)
+    {
+        if (__v < NFSHM_PROFILE_SUB_COUNT)
+            return (int) __v;
+        if (__v >> NFSHM_PROFILE_MAX_BITS)
+            return NFSHM_PROFILE_BUCKETS - 1;
+#if defined(_MSC_VER)
+        unsigned long __msb;
+        _BitScanReverse64(&__msb, __v);
+#else
+        int __msb = 63 - __builtin_clzll(__v);
+#endif
+        int __shift = (int) __msb - NFSHM_PROFILE_SUB_BITS;
+        return NFSHM_PROFILE_SUB_COUNT + __shift * NFSHM_PROFILE_SUB_COUNT + (int) ((__v >> __shift) - NFSHM_PROFILE_SUB_COUNT);
+    }
+
+    /**
+     * @brief 桶能表示的最大值
+     */
+    static uint64_t upper(int __idx)
+    {
+        if (__idx < NFSHM_PROFILE_SUB_COUNT)
+            return (uint64_t) __idx;
+        int __shift = __idx / NFSHM_PROFILE_SUB_COUNT - 1;
+        uint64_t __sub = (uint64_t) (__idx % NFSHM_PROFILE_SUB_COUNT) + NFSHM_PROFILE_SUB_COUNT;
+        return ((__sub + 1) << __shift) - 1;
+    }
+
+    void record(uint64_t __v)
+    {
+        uint32_t *__b = &m_bucket[index(__v)];
+#if defined(_MSC_VER)
+        _InterlockedIncrement((volatile long *) __b);
+#else
+        __atomic_fetch_add(__b, 1u, __ATOMIC_RELAXED);
+#endif
+        if (__v > m_max)
+            m_max = __v;
+    }
+
+    void reset() { memset(this, 0, sizeof(*this)); }
+
+    uint64_t count() const
+    {
+        uint64_t __n = 0;
+        for (int __i = 0; __i < NFSHM_PROFILE_BUCKETS; ++__i)
+            __n += m_bucket[__i];
+        return __n;
+    }
+
+    /**
+     * @brief 第__q(0~1)分位数所在桶的上界, 单位是时钟周期
+     */
+    uint64_t percentile(double __q) const
+    {
+        uint64_t __total = count();
+        if (__total == 0)
+            return 0;
+        uint64_t __rank = (uint64_t) (__q * (double) __total);
+        if (__rank >= __total)
+            __rank = __total - 1;
+        uint64_t __seen = 0;
+        for (int __i = 0; __i < NFSHM_PROFILE_BUCKETS; ++__i)
+        {
+            __seen += m_bucket[__i];
+            if (__seen > __rank)
+            {
+                uint64_t __up = upper(__i);
+                return __up < m_max ? __up : m_max;
+            }
+        }
+        return m_max;
+    }
+};
+
+/**
+ * @brief 输出一组直方图的报告, 每个操作一行: 名字 调用次数 采样次数 p50 p99 max(纳秒, 按校准的时钟频率换算), 没有记录的操作不输出
+ */
+inline std::string NFShmProfileReport(const char *__name, const NFShmProfileHistogram *__hist, int __ops, const char *const *__opNames)
+{
+    std::string __out;
+    double __tpn = NFShmProfileTicksPerNs();
+    for (int __i = 0; __i < __ops; ++__i)
+    {
+        uint64_t __n = __hist[__i].count();
+        if (__n == 0)
+            continue;
+        char __line[256];
+        snprintf(__line, sizeof(__line), "%s.%s calls:%llu samples:%llu p50:%.0fns p99:%.0fns max:%.0fns\n", __name, __opNames[__i],
+                 (unsigned long long) __hist[__i].m_calls, (unsigned long long) __n,
+                 (double) __hist[__i].percentile(0.5) / __tpn, (double) __hist[__i].percentile(0.99) / __tpn, (double) __hist[__i].m_max / __tpn);
+        __out += __line;
+    }
+    return __out;
+}
+
+/**
+ * @brief 不统计耗时, 默认策略
+ */
+struct NFShmProfileNone
+{
+    template<int OPS>
+    struct data_type
+    {
+    };
+
+    struct scope
+    {
+        template<class Data>
+        scope(Data *, int) {}
+    };
+
+    template<class Data>
+    static void reset(Data *) {}
+
+    template<class Data>
+    static std::string report(const char *, const Data *, int, const char *const *) { return std::string(); }
+};
+
+/**
+ * @brief 用rdtsc统计耗时, 每个操作一个直方图
+ */
+struct NFShmProfilePolicy
+{
+    template<int OPS>
+    struct data_type
+    {
+        data_type()
+        {
+            if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+            {
+                memset(m_hist, 0, sizeof(m_hist));
+            }
+        }
+
+        NFShmProfileHistogram m_hist[OPS];
+    };
+
+    struct scope
+    {
+        template<class Data>
+        scope(Data *__data, int __op) : m_hist(NULL), m_start(0)
+        {
+            NFShmProfileHistogram *__h = &__data->m_hist[__op];
+            if ((__h->m_calls++ & NFSHM_PROFILE_SAMPLE_MASK) == 0)
+            {
+                m_hist = __h;
+                m_start = NFShmProfileClock();
+            }
+        }
+
+        ~scope()
+        {
+            if (m_hist)
+                m_hist->record(NFShmProfileClock() - m_start);
+        }
+
+        NFShmProfileHistogram *m_hist;
+        uint64_t m_start;
+    };
+
+    template<class Data>
+    static void reset(Data *__data) { memset(__data->m_hist, 0, sizeof(__data->m_hist)); }
+
+    template<class Data>
+    static std::string report(const char *__name, const Data *__data, int __ops, const char *const *__opNames)
+    {
+        return NFShmProfileReport(__name, __data->m_hist, __ops, __opNames);
+    }
+};
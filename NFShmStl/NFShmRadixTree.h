@@ -0,0 +1,1149 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmRadixTree.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmRadixTree
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmSearch.h"
+#include <string_view>
+#include <utility>
+#include <limits>
+#include <type_traits>
+
+/**
+ * @brief 内部节点中最多保存的压缩前缀字节数, 更长的前缀查找时跳过(最后会和叶子中的完整key比较),
+ * 插入/删除需要准确的前缀时从子树中最小的叶子读取
+ */
+#define NFSHM_RADIX_TREE_MAX_PREFIX 8
+
+/**
+ * @brief 节点引用的类型, 引用是一个uint32_t, 高4位是类型, 低28位是在对应节点池中的下标, 0表示空
+ */
+enum NFShmRadixNodeType
+{
+    NFSHM_RADIX_NONE = 0,
+    NFSHM_RADIX_LEAF = 1,
+    NFSHM_RADIX_NODE4 = 2,
+    NFSHM_RADIX_NODE16 = 3,
+    NFSHM_RADIX_NODE48 = 4,
+    NFSHM_RADIX_NODE256 = 5,
+};
+
+struct NFShmRadixNodeHeader
+{
+    uint32_t m_leaf; //!<正好在这个节点结束的key(是子树中所有key的前缀)
+    uint16_t m_prefixLen; //!<压缩前缀的完整长度
+    uint16_t m_count; //!<子节点个数, 不包括m_leaf
+    uint8_t m_prefix[NFSHM_RADIX_TREE_MAX_PREFIX];
+    int m_next; //!<空闲链表的下一个节点
+};
+
+/**
+ * @brief 子节点按字节有序存放, 线性查找
+ */
+struct NFShmRadixNode4 : public NFShmRadixNodeHeader
+{
+    uint8_t m_keys[4];
+    uint32_t m_children[4];
+};
+
+/**
+ * @brief 子节点按字节有序存放, 用SSE2一次比较16个字节
+ */
+struct NFShmRadixNode16 : public NFShmRadixNodeHeader
+{
+    uint8_t m_keys[16];
+    uint32_t m_children[16];
+};
+
+/**
+ * @brief m_index[c]是字节c在m_children中的下标+1, 0表示没有
+ */
+struct NFShmRadixNode48 : public NFShmRadixNodeHeader
+{
+    uint8_t m_index[256];
+    uint32_t m_children[48];
+};
+
+struct NFShmRadixNode256 : public NFShmRadixNodeHeader
+{
+    uint32_t m_children[256];
+};
+
+/**
+ * @brief 固定大小的节点池, 空闲节点通过m_next串成链表
+ */
+template<class _Node, int MAX_NODES>
+struct NFShmRadixNodePool
+{
+    int CreateInit()
+    {
+        for (int i = 0; i < MAX_NODES; ++i)
+        {
+            m_nodes[i].m_next = i + 1;
+        }
+        m_nodes[MAX_NODES - 1].m_next = INVALID_ID;
+        m_freeStart = 0;
+        m_used = 0;
+        return 0;
+    }
+
+    int allocate()
+    {
+        if (m_freeStart == INVALID_ID)
+            return INVALID_ID;
+        int __idx = m_freeStart;
+        m_freeStart = m_nodes[__idx].m_next;
+        memset(&m_nodes[__idx], 0, sizeof(_Node));
+        ++m_used;
+        return __idx;
+    }
+
+    void deallocate(int __idx)
+    {
+        m_nodes[__idx].m_next = m_freeStart;
+        m_freeStart = __idx;
+        --m_used;
+    }
+
+    _Node m_nodes[MAX_NODES];
+    int m_freeStart;
+    int m_used;
+};
+
+template<class Tp, int MAX_KEY_LEN>
+struct NFShmRadixTreeLeaf
+{
+    Tp m_data;
+    int m_next; //!<空闲链表的下一个叶子
+    uint16_t m_len;
+    bool m_valid;
+    char m_key[MAX_KEY_LEN];
+};
+
+/**
+ * @brief 共享内存自适应基数树(ART), key是长度不超过MAX_KEY_LEN的字节串
+ * 用于名字补全, GM按前缀查玩家, 路由表最长前缀匹配这类按前缀查询的场景, 代替有序的NFShmVector<NFShmString> + 二分查找.
+ *
+ * 内部节点按子节点个数分为4/16/48/256四种, 各自有固定大小的节点池, 节点之间用下标引用, 可以直接放在共享内存中.
+ * 公共前缀压缩在内部节点中, 所以树高只和key之间的差异有关, 和元素个数无关.
+ * 某种节点的池用完时会改用更大的节点, 所有池都用完或者叶子用完时插入失败.
+ *
+ * 每个叶子保存完整的key, 内部节点最多有MAX_SIZE - 1个, 所以Node4池的大小是MAX_SIZE,
+ * 更大的节点一般很少, 默认按MAX_SIZE的比例分配, 分布特殊(比如大量单字节分叉)时可以自己指定.
+ */
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN = 32, int MAX_NODE16 = MAX_SIZE / 4 + 1, int MAX_NODE48 = MAX_SIZE / 16 + 1, int MAX_NODE256 = MAX_SIZE / 64 + 1>
+class NFShmRadixTree
+{
+    static_assert(MAX_SIZE > 0 && MAX_SIZE < (1 << 28), "MAX_SIZE out of range");
+    static_assert(MAX_KEY_LEN > 0 && MAX_KEY_LEN <= 65535, "MAX_KEY_LEN out of range");
+
+public:
+    typedef Tp value_type;
+    typedef size_t size_type;
+    typedef NFShmRadixTreeLeaf<Tp, MAX_KEY_LEN> _Leaf;
+
+public:
+    NFShmRadixTree()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    ~NFShmRadixTree()
+    {
+        clear();
+    }
+
+    int CreateInit()
+    {
+#if NF_SHM_ZERO_ON_CREATE
+        memset(m_leafMem, 0, sizeof(m_leafMem));
+#endif
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            _M_leaf(i)->m_next = i + 1;
+            _M_leaf(i)->m_valid = false;
+        }
+        _M_leaf(MAX_SIZE - 1)->m_next = INVALID_ID;
+        m_leafFreeStart = 0;
+        m_size = 0;
+        m_root = 0;
+
+        m_node4.CreateInit();
+        m_node16.CreateInit();
+        m_node48.CreateInit();
+        m_node256.CreateInit();
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (NFShmResumeConstruct<Tp>::value)
+        {
+            for (int i = 0; i < MAX_SIZE; ++i)
+            {
+                if (_M_leaf(i)->m_valid)
+                {
+                    std::_Construct(&_M_leaf(i)->m_data);
+                }
+            }
+        }
+        return 0;
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            if (_M_leaf(i)->m_valid)
+            {
+                std::_Destroy(&_M_leaf(i)->m_data);
+            }
+        }
+        CreateInit();
+    }
+
+public:
+    size_type size() const { return m_size; }
+
+    size_type max_size() const { return MAX_SIZE; }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 叶子中的key和四种内部节点池都算作额外开销
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(Tp), m_size, MAX_SIZE); }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_leafFreeStart == INVALID_ID; }
+
+    /**
+     * @brief 正在使用的内部节点个数
+     */
+    size_type inner_node_count() const { return m_node4.m_used + m_node16.m_used + m_node48.m_used + m_node256.m_used; }
+
+public:
+    /**
+     * @brief 插入, key已经存在时不修改原来的值
+     * @return first指向key对应的值, 空间不够或者key太长时为NULL; second表示是否新插入
+     */
+    std::pair<Tp *, bool> insert(std::string_view __key, const Tp &__obj)
+    {
+        if (__key.size() > (size_t) MAX_KEY_LEN)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmRadixTree key too long, len:{} MAX_KEY_LEN:{}", __key.size(), MAX_KEY_LEN);
+            return std::pair<Tp *, bool>((Tp *) NULL, false);
+        }
+
+        bool __inserted = false;
+        int __idx = _M_insert(m_root, __key, 0, __obj, __inserted);
+        if (__idx == INVALID_ID)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmRadixTree No Enough Space! size:{} MAX_SIZE:{} inner nodes:{}", m_size, MAX_SIZE, inner_node_count());
+            return std::pair<Tp *, bool>((Tp *) NULL, false);
+        }
+        return std::pair<Tp *, bool>(&_M_leaf(__idx)->m_data, __inserted);
+    }
+
+    Tp *find(std::string_view __key)
+    {
+        int __idx = _M_find_leaf(__key);
+        return __idx == INVALID_ID ? NULL : &_M_leaf(__idx)->m_data;
+    }
+
+    const Tp *find(std::string_view __key) const
+    {
+        int __idx = _M_find_leaf(__key);
+        return __idx == INVALID_ID ? NULL : &_M_leaf(__idx)->m_data;
+    }
+
+    size_type count(std::string_view __key) const { return _M_find_leaf(__key) == INVALID_ID ? 0 : 1; }
+
+    size_type erase(std::string_view __key)
+    {
+        return _M_erase(m_root, __key, 0) ? 1 : 0;
+    }
+
+    /**
+     * @brief 最长前缀匹配, 返回树中是__key前缀的最长的那个key对应的值, 没有返回NULL
+     */
+    const Tp *longest_prefix(std::string_view __key) const;
+
+    Tp *longest_prefix(std::string_view __key)
+    {
+        return const_cast<Tp *>(static_cast<const NFShmRadixTree *>(this)->longest_prefix(__key));
+    }
+
+    /**
+     * @brief 按字典序遍历所有以__prefix开头的key, 对每个元素调用__f(std::string_view key, value)
+     * __f返回bool时, 返回false停止遍历.
+     * @return 回调的次数
+     */
+    template<class _Func>
+    size_type prefix_scan(std::string_view __prefix, _Func &&__f)
+    {
+        return _M_prefix_scan(this, __prefix, __f);
+    }
+
+    template<class _Func>
+    size_type prefix_scan(std::string_view __prefix, _Func &&__f) const
+    {
+        return _M_prefix_scan(this, __prefix, __f);
+    }
+
+    /**
+     * @brief 按字典序遍历所有元素
+     */
+    template<class _Func>
+    size_type for_each(_Func &&__f) { return _M_prefix_scan(this, std::string_view(), __f); }
+
+    template<class _Func>
+    size_type for_each(_Func &&__f) const { return _M_prefix_scan(this, std::string_view(), __f); }
+
+private:
+    static int _S_type(uint32_t __ref) { return (int) (__ref >> 28); }
+
+    static int _S_index(uint32_t __ref) { return (int) (__ref & 0x0FFFFFFF); }
+
+    static uint32_t _S_make(int __type, int __idx) { return ((uint32_t) __type << 28) | (uint32_t) __idx; }
+
+    static int _S_capacity(int __type)
+    {
+        switch (__type)
+        {
+            case NFSHM_RADIX_NODE4: return 4;
+            case NFSHM_RADIX_NODE16: return 16;
+            case NFSHM_RADIX_NODE48: return 48;
+            default: return 256;
+        }
+    }
+
+    static std::string_view _S_key(const _Leaf *__leaf) { return std::string_view(__leaf->m_key, __leaf->m_len); }
+
+    _Leaf *_M_leaf(int __idx) { return (_Leaf *) m_leafMem + __idx; }
+
+    const _Leaf *_M_leaf(int __idx) const { return (const _Leaf *) m_leafMem + __idx; }
+
+    NFShmRadixNodeHeader *_M_header(uint32_t __ref)
+    {
+        int __idx = _S_index(__ref);
+        switch (_S_type(__ref))
+        {
+            case NFSHM_RADIX_NODE4: return &m_node4.m_nodes[__idx];
+            case NFSHM_RADIX_NODE16: return &m_node16.m_nodes[__idx];
+            case NFSHM_RADIX_NODE48: return &m_node48.m_nodes[__idx];
+            case NFSHM_RADIX_NODE256: return &m_node256.m_nodes[__idx];
+            default: return NULL;
+        }
+    }
+
+    const NFShmRadixNodeHeader *_M_header(uint32_t __ref) const
+    {
+        return const_cast<NFShmRadixTree *>(this)->_M_header(__ref);
+    }
+
+    static void _S_set_prefix(NFShmRadixNodeHeader *__h, const char *__p, size_t __len)
+    {
+        __h->m_prefixLen = (uint16_t) __len;
+        memcpy(__h->m_prefix, __p, __len < NFSHM_RADIX_TREE_MAX_PREFIX ? __len : NFSHM_RADIX_TREE_MAX_PREFIX);
+    }
+
+    int _M_new_leaf(std::string_view __key, const Tp &__obj)
+    {
+        int __idx = m_leafFreeStart;
+        if (__idx == INVALID_ID)
+            return INVALID_ID;
+
+        _Leaf *__leaf = _M_leaf(__idx);
+        NF_ASSERT(!__leaf->m_valid);
+        m_leafFreeStart = __leaf->m_next;
+        std::_Construct(&__leaf->m_data, __obj);
+        memcpy(__leaf->m_key, __key.data(), __key.size());
+        __leaf->m_len = (uint16_t) __key.size();
+        __leaf->m_valid = true;
+        ++m_size;
+        return __idx;
+    }
+
+    void _M_delete_leaf(int __idx)
+    {
+        _Leaf *__leaf = _M_leaf(__idx);
+        NF_ASSERT(__leaf->m_valid);
+        std::_Destroy(&__leaf->m_data);
+        __leaf->m_valid = false;
+        __leaf->m_next = m_leafFreeStart;
+        m_leafFreeStart = __idx;
+        --m_size;
+    }
+
+    /**
+     * @brief 分配指定类型的内部节点, 池满时返回0
+     */
+    uint32_t _M_alloc_node(int __type)
+    {
+        int __idx = INVALID_ID;
+        switch (__type)
+        {
+            case NFSHM_RADIX_NODE4: __idx = m_node4.allocate(); break;
+            case NFSHM_RADIX_NODE16: __idx = m_node16.allocate(); break;
+            case NFSHM_RADIX_NODE48: __idx = m_node48.allocate(); break;
+            case NFSHM_RADIX_NODE256: __idx = m_node256.allocate(); break;
+            default: break;
+        }
+        return __idx == INVALID_ID ? 0 : _S_make(__type, __idx);
+    }
+
+    /**
+     * @brief 分配至少是__type大小的内部节点, 对应的池满时依次尝试更大的节点
+     */
+    uint32_t _M_new_node(int __type)
+    {
+        for (; __type <= NFSHM_RADIX_NODE256; ++__type)
+        {
+            uint32_t __ref = _M_alloc_node(__type);
+            if (__ref != 0)
+                return __ref;
+        }
+        return 0;
+    }
+
+    void _M_delete_node(uint32_t __ref)
+    {
+        int __idx = _S_index(__ref);
+        switch (_S_type(__ref))
+        {
+            case NFSHM_RADIX_NODE4: m_node4.deallocate(__idx); break;
+            case NFSHM_RADIX_NODE16: m_node16.deallocate(__idx); break;
+            case NFSHM_RADIX_NODE48: m_node48.deallocate(__idx); break;
+            case NFSHM_RADIX_NODE256: m_node256.deallocate(__idx); break;
+            default: break;
+        }
+    }
+
+    uint32_t *_M_find_child(uint32_t __ref, uint8_t __c);
+
+    const uint32_t *_M_find_child(uint32_t __ref, uint8_t __c) const
+    {
+        return const_cast<NFShmRadixTree *>(this)->_M_find_child(__ref, __c);
+    }
+
+    /**
+     * @brief 添加子节点, 调用前要保证节点还有空位
+     */
+    void _M_add_child(uint32_t __ref, uint8_t __c, uint32_t __child);
+
+    void _M_remove_child(uint32_t __ref, uint8_t __c);
+
+    /**
+     * @brief 按字节从小到大遍历子节点, __f(c, child)返回false时停止
+     */
+    template<class _Func>
+    bool _M_for_each_child(uint32_t __ref, _Func &&__f) const;
+
+    /**
+     * @brief 子树中最小的叶子, 它的key包含了子树根的完整前缀
+     */
+    const _Leaf *_M_minimum(uint32_t __ref) const;
+
+    /**
+     * @brief 把__ref的内容搬到新节点__new上, 释放旧节点
+     */
+    void _M_move_node(uint32_t &__ref, uint32_t __new);
+
+    /**
+     * @brief 节点满时换成更大的节点
+     */
+    int _M_reserve_child(uint32_t &__ref);
+
+    /**
+     * @brief 删除后合并只有一个子节点的节点, 子节点太少时换成更小的节点
+     * @param __depth 节点前缀在key中的起始位置
+     */
+    void _M_shrink(uint32_t &__ref, size_t __depth);
+
+    /**
+     * @brief __key从__depth开始和节点完整前缀相同的字节数, 最多比较到__key结束
+     */
+    size_t _M_prefix_mismatch(uint32_t __ref, std::string_view __key, size_t __depth) const;
+
+    void _M_attach(uint32_t __node, std::string_view __key, size_t __depth, uint32_t __child)
+    {
+        if (__depth == __key.size())
+            _M_header(__node)->m_leaf = __child;
+        else
+            _M_add_child(__node, (uint8_t) __key[__depth], __child);
+    }
+
+    int _M_find_leaf(std::string_view __key) const;
+
+    int _M_insert(uint32_t &__ref, std::string_view __key, size_t __depth, const Tp &__obj, bool &__inserted);
+
+    bool _M_erase(uint32_t &__ref, std::string_view __key, size_t __depth);
+
+    template<class _Self, class _Func>
+    static bool _M_visit(_Self *__self, uint32_t __ref, _Func &__f, size_type &__count);
+
+    template<class _Self, class _Func>
+    static size_type _M_prefix_scan(_Self *__self, std::string_view __prefix, _Func &__f);
+
+private:
+    alignas(_Leaf) int8_t m_leafMem[sizeof(_Leaf) * MAX_SIZE];
+    NFShmRadixNodePool<NFShmRadixNode4, MAX_SIZE> m_node4;
+    NFShmRadixNodePool<NFShmRadixNode16, MAX_NODE16> m_node16;
+    NFShmRadixNodePool<NFShmRadixNode48, MAX_NODE48> m_node48;
+    NFShmRadixNodePool<NFShmRadixNode256, MAX_NODE256> m_node256;
+    uint32_t m_root;
+    int m_leafFreeStart;
+    int m_size;
+};
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+uint32_t *NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_find_child(uint32_t __ref, uint8_t __c)
+{
+    int __idx = _S_index(__ref);
+    switch (_S_type(__ref))
+    {
+        case NFSHM_RADIX_NODE4:
+        {
+            NFShmRadixNode4 *__n = &m_node4.m_nodes[__idx];
+            for (int i = 0; i < __n->m_count; ++i)
+            {
+                if (__n->m_keys[i] == __c)
+                    return &__n->m_children[i];
+            }
+            return NULL;
+        }
+        case NFSHM_RADIX_NODE16:
+        {
+            NFShmRadixNode16 *__n = &m_node16.m_nodes[__idx];
+#if defined(NFSHM_SEARCH_SSE2)
+            __m128i __cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char) __c), _mm_loadu_si128((const __m128i *) __n->m_keys));
+            uint32_t __mask = (uint32_t) _mm_movemask_epi8(__cmp) & ((1u << __n->m_count) - 1);
+            if (__mask)
+                return &__n->m_children[_NFShmSearchCtz(__mask)];
+#else
+            for (int i = 0; i < __n->m_count; ++i)
+            {
+                if (__n->m_keys[i] == __c)
+                    return &__n->m_children[i];
+            }
+#endif
+            return NULL;
+        }
+        case NFSHM_RADIX_NODE48:
+        {
+            NFShmRadixNode48 *__n = &m_node48.m_nodes[__idx];
+            int __slot = __n->m_index[__c];
+            return __slot ? &__n->m_children[__slot - 1] : NULL;
+        }
+        case NFSHM_RADIX_NODE256:
+        {
+            NFShmRadixNode256 *__n = &m_node256.m_nodes[__idx];
+            return __n->m_children[__c] ? &__n->m_children[__c] : NULL;
+        }
+        default:
+            return NULL;
+    }
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+void NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_add_child(uint32_t __ref, uint8_t __c, uint32_t __child)
+{
+    int __idx = _S_index(__ref);
+    switch (_S_type(__ref))
+    {
+        case NFSHM_RADIX_NODE4:
+        {
+            NFShmRadixNode4 *__n = &m_node4.m_nodes[__idx];
+            NF_ASSERT(__n->m_count < 4);
+            int __pos = 0;
+            while (__pos < __n->m_count && __n->m_keys[__pos] < __c)
+                ++__pos;
+            memmove(__n->m_keys + __pos + 1, __n->m_keys + __pos, __n->m_count - __pos);
+            memmove(__n->m_children + __pos + 1, __n->m_children + __pos, (__n->m_count - __pos) * sizeof(uint32_t));
+            __n->m_keys[__pos] = __c;
+            __n->m_children[__pos] = __child;
+            ++__n->m_count;
+            break;
+        }
+        case NFSHM_RADIX_NODE16:
+        {
+            NFShmRadixNode16 *__n = &m_node16.m_nodes[__idx];
+            NF_ASSERT(__n->m_count < 16);
+            int __pos;
+#if defined(NFSHM_SEARCH_SSE2)
+            // 无符号比较: 两边都异或0x80后做有符号比较
+            const __m128i __bias = _mm_set1_epi8((char) 0x80);
+            __m128i __lt = _mm_cmplt_epi8(_mm_xor_si128(_mm_set1_epi8((char) __c), __bias), _mm_xor_si128(_mm_loadu_si128((const __m128i *) __n->m_keys), __bias));
+            uint32_t __mask = (uint32_t) _mm_movemask_epi8(__lt) & ((1u << __n->m_count) - 1);
+            __pos = __mask ? (int) _NFShmSearchCtz(__mask) : __n->m_count;
+#else
+            __pos = 0;
+            while (__pos < __n->m_count && __n->m_keys[__pos] < __c)
+                ++__pos;
+#endif
+            memmove(__n->m_keys + __pos + 1, __n->m_keys + __pos, __n->m_count - __pos);
+            memmove(__n->m_children + __pos + 1, __n->m_children + __pos, (__n->m_count - __pos) * sizeof(uint32_t));
+            __n->m_keys[__pos] = __c;
+            __n->m_children[__pos] = __child;
+            ++__n->m_count;
+            break;
+        }
+        case NFSHM_RADIX_NODE48:
+        {
+            NFShmRadixNode48 *__n = &m_node48.m_nodes[__idx];
+            NF_ASSERT(__n->m_count < 48);
+            int __slot = 0;
+            while (__n->m_children[__slot] != 0)
+                ++__slot;
+            __n->m_children[__slot] = __child;
+            __n->m_index[__c] = (uint8_t) (__slot + 1);
+            ++__n->m_count;
+            break;
+        }
+        case NFSHM_RADIX_NODE256:
+        {
+            NFShmRadixNode256 *__n = &m_node256.m_nodes[__idx];
+            __n->m_children[__c] = __child;
+            ++__n->m_count;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+void NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_remove_child(uint32_t __ref, uint8_t __c)
+{
+    int __idx = _S_index(__ref);
+    switch (_S_type(__ref))
+    {
+        case NFSHM_RADIX_NODE4:
+        case NFSHM_RADIX_NODE16:
+        {
+            uint8_t *__keys;
+            uint32_t *__children;
+            uint16_t *__count;
+            if (_S_type(__ref) == NFSHM_RADIX_NODE4)
+            {
+                NFShmRadixNode4 *__n = &m_node4.m_nodes[__idx];
+                __keys = __n->m_keys;
+                __children = __n->m_children;
+                __count = &__n->m_count;
+            }
+            else
+            {
+                NFShmRadixNode16 *__n = &m_node16.m_nodes[__idx];
+                __keys = __n->m_keys;
+                __children = __n->m_children;
+                __count = &__n->m_count;
+            }
+
+            int __pos = 0;
+            while (__pos < *__count && __keys[__pos] != __c)
+                ++__pos;
+            NF_ASSERT(__pos < *__count);
+            memmove(__keys + __pos, __keys + __pos + 1, *__count - __pos - 1);
+            memmove(__children + __pos, __children + __pos + 1, (*__count - __pos - 1) * sizeof(uint32_t));
+            --*__count;
+            break;
+        }
+        case NFSHM_RADIX_NODE48:
+        {
+            NFShmRadixNode48 *__n = &m_node48.m_nodes[__idx];
+            int __slot = __n->m_index[__c];
+            NF_ASSERT(__slot > 0);
+            __n->m_children[__slot - 1] = 0;
+            __n->m_index[__c] = 0;
+            --__n->m_count;
+            break;
+        }
+        case NFSHM_RADIX_NODE256:
+        {
+            NFShmRadixNode256 *__n = &m_node256.m_nodes[__idx];
+            __n->m_children[__c] = 0;
+            --__n->m_count;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+template<class _Func>
+bool NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_for_each_child(uint32_t __ref, _Func &&__f) const
+{
+    int __idx = _S_index(__ref);
+    switch (_S_type(__ref))
+    {
+        case NFSHM_RADIX_NODE4:
+        {
+            const NFShmRadixNode4 *__n = &m_node4.m_nodes[__idx];
+            for (int i = 0; i < __n->m_count; ++i)
+            {
+                if (!__f(__n->m_keys[i], __n->m_children[i]))
+                    return false;
+            }
+            return true;
+        }
+        case NFSHM_RADIX_NODE16:
+        {
+            const NFShmRadixNode16 *__n = &m_node16.m_nodes[__idx];
+            for (int i = 0; i < __n->m_count; ++i)
+            {
+                if (!__f(__n->m_keys[i], __n->m_children[i]))
+                    return false;
+            }
+            return true;
+        }
+        case NFSHM_RADIX_NODE48:
+        {
+            const NFShmRadixNode48 *__n = &m_node48.m_nodes[__idx];
+            for (int __c = 0; __c < 256; ++__c)
+            {
+                if (__n->m_index[__c] && !__f((uint8_t) __c, __n->m_children[__n->m_index[__c] - 1]))
+                    return false;
+            }
+            return true;
+        }
+        case NFSHM_RADIX_NODE256:
+        {
+            const NFShmRadixNode256 *__n = &m_node256.m_nodes[__idx];
+            for (int __c = 0; __c < 256; ++__c)
+            {
+                if (__n->m_children[__c] && !__f((uint8_t) __c, __n->m_children[__c]))
+                    return false;
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+const typename NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_Leaf *
+NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_minimum(uint32_t __ref) const
+{
+    while (__ref != 0 && _S_type(__ref) != NFSHM_RADIX_LEAF)
+    {
+        const NFShmRadixNodeHeader *__h = _M_header(__ref);
+        if (__h->m_leaf)
+        {
+            __ref = __h->m_leaf;
+            break;
+        }
+        uint32_t __first = 0;
+        _M_for_each_child(__ref, [&__first](uint8_t, uint32_t __child) {
+            __first = __child;
+            return false;
+        });
+        __ref = __first;
+    }
+    return __ref != 0 ? _M_leaf(_S_index(__ref)) : NULL;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+void NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_move_node(uint32_t &__ref, uint32_t __new)
+{
+    const NFShmRadixNodeHeader *__old = _M_header(__ref);
+    NFShmRadixNodeHeader *__h = _M_header(__new);
+    __h->m_leaf = __old->m_leaf;
+    __h->m_prefixLen = __old->m_prefixLen;
+    memcpy(__h->m_prefix, __old->m_prefix, sizeof(__h->m_prefix));
+    _M_for_each_child(__ref, [this, __new](uint8_t __c, uint32_t __child) {
+        _M_add_child(__new, __c, __child);
+        return true;
+    });
+    _M_delete_node(__ref);
+    __ref = __new;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+int NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_reserve_child(uint32_t &__ref)
+{
+    int __type = _S_type(__ref);
+    if (_M_header(__ref)->m_count < _S_capacity(__type))
+        return 0;
+
+    uint32_t __new = _M_new_node(__type + 1);
+    if (__new == 0)
+        return -1;
+    _M_move_node(__ref, __new);
+    return 0;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+void NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_shrink(uint32_t &__ref, size_t __depth)
+{
+    NFShmRadixNodeHeader *__h = _M_header(__ref);
+    if (__h->m_count == 0)
+    {
+        uint32_t __leaf = __h->m_leaf;
+        _M_delete_node(__ref);
+        __ref = __leaf;
+        return;
+    }
+
+    if (__h->m_count == 1 && __h->m_leaf == 0)
+    {
+        // 只剩一个子节点, 把自己的前缀和分支字节并到子节点的前缀里
+        uint32_t __child = 0;
+        _M_for_each_child(__ref, [&__child](uint8_t, uint32_t __c) {
+            __child = __c;
+            return false;
+        });
+        if (_S_type(__child) != NFSHM_RADIX_LEAF)
+        {
+            NFShmRadixNodeHeader *__ch = _M_header(__child);
+            std::string_view __full = _S_key(_M_minimum(__child));
+            _S_set_prefix(__ch, __full.data() + __depth, __h->m_prefixLen + 1 + __ch->m_prefixLen);
+        }
+        _M_delete_node(__ref);
+        __ref = __child;
+        return;
+    }
+
+    int __type = _S_type(__ref);
+    int __smaller = NFSHM_RADIX_NONE;
+    if (__type == NFSHM_RADIX_NODE16 && __h->m_count <= 3)
+        __smaller = NFSHM_RADIX_NODE4;
+    else if (__type == NFSHM_RADIX_NODE48 && __h->m_count <= 12)
+        __smaller = NFSHM_RADIX_NODE16;
+    else if (__type == NFSHM_RADIX_NODE256 && __h->m_count <= 37)
+        __smaller = NFSHM_RADIX_NODE48;
+
+    if (__smaller != NFSHM_RADIX_NONE)
+    {
+        uint32_t __new = _M_alloc_node(__smaller);
+        if (__new != 0)
+            _M_move_node(__ref, __new);
+    }
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+size_t NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_prefix_mismatch(uint32_t __ref, std::string_view __key, size_t __depth) const
+{
+    const NFShmRadixNodeHeader *__h = _M_header(__ref);
+    size_t __max = __key.size() - __depth;
+    if (__max > __h->m_prefixLen)
+        __max = __h->m_prefixLen;
+
+    size_t __stored = __max < NFSHM_RADIX_TREE_MAX_PREFIX ? __max : NFSHM_RADIX_TREE_MAX_PREFIX;
+    for (size_t i = 0; i < __stored; ++i)
+    {
+        if (__h->m_prefix[i] != (uint8_t) __key[__depth + i])
+            return i;
+    }
+
+    if (__max > NFSHM_RADIX_TREE_MAX_PREFIX)
+    {
+        std::string_view __full = _S_key(_M_minimum(__ref));
+        for (size_t i = NFSHM_RADIX_TREE_MAX_PREFIX; i < __max; ++i)
+        {
+            if (__full[__depth + i] != __key[__depth + i])
+                return i;
+        }
+    }
+    return __max;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+int NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_find_leaf(std::string_view __key) const
+{
+    uint32_t __ref = m_root;
+    size_t __depth = 0;
+    while (__ref != 0)
+    {
+        if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+        {
+            const _Leaf *__leaf = _M_leaf(_S_index(__ref));
+            return _S_key(__leaf) == __key ? _S_index(__ref) : INVALID_ID;
+        }
+
+        // 只比较保存下来的前缀字节, 其余的留给最后和叶子比较
+        const NFShmRadixNodeHeader *__h = _M_header(__ref);
+        if (__h->m_prefixLen > 0)
+        {
+            if (__depth + __h->m_prefixLen > __key.size())
+                return INVALID_ID;
+            size_t __n = __h->m_prefixLen < NFSHM_RADIX_TREE_MAX_PREFIX ? __h->m_prefixLen : NFSHM_RADIX_TREE_MAX_PREFIX;
+            if (memcmp(__h->m_prefix, __key.data() + __depth, __n) != 0)
+                return INVALID_ID;
+            __depth += __h->m_prefixLen;
+        }
+
+        if (__depth == __key.size())
+        {
+            __ref = __h->m_leaf;
+            continue;
+        }
+
+        const uint32_t *__child = _M_find_child(__ref, (uint8_t) __key[__depth]);
+        if (__child == NULL)
+            return INVALID_ID;
+        __ref = *__child;
+        ++__depth;
+    }
+    return INVALID_ID;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+int NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_insert(uint32_t &__ref, std::string_view __key, size_t __depth, const Tp &__obj, bool &__inserted)
+{
+    if (__ref == 0)
+    {
+        int __idx = _M_new_leaf(__key, __obj);
+        if (__idx == INVALID_ID)
+            return INVALID_ID;
+        __ref = _S_make(NFSHM_RADIX_LEAF, __idx);
+        __inserted = true;
+        return __idx;
+    }
+
+    if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+    {
+        std::string_view __oldKey = _S_key(_M_leaf(_S_index(__ref)));
+        if (__oldKey == __key)
+            return _S_index(__ref);
+        if (full())
+            return INVALID_ID;
+
+        // 两个叶子的公共部分作为新节点的前缀
+        size_t __lcp = __depth;
+        while (__lcp < __oldKey.size() && __lcp < __key.size() && __oldKey[__lcp] == __key[__lcp])
+            ++__lcp;
+
+        uint32_t __node = _M_new_node(NFSHM_RADIX_NODE4);
+        if (__node == 0)
+            return INVALID_ID;
+        _S_set_prefix(_M_header(__node), __key.data() + __depth, __lcp - __depth);
+
+        int __idx = _M_new_leaf(__key, __obj);
+        _M_attach(__node, __oldKey, __lcp, __ref);
+        _M_attach(__node, __key, __lcp, _S_make(NFSHM_RADIX_LEAF, __idx));
+        __ref = __node;
+        __inserted = true;
+        return __idx;
+    }
+
+    NFShmRadixNodeHeader *__h = _M_header(__ref);
+    if (__h->m_prefixLen > 0)
+    {
+        size_t __same = _M_prefix_mismatch(__ref, __key, __depth);
+        if (__same < __h->m_prefixLen)
+        {
+            // 在前缀中间分叉, 新节点的前缀是相同的部分, 原节点去掉相同部分和分支字节
+            if (full())
+                return INVALID_ID;
+            uint32_t __node = _M_new_node(NFSHM_RADIX_NODE4);
+            if (__node == 0)
+                return INVALID_ID;
+
+            std::string_view __full = _S_key(_M_minimum(__ref));
+            _S_set_prefix(_M_header(__node), __key.data() + __depth, __same);
+            uint8_t __oldByte = (uint8_t) __full[__depth + __same];
+            _S_set_prefix(__h, __full.data() + __depth + __same + 1, __h->m_prefixLen - __same - 1);
+            _M_add_child(__node, __oldByte, __ref);
+
+            int __idx = _M_new_leaf(__key, __obj);
+            _M_attach(__node, __key, __depth + __same, _S_make(NFSHM_RADIX_LEAF, __idx));
+            __ref = __node;
+            __inserted = true;
+            return __idx;
+        }
+        __depth += __h->m_prefixLen;
+    }
+
+    if (__depth == __key.size())
+    {
+        if (__h->m_leaf != 0)
+            return _S_index(__h->m_leaf);
+        int __idx = _M_new_leaf(__key, __obj);
+        if (__idx == INVALID_ID)
+            return INVALID_ID;
+        __h->m_leaf = _S_make(NFSHM_RADIX_LEAF, __idx);
+        __inserted = true;
+        return __idx;
+    }
+
+    uint32_t *__child = _M_find_child(__ref, (uint8_t) __key[__depth]);
+    if (__child != NULL)
+        return _M_insert(*__child, __key, __depth + 1, __obj, __inserted);
+
+    if (full() || _M_reserve_child(__ref) != 0)
+        return INVALID_ID;
+
+    int __idx = _M_new_leaf(__key, __obj);
+    _M_add_child(__ref, (uint8_t) __key[__depth], _S_make(NFSHM_RADIX_LEAF, __idx));
+    __inserted = true;
+    return __idx;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+bool NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_erase(uint32_t &__ref, std::string_view __key, size_t __depth)
+{
+    if (__ref == 0)
+        return false;
+
+    if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+    {
+        if (_S_key(_M_leaf(_S_index(__ref))) != __key)
+            return false;
+        _M_delete_leaf(_S_index(__ref));
+        __ref = 0;
+        return true;
+    }
+
+    NFShmRadixNodeHeader *__h = _M_header(__ref);
+    size_t __nodeDepth = __depth;
+    if (__h->m_prefixLen > 0)
+    {
+        if (_M_prefix_mismatch(__ref, __key, __depth) != __h->m_prefixLen)
+            return false;
+        __depth += __h->m_prefixLen;
+    }
+
+    if (__depth == __key.size())
+    {
+        if (__h->m_leaf == 0)
+            return false;
+        _M_delete_leaf(_S_index(__h->m_leaf));
+        __h->m_leaf = 0;
+        _M_shrink(__ref, __nodeDepth);
+        return true;
+    }
+
+    uint8_t __c = (uint8_t) __key[__depth];
+    uint32_t *__child = _M_find_child(__ref, __c);
+    if (__child == NULL || !_M_erase(*__child, __key, __depth + 1))
+        return false;
+
+    if (*__child == 0)
+        _M_remove_child(__ref, __c);
+    _M_shrink(__ref, __nodeDepth);
+    return true;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+const Tp *NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::longest_prefix(std::string_view __key) const
+{
+    const _Leaf *__best = NULL;
+    uint32_t __ref = m_root;
+    size_t __depth = 0;
+    while (__ref != 0)
+    {
+        if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+        {
+            const _Leaf *__leaf = _M_leaf(_S_index(__ref));
+            if (__leaf->m_len <= __key.size() && memcmp(__leaf->m_key, __key.data(), __leaf->m_len) == 0)
+                __best = __leaf;
+            break;
+        }
+
+        const NFShmRadixNodeHeader *__h = _M_header(__ref);
+        if (__h->m_prefixLen > 0)
+        {
+            if (_M_prefix_mismatch(__ref, __key, __depth) != __h->m_prefixLen)
+                break;
+            __depth += __h->m_prefixLen;
+        }
+
+        // 走到这里的路径是精确匹配的, m_leaf的key就是__key的前__depth个字节
+        if (__h->m_leaf != 0)
+            __best = _M_leaf(_S_index(__h->m_leaf));
+        if (__depth == __key.size())
+            break;
+
+        const uint32_t *__child = _M_find_child(__ref, (uint8_t) __key[__depth]);
+        if (__child == NULL)
+            break;
+        __ref = *__child;
+        ++__depth;
+    }
+    return __best ? &__best->m_data : NULL;
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+template<class _Self, class _Func>
+bool NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_visit(_Self *__self, uint32_t __ref, _Func &__f, size_type &__count)
+{
+    if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+    {
+        auto *__leaf = __self->_M_leaf(_S_index(__ref));
+        ++__count;
+        if constexpr (std::is_same<decltype(__f(_S_key(__leaf), __leaf->m_data)), bool>::value)
+        {
+            return __f(_S_key(__leaf), __leaf->m_data);
+        }
+        else
+        {
+            __f(_S_key(__leaf), __leaf->m_data);
+            return true;
+        }
+    }
+
+    uint32_t __leaf = __self->_M_header(__ref)->m_leaf;
+    if (__leaf != 0 && !_M_visit(__self, __leaf, __f, __count))
+        return false;
+    return __self->_M_for_each_child(__ref, [__self, &__f, &__count](uint8_t, uint32_t __child) {
+        return _M_visit(__self, __child, __f, __count);
+    });
+}
+
+template<class Tp, int MAX_SIZE, int MAX_KEY_LEN, int MAX_NODE16, int MAX_NODE48, int MAX_NODE256>
+template<class _Self, class _Func>
+typename NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::size_type
+NFShmRadixTree<Tp, MAX_SIZE, MAX_KEY_LEN, MAX_NODE16, MAX_NODE48, MAX_NODE256>::_M_prefix_scan(_Self *__self, std::string_view __prefix, _Func &__f)
+{
+    size_type __count = 0;
+    uint32_t __ref = __self->m_root;
+    size_t __depth = 0;
+    while (__ref != 0)
+    {
+        if (_S_type(__ref) == NFSHM_RADIX_LEAF)
+        {
+            std::string_view __key = _S_key(__self->_M_leaf(_S_index(__ref)));
+            if (__key.size() >= __prefix.size() && memcmp(__key.data(), __prefix.data(), __prefix.size()) == 0)
+                _M_visit(__self, __ref, __f, __count);
+            break;
+        }
+
+        // __prefix在节点前缀中间结束时, 整个子树都以__prefix开头
+        const NFShmRadixNodeHeader *__h = __self->_M_header(__ref);
+        size_t __same = __h->m_prefixLen > 0 ? __self->_M_prefix_mismatch(__ref, __prefix, __depth) : 0;
+        if (__depth + __same == __prefix.size())
+        {
+            _M_visit(__self, __ref, __f, __count);
+            break;
+        }
+        if (__same < __h->m_prefixLen)
+            break;
+        __depth += __h->m_prefixLen;
+
+        const uint32_t *__child = __self->_M_find_child(__ref, (uint8_t) __prefix[__depth]);
+        if (__child == NULL)
+            break;
+        __ref = *__child;
+        ++__depth;
+    }
+    return __count;
+}
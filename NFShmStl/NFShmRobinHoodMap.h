@@ -0,0 +1,487 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmRobinHoodMap.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmRobinHoodMap
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmPair.h"
+#include <iterator>
+#include <utility>
+#include <functional>
+
+/**
+ * @brief 探测距离用一个字节保存, 超过这个值的插入失败
+ */
+#define NFSHM_ROBIN_HOOD_MAX_DIST 255
+
+template<class Value, class Ref, class Ptr, class Container>
+struct NFShmRobinHoodMapIterator
+{
+    typedef NFShmRobinHoodMapIterator<Value, Value &, Value *, Container> iterator;
+    typedef NFShmRobinHoodMapIterator<Value, const Value &, const Value *, Container> const_iterator;
+    typedef NFShmRobinHoodMapIterator<Value, Ref, Ptr, Container> _Self;
+
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+
+    Container *m_pContainer;
+    int m_pos;
+
+    NFShmRobinHoodMapIterator(const Container *pContainer, int iPos) : m_pContainer(const_cast<Container *>(pContainer)), m_pos(iPos) {}
+
+    NFShmRobinHoodMapIterator() : m_pContainer(NULL), m_pos(0) {}
+
+    NFShmRobinHoodMapIterator(const iterator &__it) : m_pContainer(__it.m_pContainer), m_pos(__it.m_pos) {}
+
+    reference operator*() const { return *m_pContainer->_M_slot(m_pos); }
+
+    pointer operator->() const { return &(operator*()); }
+
+    _Self &operator++()
+    {
+        m_pos = m_pContainer->_M_next_used(m_pos + 1);
+        return *this;
+    }
+
+    _Self operator++(int)
+    {
+        _Self __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    bool operator==(const _Self &__it) const { return m_pos == __it.m_pos; }
+
+    bool operator!=(const _Self &__it) const { return m_pos != __it.m_pos; }
+};
+
+/**
+ * @brief 开放寻址的共享内存哈希表, 使用Robin Hood探测和后移删除(backward-shift deletion), 没有墓碑.
+ * 和拉链法的NFShmHashMap相比, 没有next下标和桶头, 每个槽位只多一个字节的探测距离.
+ * 负载率80%以内平均探测长度在2以内; 到95%时平均探测长度约8.7, 插入/删除要整段移动元素, 删旧插新比NFShmHashMap慢一个数量级
+ * (见bench的robin_hood), 所以MAX_SIZE建议按实际元素个数的1.25倍以上规划.
+ *
+ * 槽位个数就是MAX_SIZE, 负载率 = size() / MAX_SIZE, 不会rehash.
+ * m_dist[i]为0表示空槽, 否则是槽中元素离它的起始槽位的距离+1. 同一段连续槽位中元素按起始槽位排序, 所以:
+ * - 查找时遇到m_dist比当前探测距离小的槽位就可以确定不存在(early-exit), 只有m_dist等于当前距离的槽位才需要比较key;
+ * - 插入时把元素放到第一个m_dist比当前距离小的槽位, 后面的元素整体后移一格;
+ * - 删除时把后面m_dist>1的元素整体前移一格, 直到空槽或者已经在起始槽位的元素.
+ *
+ * 注意删除会移动其他元素, 遍历时删除请用erase_if, 插入和删除都会使迭代器和元素的引用失效.
+ */
+template<class Key, class Tp, int MAX_SIZE, class HashFcn = std::hash<Key>, class EqualKey = std::equal_to<Key> >
+class NFShmRobinHoodMap
+{
+public:
+    typedef Key key_type;
+    typedef Tp data_type;
+    typedef Tp mapped_type;
+    typedef NFShmPair<Key, Tp> value_type;
+    typedef HashFcn hasher;
+    typedef EqualKey key_equal;
+
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    typedef value_type *pointer;
+    typedef const value_type *const_pointer;
+    typedef value_type &reference;
+    typedef const value_type &const_reference;
+
+    typedef NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey> _Self;
+    typedef NFShmRobinHoodMapIterator<value_type, value_type &, value_type *, _Self> iterator;
+    typedef NFShmRobinHoodMapIterator<value_type, const value_type &, const value_type *, _Self> const_iterator;
+
+    friend struct NFShmRobinHoodMapIterator<value_type, value_type &, value_type *, _Self>;
+    friend struct NFShmRobinHoodMapIterator<value_type, const value_type &, const value_type *, _Self>;
+
+    static_assert(MAX_SIZE > 0, "NFShmRobinHoodMap MAX_SIZE must be positive");
+
+public:
+    NFShmRobinHoodMap()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    NFShmRobinHoodMap(const NFShmRobinHoodMap &__x)
+    {
+        CreateInit();
+        insert(__x.begin(), __x.end());
+    }
+
+    ~NFShmRobinHoodMap()
+    {
+        clear();
+    }
+
+    int CreateInit()
+    {
+#if NF_SHM_ZERO_ON_CREATE
+        memset(m_mem, 0, sizeof(m_mem));
+#endif
+        memset(m_dist, 0, sizeof(m_dist));
+        m_size = 0;
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (NFShmResumeConstruct<value_type>::value)
+        {
+            for (int i = 0; i < MAX_SIZE; ++i)
+            {
+                if (m_dist[i] != 0)
+                {
+                    std::_Construct(_M_slot(i));
+                }
+            }
+        }
+        return 0;
+    }
+
+    NFShmRobinHoodMap &operator=(const NFShmRobinHoodMap &__x)
+    {
+        if (this != &__x)
+        {
+            clear();
+            insert(__x.begin(), __x.end());
+        }
+        return *this;
+    }
+
+public:
+    size_type size() const { return m_size; }
+
+    size_type max_size() const { return MAX_SIZE; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_SIZE; }
+
+    size_t left_size() const { return MAX_SIZE - m_size; }
+
+    double load_factor() const { return (double) m_size / (double) MAX_SIZE; }
+
+    iterator begin() { return iterator(this, _M_next_used(0)); }
+
+    iterator end() { return iterator(this, MAX_SIZE); }
+
+    const_iterator begin() const { return const_iterator(this, _M_next_used(0)); }
+
+    const_iterator end() const { return const_iterator(this, MAX_SIZE); }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 额外开销只有每个槽位一个字节的探测距离
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(value_type), m_size, MAX_SIZE); }
+
+public:
+    /**
+     * @brief 插入, key已存在时不修改, 返回已有的元素
+     * @return 空间不够或者探测距离超过NFSHM_ROBIN_HOOD_MAX_DIST时返回(end(), false)
+     */
+    std::pair<iterator, bool> insert(const value_type &__obj);
+
+    std::pair<iterator, bool> emplace(const key_type &__key, const data_type &__data) { return insert(value_type(__key, __data)); }
+
+    template<class _InputIterator>
+    void insert(_InputIterator __f, _InputIterator __l)
+    {
+        for (; __f != __l; ++__f)
+        {
+            insert(*__f);
+        }
+    }
+
+    iterator find(const key_type &__key)
+    {
+        int __pos, __d;
+        return _M_probe(__key, __pos, __d) ? iterator(this, __pos) : end();
+    }
+
+    const_iterator find(const key_type &__key) const
+    {
+        int __pos, __d;
+        return _M_probe(__key, __pos, __d) ? const_iterator(this, __pos) : end();
+    }
+
+    size_type count(const key_type &__key) const
+    {
+        int __pos, __d;
+        return _M_probe(__key, __pos, __d) ? 1 : 0;
+    }
+
+    Tp &operator[](const key_type &__key)
+    {
+        std::pair<iterator, bool> __ret = insert(value_type(__key, Tp()));
+        NF_ASSERT(__ret.first != end());
+        return __ret.first->second;
+    }
+
+    size_type erase(const key_type &__key)
+    {
+        int __pos, __d;
+        if (!_M_probe(__key, __pos, __d))
+            return 0;
+        _M_erase_pos(__pos);
+        return 1;
+    }
+
+    /**
+     * @brief 删除迭代器指向的元素, 后面的元素会前移, 所以不返回下一个位置, 遍历时删除用erase_if
+     */
+    void erase(iterator __it)
+    {
+        if (__it.m_pos >= 0 && __it.m_pos < MAX_SIZE && m_dist[__it.m_pos] != 0)
+            _M_erase_pos(__it.m_pos);
+    }
+
+    /**
+     * @brief 删除所有满足__pred(value)的元素, 每个元素只检查一次
+     * @return 删除的个数
+     */
+    template<class _Predicate>
+    size_type erase_if(_Predicate __pred);
+
+    void clear()
+    {
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            if (m_dist[i] != 0)
+            {
+                std::_Destroy(_M_slot(i));
+            }
+        }
+        memset(m_dist, 0, sizeof(m_dist));
+        m_size = 0;
+    }
+
+public:
+    /**
+     * @brief 所有元素中最长的探测距离, 0表示在起始槽位
+     */
+    size_type max_probe() const
+    {
+        int __max = 0;
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            if (m_dist[i] > __max)
+                __max = m_dist[i];
+        }
+        return __max > 0 ? __max - 1 : 0;
+    }
+
+    /**
+     * @brief 平均探测距离, 查找命中时平均要比较的槽位个数是avg_probe() + 1
+     */
+    double avg_probe() const
+    {
+        if (m_size == 0)
+            return 0;
+        uint64_t __sum = 0;
+        for (int i = 0; i < MAX_SIZE; ++i)
+        {
+            if (m_dist[i] != 0)
+                __sum += m_dist[i] - 1;
+        }
+        return (double) __sum / (double) m_size;
+    }
+
+    /**
+     * @brief 检查m_dist和元素位置是否一致, 以及Robin Hood的顺序, 用于共享内存恢复后的检查
+     */
+    bool verify() const;
+
+protected:
+    value_type *_M_slot(int __pos) { return reinterpret_cast<value_type *>(m_mem) + __pos; }
+
+    const value_type *_M_slot(int __pos) const { return reinterpret_cast<const value_type *>(m_mem) + __pos; }
+
+    int _M_next_used(int __pos) const
+    {
+        while (__pos < MAX_SIZE && m_dist[__pos] == 0)
+            ++__pos;
+        return __pos;
+    }
+
+    static int _M_next_pos(int __pos) { return __pos + 1 == MAX_SIZE ? 0 : __pos + 1; }
+
+    static int _M_prev_pos(int __pos) { return __pos == 0 ? MAX_SIZE - 1 : __pos - 1; }
+
+    /**
+     * @brief 起始槽位, 先用Fibonacci hashing把hash值打散, 再乘法映射到[0, MAX_SIZE), MAX_SIZE不需要是2的幂
+     */
+    static int _M_home(const key_type &__key)
+    {
+        uint64_t __h = (uint64_t) hasher()(__key) * 0x9E3779B97F4A7C15ull;
+        return (int) (((__h >> 32) * (uint64_t) MAX_SIZE) >> 32);
+    }
+
+    /**
+     * @brief 探测__key
+     * @param __pos 找到时是元素所在的槽位, 否则是插入的槽位
+     * @param __d 插入时的m_dist
+     * @return 是否找到
+     */
+    bool _M_probe(const key_type &__key, int &__pos, int &__d) const
+    {
+        __pos = _M_home(__key);
+        for (__d = 1;; ++__d)
+        {
+            int __cur = m_dist[__pos];
+            if (__cur < __d)
+                return false;
+            if (__cur == __d && key_equal()(_M_slot(__pos)->first, __key))
+                return true;
+            __pos = _M_next_pos(__pos);
+        }
+    }
+
+    void _M_erase_pos(int __pos);
+
+protected:
+    alignas(value_type) int8_t m_mem[sizeof(value_type) * MAX_SIZE];
+    uint8_t m_dist[MAX_SIZE];
+    int m_size;
+};
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+std::pair<typename NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::iterator, bool>
+NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::insert(const value_type &__obj)
+{
+    int __pos, __d;
+    if (_M_probe(__obj.first, __pos, __d))
+        return std::pair<iterator, bool>(iterator(this, __pos), false);
+
+    if (m_size >= MAX_SIZE)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmRobinHoodMap No Enough Space! MAX_SIZE:{}", MAX_SIZE);
+        return std::pair<iterator, bool>(end(), false);
+    }
+
+    // 从__pos往后找空槽, 中间的元素都要后移一格, 距离加1
+    int __end = __pos;
+    while (m_dist[__end] != 0)
+    {
+        if (m_dist[__end] >= NFSHM_ROBIN_HOOD_MAX_DIST)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmRobinHoodMap probe distance overflow, size:{} MAX_SIZE:{}", m_size, MAX_SIZE);
+            return std::pair<iterator, bool>(end(), false);
+        }
+        __end = _M_next_pos(__end);
+    }
+    if (__d > NFSHM_ROBIN_HOOD_MAX_DIST)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmRobinHoodMap probe distance overflow, size:{} MAX_SIZE:{}", m_size, MAX_SIZE);
+        return std::pair<iterator, bool>(end(), false);
+    }
+
+    if (__end == __pos)
+    {
+        std::_Construct(_M_slot(__pos), __obj);
+    }
+    else
+    {
+        // 只有最后一个元素需要在空槽上构造, 其余都是赋值, 最后__pos上的元素被__obj覆盖
+        int __prev = _M_prev_pos(__end);
+        std::_Construct(_M_slot(__end), std::move(*_M_slot(__prev)));
+        m_dist[__end] = m_dist[__prev] + 1;
+        for (__end = __prev; __end != __pos; __end = __prev)
+        {
+            __prev = _M_prev_pos(__end);
+            *_M_slot(__end) = std::move(*_M_slot(__prev));
+            m_dist[__end] = m_dist[__prev] + 1;
+        }
+        *_M_slot(__pos) = __obj;
+    }
+    m_dist[__pos] = (uint8_t) __d;
+    ++m_size;
+    return std::pair<iterator, bool>(iterator(this, __pos), true);
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+void NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::_M_erase_pos(int __pos)
+{
+    int __next = _M_next_pos(__pos);
+    while (m_dist[__next] > 1)
+    {
+        *_M_slot(__pos) = std::move(*_M_slot(__next));
+        m_dist[__pos] = m_dist[__next] - 1;
+        __pos = __next;
+        __next = _M_next_pos(__next);
+    }
+    std::_Destroy(_M_slot(__pos));
+    m_dist[__pos] = 0;
+    --m_size;
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+template<class _Predicate>
+typename NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::size_type
+NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::erase_if(_Predicate __pred)
+{
+    if (m_size == 0)
+        return 0;
+
+    // 从一段连续槽位的开头(空槽或者在起始槽位的元素)开始扫一圈, 后移删除只会把还没扫到的元素移到当前位置,
+    // 并且不会越过开头, 所以每个元素正好检查一次
+    int __start = 0;
+    while (__start < MAX_SIZE && m_dist[__start] > 1)
+        ++__start;
+    if (__start == MAX_SIZE)
+        __start = 0;
+
+    size_type __erased = 0;
+    int __pos = __start;
+    for (int __n = 0; __n < MAX_SIZE;)
+    {
+        if (m_dist[__pos] != 0 && __pred(*_M_slot(__pos)))
+        {
+            _M_erase_pos(__pos);
+            ++__erased;
+            if (m_dist[__pos] != 0 && _M_next_pos(__pos) != __start)
+                continue;
+        }
+        __pos = _M_next_pos(__pos);
+        ++__n;
+    }
+    return __erased;
+}
+
+template<class Key, class Tp, int MAX_SIZE, class HashFcn, class EqualKey>
+bool NFShmRobinHoodMap<Key, Tp, MAX_SIZE, HashFcn, EqualKey>::verify() const
+{
+    int __count = 0;
+    for (int i = 0; i < MAX_SIZE; ++i)
+    {
+        if (m_dist[i] == 0)
+            continue;
+        ++__count;
+        int __home = _M_home(_M_slot(i)->first);
+        int __dist = i >= __home ? i - __home : i + MAX_SIZE - __home;
+        CHECK_EXPR(__dist + 1 == m_dist[i], false, "NFShmRobinHoodMap verify failed, slot:{} dist:{} real:{}", i, m_dist[i], __dist + 1);
+        int __next = _M_next_pos(i);
+        CHECK_EXPR(m_dist[__next] <= m_dist[i] + 1, false, "NFShmRobinHoodMap verify failed, slot:{} dist:{} next dist:{}", i, m_dist[i], m_dist[__next]);
+    }
+    CHECK_EXPR(__count == m_size, false, "NFShmRobinHoodMap verify failed, used slots:{} size:{}", __count, m_size);
+    return true;
+}
@@ -0,0 +1,316 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmSearch.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmSearch
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NFSHM_SEARCH_SSE2 1
+#endif
+
+/**
+ * @brief 字节查找和比较, 用于NFShmString的find/rfind, operator==和operator<
+ * 单字符查找和子串查找都是一次比较16(SSE2)或32(AVX2)个字节, 子串查找先用首尾两个字符过滤候选位置,
+ * 再对候选位置memcmp. 没有SIMD指令集时退化为逐字节比较.
+ * 注意这里不使用SSE4.2的pcmpestri, 对于聊天/名字这种短文本, 首尾字符过滤的方式更快.
+ */
+
+inline unsigned _NFShmSearchCtz(uint32_t __m)
+{
+#if defined(_MSC_VER)
+    unsigned long __r;
+    _BitScanForward(&__r, __m);
+    return (unsigned) __r;
+#else
+    return (unsigned) __builtin_ctz(__m);
+#endif
+}
+
+inline unsigned _NFShmSearchBsr(uint32_t __m)
+{
+#if defined(_MSC_VER)
+    unsigned long __r;
+    _BitScanReverse(&__r, __m);
+    return (unsigned) __r;
+#else
+    return 31u - (unsigned) __builtin_clz(__m);
+#endif
+}
+
+/**
+ * @brief 在[__s, __s + __n)中查找第一个__c
+ * @return 找到返回位置, 否则返回NULL
+ */
+inline const char *NFShmMemChr(const char *__s, size_t __n, char __c)
+{
+    size_t __i = 0;
+#if defined(__AVX2__)
+    const __m256i __v32 = _mm256_set1_epi8(__c);
+    for (; __i + 32 <= __n; __i += 32)
+    {
+        __m256i __d = _mm256_loadu_si256((const __m256i *) (__s + __i));
+        uint32_t __m = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(__d, __v32));
+        if (__m)
+            return __s + __i + _NFShmSearchCtz(__m);
+    }
+#endif
+#if defined(NFSHM_SEARCH_SSE2)
+    const __m128i __v16 = _mm_set1_epi8(__c);
+    for (; __i + 16 <= __n; __i += 16)
+    {
+        __m128i __d = _mm_loadu_si128((const __m128i *) (__s + __i));
+        uint32_t __m = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(__d, __v16));
+        if (__m)
+            return __s + __i + _NFShmSearchCtz(__m);
+    }
+#endif
+    for (; __i < __n; ++__i)
+    {
+        if (__s[__i] == __c)
+            return __s + __i;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在[__s, __s + __n)中查找最后一个__c
+ * @return 找到返回位置, 否则返回NULL
+ */
+inline const char *NFShmMemRChr(const char *__s, size_t __n, char __c)
+{
+    size_t __i = __n;
+#if defined(__AVX2__)
+    const __m256i __v32 = _mm256_set1_epi8(__c);
+    for (; __i >= 32; __i -= 32)
+    {
+        __m256i __d = _mm256_loadu_si256((const __m256i *) (__s + __i - 32));
+        uint32_t __m = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(__d, __v32));
+        if (__m)
+            return __s + __i - 32 + _NFShmSearchBsr(__m);
+    }
+#endif
+#if defined(NFSHM_SEARCH_SSE2)
+    const __m128i __v16 = _mm_set1_epi8(__c);
+    for (; __i >= 16; __i -= 16)
+    {
+        __m128i __d = _mm_loadu_si128((const __m128i *) (__s + __i - 16));
+        uint32_t __m = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(__d, __v16));
+        if (__m)
+            return __s + __i - 16 + _NFShmSearchBsr(__m);
+    }
+#endif
+    while (__i > 0)
+    {
+        --__i;
+        if (__s[__i] == __c)
+            return __s + __i;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在[__s, __s + __n)中查找第一个子串[__p, __p + __m)
+ * @return 找到返回位置, 否则返回NULL. __m为0时返回__s
+ */
+inline const char *NFShmMemMem(const char *__s, size_t __n, const char *__p, size_t __m)
+{
+    if (__m == 0)
+        return __s;
+    if (__m > __n)
+        return NULL;
+    if (__m == 1)
+        return NFShmMemChr(__s, __n, __p[0]);
+
+    // 候选起始位置为[0, __cnt), 首字符从__s + __i读, 尾字符从__s + __i + __m - 1读, 都不会越界
+    const size_t __cnt = __n - __m + 1;
+    size_t __i = 0;
+#if defined(__AVX2__)
+    const __m256i __first32 = _mm256_set1_epi8(__p[0]);
+    const __m256i __last32 = _mm256_set1_epi8(__p[__m - 1]);
+    for (; __i + 32 <= __cnt; __i += 32)
+    {
+        __m256i __bf = _mm256_loadu_si256((const __m256i *) (__s + __i));
+        __m256i __bl = _mm256_loadu_si256((const __m256i *) (__s + __i + __m - 1));
+        uint32_t __mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(__bf, __first32), _mm256_cmpeq_epi8(__bl, __last32)));
+        while (__mask)
+        {
+            size_t __pos = __i + _NFShmSearchCtz(__mask);
+            if (memcmp(__s + __pos + 1, __p + 1, __m - 2) == 0)
+                return __s + __pos;
+            __mask &= __mask - 1;
+        }
+    }
+#endif
+#if defined(NFSHM_SEARCH_SSE2)
+    const __m128i __first16 = _mm_set1_epi8(__p[0]);
+    const __m128i __last16 = _mm_set1_epi8(__p[__m - 1]);
+    for (; __i + 16 <= __cnt; __i += 16)
+    {
+        __m128i __bf = _mm_loadu_si128((const __m128i *) (__s + __i));
+        __m128i __bl = _mm_loadu_si128((const __m128i *) (__s + __i + __m - 1));
+        uint32_t __mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(__bf, __first16), _mm_cmpeq_epi8(__bl, __last16)));
+        while (__mask)
+        {
+            size_t __pos = __i + _NFShmSearchCtz(__mask);
+            if (memcmp(__s + __pos + 1, __p + 1, __m - 2) == 0)
+                return __s + __pos;
+            __mask &= __mask - 1;
+        }
+    }
+#endif
+    for (; __i < __cnt; ++__i)
+    {
+        if (__s[__i] == __p[0] && __s[__i + __m - 1] == __p[__m - 1] && memcmp(__s + __i + 1, __p + 1, __m - 2) == 0)
+            return __s + __i;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 在[__s, __s + __n)中查找最后一个子串[__p, __p + __m)
+ * @return 找到返回位置, 否则返回NULL. __m为0时返回__s + __n
+ */
+inline const char *NFShmMemRMem(const char *__s, size_t __n, const char *__p, size_t __m)
+{
+    if (__m == 0)
+        return __s + __n;
+    if (__m > __n)
+        return NULL;
+
+    // 从后往前按尾字符跳, 每次用NFShmMemRChr定位下一个候选位置
+    size_t __end = __n;
+    while (__end >= __m)
+    {
+        const char *__r = NFShmMemRChr(__s + __m - 1, __end - __m + 1, __p[__m - 1]);
+        if (__r == NULL)
+            return NULL;
+        const char *__cand = __r - (__m - 1);
+        if (memcmp(__cand, __p, __m - 1) == 0)
+            return __cand;
+        __end = (size_t) (__r - __s);
+    }
+    return NULL;
+}
+
+/**
+ * @brief 比较[__a, __a + __n)和[__b, __b + __n)是否相等, 用于NFShmString的operator==
+ * 长度已经比较过了, 这里先比较前8个字节快速排除, 再按8/16字节比较, 最后一段用重叠读取, 不逐字节循环.
+ */
+inline bool NFShmMemEq(const char *__a, const char *__b, size_t __n)
+{
+    if (__n >= 8)
+    {
+        uint64_t __x, __y;
+        memcpy(&__x, __a, 8);
+        memcpy(&__y, __b, 8);
+        if (__x != __y)
+            return false;
+
+        size_t __i = 8;
+#if defined(NFSHM_SEARCH_SSE2)
+        for (; __i + 16 <= __n; __i += 16)
+        {
+            __m128i __va = _mm_loadu_si128((const __m128i *) (__a + __i));
+            __m128i __vb = _mm_loadu_si128((const __m128i *) (__b + __i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(__va, __vb)) != 0xFFFF)
+                return false;
+        }
+#endif
+        for (; __i + 8 <= __n; __i += 8)
+        {
+            memcpy(&__x, __a + __i, 8);
+            memcpy(&__y, __b + __i, 8);
+            if (__x != __y)
+                return false;
+        }
+        if (__i < __n)
+        {
+            memcpy(&__x, __a + __n - 8, 8);
+            memcpy(&__y, __b + __n - 8, 8);
+            return __x == __y;
+        }
+        return true;
+    }
+
+    if (__n >= 4)
+    {
+        uint32_t __x0, __y0, __x1, __y1;
+        memcpy(&__x0, __a, 4);
+        memcpy(&__y0, __b, 4);
+        memcpy(&__x1, __a + __n - 4, 4);
+        memcpy(&__y1, __b + __n - 4, 4);
+        return ((__x0 ^ __y0) | (__x1 ^ __y1)) == 0;
+    }
+
+    for (size_t __i = 0; __i < __n; ++__i)
+    {
+        if (__a[__i] != __b[__i])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 取前8个字节(不够8个补0), 转换成大端整数, 整数的大小关系和memcmp的结果一致
+ */
+inline uint64_t NFShmMemPrefix(const char *__s, size_t __n)
+{
+    uint64_t __v = 0;
+    if (__n < 8)
+    {
+        for (size_t __i = 0; __i < __n; ++__i)
+        {
+            __v |= (uint64_t) (uint8_t) __s[__i] << (56 - 8 * __i);
+        }
+        return __v;
+    }
+
+    memcpy(&__v, __s, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __v;
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(__v);
+#else
+    return __builtin_bswap64(__v);
+#endif
+}
+
+/**
+ * @brief 字典序比较, 结果和std::char_traits<char>::compare加长度比较一致
+ * 先比较前8个字节组成的整数, 大部分key在这里就能分出大小, 相同时再memcmp剩下的部分.
+ */
+inline int NFShmMemCompare(const char *__a, size_t __na, const char *__b, size_t __nb)
+{
+    uint64_t __pa = NFShmMemPrefix(__a, __na);
+    uint64_t __pb = NFShmMemPrefix(__b, __nb);
+    if (__pa != __pb)
+        return __pa < __pb ? -1 : 1;
+
+    size_t __n = __na < __nb ? __na : __nb;
+    if (__n > 8)
+    {
+        int __cmp = memcmp(__a + 8, __b + 8, __n - 8);
+        if (__cmp != 0)
+            return __cmp;
+    }
+    return __na < __nb ? -1 : (__na > __nb ? 1 : 0);
+}
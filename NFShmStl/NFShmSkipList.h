@@ -0,0 +1,934 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmSkipList.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmSkipList
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmPair.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+/**
+ * @brief 跳表的层数: 4^(L-1) >= MAX_SIZE 的最小L再加一层, 最多32层
+ */
+constexpr int NFShmSkipListLevels(int __n, int __l = 1)
+{
+    return (__l >= 31 || (1LL << (2 * (__l - 1))) >= __n) ? __l + 1 : NFShmSkipListLevels(__n, __l + 1);
+}
+
+/**
+ * @brief 高度为h(h >= 2)的塔的个数上限, 期望个数 MAX_SIZE * 3/4 * (1/4)^(h-1) 的两倍再加4
+ */
+constexpr int NFShmSkipListTowerCap(int __n, int __h)
+{
+    return (int) ((6LL * __n) >> (2 * __h)) + 4;
+}
+
+/**
+ * @brief 高度为h的塔池在m_arena中的起始位置, 高度h的塔占h-1个链接(第0层放在节点里)
+ */
+constexpr int NFShmSkipListTowerBase(int __n, int __h)
+{
+    return __h <= 2 ? 0 : NFShmSkipListTowerBase(__n, __h - 1) + NFShmSkipListTowerCap(__n, __h - 1) * (__h - 2);
+}
+
+template<class Container, class Value, class Ref, class Ptr>
+struct NFShmSkipListIterator
+{
+    typedef Value value_type;
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ptrdiff_t difference_type;
+    typedef size_t size_type;
+    typedef Ref reference;
+    typedef Ptr pointer;
+    typedef NFShmSkipListIterator<Container, Value, Value &, Value *> iterator;
+    typedef NFShmSkipListIterator<Container, Value, Ref, Ptr> _Self;
+
+    const Container *m_pContainer;
+    int m_node;
+
+    NFShmSkipListIterator(const Container *pContainer, int iNode) : m_pContainer(pContainer), m_node(iNode) {}
+
+    NFShmSkipListIterator() : m_pContainer(NULL), m_node(-1) {}
+
+    NFShmSkipListIterator(const iterator &__x) : m_pContainer(__x.m_pContainer), m_node(__x.m_node) {}
+
+    reference operator*() const { return const_cast<Container *>(m_pContainer)->_M_value(m_node); }
+
+    pointer operator->() const { return &(operator*()); }
+
+    _Self &operator++()
+    {
+        m_node = m_pContainer->_M_next(m_node);
+        return *this;
+    }
+
+    _Self operator++(int)
+    {
+        _Self __tmp = *this;
+        ++*this;
+        return __tmp;
+    }
+
+    _Self &operator--()
+    {
+        m_node = m_node == -1 ? m_pContainer->m_tail : m_pContainer->m_nodes[m_node].m_backward;
+        return *this;
+    }
+
+    _Self operator--(int)
+    {
+        _Self __tmp = *this;
+        --*this;
+        return __tmp;
+    }
+
+    bool operator==(const _Self &__it) const { return m_node == __it.m_node; }
+
+    bool operator!=(const _Self &__it) const { return m_node != __it.m_node; }
+};
+
+/**
+ * @brief 共享内存里的跳表, 按Key有序, 允许重复Key(相同Key按插入顺序排), 和Redis的zset一样带跨度(span), 按名次查找和求名次都是O(log n).
+ * 适合排行榜一类既要按分数范围扫, 又要按名次取的场景.
+ * 只按Key查找/更新时比红黑树慢: 10万~100万个元素时find约是std::multimap的2.5~3.5倍, 删旧插新约3倍(见bench的skip_list),
+ * 只需要按Key查找的数据请用NFShmHashMap.
+ *
+ * 所有链接都是下标. 第0层链接和后退指针放在节点里; 高度h >= 2的节点另有一座h-1个链接的塔,
+ * 从高度h专用的塔池里分配, 每个高度的塔池大小按概率(p = 1/4)预留两倍, 不按最高层给每个节点都留满,
+ * 平均每个节点只多占不到一个链接. 某个高度的塔池用完时新节点降一层, 只影响平衡, 不会插入失败.
+ *
+ * 和NFShmRobinHoodMap一样元素是NFShmPair<Key, Val>, 不要通过迭代器修改first, 要改分数先erase再insert.
+ * 只能单写. 恢复时先校验, 在插入/删除的中途崩溃(链接不完整)时按有效节点重新排序并重建所有层.
+ *
+ * 用法:
+ * NFShmSkipList<int64_t, uint64_t, 100000, std::greater<int64_t> > m_rank;   //分数从高到低
+ * m_rank.insert(score, roleId);
+ * size_t myRank = m_rank.rank(it);
+ * m_rank.range_by_rank(0, 99, [](const NFShmPair<int64_t, uint64_t> &v) { ... });  //前100名
+ * m_rank.range_by_score(5000, 3000, ...);   //比较器是greater时, 范围也从大到小写
+ */
+template<class Key, class Val, int MAX_SIZE, class Compare = std::less<Key> >
+class NFShmSkipList
+{
+public:
+    static_assert(MAX_SIZE > 0, "NFShmSkipList MAX_SIZE must be positive");
+
+    typedef Key key_type;
+    typedef Val mapped_type;
+    typedef NFShmPair<Key, Val> value_type;
+    typedef Compare key_compare;
+    typedef size_t size_type;
+    typedef NFShmSkipList<Key, Val, MAX_SIZE, Compare> _Self;
+    typedef NFShmSkipListIterator<_Self, value_type, value_type &, value_type *> iterator;
+    typedef NFShmSkipListIterator<_Self, value_type, const value_type &, const value_type *> const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    enum
+    {
+        MAX_LEVEL = NFShmSkipListLevels(MAX_SIZE),
+        ARENA_SIZE = NFShmSkipListTowerBase(MAX_SIZE, MAX_LEVEL + 1),
+        HEAD = MAX_SIZE,    //!<表头的编号
+    };
+
+    template<class, class, class, class> friend struct NFShmSkipListIterator;
+
+private:
+    struct _Link
+    {
+        int m_forward;
+        int m_span;     //!<到m_forward跨过的第0层节点数; m_forward为-1时是本节点之后的节点数
+    };
+
+    struct _Node
+    {
+        alignas(value_type) int8_t m_data[sizeof(value_type)];
+        _Link m_link0;
+        int m_backward;
+        int m_tower;    //!<高度>=2时第1层链接在m_arena中的位置
+        int m_height;   //!<0表示空闲节点, 空闲节点用m_link0.m_forward串成空闲链表
+    };
+
+public:
+    NFShmSkipList()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    NFShmSkipList(const NFShmSkipList &__x)
+    {
+        CreateInit();
+        insert(__x.begin(), __x.end());
+    }
+
+    ~NFShmSkipList()
+    {
+        clear();
+    }
+
+    int CreateInit()
+    {
+        m_seed = 0x9E3779B9u;
+        for (int i = 0; i < MAX_SIZE; ++i)
+            m_nodes[i].m_height = 0;
+        _M_reset();
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        if (NFShmResumeConstruct<value_type>::value)
+        {
+            for (int i = 0; i < MAX_SIZE; ++i)
+            {
+                if (m_nodes[i].m_height > 0)
+                    std::_Construct(_M_ptr(i));
+            }
+        }
+        if (!verify())
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "NFShmSkipList inconsistent after resume, rebuild, size:{}", m_size);
+            rebuild();
+        }
+        return 0;
+    }
+
+    NFShmSkipList &operator=(const NFShmSkipList &__x)
+    {
+        if (this != &__x)
+        {
+            clear();
+            insert(__x.begin(), __x.end());
+        }
+        return *this;
+    }
+
+public:
+    iterator begin() { return iterator(this, m_header[0].m_forward); }
+
+    iterator end() { return iterator(this, -1); }
+
+    const_iterator begin() const { return const_iterator(this, m_header[0].m_forward); }
+
+    const_iterator end() const { return const_iterator(this, -1); }
+
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    size_type size() const { return m_size; }
+
+    size_type max_size() const { return MAX_SIZE; }
+
+    bool empty() const { return m_size == 0; }
+
+    bool full() const { return m_size >= MAX_SIZE; }
+
+    int level() const { return m_level; }
+
+public:
+    /**
+     * @brief 插入, 相同Key排在已有的后面, 满了返回end()
+     */
+    iterator insert(const Key &__k, const Val &__v) { return insert(value_type(__k, __v)); }
+
+    iterator insert(const value_type &__v)
+    {
+        if (m_free == -1)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmSkipList No Enough Space! MAX_SIZE:{}", MAX_SIZE);
+            return end();
+        }
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path(__v.first, true, __update, __rank);
+        return iterator(this, _M_insert_at(__v, __update, __rank));
+    }
+
+    template<class _InputIterator, class = typename std::iterator_traits<_InputIterator>::iterator_category>
+    void insert(_InputIterator __f, _InputIterator __l)
+    {
+        for (; __f != __l; ++__f)
+            insert(*__f);
+    }
+
+    /**
+     * @brief Key不存在时才插入
+     */
+    std::pair<iterator, bool> insert_unique(const value_type &__v)
+    {
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path(__v.first, false, __update, __rank);
+        int __x = _M_link(__update[0], 0).m_forward;
+        if (__x != -1 && !m_cmp(__v.first, _M_key(__x)))
+            return std::make_pair(iterator(this, __x), false);
+        if (m_free == -1)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmSkipList No Enough Space! MAX_SIZE:{}", MAX_SIZE);
+            return std::make_pair(end(), false);
+        }
+        // 插在所有小于Key的节点之后, 和upper_bound的位置相同, 因为没有等于Key的节点
+        return std::make_pair(iterator(this, _M_insert_at(__v, __update, __rank)), true);
+    }
+
+    iterator erase(iterator __it)
+    {
+        int __x = __it.m_node;
+        CHECK_EXPR(_M_valid(__x), end(), "NFShmSkipList erase invalid node:{}", __x);
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path_to(__x, __update, __rank);
+        int __next = m_nodes[__x].m_link0.m_forward;
+        _M_erase_node(__x, __update);
+        return iterator(this, __next);
+    }
+
+    /**
+     * @brief 删除所有等于Key的元素
+     */
+    size_type erase(const Key &__k)
+    {
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path(__k, false, __update, __rank);
+        size_type __n = 0;
+        int __x = _M_link(__update[0], 0).m_forward;
+        while (__x != -1 && !m_cmp(__k, _M_key(__x)))
+        {
+            int __next = m_nodes[__x].m_link0.m_forward;
+            _M_erase_node(__x, __update);
+            __x = __next;
+            ++__n;
+        }
+        return __n;
+    }
+
+    void clear()
+    {
+        for (int __x = m_header[0].m_forward; __x != -1; __x = m_nodes[__x].m_link0.m_forward)
+        {
+            std::_Destroy(_M_ptr(__x));
+            m_nodes[__x].m_height = 0;
+        }
+        _M_reset();
+    }
+
+    /**
+     * @brief 第一个等于Key的元素
+     */
+    iterator find(const Key &__k)
+    {
+        iterator __it = lower_bound(__k);
+        return __it != end() && !m_cmp(__k, __it->first) ? __it : end();
+    }
+
+    const_iterator find(const Key &__k) const
+    {
+        const_iterator __it = lower_bound(__k);
+        return __it != end() && !m_cmp(__k, __it->first) ? __it : end();
+    }
+
+    size_type count(const Key &__k) const { return count_in_range(__k, __k); }
+
+    bool contains(const Key &__k) const { return find(__k) != end(); }
+
+    iterator lower_bound(const Key &__k) { return iterator(this, _M_bound(__k, false)); }
+
+    iterator upper_bound(const Key &__k) { return iterator(this, _M_bound(__k, true)); }
+
+    const_iterator lower_bound(const Key &__k) const { return const_iterator(this, _M_bound(__k, false)); }
+
+    const_iterator upper_bound(const Key &__k) const { return const_iterator(this, _M_bound(__k, true)); }
+
+    std::pair<iterator, iterator> equal_range(const Key &__k) { return std::make_pair(lower_bound(__k), upper_bound(__k)); }
+
+    std::pair<const_iterator, const_iterator> equal_range(const Key &__k) const { return std::make_pair(lower_bound(__k), upper_bound(__k)); }
+
+public:
+    /**
+     * @brief 名次, 从0开始, 即排在它前面的元素个数
+     */
+    size_type rank(const_iterator __it) const
+    {
+        if (__it.m_node == -1)
+            return m_size;
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path_to(__it.m_node, __update, __rank);
+        return __rank[0];
+    }
+
+    /**
+     * @brief 小于Key的元素个数, 也就是Key插入时的最小名次
+     */
+    size_type rank_of(const Key &__k) const
+    {
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path(__k, false, __update, __rank);
+        return __rank[0];
+    }
+
+    /**
+     * @brief 名次为__r(从0开始)的元素, 超出范围返回end()
+     */
+    iterator at_rank(size_type __r) { return iterator(this, _M_at_rank(__r)); }
+
+    const_iterator at_rank(size_type __r) const { return const_iterator(this, _M_at_rank(__r)); }
+
+    /**
+     * @brief 在[__lo, __hi]内(按比较器的顺序, 两端都包含)的元素个数, O(log n)
+     */
+    size_type count_in_range(const Key &__lo, const Key &__hi) const
+    {
+        if (m_cmp(__hi, __lo))
+            return 0;
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path(__hi, true, __update, __rank);
+        size_type __upper = __rank[0];
+        _M_path(__lo, false, __update, __rank);
+        return __upper - __rank[0];
+    }
+
+    /**
+     * @brief 按顺序对[__lo, __hi]内的每个元素调用__f(const value_type &), 返回个数
+     */
+    template<class F>
+    size_type range_by_score(const Key &__lo, const Key &__hi, F __f) const
+    {
+        size_type __n = 0;
+        for (int __x = _M_bound(__lo, false); __x != -1 && !m_cmp(__hi, _M_key(__x)); __x = m_nodes[__x].m_link0.m_forward)
+        {
+            __f(const_cast<_Self *>(this)->_M_value(__x));
+            ++__n;
+        }
+        return __n;
+    }
+
+    /**
+     * @brief 按顺序对名次在[__start, __stop]内(从0开始, 两端都包含)的每个元素调用__f(const value_type &), 返回个数
+     */
+    template<class F>
+    size_type range_by_rank(size_type __start, size_type __stop, F __f) const
+    {
+        if (__stop >= (size_type) m_size)
+            __stop = m_size - 1;
+        if (m_size == 0 || __start > __stop)
+            return 0;
+        size_type __n = 0;
+        for (int __x = _M_at_rank(__start); __n <= __stop - __start; __x = m_nodes[__x].m_link0.m_forward)
+        {
+            __f(const_cast<_Self *>(this)->_M_value(__x));
+            ++__n;
+        }
+        return __n;
+    }
+
+    /**
+     * @brief 删除名次在[__start, __stop]内的元素(比如只保留排行榜前N名), 返回删除个数
+     */
+    size_type erase_range_by_rank(size_type __start, size_type __stop)
+    {
+        if (__stop >= (size_type) m_size)
+            __stop = m_size - 1;
+        if (m_size == 0 || __start > __stop)
+            return 0;
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path_rank(__start, __update, __rank);
+        size_type __n = 0;
+        for (int __x = _M_link(__update[0], 0).m_forward; __n <= __stop - __start; ++__n)
+        {
+            int __next = m_nodes[__x].m_link0.m_forward;
+            _M_erase_node(__x, __update);
+            __x = __next;
+        }
+        return __n;
+    }
+
+    /**
+     * @brief 按有效节点(高度>0)重新排序, 重建所有层和空闲链表; 高度对应的塔不合法或被重复占用的节点降为1层
+     */
+    void rebuild();
+
+    bool verify() const;
+
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(value_type), m_size, MAX_SIZE); }
+
+private:
+    value_type *_M_ptr(int __x) { return reinterpret_cast<value_type *>(m_nodes[__x].m_data); }
+
+    const value_type *_M_ptr(int __x) const { return reinterpret_cast<const value_type *>(m_nodes[__x].m_data); }
+
+    value_type &_M_value(int __x) { return *_M_ptr(__x); }
+
+    const Key &_M_key(int __x) const { return _M_ptr(__x)->first; }
+
+    int _M_next(int __x) const { return m_nodes[__x].m_link0.m_forward; }
+
+    bool _M_valid(int __x) const { return __x >= 0 && __x < MAX_SIZE && m_nodes[__x].m_height > 0; }
+
+    _Link &_M_link(int __x, int __l)
+    {
+        if (__x == HEAD)
+            return m_header[__l];
+        return __l == 0 ? m_nodes[__x].m_link0 : m_arena[m_nodes[__x].m_tower + __l - 1];
+    }
+
+    const _Link &_M_link(int __x, int __l) const
+    {
+        if (__x == HEAD)
+            return m_header[__l];
+        return __l == 0 ? m_nodes[__x].m_link0 : m_arena[m_nodes[__x].m_tower + __l - 1];
+    }
+
+    void _M_reset()
+    {
+        for (int i = 0; i < MAX_LEVEL; ++i)
+        {
+            m_header[i].m_forward = -1;
+            m_header[i].m_span = 0;
+        }
+        for (int i = 0; i < MAX_SIZE; ++i)
+            m_nodes[i].m_link0.m_forward = i + 1 < MAX_SIZE ? i + 1 : -1;
+        m_free = 0;
+        for (int __h = 2; __h <= MAX_LEVEL; ++__h)
+        {
+            int __base = NFShmSkipListTowerBase(MAX_SIZE, __h);
+            int __cap = NFShmSkipListTowerCap(MAX_SIZE, __h);
+            m_poolFree[__h] = -1;
+            for (int i = __cap - 1; i >= 0; --i)
+                _M_pool_push(__h, __base + i * (__h - 1));
+        }
+        m_size = 0;
+        m_level = 1;
+        m_tail = -1;
+    }
+
+    void _M_pool_push(int __h, int __tower)
+    {
+        m_arena[__tower].m_forward = m_poolFree[__h];
+        m_poolFree[__h] = __tower;
+    }
+
+    /**
+     * @brief 随机高度, 每层概率1/4; 对应高度的塔池用完时降层
+     */
+    int _M_random_height()
+    {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        uint32_t __r = m_seed | 0x80000000u;
+        int __h = 1 + _M_ctz(__r) / 2;
+        if (__h > MAX_LEVEL)
+            __h = MAX_LEVEL;
+        while (__h > 1 && m_poolFree[__h] == -1)
+            --__h;
+        return __h;
+    }
+
+    /**
+     * @brief 从表头往下找: __upper为false时停在所有小于Key的节点之后(lower_bound), 为true时停在所有不大于Key的节点之后(upper_bound).
+     * __update[l]是第l层的前驱, __rank[l]是它的名次(表头为0, 第一个节点为1)
+     */
+    void _M_path(const Key &__k, bool __upper, int *__update, int *__rank) const
+    {
+        int __x = HEAD;
+        int __r = 0;
+        int __stop = -1;
+        for (int __l = m_level - 1; __l >= 0; --__l)
+        {
+            for (;;)
+            {
+                const _Link &__link = _M_link(__x, __l);
+                int __f = __link.m_forward;
+                if (__f == -1 || __f == __stop)
+                    break;
+                _M_prefetch(__f, __l);
+                if (__upper ? m_cmp(__k, _M_key(__f)) : !m_cmp(_M_key(__f), __k))
+                {
+                    __stop = __f;
+                    break;
+                }
+                __r += __link.m_span;
+                __x = __f;
+            }
+            __update[__l] = __x;
+            __rank[__l] = __r;
+        }
+    }
+
+    /**
+     * @brief 找到指定节点的前驱: 先找到第一个相同Key的位置, 再沿第0层在相同Key的节点里走到__target
+     */
+    void _M_path_to(int __target, int *__update, int *__rank) const
+    {
+        _M_path(_M_key(__target), false, __update, __rank);
+        int __r = __rank[0];
+        for (int __y = _M_link(__update[0], 0).m_forward; __y != __target; __y = m_nodes[__y].m_link0.m_forward)
+        {
+            ++__r;
+            for (int __l = 0; __l < m_nodes[__y].m_height; ++__l)
+            {
+                __update[__l] = __y;
+                __rank[__l] = __r;
+            }
+        }
+    }
+
+    /**
+     * @brief 名次为__r(从0开始)的节点的各层前驱
+     */
+    void _M_path_rank(size_type __target, int *__update, int *__rank) const
+    {
+        int __x = HEAD;
+        size_type __r = 0;
+        for (int __l = m_level - 1; __l >= 0; --__l)
+        {
+            for (;;)
+            {
+                const _Link &__link = _M_link(__x, __l);
+                if (__link.m_forward == -1 || __r + __link.m_span > __target)
+                    break;
+                __r += __link.m_span;
+                __x = __link.m_forward;
+            }
+            __update[__l] = __x;
+            __rank[__l] = (int) __r;
+        }
+    }
+
+    int _M_bound(const Key &__k, bool __upper) const
+    {
+        int __x = HEAD;
+        int __stop = -1;    //上一层停下时比较过的节点, 下一层的前向还是它时不用再比
+        for (int __l = m_level - 1; __l >= 0; --__l)
+        {
+            for (;;)
+            {
+                int __f = _M_link(__x, __l).m_forward;
+                if (__f == -1 || __f == __stop)
+                    break;
+                _M_prefetch(__f, __l);
+                if (__upper ? m_cmp(__k, _M_key(__f)) : !m_cmp(_M_key(__f), __k))
+                {
+                    __stop = __f;
+                    break;
+                }
+                __x = __f;
+            }
+        }
+        return _M_link(__x, 0).m_forward;
+    }
+
+    int _M_at_rank(size_type __r) const
+    {
+        if (__r >= (size_type) m_size)
+            return -1;
+        int __update[MAX_LEVEL];
+        int __rank[MAX_LEVEL];
+        _M_path_rank(__r, __update, __rank);
+        return _M_link(__update[0], 0).m_forward;
+    }
+
+    /**
+     * @brief 在__update给出的位置插入. 先构造值和塔, 置上高度后再挂链; 中途崩溃时恢复校验失败, 按有效节点重建
+     */
+    int _M_insert_at(const value_type &__v, int *__update, int *__rank)
+    {
+        int __x = m_free;
+        _Node &__n = m_nodes[__x];
+        int __h = _M_random_height();
+        std::_Construct(_M_ptr(__x), __v);
+        if (__h > 1)
+        {
+            __n.m_tower = m_poolFree[__h];
+            m_poolFree[__h] = m_arena[__n.m_tower].m_forward;
+        }
+        m_free = __n.m_link0.m_forward;
+        __n.m_height = __h;
+
+        if (__h > m_level)
+        {
+            for (int __l = m_level; __l < __h; ++__l)
+            {
+                __rank[__l] = 0;
+                __update[__l] = HEAD;
+                m_header[__l].m_forward = -1;
+                m_header[__l].m_span = m_size;
+            }
+            m_level = __h;
+        }
+        for (int __l = 0; __l < __h; ++__l)
+        {
+            _Link &__prev = _M_link(__update[__l], __l);
+            _Link &__link = _M_link(__x, __l);
+            __link.m_forward = __prev.m_forward;
+            __link.m_span = __prev.m_span - (__rank[0] - __rank[__l]);
+            __prev.m_forward = __x;
+            __prev.m_span = __rank[0] - __rank[__l] + 1;
+        }
+        for (int __l = __h; __l < m_level; ++__l)
+            ++_M_link(__update[__l], __l).m_span;
+
+        __n.m_backward = __update[0] == HEAD ? -1 : __update[0];
+        if (__n.m_link0.m_forward != -1)
+            m_nodes[__n.m_link0.m_forward].m_backward = __x;
+        else
+            m_tail = __x;
+        ++m_size;
+        return __x;
+    }
+
+    void _M_erase_node(int __x, int *__update)
+    {
+        _Node &__n = m_nodes[__x];
+        for (int __l = 0; __l < m_level; ++__l)
+        {
+            _Link &__prev = _M_link(__update[__l], __l);
+            if (__prev.m_forward == __x)
+            {
+                const _Link &__link = _M_link(__x, __l);
+                __prev.m_span += __link.m_span - 1;
+                __prev.m_forward = __link.m_forward;
+            }
+            else
+            {
+                --__prev.m_span;
+            }
+        }
+        if (__n.m_link0.m_forward != -1)
+            m_nodes[__n.m_link0.m_forward].m_backward = __n.m_backward;
+        else
+            m_tail = __n.m_backward;
+        while (m_level > 1 && m_header[m_level - 1].m_forward == -1)
+            --m_level;
+        --m_size;
+
+        int __h = __n.m_height;
+        __n.m_height = 0;
+        if (__h > 1)
+            _M_pool_push(__h, __n.m_tower);
+        std::_Destroy(_M_ptr(__x));
+        __n.m_link0.m_forward = m_free;
+        m_free = __x;
+    }
+
+    bool _M_tower_ok(int __h, int __tower) const
+    {
+        int __base = NFShmSkipListTowerBase(MAX_SIZE, __h);
+        int __off = __tower - __base;
+        return __off >= 0 && __off % (__h - 1) == 0 && __off / (__h - 1) < NFShmSkipListTowerCap(MAX_SIZE, __h);
+    }
+
+    /**
+     * @brief 比较__f的key的同时预取它在第__l层的链接: 塔和节点不在一起, 不预取的话前进一步要等两次cache miss
+     */
+    void _M_prefetch(int __f, int __l) const
+    {
+#if defined(__GNUC__)
+        if (__l > 0)
+            __builtin_prefetch(&m_arena[m_nodes[__f].m_tower + __l - 1]);
+#endif
+    }
+
+    static int _M_ctz(uint32_t __v)
+    {
+#if defined(_MSC_VER)
+        unsigned long __i;
+        _BitScanForward(&__i, __v);
+        return (int) __i;
+#else
+        return __builtin_ctz(__v);
+#endif
+    }
+
+    _Node m_nodes[MAX_SIZE];
+    _Link m_header[MAX_LEVEL];
+    _Link m_arena[ARENA_SIZE > 0 ? ARENA_SIZE : 1];
+    int m_poolFree[MAX_LEVEL + 1];  //!<每个高度空闲塔的链表头, 用塔的第一个链接串起来
+    int m_free;
+    int m_size;
+    int m_level;
+    int m_tail;
+    uint32_t m_seed;
+    Compare m_cmp;
+};
+
+template<class Key, class Val, int MAX_SIZE, class Compare>
+void NFShmSkipList<Key, Val, MAX_SIZE, Compare>::rebuild()
+{
+    std::vector<int> __nodes;
+    std::vector<char> __used(ARENA_SIZE > 0 ? ARENA_SIZE : 1, 0);
+    for (int i = 0; i < MAX_SIZE; ++i)
+    {
+        _Node &__n = m_nodes[i];
+        if (__n.m_height <= 0)
+            continue;
+        if (__n.m_height > MAX_LEVEL)
+            __n.m_height = 1;
+        if (__n.m_height > 1)
+        {
+            if (_M_tower_ok(__n.m_height, __n.m_tower) && !__used[__n.m_tower])
+                __used[__n.m_tower] = 1;
+            else
+                __n.m_height = 1;
+        }
+        __nodes.push_back(i);
+    }
+    std::stable_sort(__nodes.begin(), __nodes.end(), [this](int __a, int __b) { return m_cmp(_M_key(__a), _M_key(__b)); });
+
+    m_free = -1;
+    for (int i = MAX_SIZE - 1; i >= 0; --i)
+    {
+        if (m_nodes[i].m_height <= 0)
+        {
+            m_nodes[i].m_link0.m_forward = m_free;
+            m_free = i;
+        }
+    }
+    for (int __h = 2; __h <= MAX_LEVEL; ++__h)
+    {
+        int __base = NFShmSkipListTowerBase(MAX_SIZE, __h);
+        m_poolFree[__h] = -1;
+        for (int i = NFShmSkipListTowerCap(MAX_SIZE, __h) - 1; i >= 0; --i)
+        {
+            if (!__used[__base + i * (__h - 1)])
+                _M_pool_push(__h, __base + i * (__h - 1));
+        }
+    }
+
+    int __last[MAX_LEVEL];
+    int __lastRank[MAX_LEVEL];
+    m_level = 1;
+    for (int __l = 0; __l < MAX_LEVEL; ++__l)
+    {
+        __last[__l] = HEAD;
+        __lastRank[__l] = 0;
+        m_header[__l].m_forward = -1;
+        m_header[__l].m_span = 0;
+    }
+    m_size = (int) __nodes.size();
+    for (int i = 0; i < m_size; ++i)
+    {
+        int __x = __nodes[i];
+        int __h = m_nodes[__x].m_height;
+        if (__h > m_level)
+            m_level = __h;
+        for (int __l = 0; __l < __h; ++__l)
+        {
+            _Link &__prev = _M_link(__last[__l], __l);
+            __prev.m_forward = __x;
+            __prev.m_span = i + 1 - __lastRank[__l];
+            __last[__l] = __x;
+            __lastRank[__l] = i + 1;
+        }
+        m_nodes[__x].m_backward = i == 0 ? -1 : __nodes[i - 1];
+    }
+    for (int __l = 0; __l < m_level; ++__l)
+    {
+        _Link &__link = _M_link(__last[__l], __l);
+        __link.m_forward = -1;
+        __link.m_span = m_size - __lastRank[__l];
+    }
+    m_tail = m_size > 0 ? __nodes[m_size - 1] : -1;
+}
+
+template<class Key, class Val, int MAX_SIZE, class Compare>
+bool NFShmSkipList<Key, Val, MAX_SIZE, Compare>::verify() const
+{
+    CHECK_EXPR(m_level >= 1 && m_level <= MAX_LEVEL && m_size >= 0 && m_size <= MAX_SIZE, false, "NFShmSkipList verify failed, level:{} size:{}", m_level, m_size);
+    std::vector<int> __rankOf(MAX_SIZE, -1);
+    int __r = 0;
+    int __prev = -1;
+    for (int __x = m_header[0].m_forward; __x != -1; __x = m_nodes[__x].m_link0.m_forward)
+    {
+        CHECK_EXPR(_M_valid(__x) && __rankOf[__x] == -1 && __r < m_size, false, "NFShmSkipList verify failed, bad node:{} at rank:{}", __x, __r);
+        CHECK_EXPR(m_nodes[__x].m_height <= m_level, false, "NFShmSkipList verify failed, node:{} height:{} > level:{}", __x, m_nodes[__x].m_height, m_level);
+        CHECK_EXPR(m_nodes[__x].m_backward == __prev, false, "NFShmSkipList verify failed, node:{} backward:{} != {}", __x, m_nodes[__x].m_backward, __prev);
+        CHECK_EXPR(__prev == -1 || !m_cmp(_M_key(__x), _M_key(__prev)), false, "NFShmSkipList verify failed, node:{} out of order", __x);
+        CHECK_EXPR(m_nodes[__x].m_height == 1 || _M_tower_ok(m_nodes[__x].m_height, m_nodes[__x].m_tower), false, "NFShmSkipList verify failed, node:{} bad tower:{}", __x, m_nodes[__x].m_tower);
+        __rankOf[__x] = ++__r;
+        __prev = __x;
+    }
+    CHECK_EXPR(__r == m_size && m_tail == __prev, false, "NFShmSkipList verify failed, linked:{} size:{} tail:{}", __r, m_size, m_tail);
+
+    for (int __l = 0; __l < m_level; ++__l)
+    {
+        int __x = HEAD;
+        int __xr = 0;
+        for (;;)
+        {
+            const _Link &__link = _M_link(__x, __l);
+            if (__link.m_forward == -1)
+            {
+                CHECK_EXPR(__link.m_span == m_size - __xr, false, "NFShmSkipList verify failed, level:{} tail span:{} != {}", __l, __link.m_span, m_size - __xr);
+                break;
+            }
+            int __f = __link.m_forward;
+            CHECK_EXPR(_M_valid(__f) && __rankOf[__f] > __xr && m_nodes[__f].m_height > __l, false, "NFShmSkipList verify failed, level:{} bad forward:{}", __l, __f);
+            CHECK_EXPR(__link.m_span == __rankOf[__f] - __xr, false, "NFShmSkipList verify failed, level:{} node:{} span:{} != {}", __l, __x, __link.m_span, __rankOf[__f] - __xr);
+            __x = __f;
+            __xr = __rankOf[__f];
+        }
+    }
+
+    int __valid = 0;
+    std::vector<int> __towers(MAX_LEVEL + 1, 0);
+    for (int i = 0; i < MAX_SIZE; ++i)
+    {
+        if (m_nodes[i].m_height > 0)
+        {
+            ++__valid;
+            ++__towers[m_nodes[i].m_height > MAX_LEVEL ? 0 : m_nodes[i].m_height];
+        }
+    }
+    CHECK_EXPR(__valid == m_size, false, "NFShmSkipList verify failed, valid nodes:{} != size:{}", __valid, m_size);
+    int __free = 0;
+    for (int __x = m_free; __x != -1; __x = m_nodes[__x].m_link0.m_forward)
+    {
+        CHECK_EXPR(__x >= 0 && __x < MAX_SIZE && m_nodes[__x].m_height == 0 && __free < MAX_SIZE, false, "NFShmSkipList verify failed, bad free node:{}", __x);
+        ++__free;
+    }
+    CHECK_EXPR(__free + m_size == MAX_SIZE, false, "NFShmSkipList verify failed, free:{} + size:{} != {}", __free, m_size, MAX_SIZE);
+    for (int __h = 2; __h <= MAX_LEVEL; ++__h)
+    {
+        int __cap = NFShmSkipListTowerCap(MAX_SIZE, __h);
+        int __n = 0;
+        for (int __t = m_poolFree[__h]; __t != -1; __t = m_arena[__t].m_forward)
+        {
+            CHECK_EXPR(_M_tower_ok(__h, __t) && __n < __cap, false, "NFShmSkipList verify failed, height:{} bad free tower:{}", __h, __t);
+            ++__n;
+        }
+        CHECK_EXPR(__n + __towers[__h] == __cap, false, "NFShmSkipList verify failed, height:{} free towers:{} + used:{} != {}", __h, __n, __towers[__h], __cap);
+    }
+    return true;
+}
@@ -11,6 +11,15 @@
 
 #include "NFComm/NFCore/NFPlatform.h"
 #include <stdio.h>
+#include <stddef.h>
+#include <type_traits>
+#include <limits>
+#include "NFShmMemoryStats.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #if NF_PLATFORM == NF_PLATFORM_WIN
 namespace std
@@ -463,4 +472,99 @@ namespace std
 #define stl__Identity _Identity
 
 
-#endif
\ No newline at end of file
+#endif
+
+/**
+ * @brief 异构查找(heterogeneous lookup)支持
+ * 当比较/hash函数对象定义了is_transparent时, 容器的find/count/equal_range/erase等接口
+ * 可以直接使用能与Key比较的类型(比如std::string_view, const char*)查找, 而不用先构造一个临时的Key.
+ */
+template<class _Func, class _SfinaeType, class = void>
+struct NFShmHasIsTransparent
+{
+};
+
+template<class _Func, class _SfinaeType>
+struct NFShmHasIsTransparent<_Func, _SfinaeType, typename std::conditional<true, void, typename _Func::is_transparent>::type>
+{
+    typedef void type;
+};
+
+template<class _Func, class _SfinaeType>
+using NFShmHasIsTransparent_t = typename NFShmHasIsTransparent<_Func, _SfinaeType>::type;
+
+/**
+ * @brief 创建(CreateInit/Init(bResetShm=true))时是否先清零整块内存
+ * 默认不清零, 只初始化元数据和空闲链表, 元素在插入时才构造. 新映射的共享内存本来就是0,
+ * 多清一遍会在启动时把整段内存都触发一次缺页, 几个G的段要花好几秒.
+ * 需要共享内存字节级确定(比如对整块共享内存做快照diff)时, 编译时定义NF_SHM_ZERO_ON_CREATE为1.
+ */
+#ifndef NF_SHM_ZERO_ON_CREATE
+#define NF_SHM_ZERO_ON_CREATE 0
+#endif
+
+/**
+ * @brief 恢复(ResumeInit)时是否要对已有元素重新调用构造函数
+ * 重新构造是为了让带虚函数表的共享内存对象在新进程中恢复(构造函数在恢复模式下会调用ResumeInit).
+ * 数值类型和没有自定义构造函数的类型不需要, 而且对后者值初始化会把数据清零, 所以直接跳过,
+ * 这样恢复只和元数据有关, 和容量无关. 容器的节点类型特化这个模板, 转发到节点中保存的元素类型.
+ */
+template<class Tp>
+struct NFShmResumeConstruct
+{
+    static const bool value = !std::numeric_limits<Tp>::is_specialized && !std::is_trivially_default_constructible<Tp>::value;
+};
+
+enum NFShmAdviseMode
+{
+    NFSHM_ADVISE_NONE = -1,    //!<不做任何建议, Dy容器Init的默认值
+    NFSHM_ADVISE_WILLNEED = 0, //!<提示内核马上会访问, 只预读不建立映射
+    NFSHM_ADVISE_POPULATE = 1, //!<一次性建立整段的页表映射, 后面访问不再缺页, 相当于对已映射的内存补一个MAP_POPULATE
+    NFSHM_ADVISE_HUGEPAGE = 2, //!<允许使用透明大页, 减少TLB miss和缺页次数
+};
+
+/**
+ * @brief 对共享内存区域给出访问建议, Dy容器的Init通过iAdvise参数调用, 也可以单独对任意区域调用
+ * 热恢复不会访问元素内存, 缺页分散到运行时; 对延迟敏感的进程可以在启动时NFSHM_ADVISE_POPULATE一次性缺页.
+ * 非Linux平台什么都不做.
+ * @return 成功返回0, 失败返回-1
+ */
+inline int NFShmAdvise(const void *pBuffer, size_t bufSize, int iMode)
+{
+#if defined(__linux__)
+    size_t iPageSize = (size_t) sysconf(_SC_PAGESIZE);
+    uintptr_t iBegin = (uintptr_t) pBuffer & ~(uintptr_t) (iPageSize - 1);
+    size_t iLen = (uintptr_t) pBuffer + bufSize - iBegin;
+    switch (iMode)
+    {
+        case NFSHM_ADVISE_WILLNEED:
+            return madvise((void *) iBegin, iLen, MADV_WILLNEED);
+        case NFSHM_ADVISE_POPULATE:
+        {
+#if defined(MADV_POPULATE_WRITE)
+            if (madvise((void *) iBegin, iLen, MADV_POPULATE_WRITE) == 0)
+                return 0;
+#endif
+            // 内核不支持(5.14以前)时每页读一个字节
+            for (uintptr_t p = iBegin; p < iBegin + iLen; p += iPageSize)
+            {
+                (void) *(volatile const char *) p;
+            }
+            return 0;
+        }
+        case NFSHM_ADVISE_HUGEPAGE:
+#if defined(MADV_HUGEPAGE)
+            return madvise((void *) iBegin, iLen, MADV_HUGEPAGE);
+#else
+            return -1;
+#endif
+        default:
+            return -1;
+    }
+#else
+    (void) pBuffer;
+    (void) bufSize;
+    (void) iMode;
+    return 0;
+#endif
+}
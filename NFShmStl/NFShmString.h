@@ -12,6 +12,21 @@
 #include "NFComm/NFPluginModule/NFLogMgr.h"
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFShmStl.h"
+#include "NFShmHash.h"
+#include "NFShmSearch.h"
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+
+/**
+ * @brief NFShmString构造时是否清零整个缓冲区
+ * 默认只写结束符, 构造是O(1)的, [size()+1, MAX_SIZE]的内容是未定义的.
+ * 需要共享内存字节级确定(比如对整块共享内存做快照diff/校验)时, 可以编译时定义NF_SHM_STRING_ZERO_TAIL为1,
+ * 恢复构造时清零整个缓冲区的行为; 或者只在做快照前对需要的对象调用zero_tail().
+ */
+#ifndef NF_SHM_STRING_ZERO_TAIL
+#define NF_SHM_STRING_ZERO_TAIL 0
+#endif
 
 template<class Tp, int MAX_SIZE>
 class NFShmStringBase
@@ -42,7 +57,11 @@ protected:
     int CreateInit()
     {
         m_size = 0;
+#if NF_SHM_STRING_ZERO_TAIL
         memset(m_data, 0, sizeof(m_data));
+#else
+        m_data[0] = Tp();
+#endif
         return 0;
     }
 
@@ -320,6 +339,11 @@ public:                         // Size, capacity, etc.
 
     size_type capacity() const { return MAX_SIZE; }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(CharT), m_size, MAX_SIZE); }
+
     void clear()
     {
         if (!empty())
@@ -364,6 +388,14 @@ public:                         // Other modifier member functions.
     {
     }
 
+    /**
+     * @brief 把结束符之后未使用的部分清零, 用于需要字节级确定内容的场景(共享内存快照等)
+     */
+    void zero_tail()
+    {
+        memset(m_data + m_size, 0, (MAX_SIZE + 1 - m_size) * sizeof(CharT));
+    }
+
 public:                         // Conversion to C string.
 
     const CharT *c_str() const { return m_data; }
@@ -380,6 +412,20 @@ public:                         // Conversion to C string.
         return GetString();
     }
 
+    /**
+     * @brief 转换为std::basic_string_view, 不拷贝数据, 可以直接用于std算法或者接受string_view的接口.
+     * 注意string_view只在NFShmString不被修改时有效.
+     */
+    operator std::basic_string_view<CharT, Traits>() const
+    {
+        return std::basic_string_view<CharT, Traits>(m_data, m_size);
+    }
+
+    std::basic_string_view<CharT, Traits> view() const
+    {
+        return std::basic_string_view<CharT, Traits>(m_data, m_size);
+    }
+
 public:                         // Append, operator+=, push_back.
 
     NFShmString &operator+=(const NFShmString &__s) { return append(__s); }
@@ -443,6 +489,78 @@ public:                         // Append, operator+=, push_back.
         --m_size;
     }
 
+public:                         // Format.
+    // 直接格式化到m_data中, 不产生临时std::string, 超过MAX_SIZE的部分被截断.
+
+    /**
+     * @brief 用fmt格式化并追加到末尾, 用法和NF_FORMAT一样
+     */
+    template<typename... ARGS>
+    NFShmString &append_format(fmt::format_string<ARGS...> __fmt, ARGS &&... __args)
+    {
+        size_type __left = MAX_SIZE - m_size;
+        auto __result = fmt::format_to_n(m_data + m_size, __left, __fmt, std::forward<ARGS>(__args)...);
+        m_size += (std::min)((size_type) __result.size, __left);
+        _M_terminate_string();
+        return *this;
+    }
+
+    /**
+     * @brief 用fmt格式化并替换原来的内容
+     */
+    template<typename... ARGS>
+    NFShmString &assign_format(fmt::format_string<ARGS...> __fmt, ARGS &&... __args)
+    {
+        m_size = 0;
+        return append_format(__fmt, std::forward<ARGS>(__args)...);
+    }
+
+    /**
+     * @brief 追加整数, 用std::to_chars, 空间不够时截断
+     */
+    template<typename _Int>
+    NFShmString &append_int(_Int __value, int __base = 10)
+    {
+        static_assert(std::is_integral<_Int>::value, "append_int need integral type");
+        std::to_chars_result __result = std::to_chars(m_data + m_size, m_data + MAX_SIZE, __value, __base);
+        if (__result.ec == std::errc())
+        {
+            m_size = __result.ptr - m_data;
+            _M_terminate_string();
+            return *this;
+        }
+
+        char __buf[sizeof(_Int) * 8 + 2];
+        __result = std::to_chars(__buf, __buf + sizeof(__buf), __value, __base);
+        return append(__buf, __result.ptr);
+    }
+
+    /**
+     * @brief 追加浮点数, 用std::to_chars, 空间不够时截断
+     * @param __value
+     * @param __precision 小于0时使用能精确还原的最短格式, 否则为小数点后的位数(fixed)
+     */
+    NFShmString &append_double(double __value, int __precision = -1)
+    {
+        std::to_chars_result __result = __precision < 0 ? std::to_chars(m_data + m_size, m_data + MAX_SIZE, __value)
+                                                        : std::to_chars(m_data + m_size, m_data + MAX_SIZE, __value, std::chars_format::fixed, __precision);
+        if (__result.ec == std::errc())
+        {
+            m_size = __result.ptr - m_data;
+            _M_terminate_string();
+            return *this;
+        }
+
+        char __buf[512];
+        __result = __precision < 0 ? std::to_chars(__buf, __buf + sizeof(__buf), __value)
+                                   : std::to_chars(__buf, __buf + sizeof(__buf), __value, std::chars_format::fixed, __precision);
+        if (__result.ec == std::errc())
+        {
+            append(__buf, __result.ptr);
+        }
+        return *this;
+    }
+
 public:
     template<class _InputIter>
     NFShmString &append(_InputIter __f, _InputIter __l, input_iterator_tag);
@@ -660,7 +778,7 @@ public:                         // Erase.
 
 public:                         // Compare
 
-    int compare(const NFShmString &__s) const { return _M_compare(m_data, m_data + m_size, __s.m_data, __s.m_data + m_size); }
+    int compare(const NFShmString &__s) const { return _M_compare(m_data, m_data + m_size, __s.m_data, __s.m_data + __s.m_size); }
 
     int compare(size_type __pos1, size_type __n1,
                 const NFShmString &__s) const
@@ -668,7 +786,7 @@ public:                         // Compare
         NF_ASSERT(__pos1 <= size());
         return _M_compare(m_data + __pos1,
                           m_data + __pos1 + min(__n1, size() - __pos1),
-                          __s.m_data, __s.m_data + m_size);
+                          __s.m_data, __s.m_data + __s.m_size);
     }
 
     int compare(size_type __pos1, size_type __n1,
@@ -679,7 +797,7 @@ public:                         // Compare
         return _M_compare(m_data + __pos1,
                           m_data + __pos1 + min(__n1, size() - __pos1),
                           __s.m_data + __pos2,
-                          __s.m_data + __pos2 + min(__n2, size() - __pos2));
+                          __s.m_data + __pos2 + min(__n2, __s.size() - __pos2));
     }
 
     int compare(const CharT *__s) const
@@ -704,14 +822,140 @@ public:                         // Compare
                           __s, __s + __n2);
     }
 
+public:                         // Substring.
+
+    NFShmString substr(size_type __pos = 0, size_type __n = npos) const
+    {
+        if (__pos > size())
+            return NFShmString();
+        return NFShmString(m_data + __pos, m_data + __pos + (std::min)(__n, size() - __pos));
+    }
+
+    bool starts_with(std::basic_string_view<CharT, Traits> __s) const
+    {
+        return size() >= __s.size() && Traits::compare(m_data, __s.data(), __s.size()) == 0;
+    }
+
+    bool starts_with(CharT __c) const { return !empty() && Traits::eq(m_data[0], __c); }
+
+    bool starts_with(const CharT *__s) const { return starts_with(std::basic_string_view<CharT, Traits>(__s)); }
+
+    bool ends_with(std::basic_string_view<CharT, Traits> __s) const
+    {
+        return size() >= __s.size() && Traits::compare(m_data + size() - __s.size(), __s.data(), __s.size()) == 0;
+    }
+
+    bool ends_with(CharT __c) const { return !empty() && Traits::eq(m_data[m_size - 1], __c); }
+
+    bool ends_with(const CharT *__s) const { return ends_with(std::basic_string_view<CharT, Traits>(__s)); }
+
+public:                         // Searching.
+    // 直接在m_data上查找, 不转换成std::string. char类型使用NFShmSearch.h中的SIMD实现.
+    // NFShmString, std::string, std::string_view都通过string_view的重载查找.
+
+    size_type find(std::basic_string_view<CharT, Traits> __s, size_type __pos = 0) const { return find(__s.data(), __pos, __s.size()); }
+
+    size_type find(const CharT *__s, size_type __pos = 0) const { return find(__s, __pos, Traits::length(__s)); }
+
+    size_type find(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type find(CharT __c, size_type __pos = 0) const;
+
+    size_type rfind(std::basic_string_view<CharT, Traits> __s, size_type __pos = npos) const { return rfind(__s.data(), __pos, __s.size()); }
+
+    size_type rfind(const CharT *__s, size_type __pos = npos) const { return rfind(__s, __pos, Traits::length(__s)); }
+
+    size_type rfind(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type rfind(CharT __c, size_type __pos = npos) const;
+
+    size_type find_first_of(std::basic_string_view<CharT, Traits> __s, size_type __pos = 0) const { return find_first_of(__s.data(), __pos, __s.size()); }
+
+    size_type find_first_of(const CharT *__s, size_type __pos = 0) const { return find_first_of(__s, __pos, Traits::length(__s)); }
+
+    size_type find_first_of(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type find_first_of(CharT __c, size_type __pos = 0) const { return find(__c, __pos); }
+
+    size_type find_last_of(std::basic_string_view<CharT, Traits> __s, size_type __pos = npos) const { return find_last_of(__s.data(), __pos, __s.size()); }
+
+    size_type find_last_of(const CharT *__s, size_type __pos = npos) const { return find_last_of(__s, __pos, Traits::length(__s)); }
+
+    size_type find_last_of(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type find_last_of(CharT __c, size_type __pos = npos) const { return rfind(__c, __pos); }
+
+    size_type find_first_not_of(std::basic_string_view<CharT, Traits> __s, size_type __pos = 0) const { return find_first_not_of(__s.data(), __pos, __s.size()); }
+
+    size_type find_first_not_of(const CharT *__s, size_type __pos = 0) const { return find_first_not_of(__s, __pos, Traits::length(__s)); }
+
+    size_type find_first_not_of(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type find_first_not_of(CharT __c, size_type __pos = 0) const;
+
+    size_type find_last_not_of(std::basic_string_view<CharT, Traits> __s, size_type __pos = npos) const { return find_last_not_of(__s.data(), __pos, __s.size()); }
+
+    size_type find_last_not_of(const CharT *__s, size_type __pos = npos) const { return find_last_not_of(__s, __pos, Traits::length(__s)); }
+
+    size_type find_last_not_of(const CharT *__s, size_type __pos, size_type __n) const;
+
+    size_type find_last_not_of(CharT __c, size_type __pos = npos) const;
+
+    bool contains(std::basic_string_view<CharT, Traits> __s) const { return find(__s) != npos; }
+
+    bool contains(const CharT *__s) const { return find(__s) != npos; }
+
+    bool contains(CharT __c) const { return find(__c) != npos; }
+
+private:                        // Helper functions for find.
+    static const bool _S_byte_search = std::is_same<CharT, char>::value && std::is_same<Traits, std::char_traits<char> >::value;
+
 public:                        // Helper function for compare.
+    // char类型先比较前8个字节组成的大端整数, 大部分key不需要memcmp就能分出大小
     static int _M_compare(const CharT *__f1, const CharT *__l1,
                           const CharT *__f2, const CharT *__l2)
     {
         const ptrdiff_t __n1 = __l1 - __f1;
         const ptrdiff_t __n2 = __l2 - __f2;
-        const int cmp = Traits::compare(__f1, __f2, min(__n1, __n2));
-        return cmp != 0 ? cmp : (__n1 < __n2 ? -1 : (__n1 > __n2 ? 1 : 0));
+        if constexpr (_S_byte_search)
+        {
+            return NFShmMemCompare(__f1, __n1, __f2, __n2);
+        }
+        else
+        {
+            const int cmp = Traits::compare(__f1, __f2, min(__n1, __n2));
+            return cmp != 0 ? cmp : (__n1 < __n2 ? -1 : (__n1 > __n2 ? 1 : 0));
+        }
+    }
+
+    // 长度相同的两段是否相等, 长度由调用者先比较
+    static bool _M_equal(const CharT *__a, const CharT *__b, size_type __n)
+    {
+        if constexpr (_S_byte_search)
+        {
+            return NFShmMemEq(__a, __b, __n);
+        }
+        else
+        {
+            return Traits::compare(__a, __b, __n) == 0;
+        }
+    }
+
+    // 和C字符串比较, 不计算C字符串的完整长度: 先比较首字符, 再只在前__n + 1个字符中找结束符
+    static bool _M_equal_cstr(const CharT *__data, size_type __n, const CharT *__s)
+    {
+        if constexpr (_S_byte_search)
+        {
+            if (__n > 0 && __s[0] != __data[0])
+                return false;
+            // memchr保证找到后不再往后读, 所以__s比__n短时也不会越界
+            return memchr(__s, 0, __n + 1) == __s + __n && NFShmMemEq(__data, __s, __n);
+        }
+        else
+        {
+            size_type __len = Traits::length(__s);
+            return __len == __n && Traits::compare(__data, __s, __n) == 0;
+        }
     }
 };
 
@@ -1039,6 +1283,198 @@ NFShmString<MAX_SIZE, CharT, _Traits>::insert(iterator __position,
     }
 }
 
+/**
+ * @brief 把格式化结果直接写入__s, 替换原来的内容, 超过MAX_SIZE的部分被截断
+ * NFShmString<64> key; format_to(key, "{}_{}", roleId, itemId);
+ */
+template<int MAX_SIZE, class _Traits, typename... ARGS>
+inline NFShmString<MAX_SIZE, char, _Traits> &format_to(NFShmString<MAX_SIZE, char, _Traits> &__s, fmt::format_string<ARGS...> __fmt, ARGS &&... __args)
+{
+    return __s.assign_format(__fmt, std::forward<ARGS>(__args)...);
+}
+
+/**
+ * @brief 把格式化结果追加到__s末尾, 超过MAX_SIZE的部分被截断
+ */
+template<int MAX_SIZE, class _Traits, typename... ARGS>
+inline NFShmString<MAX_SIZE, char, _Traits> &append_format(NFShmString<MAX_SIZE, char, _Traits> &__s, fmt::format_string<ARGS...> __fmt, ARGS &&... __args)
+{
+    return __s.append_format(__fmt, std::forward<ARGS>(__args)...);
+}
+
+// ------------------------------------------------------------
+// Searching.
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find(const CharT *__s, size_type __pos, size_type __n) const
+{
+    if (__pos > size())
+        return npos;
+
+    if constexpr (_S_byte_search)
+    {
+        const char *__r = NFShmMemMem(m_data + __pos, size() - __pos, __s, __n);
+        return __r ? __r - m_data : npos;
+    }
+    else
+    {
+        const CharT *__r = std::search(m_data + __pos, m_data + m_size, __s, __s + __n, _Traits::eq);
+        return (__r != m_data + m_size || __n == 0) ? __r - m_data : npos;
+    }
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find(CharT __c, size_type __pos) const
+{
+    if (__pos >= size())
+        return npos;
+
+    if constexpr (_S_byte_search)
+    {
+        const char *__r = NFShmMemChr(m_data + __pos, size() - __pos, __c);
+        return __r ? __r - m_data : npos;
+    }
+    else
+    {
+        const CharT *__r = _Traits::find(m_data + __pos, size() - __pos, __c);
+        return __r ? __r - m_data : npos;
+    }
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::rfind(const CharT *__s, size_type __pos, size_type __n) const
+{
+    if (__n > size())
+        return npos;
+
+    // 匹配的起始位置不超过__pos
+    const size_type __last = (std::min)(size() - __n, __pos) + __n;
+    if constexpr (_S_byte_search)
+    {
+        const char *__r = NFShmMemRMem(m_data, __last, __s, __n);
+        return __r ? __r - m_data : npos;
+    }
+    else
+    {
+        const CharT *__r = std::find_end(m_data, m_data + __last, __s, __s + __n, _Traits::eq);
+        return (__r != m_data + __last || __n == 0) ? __r - m_data : npos;
+    }
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::rfind(CharT __c, size_type __pos) const
+{
+    if (empty())
+        return npos;
+
+    const size_type __last = (std::min)(size() - 1, __pos) + 1;
+    if constexpr (_S_byte_search)
+    {
+        const char *__r = NFShmMemRChr(m_data, __last, __c);
+        return __r ? __r - m_data : npos;
+    }
+    else
+    {
+        for (size_type __i = __last; __i > 0; --__i)
+        {
+            if (_Traits::eq(m_data[__i - 1], __c))
+                return __i - 1;
+        }
+        return npos;
+    }
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_first_of(const CharT *__s, size_type __pos, size_type __n) const
+{
+    if (__n == 1)
+        return find(__s[0], __pos);
+
+    for (size_type __i = __pos; __i < size(); ++__i)
+    {
+        if (_Traits::find(__s, __n, m_data[__i]))
+            return __i;
+    }
+    return npos;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_last_of(const CharT *__s, size_type __pos, size_type __n) const
+{
+    if (__n == 1)
+        return rfind(__s[0], __pos);
+
+    if (empty())
+        return npos;
+
+    for (size_type __i = (std::min)(size() - 1, __pos) + 1; __i > 0; --__i)
+    {
+        if (_Traits::find(__s, __n, m_data[__i - 1]))
+            return __i - 1;
+    }
+    return npos;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_first_not_of(const CharT *__s, size_type __pos, size_type __n) const
+{
+    for (size_type __i = __pos; __i < size(); ++__i)
+    {
+        if (!_Traits::find(__s, __n, m_data[__i]))
+            return __i;
+    }
+    return npos;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_first_not_of(CharT __c, size_type __pos) const
+{
+    for (size_type __i = __pos; __i < size(); ++__i)
+    {
+        if (!_Traits::eq(m_data[__i], __c))
+            return __i;
+    }
+    return npos;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_last_not_of(const CharT *__s, size_type __pos, size_type __n) const
+{
+    if (empty())
+        return npos;
+
+    for (size_type __i = (std::min)(size() - 1, __pos) + 1; __i > 0; --__i)
+    {
+        if (!_Traits::find(__s, __n, m_data[__i - 1]))
+            return __i - 1;
+    }
+    return npos;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+typename NFShmString<MAX_SIZE, CharT, _Traits>::size_type
+NFShmString<MAX_SIZE, CharT, _Traits>::find_last_not_of(CharT __c, size_type __pos) const
+{
+    if (empty())
+        return npos;
+
+    for (size_type __i = (std::min)(size() - 1, __pos) + 1; __i > 0; --__i)
+    {
+        if (!_Traits::eq(m_data[__i - 1], __c))
+            return __i - 1;
+    }
+    return npos;
+}
+
 // Operator== and operator!=
 
 template<int MAX_SIZE, class CharT, class _Traits>
@@ -1046,23 +1482,35 @@ inline bool
 operator==(const NFShmString<MAX_SIZE, CharT, _Traits>& __x,
            const NFShmString<MAX_SIZE, CharT, _Traits>& __y) {
     return __x.size() == __y.size() &&
-           _Traits::compare(__x.data(), __y.data(), __x.size()) == 0;
+           NFShmString<MAX_SIZE, CharT, _Traits>::_M_equal(__x.data(), __y.data(), __x.size());
 }
 
 template<int MAX_SIZE, class CharT, class _Traits>
 inline bool
 operator==(const CharT* __s,
            const NFShmString<MAX_SIZE, CharT, _Traits>& __y) {
-    size_t __n = _Traits::length(__s);
-    return __n == __y.size() && _Traits::compare(__s, __y.data(), __n) == 0;
+    return NFShmString<MAX_SIZE, CharT, _Traits>::_M_equal_cstr(__y.data(), __y.size(), __s);
 }
 
 template<int MAX_SIZE, class CharT, class _Traits>
 inline bool
 operator==(const NFShmString<MAX_SIZE, CharT, _Traits>& __x,
            const CharT* __s) {
-    size_t __n = _Traits::length(__s);
-    return __x.size() == __n && _Traits::compare(__x.data(), __s, __n) == 0;
+    return NFShmString<MAX_SIZE, CharT, _Traits>::_M_equal_cstr(__x.data(), __x.size(), __s);
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+inline bool
+operator==(const NFShmString<MAX_SIZE, CharT, _Traits>& __x,
+           std::basic_string_view<CharT, _Traits> __s) {
+    return __x.size() == __s.size() && NFShmString<MAX_SIZE, CharT, _Traits>::_M_equal(__x.data(), __s.data(), __s.size());
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+inline bool
+operator==(std::basic_string_view<CharT, _Traits> __s,
+           const NFShmString<MAX_SIZE, CharT, _Traits>& __y) {
+    return __s.size() == __y.size() && NFShmString<MAX_SIZE, CharT, _Traits>::_M_equal(__s.data(), __y.data(), __s.size());
 }
 
 // Operator< (and also >, <=, and >=).
@@ -1093,17 +1541,94 @@ operator<(const NFShmString<MAX_SIZE, CharT, _Traits>& __x,
            ::_M_compare(__x.begin(), __x.end(), __s, __s + __n) < 0;
 }
 
+template<int MAX_SIZE, class CharT, class _Traits>
+inline bool
+operator<(const NFShmString<MAX_SIZE, CharT, _Traits>& __x,
+          std::basic_string_view<CharT, _Traits> __s) {
+    return NFShmString<MAX_SIZE, CharT, _Traits>
+           ::_M_compare(__x.begin(), __x.end(), __s.data(), __s.data() + __s.size()) < 0;
+}
+
+template<int MAX_SIZE, class CharT, class _Traits>
+inline bool
+operator<(std::basic_string_view<CharT, _Traits> __s,
+          const NFShmString<MAX_SIZE, CharT, _Traits>& __y) {
+    return NFShmString<MAX_SIZE, CharT, _Traits>
+           ::_M_compare(__s.data(), __s.data() + __s.size(), __y.begin(), __y.end()) < 0;
+}
+
 /**
 *@brief 求hash值
+* 直接对data()/size()求hash, 不构造临时std::string.
+* std::string, const char *, std::string_view使用同一个hash函数, 内容相同时hash值相同, 可用于异构查找.
 */
 namespace std
 {
     template<int SIZE>
     struct hash<NFShmString<SIZE>>
     {
+        typedef void is_transparent;
+
         size_t operator()(const NFShmString <SIZE> &eventKey) const
         {
-            return std::hash<std::string>()(eventKey.ToString());
+            return NFShmHashBytes(eventKey.data(), eventKey.size());
+        }
+
+        template<int SIZE2>
+        size_t operator()(const NFShmString <SIZE2> &eventKey) const
+        {
+            return NFShmHashBytes(eventKey.data(), eventKey.size());
+        }
+
+        size_t operator()(const std::string &eventKey) const
+        {
+            return NFShmHashBytes(eventKey.data(), eventKey.size());
+        }
+
+        size_t operator()(std::string_view eventKey) const
+        {
+            return NFShmHashBytes(eventKey.data(), eventKey.size());
+        }
+
+        size_t operator()(const char *eventKey) const
+        {
+            return NFShmHashBytes(eventKey, strlen(eventKey));
         }
     };
-}
\ No newline at end of file
+
+    /**
+    *@brief 比较函数, 和hash<NFShmString>配合使用, 支持异构查找.
+    * NFShmHashMap<NFShmString<N>, T, MAX_SIZE>等容器可以直接用std::string, const char *, std::string_view查找, 不需要构造临时key.
+    */
+    template<int SIZE>
+    struct equal_to<NFShmString<SIZE>>
+    {
+        typedef void is_transparent;
+
+        bool operator()(const NFShmString <SIZE> &__x, const NFShmString <SIZE> &__y) const
+        {
+            return __x == __y;
+        }
+
+        template<int SIZE2>
+        bool operator()(const NFShmString <SIZE> &__x, const NFShmString <SIZE2> &__y) const
+        {
+            return __x == std::string_view(__y.data(), __y.size());
+        }
+
+        bool operator()(const NFShmString <SIZE> &__x, const std::string &__y) const
+        {
+            return __x == std::string_view(__y.data(), __y.size());
+        }
+
+        bool operator()(const NFShmString <SIZE> &__x, std::string_view __y) const
+        {
+            return __x == __y;
+        }
+
+        bool operator()(const NFShmString <SIZE> &__x, const char *__y) const
+        {
+            return __x == __y;
+        }
+    };
+}
@@ -0,0 +1,344 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmStringPool.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStringPool
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFPluginModule/NFCheck.h"
+#include "NFShmStl.h"
+#include "NFShmHash.h"
+#include <string_view>
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief 字符串池中的一个字符串
+ */
+struct NFShmStringPoolNode
+{
+    uint32_t m_offset; //!<在m_arena中的偏移
+    uint32_t m_len; //!<字符串长度, 不包括结束符
+    uint32_t m_hash;
+    int32_t m_refCount;
+    int m_next; //!<有效时是hash桶链表的下一个节点, 无效时是空闲链表的下一个节点
+    bool m_valid;
+};
+
+/**
+ * @brief 共享内存字符串池(字符串驻留)
+ * 相同内容的字符串只存一份, 返回一个32位的handle. 共享内存结构里存handle代替NFShmString<64>,
+ * 既省内存, 比较两个字符串是否相等也只需要比较handle(相同内容一定得到相同的handle).
+ *
+ * 字符串连续存放在MAX_BYTES字节的m_arena中, 每个字符串后面有'\0', 可以直接c_str().
+ * 所有位置都用偏移/下标表示, 可以直接放在共享内存中, 进程重启后ResumeInit即可继续使用.
+ *
+ * intern会增加引用计数, 不需要回收的字符串(比如配置表中的名字)可以从来不调用release.
+ * 引用计数减到0时字符串被删除, 它占用的字节要compact()后才能重新使用, m_arena不够时intern会自动compact.
+ * 注意删除后handle会被复用, 调用release后不要再使用原来的handle.
+ */
+template<int MAX_BYTES, int MAX_STRINGS>
+class NFShmStringPool
+{
+public:
+    typedef uint32_t handle_type;
+    typedef size_t size_type;
+
+    static const handle_type INVALID_HANDLE = 0; //!<handle是节点下标+1, 所以清零的共享内存结构中的handle都是无效的
+
+public:
+    NFShmStringPool()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            CreateInit();
+        }
+        else
+        {
+            ResumeInit();
+        }
+    }
+
+    ~NFShmStringPool()
+    {
+    }
+
+    int CreateInit()
+    {
+        m_arenaUsed = 0;
+        m_deadBytes = 0;
+        m_numElements = 0;
+        m_firstFreeIdx = 0;
+        for (int i = 0; i < MAX_STRINGS; ++i)
+        {
+            m_nodes[i].m_next = i + 1;
+            m_nodes[i].m_valid = false;
+            m_bucketsFirstIdx[i] = INVALID_ID;
+        }
+        m_nodes[MAX_STRINGS - 1].m_next = INVALID_ID;
+        return 0;
+    }
+
+    int ResumeInit()
+    {
+        return 0;
+    }
+
+public:
+    /**
+     * @brief 查找或插入一个字符串, 引用计数加1
+     * @param __s
+     * @return 字符串的handle, 空间不够时返回INVALID_HANDLE
+     */
+    handle_type intern(std::string_view __s);
+
+    /**
+     * @brief 只查找, 不插入, 不改变引用计数
+     * @param __s
+     * @return 不存在返回INVALID_HANDLE
+     */
+    handle_type find(std::string_view __s) const
+    {
+        uint32_t __hash = (uint32_t) NFShmHashBytes(__s.data(), __s.size());
+        int __idx = _M_find_node(__s, __hash);
+        return __idx >= 0 ? (handle_type) (__idx + 1) : INVALID_HANDLE;
+    }
+
+    /**
+     * @brief 返回handle对应的字符串, 不拷贝. handle无效时返回空的string_view
+     */
+    std::string_view view(handle_type __h) const
+    {
+        const NFShmStringPoolNode *__node = _M_get_node(__h);
+        if (__node == NULL)
+            return std::string_view();
+        return std::string_view(m_arena + __node->m_offset, __node->m_len);
+    }
+
+    const char *c_str(handle_type __h) const
+    {
+        const NFShmStringPoolNode *__node = _M_get_node(__h);
+        if (__node == NULL)
+            return "";
+        return m_arena + __node->m_offset;
+    }
+
+    size_type length(handle_type __h) const
+    {
+        const NFShmStringPoolNode *__node = _M_get_node(__h);
+        return __node ? __node->m_len : 0;
+    }
+
+    bool valid(handle_type __h) const { return _M_get_node(__h) != NULL; }
+
+    int ref_count(handle_type __h) const
+    {
+        const NFShmStringPoolNode *__node = _M_get_node(__h);
+        return __node ? __node->m_refCount : 0;
+    }
+
+    /**
+     * @brief 引用计数加1, 拷贝一个handle给另一个持有者时使用
+     */
+    int add_ref(handle_type __h)
+    {
+        NFShmStringPoolNode *__node = _M_get_node(__h);
+        CHECK_EXPR(__node, -1, "NFShmStringPool add_ref invalid handle:{}", __h);
+        ++__node->m_refCount;
+        return 0;
+    }
+
+    /**
+     * @brief 引用计数减1, 减到0时删除字符串
+     */
+    int release(handle_type __h);
+
+    /**
+     * @brief 整理m_arena, 回收已删除字符串占用的字节, 不改变任何handle
+     */
+    int compact();
+
+    void clear() { CreateInit(); }
+
+public:
+    size_type size() const { return m_numElements; }
+
+    size_type max_size() const { return MAX_STRINGS; }
+
+    bool empty() const { return m_numElements == 0; }
+
+    bool full() const { return m_firstFreeIdx == INVALID_ID; }
+
+    size_type bytes_used() const { return m_arenaUsed; }
+
+    size_type bytes_dead() const { return m_deadBytes; }
+
+    size_type max_bytes() const { return MAX_BYTES; }
+
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats. 以m_arena中的字节为单位: 存活字符串的字节是m_liveBytes,
+     * 还没有用过的字节是m_freeBytes, 已删除未compact的字节和节点/桶都算作额外开销. m_size/m_capacity是字符串个数.
+     */
+    NFShmMemoryStats memory_stats() const
+    {
+        NFShmMemoryStats __st = NFShmMakeMemoryStats(sizeof(*this), 1, m_arenaUsed - m_deadBytes, MAX_BYTES - m_deadBytes);
+        __st.m_size = m_numElements;
+        __st.m_capacity = MAX_STRINGS;
+        return __st;
+    }
+
+private:
+    NFShmStringPoolNode *_M_get_node(handle_type __h)
+    {
+        if (__h == INVALID_HANDLE || __h > (handle_type) MAX_STRINGS || !m_nodes[__h - 1].m_valid)
+            return NULL;
+        return &m_nodes[__h - 1];
+    }
+
+    const NFShmStringPoolNode *_M_get_node(handle_type __h) const
+    {
+        if (__h == INVALID_HANDLE || __h > (handle_type) MAX_STRINGS || !m_nodes[__h - 1].m_valid)
+            return NULL;
+        return &m_nodes[__h - 1];
+    }
+
+    int _M_find_node(std::string_view __s, uint32_t __hash) const
+    {
+        for (int __idx = m_bucketsFirstIdx[__hash % MAX_STRINGS]; __idx != INVALID_ID; __idx = m_nodes[__idx].m_next)
+        {
+            const NFShmStringPoolNode &__node = m_nodes[__idx];
+            if (__node.m_hash == __hash && __node.m_len == __s.size() && memcmp(m_arena + __node.m_offset, __s.data(), __s.size()) == 0)
+                return __idx;
+        }
+        return INVALID_ID;
+    }
+
+private:
+    char m_arena[MAX_BYTES];
+    NFShmStringPoolNode m_nodes[MAX_STRINGS];
+    int m_bucketsFirstIdx[MAX_STRINGS];
+    uint32_t m_arenaUsed; //!<m_arena已使用的字节数, 包括已删除的字符串
+    uint32_t m_deadBytes; //!<已删除的字符串占用的字节数, compact后回收
+    int m_numElements;
+    int m_firstFreeIdx; //!<空闲链表头节点
+};
+
+template<int MAX_BYTES, int MAX_STRINGS>
+typename NFShmStringPool<MAX_BYTES, MAX_STRINGS>::handle_type
+NFShmStringPool<MAX_BYTES, MAX_STRINGS>::intern(std::string_view __s)
+{
+    uint32_t __hash = (uint32_t) NFShmHashBytes(__s.data(), __s.size());
+    int __idx = _M_find_node(__s, __hash);
+    if (__idx >= 0)
+    {
+        ++m_nodes[__idx].m_refCount;
+        return (handle_type) (__idx + 1);
+    }
+
+    if (m_firstFreeIdx == INVALID_ID)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmStringPool No Enough Space! MAX_STRINGS:{}", MAX_STRINGS);
+        return INVALID_HANDLE;
+    }
+
+    size_t __need = __s.size() + 1;
+    if (m_arenaUsed + __need > (size_t) MAX_BYTES && m_deadBytes > 0)
+    {
+        compact();
+    }
+
+    if (m_arenaUsed + __need > (size_t) MAX_BYTES)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "The NFShmStringPool No Enough Space! MAX_BYTES:{} used:{} need:{}", MAX_BYTES, m_arenaUsed, __need);
+        return INVALID_HANDLE;
+    }
+
+    __idx = m_firstFreeIdx;
+    NFShmStringPoolNode &__node = m_nodes[__idx];
+    m_firstFreeIdx = __node.m_next;
+
+    memcpy(m_arena + m_arenaUsed, __s.data(), __s.size());
+    m_arena[m_arenaUsed + __s.size()] = '\0';
+
+    int __bucket = __hash % MAX_STRINGS;
+    __node.m_offset = m_arenaUsed;
+    __node.m_len = (uint32_t) __s.size();
+    __node.m_hash = __hash;
+    __node.m_refCount = 1;
+    __node.m_valid = true;
+    __node.m_next = m_bucketsFirstIdx[__bucket];
+    m_bucketsFirstIdx[__bucket] = __idx;
+
+    m_arenaUsed += __need;
+    ++m_numElements;
+    return (handle_type) (__idx + 1);
+}
+
+template<int MAX_BYTES, int MAX_STRINGS>
+int NFShmStringPool<MAX_BYTES, MAX_STRINGS>::release(handle_type __h)
+{
+    NFShmStringPoolNode *__node = _M_get_node(__h);
+    CHECK_EXPR(__node, -1, "NFShmStringPool release invalid handle:{}", __h);
+    if (--__node->m_refCount > 0)
+        return 0;
+
+    int __idx = __h - 1;
+    int *__link = &m_bucketsFirstIdx[__node->m_hash % MAX_STRINGS];
+    while (*__link != __idx)
+    {
+        NF_ASSERT(*__link != INVALID_ID);
+        __link = &m_nodes[*__link].m_next;
+    }
+    *__link = __node->m_next;
+
+    // 最后一个字符串直接归还, 否则等compact回收
+    uint32_t __bytes = __node->m_len + 1;
+    if (__node->m_offset + __bytes == m_arenaUsed)
+        m_arenaUsed -= __bytes;
+    else
+        m_deadBytes += __bytes;
+
+    __node->m_valid = false;
+    __node->m_next = m_firstFreeIdx;
+    m_firstFreeIdx = __idx;
+    --m_numElements;
+    return 0;
+}
+
+template<int MAX_BYTES, int MAX_STRINGS>
+int NFShmStringPool<MAX_BYTES, MAX_STRINGS>::compact()
+{
+    if (m_deadBytes == 0)
+        return 0;
+
+    std::vector<int> __live;
+    __live.reserve(m_numElements);
+    for (int i = 0; i < MAX_STRINGS; ++i)
+    {
+        if (m_nodes[i].m_valid)
+            __live.push_back(i);
+    }
+    std::sort(__live.begin(), __live.end(), [this](int __a, int __b) { return m_nodes[__a].m_offset < m_nodes[__b].m_offset; });
+
+    uint32_t __dst = 0;
+    for (size_t i = 0; i < __live.size(); ++i)
+    {
+        NFShmStringPoolNode &__node = m_nodes[__live[i]];
+        if (__node.m_offset != __dst)
+        {
+            memmove(m_arena + __dst, m_arena + __node.m_offset, __node.m_len + 1);
+            __node.m_offset = __dst;
+        }
+        __dst += __node.m_len + 1;
+    }
+
+    m_arenaUsed = __dst;
+    m_deadBytes = 0;
+    return 0;
+}
@@ -775,6 +775,11 @@ public:
 
     size_type max_size() const { return MAX_SIZE; }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats, 链表节点和红黑树的链接都算作额外开销
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(value_type), _M_node_count, MAX_SIZE); }
+
 public:
     // insert/erase
     pair<iterator, bool> insert_unique(const value_type &__x);
@@ -801,7 +806,7 @@ public:
 
     void erase(iterator __position);
 
-    size_type erase(const key_type &__x);
+    size_type erase(const key_type &__x) { return _M_erase_key(__x); }
 
     void erase(iterator __first, iterator __last);
 
@@ -821,23 +826,88 @@ public:
 
 public:
     // set operations:
-    iterator find(const key_type &__x);
+    iterator find(const key_type &__x) { return _M_find(__x); }
+
+    const_iterator find(const key_type &__x) const { return _M_find(__x); }
+
+    size_type count(const key_type &__x) const { return _M_count(__x); }
+
+    iterator lower_bound(const key_type &__x) { return _M_lower_bound(__x); }
+
+    const_iterator lower_bound(const key_type &__x) const { return _M_lower_bound(__x); }
+
+    iterator upper_bound(const key_type &__x) { return _M_upper_bound(__x); }
+
+    const_iterator upper_bound(const key_type &__x) const { return _M_upper_bound(__x); }
+
+    pair<iterator, iterator> equal_range(const key_type &__x) { return _M_equal_range(__x); }
+
+    pair<const_iterator, const_iterator> equal_range(const key_type &__x) const { return _M_equal_range(__x); }
+
+    /**
+     * @brief 异构查找, Compare定义了is_transparent(比如std::less<>)时启用,
+     * __x只需要能和key_type用Compare双向比较, 不需要构造临时key.
+     */
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    iterator find(const _Kt &__x) { return _M_find(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    const_iterator find(const _Kt &__x) const { return _M_find(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    size_type count(const _Kt &__x) const { return _M_count(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    iterator lower_bound(const _Kt &__x) { return _M_lower_bound(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    const_iterator lower_bound(const _Kt &__x) const { return _M_lower_bound(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    iterator upper_bound(const _Kt &__x) { return _M_upper_bound(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    const_iterator upper_bound(const _Kt &__x) const { return _M_upper_bound(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    pair<iterator, iterator> equal_range(const _Kt &__x) { return _M_equal_range(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    pair<const_iterator, const_iterator> equal_range(const _Kt &__x) const { return _M_equal_range(__x); }
+
+    template<class _Kt, class = NFShmHasIsTransparent_t<Compare, _Kt> >
+    size_type erase(const _Kt &__x) { return _M_erase_key(__x); }
+
+private:
+    template<class _Kt>
+    iterator _M_find(const _Kt &__k);
+
+    template<class _Kt>
+    const_iterator _M_find(const _Kt &__k) const;
 
-    const_iterator find(const key_type &__x) const;
+    template<class _Kt>
+    size_type _M_count(const _Kt &__k) const;
 
-    size_type count(const key_type &__x) const;
+    template<class _Kt>
+    iterator _M_lower_bound(const _Kt &__k);
 
-    iterator lower_bound(const key_type &__x);
+    template<class _Kt>
+    const_iterator _M_lower_bound(const _Kt &__k) const;
 
-    const_iterator lower_bound(const key_type &__x) const;
+    template<class _Kt>
+    iterator _M_upper_bound(const _Kt &__k);
 
-    iterator upper_bound(const key_type &__x);
+    template<class _Kt>
+    const_iterator _M_upper_bound(const _Kt &__k) const;
 
-    const_iterator upper_bound(const key_type &__x) const;
+    template<class _Kt>
+    pair<iterator, iterator> _M_equal_range(const _Kt &__k);
 
-    pair<iterator, iterator> equal_range(const key_type &__x);
+    template<class _Kt>
+    pair<const_iterator, const_iterator> _M_equal_range(const _Kt &__k) const;
 
-    pair<const_iterator, const_iterator> equal_range(const key_type &__x) const;
+    template<class _Kt>
+    size_type _M_erase_key(const _Kt &__k);
 
 public:
     // Debugging.
@@ -1078,10 +1148,11 @@ inline void NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::size_type
-NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::erase(const Key &__x)
+NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::_M_erase_key(const _Kt &__x)
 {
-    pair<iterator, iterator> __p = equal_range(__x);
+    pair<iterator, iterator> __p = _M_equal_range(__x);
     size_type __n = 0;
     distance(__p.first, __p.second, __n);
     erase(__p.first, __p.second);
@@ -1150,8 +1221,9 @@ void NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::iterator
-NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::find(const Key &__k)
+NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::_M_find(const _Kt &__k)
 {
     _Link_type __y = _M_header;      // Last node which is not less than __k.
     _Link_type __x = _M_root();      // Current node.
@@ -1168,8 +1240,9 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::find(const Key &__k)
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::const_iterator
-NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::find(const Key &__k) const
+NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::_M_find(const _Kt &__k) const
 {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = get_node(_M_root()); /* Current node. */
@@ -1187,20 +1260,22 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::find(const Key &__k) const
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::size_type
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::count(const Key &__k) const
+::_M_count(const _Kt &__k) const
 {
-    pair<const_iterator, const_iterator> __p = equal_range(__k);
+    pair<const_iterator, const_iterator> __p = _M_equal_range(__k);
     size_type __n = 0;
     distance(__p.first, __p.second, __n);
     return __n;
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::iterator
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::lower_bound(const Key &__k)
+::_M_lower_bound(const _Kt &__k)
 {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = get_node(_M_root()); /* Current node. */
@@ -1215,9 +1290,10 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::const_iterator
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::lower_bound(const Key &__k) const
+::_M_lower_bound(const _Kt &__k) const
 {
     _Link_type __y = _M_header; /* Last node which is not less than __k. */
     _Link_type __x = get_node(_M_root()); /* Current node. */
@@ -1232,9 +1308,10 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::iterator
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::upper_bound(const Key &__k)
+::_M_upper_bound(const _Kt &__k)
 {
     _Link_type __y = _M_header; /* Last node which is greater than __k. */
     _Link_type __x = get_node(_M_root()); /* Current node. */
@@ -1249,9 +1326,10 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::const_iterator
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::upper_bound(const Key &__k) const
+::_M_upper_bound(const _Kt &__k) const
 {
     _Link_type __y = _M_header; /* Last node which is greater than __k. */
     _Link_type __x = get_node(_M_root()); /* Current node. */
@@ -1266,24 +1344,26 @@ NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 inline
 pair<typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::iterator,
         typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::iterator>
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::equal_range(const Key &__k)
+::_M_equal_range(const _Kt &__k)
 {
-    return pair<iterator, iterator>(lower_bound(__k), upper_bound(__k));
+    return pair<iterator, iterator>(_M_lower_bound(__k), _M_upper_bound(__k));
 }
 
 template<int MAX_SIZE, class Key, class Value, class KeyOfValue, class Compare>
+template<class _Kt>
 inline
 pair<typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::const_iterator,
         typename NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>::const_iterator>
 NFShmTree<MAX_SIZE, Key, Value, KeyOfValue, Compare>
-::equal_range(const Key &__k) const
+::_M_equal_range(const _Kt &__k) const
 {
-    return pair<const_iterator, const_iterator>(lower_bound(__k),
-                                                upper_bound(__k));
+    return pair<const_iterator, const_iterator>(_M_lower_bound(__k),
+                                                _M_upper_bound(__k));
 }
 
 inline int
@@ -13,11 +13,24 @@
 #include "NFComm/NFShmCore/NFShmMgr.h"
 #include "NFComm/NFPluginModule/NFCheck.h"
 #include "NFShmStl.h"
+#include "NFShmProfile.h"
 #include <iterator>
 #include <algorithm>
 #include <vector>
 #include <type_traits>
 
+/**
+ * @brief NFShmVector在ProfilePolicy为NFShmProfilePolicy时统计耗时的操作
+ */
+enum NFShmVectorProfileOp
+{
+    NFSHM_VECTOR_PROFILE_INSERT = 0,
+    NFSHM_VECTOR_PROFILE_BINARY_INSERT = 1,
+    NFSHM_VECTOR_PROFILE_BINARY_SEARCH = 2,
+    NFSHM_VECTOR_PROFILE_ERASE = 3,
+    NFSHM_VECTOR_PROFILE_OPS = 4,
+};
+
 template<class Tp, size_t MAX_SIZE>
 class NFShmVectorBase
 {
@@ -44,7 +57,9 @@ public:
     int CreateInit()
     {
         m_size = 0;
+#if NF_SHM_ZERO_ON_CREATE
         memset(m_mem, 0, sizeof(m_mem));
+#endif
         m_data = (Tp*)m_mem;
         return 0;
     }
@@ -52,7 +67,7 @@ public:
     int ResumeInit()
     {
         m_data = (Tp*)m_mem;
-        if (!std::numeric_limits<Tp>::is_specialized)
+        if (NFShmResumeConstruct<Tp>::value)
         {
             for(size_t i = 0; i < m_size; i++)
             {
@@ -69,11 +84,12 @@ protected:
     size_t m_size;
 };
 
-template<class Tp, size_t MAX_SIZE>
-class NFShmVector : protected NFShmVectorBase<Tp, MAX_SIZE>
+template<class Tp, size_t MAX_SIZE, class ProfilePolicy = NFShmProfileNone>
+class NFShmVector : protected NFShmVectorBase<Tp, MAX_SIZE>, private ProfilePolicy::template data_type<NFSHM_VECTOR_PROFILE_OPS>
 {
 private:
     typedef NFShmVectorBase<Tp, MAX_SIZE> _Base;
+    typedef typename ProfilePolicy::template data_type<NFSHM_VECTOR_PROFILE_OPS> _Profile;
 protected:
     using _Base::m_data;
     using _Base::m_size;
@@ -139,15 +155,15 @@ public:
         m_size = __n;
     }
 
-    template<size_t X_MAX_SIZE>
-    NFShmVector(const NFShmVector<Tp, X_MAX_SIZE> &__x)
+    template<size_t X_MAX_SIZE, class X_ProfilePolicy>
+    NFShmVector(const NFShmVector<Tp, X_MAX_SIZE, X_ProfilePolicy> &__x)
     {
         int max_size = MAX_SIZE <= __x.size() ? MAX_SIZE : __x.size();
         auto finish = std::uninitialized_copy_n(__x.begin(), max_size, m_data);
         m_size = finish - begin();
     }
 
-    NFShmVector(const NFShmVector<Tp, MAX_SIZE> &__x)
+    NFShmVector(const NFShmVector<Tp, MAX_SIZE, ProfilePolicy> &__x)
     {
         int max_size = MAX_SIZE <= __x.size() ? MAX_SIZE : __x.size();
         auto finish = std::uninitialized_copy_n(__x.begin(), max_size, m_data);
@@ -177,8 +193,8 @@ public:
         clear();
     }
 
-    NFShmVector<Tp, MAX_SIZE> &operator=(const NFShmVector<Tp, MAX_SIZE> &__x);
-    NFShmVector<Tp, MAX_SIZE> &operator=(const std::vector<Tp> &__x);
+    NFShmVector<Tp, MAX_SIZE, ProfilePolicy> &operator=(const NFShmVector<Tp, MAX_SIZE, ProfilePolicy> &__x);
+    NFShmVector<Tp, MAX_SIZE, ProfilePolicy> &operator=(const std::vector<Tp> &__x);
 
 public:
     iterator begin() { return m_data; }
@@ -203,6 +219,11 @@ public:
 
     size_type capacity() const { return MAX_SIZE; }
 
+    /**
+     * @brief 内存使用情况, 见NFShmMemoryStats
+     */
+    NFShmMemoryStats memory_stats() const { return NFShmMakeMemoryStats(sizeof(*this), sizeof(Tp), m_size, MAX_SIZE); }
+
     bool empty() const { return begin() == end(); }
 
     bool full() const { return size() >= MAX_SIZE;}
@@ -327,7 +348,7 @@ public:
         }
     }
 
-    void swap(NFShmVector<Tp, MAX_SIZE> &__x)
+    void swap(NFShmVector<Tp, MAX_SIZE, ProfilePolicy> &__x)
     {
 
     }
@@ -339,6 +360,7 @@ public:
 
     iterator insert(iterator __position, const Tp &__x)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_VECTOR_PROFILE_INSERT);
         size_type __n = __position - begin();
         if (m_size < MAX_SIZE && __position == end())
         {
@@ -362,6 +384,7 @@ public:
 
     iterator insert(iterator __position)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_VECTOR_PROFILE_INSERT);
         size_type __n = __position - begin();
         if (m_size <  MAX_SIZE && __position == end())
         {
@@ -405,6 +428,7 @@ public:
      */
     iterator erase(iterator __position)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_VECTOR_PROFILE_ERASE);
         CHECK_EXPR(__position != end(), end(), "");
         CHECK_EXPR(__position - begin() < m_size, end(), "");
 
@@ -475,6 +499,7 @@ public:
     template<typename _Compare>
     iterator binary_insert(const Tp &val, _Compare comp)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_VECTOR_PROFILE_BINARY_INSERT);
         CHECK_EXPR(m_size < MAX_SIZE, end(), "The Vector No Enough Space! binary_insert Fail!");
 
         auto iter = std::lower_bound(begin(), end(), val, comp);
@@ -502,6 +527,7 @@ public:
     template<typename _Compare>
     iterator binary_search(const Tp &val, _Compare comp)
     {
+        typename ProfilePolicy::scope __prof(_M_profile(), NFSHM_VECTOR_PROFILE_BINARY_SEARCH);
         auto pair_iter = std::equal_range(begin(), end(), val, comp);
         if (pair_iter.first != pair_iter.second)
         {
@@ -599,7 +625,20 @@ public:
     {
         return std::vector<Tp>(begin(), end());
     }
+
+    /**
+     * @brief 输出各操作的耗时分布(p50/p99/max), ProfilePolicy为NFShmProfileNone时返回空串
+     */
+    std::string profile_report(const char *__name) const
+    {
+        static const char *const __names[NFSHM_VECTOR_PROFILE_OPS] = {"insert", "binary_insert", "binary_search", "erase"};
+        return ProfilePolicy::report(__name, _M_profile(), NFSHM_VECTOR_PROFILE_OPS, __names);
+    }
+
+    void reset_profile() { ProfilePolicy::reset(_M_profile()); }
 protected:
+    _Profile *_M_profile() const { return const_cast<_Profile *>(static_cast<const _Profile *>(this)); }
+
     int _M_insert_aux(iterator __position, const Tp &__x);
 
     int _M_insert_aux(iterator __position);
@@ -707,25 +746,25 @@ protected:
 };
 
 
-template<class _Tp, int MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 inline bool
-operator==(const NFShmVector<_Tp, MAX_SIZE> &__x, const NFShmVector<_Tp, MAX_SIZE> &__y)
+operator==(const NFShmVector<_Tp, MAX_SIZE, _Pp> &__x, const NFShmVector<_Tp, MAX_SIZE, _Pp> &__y)
 {
     return __x.size() == __y.size() &&
            std::equal(__x.begin(), __x.end(), __y.begin());
 }
 
-template<class _Tp, int MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 inline bool
-operator<(const NFShmVector<_Tp, MAX_SIZE> &__x, const NFShmVector<_Tp, MAX_SIZE> &__y)
+operator<(const NFShmVector<_Tp, MAX_SIZE, _Pp> &__x, const NFShmVector<_Tp, MAX_SIZE, _Pp> &__y)
 {
     return std::lexicographical_compare(__x.begin(), __x.end(),
                                         __y.begin(), __y.end());
 }
 
-template<class _Tp, size_t MAX_SIZE>
-NFShmVector<_Tp, MAX_SIZE> &
-NFShmVector<_Tp, MAX_SIZE>::operator=(const NFShmVector<_Tp, MAX_SIZE> &__x)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+NFShmVector<_Tp, MAX_SIZE, _Pp> &
+NFShmVector<_Tp, MAX_SIZE, _Pp>::operator=(const NFShmVector<_Tp, MAX_SIZE, _Pp> &__x)
 {
     if (&__x != this)
     {
@@ -745,16 +784,16 @@ NFShmVector<_Tp, MAX_SIZE>::operator=(const NFShmVector<_Tp, MAX_SIZE> &__x)
     return *this;
 }
 
-template<class _Tp, size_t MAX_SIZE>
-NFShmVector<_Tp, MAX_SIZE> &
-NFShmVector<_Tp, MAX_SIZE>::operator=(const std::vector<_Tp> &__x)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+NFShmVector<_Tp, MAX_SIZE, _Pp> &
+NFShmVector<_Tp, MAX_SIZE, _Pp>::operator=(const std::vector<_Tp> &__x)
 {
     assign(__x.begin(), __x.end());
     return *this;
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmVector<_Tp, MAX_SIZE>::_M_fill_assign(size_t __n, const value_type &__val)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_fill_assign(size_t __n, const value_type &__val)
 {
     if (__n > capacity())
     {
@@ -772,8 +811,8 @@ void NFShmVector<_Tp, MAX_SIZE>::_M_fill_assign(size_t __n, const value_type &__
         erase(std::fill_n(begin(), __n, __val), end());
 }
 
-template<class _Tp, size_t MAX_SIZE>
-int NFShmVector<_Tp, MAX_SIZE>::_M_insert_aux(iterator __position, const _Tp &__x)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+int NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_insert_aux(iterator __position, const _Tp &__x)
 {
     CHECK_EXPR(m_size < MAX_SIZE, -1, "The Vector No Enough Space!");
     std::_Construct(m_data + m_size, *(m_data + m_size - 1));
@@ -785,8 +824,8 @@ int NFShmVector<_Tp, MAX_SIZE>::_M_insert_aux(iterator __position, const _Tp &__
     return 0;
 }
 
-template<class _Tp, size_t MAX_SIZE>
-int NFShmVector<_Tp, MAX_SIZE>::_M_insert_aux(iterator __position)
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+int NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_insert_aux(iterator __position)
 {
     CHECK_EXPR(m_size < MAX_SIZE, -1, "The Vector No Enough Space!");
     std::_Construct(m_data + m_size, *(m_data + m_size - 1));
@@ -797,8 +836,8 @@ int NFShmVector<_Tp, MAX_SIZE>::_M_insert_aux(iterator __position)
     return 0;
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmVector<_Tp, MAX_SIZE>::_M_fill_insert(iterator __position, size_type __n,
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_fill_insert(iterator __position, size_type __n,
                                                 const _Tp &__x)
 {
     if (__n != 0)
@@ -832,8 +871,8 @@ void NFShmVector<_Tp, MAX_SIZE>::_M_fill_insert(iterator __position, size_type _
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
-void NFShmVector<_Tp, MAX_SIZE>::insert(iterator __position,
+template<class _Tp, size_t MAX_SIZE, class _Pp>
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::insert(iterator __position,
                                         const_iterator __first,
                                         const_iterator __last)
 {
@@ -873,9 +912,9 @@ void NFShmVector<_Tp, MAX_SIZE>::insert(iterator __position,
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _InputIter>
-void NFShmVector<_Tp, MAX_SIZE>::_M_assign_aux(_InputIter __first, _InputIter __last,
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_assign_aux(_InputIter __first, _InputIter __last,
                                                std::input_iterator_tag)
 {
     iterator __cur = begin();
@@ -887,9 +926,9 @@ void NFShmVector<_Tp, MAX_SIZE>::_M_assign_aux(_InputIter __first, _InputIter __
         insert(end(), __first, __last);
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _ForwardIter>
-void NFShmVector<_Tp, MAX_SIZE>::_M_assign_aux(_ForwardIter __first, _ForwardIter __last,
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_assign_aux(_ForwardIter __first, _ForwardIter __last,
                                                std::forward_iterator_tag)
 {
     size_type __len = std::distance(__first, __last);
@@ -919,9 +958,9 @@ void NFShmVector<_Tp, MAX_SIZE>::_M_assign_aux(_ForwardIter __first, _ForwardIte
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _InputIterator>
-void NFShmVector<_Tp, MAX_SIZE>::_M_range_insert(iterator __pos,
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_range_insert(iterator __pos,
                                                  _InputIterator __first,
                                                  _InputIterator __last,
                                                  std::input_iterator_tag)
@@ -937,9 +976,9 @@ void NFShmVector<_Tp, MAX_SIZE>::_M_range_insert(iterator __pos,
     }
 }
 
-template<class _Tp, size_t MAX_SIZE>
+template<class _Tp, size_t MAX_SIZE, class _Pp>
 template<class _ForwardIterator>
-void NFShmVector<_Tp, MAX_SIZE>::_M_range_insert(iterator __position,
+void NFShmVector<_Tp, MAX_SIZE, _Pp>::_M_range_insert(iterator __position,
                                                  _ForwardIterator __first,
                                                  _ForwardIterator __last,
                                                  std::forward_iterator_tag)
@@ -0,0 +1,481 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBench.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFCore/NFPlatform.h"
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+
+/**
+ * @brief 一行压测结果. ns_per_op = 总耗时 / ops, 同一组(suite, container, op, n)跑多遍时取最快的一遍.
+ * 非计时的结果(误判率, 误差, 内存)放在value列, 这时ns_per_op为0
+ */
+struct NFShmBenchResult
+{
+    std::string m_suite;
+    std::string m_container;
+    std::string m_op;
+    size_t m_size;
+    double m_nsPerOp;
+    uint64_t m_ops;
+    double m_value;
+};
+
+class NFShmBench;
+
+typedef void (*NFShmBenchSuiteFunc)(NFShmBench& bench);
+
+/**
+ * @brief 压测框架. 每个suite是一个函数, 用NFSHM_BENCH_SUITE在各自的cpp里注册;
+ * 结果按csv或json输出, 进度和说明打到stderr, 不混进结果里
+ *
+ * 用法:
+ * nfshm_bench --suite=containers,strings --sizes=1000,100000 --format=json --out=result.json
+ * nfshm_bench --sizes=all   //包含10M
+ * nfshm_bench --list
+ */
+class NFShmBench
+{
+public:
+    enum
+    {
+        DEFAULT_OPS = 1 << 20, //小规模时重复多遍, 每个操作至少做这么多次, 计时才稳定
+    };
+
+    struct Suite
+    {
+        const char* m_name;
+        NFShmBenchSuiteFunc m_func;
+    };
+
+    static std::vector<Suite>& Suites()
+    {
+        static std::vector<Suite> s_suites;
+        return s_suites;
+    }
+
+    static int Register(const char* name, NFShmBenchSuiteFunc func)
+    {
+        Suite suite = {name, func};
+        Suites().push_back(suite);
+        return 0;
+    }
+
+    /**
+     * @brief 当前时间, 纳秒
+     */
+    static uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 第i个测试key, 用murmur3的fmix32打乱, 是2^32上的双射, 不会重复.
+     * 不能只乘黄金比例常数: 那样得到的是低差异序列, 对key取模后分布得比随机还均匀,
+     * 用恒等hash的表(std::hash<int>)会测出不真实的短探测距离
+     */
+    static uint32_t Key(size_t i)
+    {
+        uint32_t h = (uint32_t) i;
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        h *= 0xc2b2ae35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    /**
+     * @brief 把结果喂给一个编译器看不见的地方, 防止计时的循环被优化掉
+     */
+    template<class T>
+    static void Keep(const T& value)
+    {
+#if defined(__GNUC__)
+        __asm__ __volatile__("" : : "g"(&value) : "memory");
+#else
+        static volatile const void* s_sink;
+        s_sink = &value;
+#endif
+    }
+
+    /**
+     * @brief 规模为n时, 每个计时段要重复几遍才能凑够DEFAULT_OPS次操作
+     */
+    static int Passes(size_t n)
+    {
+        return n >= DEFAULT_OPS ? 1 : (int)((DEFAULT_OPS + n - 1) / n);
+    }
+
+public:
+    NFShmBench() : m_repeat(3), m_json(false), m_curSuite("")
+    {
+        m_sizes.push_back(1000);
+        m_sizes.push_back(10000);
+        m_sizes.push_back(100000);
+        m_sizes.push_back(1000000);
+    }
+
+    int Run(int argc, char** argv)
+    {
+        std::string out;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--list")
+            {
+                for (size_t j = 0; j < Suites().size(); j++)
+                {
+                    printf("%s\n", Suites()[j].m_name);
+                }
+                return 0;
+            }
+            else if (arg.compare(0, 8, "--suite=") == 0)
+            {
+                Split(arg.substr(8), m_suites);
+            }
+            else if (arg.compare(0, 8, "--sizes=") == 0)
+            {
+                std::vector<std::string> sizes;
+                Split(arg.substr(8), sizes);
+                m_sizes.clear();
+                for (size_t j = 0; j < sizes.size(); j++)
+                {
+                    if (sizes[j] == "all")
+                    {
+                        static const size_t s_all[] = {1000, 10000, 100000, 1000000, 10000000};
+                        m_sizes.assign(s_all, s_all + sizeof(s_all) / sizeof(s_all[0]));
+                    }
+                    else
+                    {
+                        m_sizes.push_back(strtoull(sizes[j].c_str(), NULL, 10));
+                    }
+                }
+            }
+            else if (arg.compare(0, 9, "--repeat=") == 0)
+            {
+                m_repeat = std::max(1, atoi(arg.c_str() + 9));
+            }
+            else if (arg == "--format=json")
+            {
+                m_json = true;
+            }
+            else if (arg == "--format=csv")
+            {
+                m_json = false;
+            }
+            else if (arg.compare(0, 6, "--out=") == 0)
+            {
+                out = arg.substr(6);
+            }
+            else
+            {
+                fprintf(stderr, "usage: %s [--list] [--suite=a,b] [--sizes=1000,10000|all] [--repeat=3] [--format=csv|json] [--out=file]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        for (size_t i = 0; i < m_suites.size(); i++)
+        {
+            bool found = false;
+            for (size_t j = 0; j < Suites().size(); j++)
+            {
+                found = found || m_suites[i] == Suites()[j].m_name;
+            }
+            if (!found)
+            {
+                fprintf(stderr, "unknown suite: %s, use --list\n", m_suites[i].c_str());
+                return 1;
+            }
+        }
+
+        for (size_t i = 0; i < Suites().size(); i++)
+        {
+            if (!m_suites.empty() && std::find(m_suites.begin(), m_suites.end(), Suites()[i].m_name) == m_suites.end())
+            {
+                continue;
+            }
+            m_curSuite = Suites()[i].m_name;
+            fprintf(stderr, "suite %s ...\n", m_curSuite);
+            Suites()[i].m_func(*this);
+        }
+
+        FILE* fp = out.empty() ? stdout : fopen(out.c_str(), "w");
+        if (fp == NULL)
+        {
+            fprintf(stderr, "open %s failed\n", out.c_str());
+            return 1;
+        }
+        Write(fp);
+        if (fp != stdout)
+        {
+            fclose(fp);
+        }
+        return 0;
+    }
+
+    const std::vector<size_t>& Sizes() const
+    {
+        return m_sizes;
+    }
+
+    bool WantSize(size_t n) const
+    {
+        return std::find(m_sizes.begin(), m_sizes.end(), n) != m_sizes.end();
+    }
+
+    int Repeat() const
+    {
+        return m_repeat;
+    }
+
+    /**
+     * @brief 记一行计时结果, 同一组重复记录时保留最快的
+     */
+    void Report(const char* container, const char* op, size_t n, uint64_t ns, uint64_t ops)
+    {
+        if (ops == 0)
+        {
+            return;
+        }
+        double nsPerOp = (double)ns / (double)ops;
+        NFShmBenchResult* pResult = Find(container, op, n);
+        if (pResult)
+        {
+            if (nsPerOp < pResult->m_nsPerOp)
+            {
+                pResult->m_nsPerOp = nsPerOp;
+                pResult->m_ops = ops;
+            }
+            return;
+        }
+        NFShmBenchResult result = {m_curSuite, container, op, n, nsPerOp, ops, 0.0};
+        m_results.push_back(result);
+    }
+
+    /**
+     * @brief 记一行非计时的结果(误差, 误判率, 字节数等)
+     */
+    void ReportValue(const char* container, const char* op, size_t n, double value)
+    {
+        NFShmBenchResult* pResult = Find(container, op, n);
+        if (pResult)
+        {
+            pResult->m_value = value;
+            return;
+        }
+        NFShmBenchResult result = {m_curSuite, container, op, n, 0.0, 0, value};
+        m_results.push_back(result);
+    }
+
+    /**
+     * @brief 给某个结果之外的说明, 比如哪些组合没有跑以及原因, 打到stderr
+     */
+    void Note(const char* msg) const
+    {
+        fprintf(stderr, "  note: %s\n", msg);
+    }
+
+    const std::vector<NFShmBenchResult>& Results() const
+    {
+        return m_results;
+    }
+
+private:
+    NFShmBenchResult* Find(const char* container, const char* op, size_t n)
+    {
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            NFShmBenchResult& r = m_results[i];
+            if (r.m_size == n && r.m_suite == m_curSuite && r.m_container == container && r.m_op == op)
+            {
+                return &r;
+            }
+        }
+        return NULL;
+    }
+
+    void Write(FILE* fp) const
+    {
+        if (m_json)
+        {
+            fprintf(fp, "[\n");
+            for (size_t i = 0; i < m_results.size(); i++)
+            {
+                const NFShmBenchResult& r = m_results[i];
+                fprintf(fp, "  {\"suite\": \"%s\", \"container\": \"%s\", \"op\": \"%s\", \"n\": %zu, \"ns_per_op\": %.3f, \"ops\": %llu, \"value\": %.6g}%s\n",
+                        r.m_suite.c_str(), r.m_container.c_str(), r.m_op.c_str(), r.m_size, r.m_nsPerOp, (unsigned long long)r.m_ops, r.m_value,
+                        i + 1 < m_results.size() ? "," : "");
+            }
+            fprintf(fp, "]\n");
+        }
+        else
+        {
+            fprintf(fp, "suite,container,op,n,ns_per_op,ops,value\n");
+            for (size_t i = 0; i < m_results.size(); i++)
+            {
+                const NFShmBenchResult& r = m_results[i];
+                fprintf(fp, "%s,%s,%s,%zu,%.3f,%llu,%.6g\n", r.m_suite.c_str(), r.m_container.c_str(), r.m_op.c_str(), r.m_size, r.m_nsPerOp,
+                        (unsigned long long)r.m_ops, r.m_value);
+            }
+        }
+    }
+
+    static void Split(const std::string& str, std::vector<std::string>& out)
+    {
+        size_t start = 0;
+        while (start <= str.size())
+        {
+            size_t end = str.find(',', start);
+            if (end == std::string::npos)
+            {
+                end = str.size();
+            }
+            if (end > start)
+            {
+                out.push_back(str.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+    }
+
+private:
+    std::vector<size_t> m_sizes;
+    std::vector<std::string> m_suites;
+    int m_repeat;
+    bool m_json;
+    const char* m_curSuite;
+    std::vector<NFShmBenchResult> m_results;
+};
+
+/**
+ * @brief 只分配不释放的内存池. 给std::map这类按节点分配的容器用: 前一个容器释放的节点散落在malloc的空闲链表里,
+ * 后建的容器会拿到顺序被打乱的节点, 同样的查找慢一倍, 比较两个比较函数时结论会反过来
+ */
+class NFShmBenchArena
+{
+public:
+    enum
+    {
+        BLOCK_SIZE = 4 << 20,
+    };
+
+    NFShmBenchArena() : m_cur(NULL), m_left(0)
+    {
+    }
+
+    void* Alloc(size_t n, size_t align)
+    {
+        size_t pad = (align - ((uintptr_t) m_cur & (align - 1))) & (align - 1);
+        if (m_cur == NULL || pad + n > m_left)
+        {
+            size_t size = std::max((size_t) BLOCK_SIZE, n + align);
+            m_blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+            m_cur = m_blocks.back().get();
+            m_left = size;
+            pad = (align - ((uintptr_t) m_cur & (align - 1))) & (align - 1);
+        }
+        void* p = m_cur + pad;
+        m_cur += pad + n;
+        m_left -= pad + n;
+        return p;
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]> > m_blocks;
+    char* m_cur;
+    size_t m_left;
+};
+
+template<class T>
+struct NFShmBenchArenaAllocator
+{
+    typedef T value_type;
+
+    explicit NFShmBenchArenaAllocator(NFShmBenchArena* pArena) : m_pArena(pArena)
+    {
+    }
+
+    template<class U>
+    NFShmBenchArenaAllocator(const NFShmBenchArenaAllocator<U>& other) : m_pArena(other.m_pArena)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(m_pArena->Alloc(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    template<class U>
+    bool operator==(const NFShmBenchArenaAllocator<U>& other) const
+    {
+        return m_pArena == other.m_pArena;
+    }
+
+    template<class U>
+    bool operator!=(const NFShmBenchArenaAllocator<U>& other) const
+    {
+        return m_pArena != other.m_pArena;
+    }
+
+    NFShmBenchArena* m_pArena;
+};
+
+/**
+ * @brief 定长容器的规模是模板参数, 用它把运行时选中的规模分发到编译期的几个实例上
+ * Fn<N>::Run(bench)只在N被--sizes选中时调用
+ */
+template<template<int> class Fn, int... Ns>
+struct NFShmBenchForSizes
+{
+    static void Run(NFShmBench& bench)
+    {
+        int dummy[] = {0, (bench.WantSize(Ns) ? (Fn<Ns>::Run(bench), 0) : 0)...};
+        (void) dummy;
+    }
+};
+
+template<template<int> class Fn>
+inline void NFShmBenchForEachSize(NFShmBench& bench)
+{
+    NFShmBenchForSizes<Fn, 1000, 10000, 100000, 1000000, 10000000>::Run(bench);
+}
+
+/**
+ * @brief 计时一段代码, 结果交给bench.Report
+ */
+#define NFSHM_BENCH_TIME(bench, container, op, n, ops, code) \
+    do { \
+        uint64_t __nfshm_bench_start = NFShmBench::Now(); \
+        code; \
+        (bench).Report(container, op, n, NFShmBench::Now() - __nfshm_bench_start, ops); \
+    } while (0)
+
+#define NFSHM_BENCH_CONCAT_(a, b) a##b
+#define NFSHM_BENCH_CONCAT(a, b) NFSHM_BENCH_CONCAT_(a, b)
+
+/**
+ * @brief 注册一个suite: NFSHM_BENCH_SUITE(containers) { ... bench.Report(...) ... }
+ */
+#define NFSHM_BENCH_SUITE(name) \
+    static void NFSHM_BENCH_CONCAT(NFShmBenchSuite_, name)(NFShmBench& bench); \
+    static int NFSHM_BENCH_CONCAT(s_NFShmBenchReg_, name) = NFShmBench::Register(#name, &NFSHM_BENCH_CONCAT(NFShmBenchSuite_, name)); \
+    static void NFSHM_BENCH_CONCAT(NFShmBenchSuite_, name)(NFShmBench& bench)
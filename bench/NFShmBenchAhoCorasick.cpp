@@ -0,0 +1,232 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchAhoCorasick.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmAhoCorasick.h"
+#include <map>
+#include <random>
+#include <malloc.h>
+
+/**
+ * @brief 对照组: 现在每个进程在堆上建的自动机, 子节点用std::map, 失败时沿fail指针回退
+ */
+class NFShmBenchHeapAhoCorasick
+{
+public:
+    struct Node
+    {
+        Node() : m_fail(0), m_output(-1), m_outLink(0)
+        {
+        }
+
+        std::map<uint8_t, int> m_next;
+        int m_fail;
+        int m_output;
+        int m_outLink;
+    };
+
+    void build(const std::vector<std::string>& patterns)
+    {
+        m_nodes.assign(1, Node());
+        m_len.clear();
+        for (size_t i = 0; i < patterns.size(); i++)
+        {
+            int s = 0;
+            for (size_t j = 0; j < patterns[i].size(); j++)
+            {
+                uint8_t c = (uint8_t) patterns[i][j];
+                auto it = m_nodes[s].m_next.find(c);
+                if (it == m_nodes[s].m_next.end())
+                {
+                    m_nodes.push_back(Node());
+                    int t = (int) m_nodes.size() - 1;
+                    m_nodes[s].m_next[c] = t;
+                    s = t;
+                }
+                else
+                {
+                    s = it->second;
+                }
+            }
+            if (m_nodes[s].m_output < 0)
+            {
+                m_nodes[s].m_output = (int) i;
+            }
+            m_len.push_back((int) patterns[i].size());
+        }
+
+        std::vector<int> queue;
+        for (auto it = m_nodes[0].m_next.begin(); it != m_nodes[0].m_next.end(); ++it)
+        {
+            queue.push_back(it->second);
+        }
+        for (size_t head = 0; head < queue.size(); head++)
+        {
+            int s = queue[head];
+            for (auto it = m_nodes[s].m_next.begin(); it != m_nodes[s].m_next.end(); ++it)
+            {
+                int t = it->second;
+                int f = m_nodes[s].m_fail;
+                while (f != 0 && m_nodes[f].m_next.find(it->first) == m_nodes[f].m_next.end())
+                {
+                    f = m_nodes[f].m_fail;
+                }
+                auto ft = m_nodes[f].m_next.find(it->first);
+                m_nodes[t].m_fail = ft != m_nodes[f].m_next.end() ? ft->second : 0;
+                int ff = m_nodes[t].m_fail;
+                m_nodes[t].m_outLink = m_nodes[ff].m_output >= 0 ? ff : m_nodes[ff].m_outLink;
+                queue.push_back(t);
+            }
+        }
+    }
+
+    template<class Func>
+    size_t scan(std::string_view text, Func&& f) const
+    {
+        size_t matches = 0;
+        int s = 0;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            uint8_t c = (uint8_t) text[i];
+            while (true)
+            {
+                auto it = m_nodes[s].m_next.find(c);
+                if (it != m_nodes[s].m_next.end())
+                {
+                    s = it->second;
+                    break;
+                }
+                if (s == 0)
+                {
+                    break;
+                }
+                s = m_nodes[s].m_fail;
+            }
+            for (int o = m_nodes[s].m_output >= 0 ? s : m_nodes[s].m_outLink; o != 0; o = m_nodes[o].m_outLink)
+            {
+                int id = m_nodes[o].m_output;
+                f(i + 1 - m_len[id], (size_t) m_len[id], id);
+                ++matches;
+            }
+        }
+        return matches;
+    }
+
+    size_t replace(std::string& text, char mask) const
+    {
+        size_t lastEnd = (size_t) -1;
+        return scan(text, [&](size_t pos, size_t len, int) {
+            if (pos + len == lastEnd)
+            {
+                return;
+            }
+            lastEnd = pos + len;
+            memset(&text[pos], mask, len);
+        });
+    }
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<int> m_len;
+};
+
+typedef NFShmAhoCorasick<1 << 19, 65536> NFShmBenchAhoCorasick;
+
+/**
+ * @brief 模式串是4~10个小写字母的随机词, 文本是随机小写字母和空格拼成的聊天消息, 每条消息里有1%的概率嵌一个模式串
+ */
+static void NFShmBenchAhoCorasickRun(NFShmBench& bench, size_t numPatterns)
+{
+    std::mt19937_64 rng(20261017);
+    std::vector<std::string> patterns(numPatterns);
+    for (size_t i = 0; i < numPatterns; i++)
+    {
+        size_t len = 4 + rng() % 7;
+        for (size_t j = 0; j < len; j++)
+        {
+            patterns[i].push_back((char) ('a' + rng() % 26));
+        }
+    }
+
+    const size_t MSG_LEN = 64;
+    const size_t NUM_MSGS = 16384; //1M字节
+    std::vector<std::string> msgs(NUM_MSGS);
+    std::string text;
+    for (size_t i = 0; i < NUM_MSGS; i++)
+    {
+        std::string& msg = msgs[i];
+        while (msg.size() < MSG_LEN)
+        {
+            if (rng() % 100 == 0)
+            {
+                msg += patterns[rng() % numPatterns];
+            }
+            else
+            {
+                msg.push_back(rng() % 6 == 0 ? ' ' : (char) ('a' + rng() % 26));
+            }
+        }
+        msg.resize(MSG_LEN);
+        text += msg;
+    }
+
+    std::unique_ptr<NFShmBenchAhoCorasick> pShm(new NFShmBenchAhoCorasick());
+    NFShmBenchHeapAhoCorasick heap;
+    uint64_t sum = 0;
+
+    for (int r = 0; r < bench.Repeat(); r++)
+    {
+        NFSHM_BENCH_TIME(bench, "NFShmAhoCorasick", "build", numPatterns, numPatterns, sum += pShm->build(patterns));
+        size_t before = mallinfo2().uordblks;
+        NFSHM_BENCH_TIME(bench, "heap std::map trie", "build", numPatterns, numPatterns, heap.build(patterns));
+        if (r == 0)
+        {
+            bench.ReportValue("NFShmAhoCorasick", "bytes", numPatterns, (double) sizeof(NFShmBenchAhoCorasick));
+            bench.ReportValue("heap std::map trie", "bytes", numPatterns, (double) (mallinfo2().uordblks - before));
+            bench.ReportValue("NFShmAhoCorasick", "states", numPatterns, (double) pShm->state_count());
+        }
+
+        size_t shmMatches = 0;
+        size_t heapMatches = 0;
+        NFSHM_BENCH_TIME(bench, "NFShmAhoCorasick", "scan_byte", numPatterns, text.size(),
+                         shmMatches = pShm->scan(text, [&sum](size_t pos, size_t, int) { sum += pos; }));
+        NFSHM_BENCH_TIME(bench, "heap std::map trie", "scan_byte", numPatterns, text.size(),
+                         heapMatches = heap.scan(text, [&sum](size_t pos, size_t, int) { sum += pos; }));
+        if (shmMatches != heapMatches)
+        {
+            bench.Note("aho_corasick: NFShmAhoCorasick and the heap trie disagree on the match count");
+        }
+        bench.ReportValue("NFShmAhoCorasick", "matches", numPatterns, (double) shmMatches);
+
+        NFSHM_BENCH_TIME(bench, "NFShmAhoCorasick", "contains_msg", numPatterns, NUM_MSGS, for (size_t i = 0; i < NUM_MSGS; i++)
+                         {
+                             sum += pShm->contains(msgs[i]);
+                         });
+
+        std::vector<std::string> work(msgs);
+        NFSHM_BENCH_TIME(bench, "NFShmAhoCorasick", "replace_msg", numPatterns, NUM_MSGS, for (size_t i = 0; i < NUM_MSGS; i++)
+                         {
+                             sum += pShm->replace(work[i], '*');
+                         });
+        work = msgs;
+        NFSHM_BENCH_TIME(bench, "heap std::map trie", "replace_msg", numPatterns, NUM_MSGS, for (size_t i = 0; i < NUM_MSGS; i++)
+                         {
+                             sum += heap.replace(work[i], '*');
+                         });
+    }
+    NFShmBench::Keep(sum);
+}
+
+NFSHM_BENCH_SUITE(aho_corasick)
+{
+    //n列是模式串个数, 和--sizes无关; 线上屏蔽字大约5万条
+    NFShmBenchAhoCorasickRun(bench, 1000);
+    NFShmBenchAhoCorasickRun(bench, 10000);
+    NFShmBenchAhoCorasickRun(bench, 50000);
+}
@@ -0,0 +1,189 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchColumnTable.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmVector.h"
+#include "NFComm/NFShmStl/NFShmColumnTable.h"
+
+struct NFShmBenchPlayerName
+{
+    char m_data[36];
+};
+
+/**
+ * @brief 对照组的行结构, 正好一条cache line, 扫描一个字段也要把整行读进来
+ */
+struct NFShmBenchPlayer
+{
+    uint64_t m_id;
+    int m_level;
+    int64_t m_gold;
+    uint32_t m_lastLogin;
+    NFShmBenchPlayerName m_name;
+};
+
+enum
+{
+    NFSHM_BENCH_COL_ID = 0,
+    NFSHM_BENCH_COL_LEVEL = 1,
+    NFSHM_BENCH_COL_GOLD = 2,
+    NFSHM_BENCH_COL_LAST_LOGIN = 3,
+    NFSHM_BENCH_COL_NAME = 4,
+};
+
+static const uint32_t NFSHM_BENCH_LOGIN_CUT = 43200;
+
+/**
+ * @brief 在fill过的结构体数组上做和列存表一样的统计, ops是行数, 结果写进sums用来和列存表对账
+ */
+template<class Vec>
+void NFShmBenchScanStruct(NFShmBench& bench, const char* name, size_t n, const Vec& v, int64_t* sums)
+{
+    size_t rows = v.size();
+    int passes = NFShmBench::Passes(rows);
+    uint64_t ops = (uint64_t) passes * rows;
+    NFSHM_BENCH_TIME(bench, name, "sum", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         int64_t sum = 0;
+                         for (size_t i = 0; i < rows; i++)
+                         {
+                             sum += v[i].m_level;
+                         }
+                         sums[0] = sum;
+                     });
+    NFSHM_BENCH_TIME(bench, name, "count_where", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         int64_t count = 0;
+                         for (size_t i = 0; i < rows; i++)
+                         {
+                             count += v[i].m_lastLogin > NFSHM_BENCH_LOGIN_CUT;
+                         }
+                         sums[1] = count;
+                     });
+    NFSHM_BENCH_TIME(bench, name, "min_max", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         int lo = v[0].m_level;
+                         int hi = v[0].m_level;
+                         for (size_t i = 1; i < rows; i++)
+                         {
+                             lo = std::min(lo, v[i].m_level);
+                             hi = std::max(hi, v[i].m_level);
+                         }
+                         sums[2] = lo;
+                         sums[3] = hi;
+                     });
+    NFSHM_BENCH_TIME(bench, name, "sum_where", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         int64_t sum = 0;
+                         for (size_t i = 0; i < rows; i++)
+                         {
+                             sum += v[i].m_level >= 50 ? v[i].m_gold : 0;
+                         }
+                         sums[4] = sum;
+                     });
+}
+
+template<class Table>
+void NFShmBenchScanColumn(NFShmBench& bench, const char* name, size_t n, const Table& t, int64_t* sums)
+{
+    size_t rows = t.size();
+    int passes = NFShmBench::Passes(rows);
+    uint64_t ops = (uint64_t) passes * rows;
+    NFSHM_BENCH_TIME(bench, name, "sum", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         sums[0] = t.template sum<NFSHM_BENCH_COL_LEVEL>();
+                     });
+    NFSHM_BENCH_TIME(bench, name, "count_where", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         sums[1] = (int64_t) t.template count_where<NFSHM_BENCH_COL_LAST_LOGIN>(
+                             [](uint32_t login) { return login > NFSHM_BENCH_LOGIN_CUT; });
+                     });
+    NFSHM_BENCH_TIME(bench, name, "min_max", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         int lo = 0;
+                         int hi = 0;
+                         t.template min_value<NFSHM_BENCH_COL_LEVEL>(lo);
+                         t.template max_value<NFSHM_BENCH_COL_LEVEL>(hi);
+                         sums[2] = lo;
+                         sums[3] = hi;
+                     });
+    NFSHM_BENCH_TIME(bench, name, "sum_where", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         sums[4] = (t.template sum_where<NFSHM_BENCH_COL_GOLD, NFSHM_BENCH_COL_LEVEL>([](int level) { return level >= 50; }));
+                     });
+}
+
+/**
+ * @brief full: N行全部有效; holes: 插满后按key随机删掉约10%, 位图里大部分字是部分有效的.
+ * 结构体数组删除时用最后一行补洞, 始终是连续的, 是它最好的情况.
+ * n列是MAX_ROWS, ns_per_op是每个有效行的耗时
+ */
+template<int N>
+struct NFShmBenchColumnTableSize
+{
+    typedef NFShmVector<NFShmBenchPlayer, N> Vec;
+    typedef NFShmColumnTable<N, uint64_t, int, int64_t, uint32_t, NFShmBenchPlayerName> Table;
+
+    static void Run(NFShmBench& bench)
+    {
+        std::unique_ptr<Vec> pVec(new Vec());
+        std::unique_ptr<Table> pTable(new Table());
+        NFShmBenchPlayerName playerName;
+        memset(&playerName, 'a', sizeof(playerName));
+        for (int i = 0; i < N; i++)
+        {
+            NFShmBenchPlayer player;
+            player.m_id = i;
+            player.m_level = (int) (NFShmBench::Key(i) % 100);
+            player.m_gold = NFShmBench::Key(i + N) % 1000000;
+            player.m_lastLogin = NFShmBench::Key(i + 2 * N) % 86400;
+            player.m_name = playerName;
+            pVec->push_back(player);
+            pTable->insert(player.m_id, player.m_level, player.m_gold, player.m_lastLogin, player.m_name);
+        }
+
+        for (int holes = 0; holes < 2; holes++)
+        {
+            if (holes)
+            {
+                for (int i = N - 1; i >= 0; i--)
+                {
+                    if (NFShmBench::Key(i + 3 * N) % 10 == 0)
+                    {
+                        pTable->erase(i);
+                        (*pVec)[i] = pVec->back();
+                        pVec->pop_back();
+                    }
+                }
+            }
+            std::string vecName = std::string("NFShmVector<struct>") + (holes ? "/holes" : "/full");
+            std::string tableName = std::string("NFShmColumnTable") + (holes ? "/holes" : "/full");
+            for (int r = 0; r < bench.Repeat(); r++)
+            {
+                int64_t vecSums[5] = {0};
+                int64_t tableSums[5] = {0};
+                NFShmBenchScanStruct(bench, vecName.c_str(), N, *pVec, vecSums);
+                NFShmBenchScanColumn(bench, tableName.c_str(), N, *pTable, tableSums);
+                if (memcmp(vecSums, tableSums, sizeof(vecSums)) != 0)
+                {
+                    bench.Note(("column_table: results differ at n=" + std::to_string(N)).c_str());
+                }
+                NFShmBench::Keep(vecSums);
+                NFShmBench::Keep(tableSums);
+            }
+        }
+        bench.ReportValue("NFShmColumnTable", "bytes", N, (double) sizeof(Table));
+        bench.ReportValue("NFShmVector<struct>", "bytes", N, (double) sizeof(Vec));
+    }
+};
+
+NFSHM_BENCH_SUITE(column_table)
+{
+    NFShmBenchForEachSize<NFShmBenchColumnTableSize>(bench);
+}
@@ -0,0 +1,409 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchContainers.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmDyVector.h"
+#include "NFComm/NFShmStl/NFShmDyList.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmHashMapWithList.h"
+#include "NFComm/NFShmStl/NFShmDyHashMap.h"
+#include "NFComm/NFShmStl/NFShmDyHashMapWithList.h"
+#include "NFComm/NFShmStl/NFShmVector.h"
+#include "NFComm/NFShmStl/NFShmList.h"
+#include "NFComm/NFShmStl/NFShmString.h"
+#include <unordered_map>
+#include <map>
+#include <list>
+
+/**
+ * @brief Dy容器自己不持有内存, 压测里用一块堆内存代替共享内存段. 成员的声明顺序保证容器先于缓冲区析构
+ */
+template<class Map>
+struct NFShmBenchDyHolder
+{
+    explicit NFShmBenchDyHolder(int n) : m_buffer(Map::CountSize(n))
+    {
+        m_map.Init(m_buffer.data(), (int) m_buffer.size(), n, true);
+    }
+
+    std::vector<char> m_buffer;
+    Map m_map;
+};
+
+/**
+ * @brief 关联容器的通用压测: insert, find_hit, find_miss, iterate, erase, clear.
+ * 小规模时每个操作重复Passes(n)遍; 每遍前需要的准备工作(清空/重新插入)不计时
+ */
+template<class Map>
+void NFShmBenchMap(NFShmBench& bench, const char* name, size_t n, Map& m)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t ops = (uint64_t) passes * n;
+    uint64_t sum = 0;
+    uint64_t ns = 0;
+
+    for (int p = 0; p < passes; p++)
+    {
+        m.clear();
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            m.insert(std::make_pair((int) NFShmBench::Key(i), (int) i));
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "insert", n, ns, ops);
+    if (m.size() != n)
+    {
+        bench.Note((std::string(name) + " insert lost elements").c_str());
+    }
+
+    NFSHM_BENCH_TIME(bench, name, "find_hit", n, ops,
+                     for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find((int) NFShmBench::Key(i))->second;
+                         }
+                     });
+
+    NFSHM_BENCH_TIME(bench, name, "find_miss", n, ops,
+                     for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find((int) NFShmBench::Key(n + i)) == m.end();
+                         }
+                     });
+
+    NFSHM_BENCH_TIME(bench, name, "iterate", n, ops,
+                     for (int p = 0; p < passes; p++)
+                     {
+                         for (auto it = m.begin(); it != m.end(); ++it)
+                         {
+                             sum += it->second;
+                         }
+                     });
+
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        if (p > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                m.insert(std::make_pair((int) NFShmBench::Key(i), (int) i));
+            }
+        }
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            sum += m.erase((int) NFShmBench::Key(i));
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "erase", n, ns, ops);
+
+    //clear按元素个数折算, 和逐个erase可比
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            m.insert(std::make_pair((int) NFShmBench::Key(i), (int) i));
+        }
+        uint64_t start = NFShmBench::Now();
+        m.clear();
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "clear", n, ns, ops);
+
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchHashMaps
+{
+    static void Run(NFShmBench& bench)
+    {
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            {
+                std::unique_ptr<NFShmHashMap<int, int, N> > pMap(new NFShmHashMap<int, int, N>());
+                NFShmBenchMap(bench, "NFShmHashMap", N, *pMap);
+            }
+            {
+                std::unique_ptr<NFShmHashMapWithList<int, int, N> > pMap(new NFShmHashMapWithList<int, int, N>());
+                NFShmBenchMap(bench, "NFShmHashMapWithList", N, *pMap);
+            }
+            {
+                std::unique_ptr<NFShmBenchDyHolder<NFShmDyHashMap<int, int> > > pHolder(new NFShmBenchDyHolder<NFShmDyHashMap<int, int> >(N));
+                NFShmBenchMap(bench, "NFShmDyHashMap", N, pHolder->m_map);
+            }
+            {
+                std::unique_ptr<NFShmBenchDyHolder<NFShmDyHashMapWithList<int, int> > > pHolder(
+                    new NFShmBenchDyHolder<NFShmDyHashMapWithList<int, int> >(N));
+                NFShmBenchMap(bench, "NFShmDyHashMapWithList", N, pHolder->m_map);
+            }
+            {
+                //共享内存的表是预先分配好的, std这边也先reserve, 只比较操作本身
+                std::unordered_map<int, int> map;
+                map.reserve(N);
+                NFShmBenchMap(bench, "std::unordered_map", N, map);
+            }
+        }
+    }
+};
+
+template<int N>
+struct NFShmBenchOrdered
+{
+    static void Run(NFShmBench& bench)
+    {
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            std::map<int, int> map;
+            NFShmBenchMap(bench, "std::map", N, map);
+        }
+    }
+};
+
+template<class Tp, size_t MAX_SIZE, class Pp>
+inline void NFShmBenchPop(NFShmVector<Tp, MAX_SIZE, Pp>& v)
+{
+    v.pop_back();
+}
+
+inline void NFShmBenchPop(std::vector<int>& v)
+{
+    v.pop_back();
+}
+
+template<class Tp, size_t MAX_SIZE, class Pp>
+inline void NFShmBenchPop(NFShmList<Tp, MAX_SIZE, Pp>& l)
+{
+    l.pop_front();
+}
+
+inline void NFShmBenchPop(std::list<int>& l)
+{
+    l.pop_front();
+}
+
+/**
+ * @brief 顺序容器: insert(push_back), at(随机下标读, 只有vector), iterate, erase(vector从尾部pop_back, list从头部pop_front), clear
+ */
+template<bool RANDOM_ACCESS, class Vec>
+void NFShmBenchSequence(NFShmBench& bench, const char* name, size_t n, Vec& v)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t ops = (uint64_t) passes * n;
+    uint64_t sum = 0;
+    uint64_t ns = 0;
+
+    for (int p = 0; p < passes; p++)
+    {
+        v.clear();
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            v.push_back((int) i);
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "insert", n, ns, ops);
+
+    if constexpr (RANDOM_ACCESS)
+    {
+        NFSHM_BENCH_TIME(bench, name, "at", n, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (size_t i = 0; i < n; i++)
+                             {
+                                 sum += v[(i * 7919) % n];
+                             }
+                         });
+    }
+
+    NFSHM_BENCH_TIME(bench, name, "iterate", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (auto it = v.begin(); it != v.end(); ++it)
+                         {
+                             sum += *it;
+                         }
+                     });
+
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        if (p > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                v.push_back((int) i);
+            }
+        }
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            NFShmBenchPop(v);
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "erase", n, ns, ops);
+
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            v.push_back((int) i);
+        }
+        uint64_t start = NFShmBench::Now();
+        v.clear();
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "clear", n, ns, ops);
+
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchSequences
+{
+    static void Run(NFShmBench& bench)
+    {
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            {
+                std::unique_ptr<NFShmVector<int, N> > pVec(new NFShmVector<int, N>());
+                NFShmBenchSequence<true>(bench, "NFShmVector", N, *pVec);
+            }
+            {
+                std::vector<int> vec;
+                NFShmBenchSequence<true>(bench, "std::vector", N, vec);
+            }
+            {
+                std::unique_ptr<NFShmList<int, N> > pList(new NFShmList<int, N>());
+                NFShmBenchSequence<false>(bench, "NFShmList", N, *pList);
+            }
+            {
+                std::list<int> list;
+                NFShmBenchSequence<false>(bench, "std::list", N, list);
+            }
+        }
+    }
+};
+
+/**
+ * @brief 字符串: insert(逐字符push_back), find_hit(子串在末尾, 每次扫全串), find_miss, iterate, erase(pop_back), clear.
+ * find的ops是调用次数, 其他是字符数
+ */
+template<class Str>
+void NFShmBenchStringOps(NFShmBench& bench, const char* name, size_t n, Str& s)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t ops = (uint64_t) passes * n;
+    uint64_t sum = 0;
+    uint64_t ns = 0;
+
+    for (int p = 0; p < passes; p++)
+    {
+        s.clear();
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            s.push_back((char) ('a' + i % 26));
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "insert", n, ns, ops);
+
+    //末尾换成一个字母表外的字符, 命中的子串只在结尾出现一次
+    s.pop_back();
+    s.push_back('!');
+    int calls = std::max(1, NFShmBench::Passes(n) / 16);
+    NFSHM_BENCH_TIME(bench, name, "find_hit", n, calls, for (int c = 0; c < calls; c++)
+                     {
+                         sum += s.find("xyz!", 0, 4);
+                     });
+    NFSHM_BENCH_TIME(bench, name, "find_miss", n, calls, for (int c = 0; c < calls; c++)
+                     {
+                         sum += s.find("xyz#", 0, 4);
+                     });
+
+    NFSHM_BENCH_TIME(bench, name, "iterate", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (auto it = s.begin(); it != s.end(); ++it)
+                         {
+                             sum += (unsigned char) *it;
+                         }
+                     });
+
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        if (p > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                s.push_back((char) ('a' + i % 26));
+            }
+        }
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            s.pop_back();
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "erase", n, ns, ops);
+
+    ns = 0;
+    for (int p = 0; p < passes; p++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            s.push_back((char) ('a' + i % 26));
+        }
+        uint64_t start = NFShmBench::Now();
+        s.clear();
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name, "clear", n, ns, ops);
+
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchStrings
+{
+    static void Run(NFShmBench& bench)
+    {
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            {
+                std::unique_ptr<NFShmString<N> > pStr(new NFShmString<N>());
+                NFShmBenchStringOps(bench, "NFShmString", N, *pStr);
+            }
+            {
+                std::string str;
+                NFShmBenchStringOps(bench, "std::string", N, str);
+            }
+        }
+    }
+};
+
+NFSHM_BENCH_SUITE(containers)
+{
+    NFShmBenchForEachSize<NFShmBenchHashMaps>(bench);
+    NFShmBenchForEachSize<NFShmBenchSequences>(bench);
+    NFShmBenchForEachSize<NFShmBenchStrings>(bench);
+    NFShmBenchForEachSize<NFShmBenchOrdered>(bench);
+    bench.Note("NFShmTree is not benchmarked: instantiating it fails to compile in this tree (iterator ctor/operator== at NFShmTree.h), std::map rows are the ordered baseline");
+}
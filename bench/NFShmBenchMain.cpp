@@ -0,0 +1,17 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchMain.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+
+int main(int argc, char** argv)
+{
+    NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_INIT);
+    NFShmBench bench;
+    return bench.Run(argc, argv);
+}
@@ -0,0 +1,118 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchRobinHood.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmRobinHoodMap.h"
+
+/**
+ * @brief 容量为N的表装到fill%: insert, find_hit, find_miss, churn(删一个旧的再插一个新的, 装载率不变), erase.
+ * 容器名后面带上装载率, n列是容量
+ */
+template<class Map>
+void NFShmBenchFill(NFShmBench& bench, const std::string& name, size_t n, int fill, Map& m)
+{
+    size_t count = n * fill / 100;
+    int passes = NFShmBench::Passes(count);
+    uint64_t ops = (uint64_t) passes * count;
+    uint64_t sum = 0;
+    uint64_t ns = 0;
+
+    for (int p = 0; p < passes; p++)
+    {
+        m.clear();
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < count; i++)
+        {
+            m.insert(std::make_pair((int) NFShmBench::Key(i), (int) i));
+        }
+        ns += NFShmBench::Now() - start;
+    }
+    bench.Report(name.c_str(), "insert", n, ns, ops);
+    if (m.size() != count)
+    {
+        bench.Note((name + " insert lost elements").c_str());
+    }
+
+    NFSHM_BENCH_TIME(bench, name.c_str(), "find_hit", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < count; i++)
+                         {
+                             sum += m.find((int) NFShmBench::Key(i))->second;
+                         }
+                     });
+    NFSHM_BENCH_TIME(bench, name.c_str(), "find_miss", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < count; i++)
+                         {
+                             sum += m.find((int) NFShmBench::Key(n + i)) == m.end();
+                         }
+                     });
+
+    //一直在满载附近删旧插新, 开放寻址有墓碑的话这里会越跑越慢
+    size_t churn = std::max(count, (size_t) NFShmBench::DEFAULT_OPS);
+    NFSHM_BENCH_TIME(bench, name.c_str(), "churn", n, churn, for (size_t i = 0; i < churn; i++)
+                     {
+                         sum += m.erase((int) NFShmBench::Key(i));
+                         m.insert(std::make_pair((int) NFShmBench::Key(i + count), (int) i));
+                     });
+
+    ns = 0;
+    size_t first = churn;
+    uint64_t start = NFShmBench::Now();
+    for (size_t i = first; i < first + count; i++)
+    {
+        sum += m.erase((int) NFShmBench::Key(i));
+    }
+    ns += NFShmBench::Now() - start;
+    bench.Report(name.c_str(), "erase", n, ns, count);
+    if (m.size() != 0)
+    {
+        bench.Note((name + " erase left elements").c_str());
+    }
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchRobinHoodSize
+{
+    static void Run(NFShmBench& bench)
+    {
+        static const int s_fills[] = {50, 80, 95};
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            for (size_t f = 0; f < sizeof(s_fills) / sizeof(s_fills[0]); f++)
+            {
+                int fill = s_fills[f];
+                std::string suffix = "@" + std::to_string(fill) + "%";
+                {
+                    std::unique_ptr<NFShmRobinHoodMap<int, int, N> > pMap(new NFShmRobinHoodMap<int, int, N>());
+                    NFShmBenchFill(bench, "NFShmRobinHoodMap" + suffix, N, fill, *pMap);
+
+                    //探测距离在churn之后再量, 反映长期运行的状态
+                    for (size_t i = 0; i < (size_t) N * fill / 100; i++)
+                    {
+                        pMap->insert(std::make_pair((int) NFShmBench::Key(i), (int) i));
+                    }
+                    bench.ReportValue(("NFShmRobinHoodMap" + suffix).c_str(), "max_probe", N, (double) pMap->max_probe());
+                    bench.ReportValue(("NFShmRobinHoodMap" + suffix).c_str(), "avg_probe", N, pMap->avg_probe());
+                }
+                {
+                    std::unique_ptr<NFShmHashMap<int, int, N> > pMap(new NFShmHashMap<int, int, N>());
+                    NFShmBenchFill(bench, "NFShmHashMap" + suffix, N, fill, *pMap);
+                }
+            }
+        }
+    }
+};
+
+NFSHM_BENCH_SUITE(robin_hood)
+{
+    NFShmBenchForEachSize<NFShmBenchRobinHoodSize>(bench);
+}
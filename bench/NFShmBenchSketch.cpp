@@ -0,0 +1,214 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchSketch.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHyperLogLog.h"
+#include "NFComm/NFShmStl/NFShmCountMinSketch.h"
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+typedef NFShmHyperLogLog<14> NFShmBenchHll;
+typedef NFShmCountMinSketch<uint64_t, 2720, 5, 16> NFShmBenchCms;
+
+static const size_t s_sketchSizes[] = {1000, 10000, 100000, 1000000, 10000000};
+
+/**
+ * @brief 同一个基数跑若干组互不相交的key, 统计相对误差的平均绝对值和最大值.
+ * seq是连续整数(玩家id, 自增流水号), 第t组从t << 40开始; rand是随机64位数.
+ * 整数key的std::hash是原值, 这两组的误差应该一样, 都在relative_error()附近
+ */
+static void NFShmBenchHllRun(NFShmBench& bench, size_t n)
+{
+    int trials = (int) std::min<size_t>(16, std::max<size_t>(2, 4000000 / n));
+    std::unique_ptr<NFShmBenchHll> pHll(new NFShmBenchHll());
+    std::mt19937_64 rng(20261017 + n);
+    double seqSum = 0, seqMax = 0, randSum = 0, randMax = 0;
+    for (int t = 0; t < trials; t++)
+    {
+        pHll->clear();
+        uint64_t base = (uint64_t) t << 40;
+        uint64_t start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            pHll->add<uint64_t>(base + i);
+        }
+        bench.Report("NFShmHyperLogLog<14>/seq", "add", n, NFShmBench::Now() - start, n);
+        double err = fabs(pHll->estimate() / (double) n - 1.0);
+        seqSum += err;
+        seqMax = std::max(seqMax, err);
+
+        pHll->clear();
+        start = NFShmBench::Now();
+        for (size_t i = 0; i < n; i++)
+        {
+            pHll->add<uint64_t>(rng());
+        }
+        bench.Report("NFShmHyperLogLog<14>/rand", "add", n, NFShmBench::Now() - start, n);
+        err = fabs(pHll->estimate() / (double) n - 1.0);
+        randSum += err;
+        randMax = std::max(randMax, err);
+    }
+    bench.ReportValue("NFShmHyperLogLog<14>/seq", "mean_abs_err", n, seqSum / trials);
+    bench.ReportValue("NFShmHyperLogLog<14>/seq", "max_abs_err", n, seqMax);
+    bench.ReportValue("NFShmHyperLogLog<14>/rand", "mean_abs_err", n, randSum / trials);
+    bench.ReportValue("NFShmHyperLogLog<14>/rand", "max_abs_err", n, randMax);
+    bench.ReportValue("NFShmHyperLogLog<14>", "std_err", n, NFShmBenchHll::relative_error());
+    bench.ReportValue("NFShmHyperLogLog<14>", "bytes", n, (double) sizeof(NFShmBenchHll));
+
+    //超过4倍理论误差几乎不可能(>4 sigma), 出现说明hash没有打散
+    if (seqMax > 4 * NFShmBenchHll::relative_error() || randMax > 4 * NFShmBenchHll::relative_error())
+    {
+        bench.Note(("sketch: HyperLogLog error at n=" + std::to_string(n) + " is above 4x the standard error").c_str());
+    }
+
+    uint64_t sum = 0;
+    int passes = NFShmBench::Passes(n);
+    NFSHM_BENCH_TIME(bench, "NFShmHyperLogLog<14>", "estimate", n, passes, for (int p = 0; p < passes; p++)
+                     {
+                         sum += (uint64_t) pHll->estimate();
+                     });
+    std::unique_ptr<NFShmBenchHll> pOther(new NFShmBenchHll(*pHll));
+    NFSHM_BENCH_TIME(bench, "NFShmHyperLogLog<14>", "merge", n, passes, for (int p = 0; p < passes; p++)
+                     {
+                         pOther->merge(*pHll);
+                     });
+
+    //精确去重的对照, 内存随基数线性增长
+    if (n <= 1000000)
+    {
+        std::unordered_set<uint64_t> exact;
+        exact.reserve(n);
+        NFSHM_BENCH_TIME(bench, "std::unordered_set", "add", n, n, for (size_t i = 0; i < n; i++)
+                         {
+                             exact.insert(i);
+                         });
+        sum += exact.size();
+    }
+    NFShmBench::Keep(sum);
+}
+
+/**
+ * @brief 10万个物品id, 按Zipf(s=1)分布产生n次购买. 统计:
+ * avg_err: 所有出现过的key的(估计值 - 真实值)的平均; max_err_ratio: 最大误差 / error_bound();
+ * over_bound: 误差超过error_bound()的key的比例, 理论上不超过e^(-DEPTH); topk_recall: 真实top16在sketch的top16里的比例
+ */
+static void NFShmBenchCmsRun(NFShmBench& bench, size_t n)
+{
+    const size_t UNIVERSE = 100000;
+    std::vector<double> cdf(UNIVERSE);
+    double acc = 0;
+    for (size_t i = 0; i < UNIVERSE; i++)
+    {
+        acc += 1.0 / (double) (i + 1);
+        cdf[i] = acc;
+    }
+    std::mt19937_64 rng(20261017 + n);
+    std::uniform_real_distribution<double> dist(0, acc);
+    std::vector<uint64_t> stream(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+        stream[i] = NFShmBench::Key(std::min(rank, UNIVERSE - 1));
+    }
+
+    std::unordered_map<uint64_t, uint32_t> exact;
+    exact.reserve(UNIVERSE);
+    NFSHM_BENCH_TIME(bench, "std::unordered_map", "add", n, n, for (size_t i = 0; i < n; i++)
+                     {
+                         exact[stream[i]]++;
+                     });
+    std::vector<std::pair<uint32_t, uint64_t> > trueTop;
+    for (auto it = exact.begin(); it != exact.end(); ++it)
+    {
+        trueTop.push_back(std::make_pair(it->second, it->first));
+    }
+    std::sort(trueTop.rbegin(), trueTop.rend());
+    trueTop.resize(std::min<size_t>(trueTop.size(), 16));
+
+    std::unique_ptr<NFShmBenchCms> pCms(new NFShmBenchCms());
+    for (int mode = 0; mode < 2; mode++)
+    {
+        const char* name = mode == 0 ? "NFShmCountMinSketch/add" : "NFShmCountMinSketch/add_atomic";
+        pCms->clear();
+        if (mode == 0)
+        {
+            NFSHM_BENCH_TIME(bench, name, "add", n, n, for (size_t i = 0; i < n; i++)
+                             {
+                                 pCms->add(stream[i]);
+                             });
+        }
+        else
+        {
+            NFSHM_BENCH_TIME(bench, name, "add", n, n, for (size_t i = 0; i < n; i++)
+                             {
+                                 pCms->add_atomic(stream[i]);
+                             });
+        }
+
+        double errSum = 0, errMax = 0;
+        size_t over = 0;
+        double bound = pCms->error_bound();
+        for (auto it = exact.begin(); it != exact.end(); ++it)
+        {
+            uint32_t est = pCms->estimate(it->first);
+            if (est < it->second)
+            {
+                bench.Note("sketch: CountMinSketch estimate below the true count");
+            }
+            double err = (double) est - (double) it->second;
+            errSum += err;
+            errMax = std::max(errMax, err);
+            over += err > bound;
+        }
+        bench.ReportValue(name, "avg_err", n, errSum / (double) exact.size());
+        bench.ReportValue(name, "max_err_ratio", n, errMax / bound);
+        bench.ReportValue(name, "over_bound", n, (double) over / (double) exact.size());
+
+        std::vector<std::pair<uint64_t, uint64_t> > top;
+        pCms->top_k(top);
+        size_t recall = 0;
+        for (size_t i = 0; i < trueTop.size(); i++)
+        {
+            for (size_t j = 0; j < top.size(); j++)
+            {
+                recall += top[j].first == trueTop[i].second;
+            }
+        }
+        bench.ReportValue(name, "topk_recall", n, (double) recall / (double) trueTop.size());
+    }
+    bench.ReportValue("NFShmCountMinSketch", "bytes", n, (double) sizeof(NFShmBenchCms));
+    bench.ReportValue("NFShmCountMinSketch", "error_probability", n, NFShmBenchCms::error_probability());
+
+    uint64_t sum = 0;
+    NFSHM_BENCH_TIME(bench, "NFShmCountMinSketch", "estimate", n, n, for (size_t i = 0; i < n; i++)
+                     {
+                         sum += pCms->estimate(stream[i]);
+                     });
+    NFShmBench::Keep(sum);
+}
+
+NFSHM_BENCH_SUITE(sketch)
+{
+    //sketch的大小固定, n列对HLL是不同key的个数, 对CMS是事件个数
+    for (size_t i = 0; i < sizeof(s_sketchSizes) / sizeof(s_sketchSizes[0]); i++)
+    {
+        size_t n = s_sketchSizes[i];
+        if (!bench.WantSize(n))
+        {
+            continue;
+        }
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            NFShmBenchHllRun(bench, n);
+            NFShmBenchCmsRun(bench, n);
+        }
+    }
+}
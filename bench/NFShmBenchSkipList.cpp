@@ -0,0 +1,191 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchSkipList.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmSkipList.h"
+#include <map>
+
+/**
+ * @brief 排行榜场景: key是分数(各不相同), value是角色id.
+ * 对照组是std::multimap(跳表允许重复分数), 用arena分配器让节点连续, 否则它的find会被malloc的碎片拖慢.
+ * NFShmTree实例化时编译不过, 有序容器只能和std比
+ */
+typedef std::multimap<int64_t, uint64_t, std::less<int64_t>, NFShmBenchArenaAllocator<std::pair<const int64_t, uint64_t> > >
+        NFShmBenchRankMap;
+
+static const int NFSHM_BENCH_RANGE_LEN = 100;
+
+inline int64_t NFShmBenchScore(size_t i)
+{
+    return (int64_t) NFShmBench::Key(i);
+}
+
+template<int N>
+struct NFShmBenchSkipListSize
+{
+    typedef NFShmSkipList<int64_t, uint64_t, N> SkipList;
+
+    static void Run(NFShmBench& bench)
+    {
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            std::unique_ptr<SkipList> pList(new SkipList());
+            RunSkipList(bench, *pList);
+
+            NFShmBenchArena arena;
+            NFShmBenchRankMap map{std::less<int64_t>(), NFShmBenchArenaAllocator<std::pair<const int64_t, uint64_t> >(&arena)};
+            RunMap(bench, map);
+        }
+    }
+
+    static void RunSkipList(NFShmBench& bench, SkipList& l)
+    {
+        const char* name = "NFShmSkipList";
+        int passes = NFShmBench::Passes(N);
+        uint64_t ops = (uint64_t) passes * N;
+        uint64_t sum = 0;
+        NFSHM_BENCH_TIME(bench, name, "insert", N, N, for (int i = 0; i < N; i++)
+                         {
+                             l.insert(NFShmBenchScore(i), (uint64_t) i);
+                         });
+        NFSHM_BENCH_TIME(bench, name, "find_hit", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += l.find(NFShmBenchScore(i))->second;
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "find_miss", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += l.find(NFShmBenchScore(N + i)) == l.end();
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "rank", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += l.rank_of(NFShmBenchScore(i));
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "at_rank", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += l.at_rank(NFShmBench::Key(i) % N)->second;
+                             }
+                         });
+
+        //一次取从某个分数开始的100个, ops按取到的元素个数算
+        int ranges = std::max(1, (int) (NFShmBench::DEFAULT_OPS / NFSHM_BENCH_RANGE_LEN));
+        NFSHM_BENCH_TIME(bench, name, "range_100", N, (uint64_t) ranges * NFSHM_BENCH_RANGE_LEN, for (int i = 0; i < ranges; i++)
+                         {
+                             int start = (int) (NFShmBench::Key(i) % N);
+                             sum += l.range_by_rank(start, start + NFSHM_BENCH_RANGE_LEN - 1,
+                                                    [&sum](const typename SkipList::value_type& v) { sum += v.second; });
+                         });
+        NFSHM_BENCH_TIME(bench, name, "iterate", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (auto it = l.begin(); it != l.end(); ++it)
+                             {
+                                 sum += it->second;
+                             }
+                         });
+
+        //分数变化: 删掉旧分数再插入新分数, 规模不变
+        NFSHM_BENCH_TIME(bench, name, "update", N, NFShmBench::DEFAULT_OPS, for (int i = 0; i < NFShmBench::DEFAULT_OPS; i++)
+                         {
+                             sum += l.erase(NFShmBenchScore(i));
+                             l.insert(NFShmBenchScore(i + N), (uint64_t) i);
+                         });
+        if (!l.verify() || l.size() != (size_t) N)
+        {
+            bench.Note(("skip_list: verify failed after update at n=" + std::to_string(N)).c_str());
+        }
+        NFSHM_BENCH_TIME(bench, name, "erase", N, N, for (int i = NFShmBench::DEFAULT_OPS; i < NFShmBench::DEFAULT_OPS + N; i++)
+                         {
+                             sum += l.erase(NFShmBenchScore(i));
+                         });
+        if (!l.empty())
+        {
+            bench.Note(("skip_list: erase left elements at n=" + std::to_string(N)).c_str());
+        }
+        NFShmBench::Keep(sum);
+    }
+
+    static void RunMap(NFShmBench& bench, NFShmBenchRankMap& m)
+    {
+        const char* name = "std::multimap";
+        int passes = NFShmBench::Passes(N);
+        uint64_t ops = (uint64_t) passes * N;
+        uint64_t sum = 0;
+        NFSHM_BENCH_TIME(bench, name, "insert", N, N, for (int i = 0; i < N; i++)
+                         {
+                             m.insert(std::make_pair(NFShmBenchScore(i), (uint64_t) i));
+                         });
+        NFSHM_BENCH_TIME(bench, name, "find_hit", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += m.find(NFShmBenchScore(i))->second;
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "find_miss", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (int i = 0; i < N; i++)
+                             {
+                                 sum += m.find(NFShmBenchScore(N + i)) == m.end();
+                             }
+                         });
+
+        //红黑树没有跨度, 求名次和按名次取都要从头数, O(n), 只做少量次数
+        int queries = std::max(16, std::min(N, (1 << 24) / N));
+        NFSHM_BENCH_TIME(bench, name, "rank", N, queries, for (int i = 0; i < queries; i++)
+                         {
+                             sum += std::distance(m.begin(), m.lower_bound(NFShmBenchScore(i)));
+                         });
+        NFSHM_BENCH_TIME(bench, name, "at_rank", N, queries, for (int i = 0; i < queries; i++)
+                         {
+                             sum += std::next(m.begin(), NFShmBench::Key(i) % N)->second;
+                         });
+        //按分数定位起点再往后走100个, 不是按名次, 对std::multimap是最有利的写法
+        int ranges = std::max(1, (int) (NFShmBench::DEFAULT_OPS / NFSHM_BENCH_RANGE_LEN));
+        NFSHM_BENCH_TIME(bench, name, "range_100", N, (uint64_t) ranges * NFSHM_BENCH_RANGE_LEN, for (int i = 0; i < ranges; i++)
+                         {
+                             auto it = m.lower_bound(NFShmBenchScore(i % N));
+                             for (int k = 0; k < NFSHM_BENCH_RANGE_LEN && it != m.end(); k++, ++it)
+                             {
+                                 sum += it->second;
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "iterate", N, ops, for (int p = 0; p < passes; p++)
+                         {
+                             for (auto it = m.begin(); it != m.end(); ++it)
+                             {
+                                 sum += it->second;
+                             }
+                         });
+        NFSHM_BENCH_TIME(bench, name, "update", N, NFShmBench::DEFAULT_OPS, for (int i = 0; i < NFShmBench::DEFAULT_OPS; i++)
+                         {
+                             sum += m.erase(NFShmBenchScore(i));
+                             m.insert(std::make_pair(NFShmBenchScore(i + N), (uint64_t) i));
+                         });
+        NFSHM_BENCH_TIME(bench, name, "erase", N, N, for (int i = NFShmBench::DEFAULT_OPS; i < NFShmBench::DEFAULT_OPS + N; i++)
+                         {
+                             sum += m.erase(NFShmBenchScore(i));
+                         });
+        NFShmBench::Keep(sum);
+    }
+};
+
+NFSHM_BENCH_SUITE(skip_list)
+{
+    NFShmBenchForEachSize<NFShmBenchSkipListSize>(bench);
+}
@@ -0,0 +1,209 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchStringCompare.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmString.h"
+#include <map>
+
+typedef NFShmString<64> NFShmBenchCmpKey;
+
+/**
+ * @brief 改之前的比较: 先按较短的长度memcmp, 再比长度(原来的_M_compare), ==也是走这条路
+ */
+struct NFShmBenchOldEqual
+{
+    bool operator()(const NFShmBenchCmpKey& x, const NFShmBenchCmpKey& y) const
+    {
+        int r = memcmp(x.data(), y.data(), std::min(x.size(), y.size()));
+        return r == 0 && x.size() == y.size();
+    }
+
+    //和const char*比较时每次先Traits::length
+    bool operator()(const NFShmBenchCmpKey& x, const char* s) const
+    {
+        size_t n = strlen(s);
+        int r = memcmp(x.data(), s, std::min(x.size(), n));
+        return r == 0 && x.size() == n;
+    }
+};
+
+struct NFShmBenchOldLess
+{
+    bool operator()(const NFShmBenchCmpKey& x, const NFShmBenchCmpKey& y) const
+    {
+        int r = memcmp(x.data(), y.data(), std::min(x.size(), y.size()));
+        return r != 0 ? r < 0 : x.size() < y.size();
+    }
+};
+
+/**
+ * @brief 所有key共享一段长前缀, 比较时前8个字节区分不开, 是前缀比较最差的情况
+ */
+inline std::string NFShmBenchCmpKeyText(size_t i)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "player_guild_member_%08u", NFShmBench::Key(i) % 100000000u);
+    return buf;
+}
+
+/**
+ * @brief 变化的部分在最前面, 大部分比较在前8个字节就能分出大小
+ */
+inline std::string NFShmBenchCmpPrefixKeyText(size_t i)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%08u_guild_member", NFShmBench::Key(i) % 100000000u);
+    return buf;
+}
+
+template<class Less>
+void NFShmBenchCmpOrdered(NFShmBench& bench, const char* name, size_t n, const std::vector<NFShmBenchCmpKey>& hit,
+                          const std::vector<NFShmBenchCmpKey>& miss)
+{
+    typedef std::pair<const NFShmBenchCmpKey, int> Value;
+    NFShmBenchArena arena;
+    std::map<NFShmBenchCmpKey, int, Less, NFShmBenchArenaAllocator<Value> > map{Less(), NFShmBenchArenaAllocator<Value>(&arena)};
+    for (size_t i = 0; i < n; i++)
+    {
+        map.insert(std::make_pair(hit[i], (int) i));
+    }
+    NFShmBenchCmpFind(bench, name, n, map, hit, miss);
+    map.clear();
+}
+
+template<class Map>
+void NFShmBenchCmpFind(NFShmBench& bench, const char* name, size_t n, const Map& m, const std::vector<NFShmBenchCmpKey>& hit,
+                       const std::vector<NFShmBenchCmpKey>& miss)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t ops = (uint64_t) passes * n;
+    uint64_t sum = 0;
+    NFSHM_BENCH_TIME(bench, name, "find_hit", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find(hit[i]) != m.end();
+                         }
+                     });
+    NFSHM_BENCH_TIME(bench, name, "find_miss", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find(miss[i]) == m.end();
+                         }
+                     });
+    NFShmBench::Keep(sum);
+}
+
+template<class Eq, class Rhs>
+void NFShmBenchCmpEqual(NFShmBench& bench, const char* name, const char* op, size_t n, const std::vector<NFShmBenchCmpKey>& lhs,
+                        const std::vector<Rhs>& rhs)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t sum = 0;
+    Eq eq;
+    NFSHM_BENCH_TIME(bench, name, op, n, (uint64_t) passes * n, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += eq(lhs[i], rhs[i]);
+                         }
+                     });
+    NFShmBench::Keep(sum);
+}
+
+struct NFShmBenchNewEqual
+{
+    template<class Rhs>
+    bool operator()(const NFShmBenchCmpKey& x, const Rhs& y) const
+    {
+        return x == y;
+    }
+};
+
+struct NFShmBenchNewLess
+{
+    bool operator()(const NFShmBenchCmpKey& x, const NFShmBenchCmpKey& y) const
+    {
+        return x < y;
+    }
+};
+
+template<int N>
+struct NFShmBenchStringCompareSize
+{
+    static void Run(NFShmBench& bench)
+    {
+        if (N > 1000000)
+        {
+            bench.Note("string_compare: skip 10M");
+            return;
+        }
+        std::vector<NFShmBenchCmpKey> hit(N), miss(N), same(N), near(N);
+        std::vector<std::string> sameStr(N);
+        std::vector<const char*> sameCStr(N);
+        std::vector<NFShmBenchCmpKey> prefixHit(N), prefixMiss(N);
+        for (int i = 0; i < N; i++)
+        {
+            prefixHit[i] = NFShmBenchCmpPrefixKeyText(i);
+            prefixMiss[i] = NFShmBenchCmpPrefixKeyText(N + i);
+            hit[i] = NFShmBenchCmpKeyText(i);
+            miss[i] = NFShmBenchCmpKeyText(N + i);
+            sameStr[i] = hit[i].ToString();
+            same[i] = sameStr[i];
+            //同样长度, 只有最后一个字节不同
+            near[i] = hit[i];
+            near[i][near[i].size() - 1] = 'x';
+        }
+        for (int i = 0; i < N; i++)
+        {
+            sameCStr[i] = sameStr[i].c_str();
+        }
+
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            NFShmBenchCmpEqual<NFShmBenchOldEqual>(bench, "memcmp+length(old)", "equal", N, hit, same);
+            NFShmBenchCmpEqual<NFShmBenchNewEqual>(bench, "operator==", "equal", N, hit, same);
+            NFShmBenchCmpEqual<NFShmBenchOldEqual>(bench, "memcmp+length(old)", "not_equal_tail", N, hit, near);
+            NFShmBenchCmpEqual<NFShmBenchNewEqual>(bench, "operator==", "not_equal_tail", N, hit, near);
+            NFShmBenchCmpEqual<NFShmBenchOldEqual>(bench, "strlen+memcmp(old)", "equal_cstr", N, hit, sameCStr);
+            NFShmBenchCmpEqual<NFShmBenchNewEqual>(bench, "operator==", "equal_cstr", N, hit, sameCStr);
+
+            {
+                typedef NFShmHashMap<NFShmBenchCmpKey, int, N, std::hash<NFShmBenchCmpKey>, NFShmBenchOldEqual> OldMap;
+                std::unique_ptr<OldMap> pMap(new OldMap());
+                for (int i = 0; i < N; i++)
+                {
+                    pMap->insert(std::make_pair(hit[i], i));
+                }
+                NFShmBenchCmpFind(bench, "NFShmHashMap(old equal)", N, *pMap, hit, miss);
+            }
+            {
+                typedef NFShmHashMap<NFShmBenchCmpKey, int, N> NewMap;
+                std::unique_ptr<NewMap> pMap(new NewMap());
+                for (int i = 0; i < N; i++)
+                {
+                    pMap->insert(std::make_pair(hit[i], i));
+                }
+                NFShmBenchCmpFind(bench, "NFShmHashMap", N, *pMap, hit, miss);
+            }
+            NFShmBenchCmpOrdered<NFShmBenchOldLess>(bench, "std::map(old less)", N, hit, miss);
+            NFShmBenchCmpOrdered<NFShmBenchNewLess>(bench, "std::map(operator<)", N, hit, miss);
+            NFShmBenchCmpOrdered<NFShmBenchOldLess>(bench, "std::map(old less)/prefix_key", N, prefixHit, prefixMiss);
+            NFShmBenchCmpOrdered<NFShmBenchNewLess>(bench, "std::map(operator<)/prefix_key", N, prefixHit, prefixMiss);
+        }
+    }
+};
+
+NFSHM_BENCH_SUITE(string_compare)
+{
+    NFShmBenchForEachSize<NFShmBenchStringCompareSize>(bench);
+    bench.Note("string_compare: NFShmTree does not compile when instantiated, the ordered lookups use std::map with the old/new less");
+}
@@ -0,0 +1,96 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchStringFormat.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmString.h"
+
+/**
+ * @brief 每种写法格式化同样的内容: NF_FORMAT生成std::string再赋值 vs 直接写进NFShmString.
+ * 和容器规模无关, 不看--sizes, n列是目标字符串的MAX_SIZE
+ */
+template<int MAX_SIZE>
+void NFShmBenchStringFormatRun(NFShmBench& bench)
+{
+    const int ops = NFShmBench::DEFAULT_OPS;
+    uint64_t sum = 0;
+    NFShmString<MAX_SIZE> str;
+
+    //短key, 在std::string的SSO之内
+    NFSHM_BENCH_TIME(bench, "NF_FORMAT+assign", "key", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = NF_FORMAT("{}_{}", i, 1001);
+                         sum += str.size();
+                     });
+    NFSHM_BENCH_TIME(bench, "format_to", "key", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         format_to(str, "{}_{}", i, 1001);
+                         sum += str.size();
+                     });
+
+    //超过SSO的日志/展示串, NF_FORMAT要分配一次堆内存
+    NFSHM_BENCH_TIME(bench, "NF_FORMAT+assign", "text", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = NF_FORMAT("role:{} level:{} gold:{} zone:{}", 100000000 + i, i & 255, 1234567, "s1");
+                         sum += str.size();
+                     });
+    NFSHM_BENCH_TIME(bench, "format_to", "text", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         format_to(str, "role:{} level:{} gold:{} zone:{}", 100000000 + i, i & 255, 1234567, "s1");
+                         sum += str.size();
+                     });
+
+    //逐段拼接: 前缀 + 整数 + 浮点
+    NFSHM_BENCH_TIME(bench, "NF_FORMAT+append", "append_num", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = "hp:";
+                         str.append(NF_FORMAT("{}", i));
+                         str.append(",rate:");
+                         str.append(NF_FORMAT("{}", i * 0.25));
+                         sum += str.size();
+                     });
+    NFSHM_BENCH_TIME(bench, "to_string+append", "append_num", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = "hp:";
+                         str.append(std::to_string(i));
+                         str.append(",rate:");
+                         str.append(std::to_string(i * 0.25));
+                         sum += str.size();
+                     });
+    NFSHM_BENCH_TIME(bench, "append_int/append_double", "append_num", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = "hp:";
+                         str.append_int(i);
+                         str.append(",rate:");
+                         str.append_double(i * 0.25);
+                         sum += str.size();
+                     });
+
+    //结果比MAX_SIZE长, 两种写法都截断
+    std::string longArg(MAX_SIZE * 2, 'x');
+    NFSHM_BENCH_TIME(bench, "NF_FORMAT+assign", "truncate", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         str = NF_FORMAT("{}:{}", i, longArg);
+                         sum += str.size();
+                     });
+    NFSHM_BENCH_TIME(bench, "format_to", "truncate", MAX_SIZE, ops, for (int i = 0; i < ops; i++)
+                     {
+                         format_to(str, "{}:{}", i, longArg);
+                         sum += str.size();
+                     });
+    NFShmBench::Keep(sum);
+}
+
+NFSHM_BENCH_SUITE(string_format)
+{
+    for (int r = 0; r < bench.Repeat(); r++)
+    {
+        NFShmBenchStringFormatRun<64>(bench);
+        NFShmBenchStringFormatRun<256>(bench);
+    }
+}
@@ -0,0 +1,135 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchStringHash.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmString.h"
+#include <unordered_map>
+
+typedef NFShmString<64> NFShmBenchStrKey;
+
+/**
+ * @brief 改之前的hash: 先ToString()构造一个std::string再求hash, 每次都要分配一次堆内存
+ */
+struct NFShmBenchToStringHash
+{
+    size_t operator()(const NFShmBenchStrKey& key) const
+    {
+        return std::hash<std::string>()(key.ToString());
+    }
+};
+
+/**
+ * @brief 长度超过std::string的SSO(15字节), 旧的hash每次都会malloc, 和线上的"前缀_id_后缀"一类key接近
+ */
+inline std::string NFShmBenchStrKeyText(size_t i)
+{
+    return "player_" + std::to_string(NFShmBench::Key(i)) + "_inventory";
+}
+
+template<class Map, class Probe>
+void NFShmBenchStringFind(NFShmBench& bench, const char* name, size_t n, Map& m, const std::vector<Probe>& hit, const std::vector<Probe>& miss)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t ops = (uint64_t) passes * n;
+    uint64_t sum = 0;
+    NFSHM_BENCH_TIME(bench, name, "find_hit", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find(hit[i])->second;
+                         }
+                     });
+    NFSHM_BENCH_TIME(bench, name, "find_miss", n, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += m.find(miss[i]) == m.end();
+                         }
+                     });
+    NFShmBench::Keep(sum);
+}
+
+template<class Hash, class Key>
+void NFShmBenchStringHashOnly(NFShmBench& bench, const char* name, size_t n, const std::vector<Key>& keys)
+{
+    int passes = NFShmBench::Passes(n);
+    uint64_t sum = 0;
+    Hash hash;
+    NFSHM_BENCH_TIME(bench, name, "hash", n, (uint64_t) passes * n, for (int p = 0; p < passes; p++)
+                     {
+                         for (size_t i = 0; i < n; i++)
+                         {
+                             sum += hash(keys[i]);
+                         }
+                     });
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchStringHashSize
+{
+    static void Run(NFShmBench& bench)
+    {
+        std::vector<NFShmBenchStrKey> hit(N), miss(N);
+        std::vector<std::string> hitStr(N), missStr(N);
+        std::vector<std::string_view> hitView(N);
+        for (int i = 0; i < N; i++)
+        {
+            hitStr[i] = NFShmBenchStrKeyText(i);
+            missStr[i] = NFShmBenchStrKeyText(N + i);
+            hit[i] = hitStr[i];
+            miss[i] = missStr[i];
+            hitView[i] = hitStr[i];
+        }
+
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            NFShmBenchStringHashOnly<NFShmBenchToStringHash>(bench, "ToString+std::hash", N, hit);
+            NFShmBenchStringHashOnly<std::hash<NFShmBenchStrKey> >(bench, "std::hash<NFShmString>", N, hit);
+            NFShmBenchStringHashOnly<std::hash<std::string> >(bench, "std::hash<std::string>", N, hitStr);
+
+            {
+                typedef NFShmHashMap<NFShmBenchStrKey, int, N, NFShmBenchToStringHash> OldMap;
+                std::unique_ptr<OldMap> pMap(new OldMap());
+                for (int i = 0; i < N; i++)
+                {
+                    pMap->insert(std::make_pair(hit[i], i));
+                }
+                NFShmBenchStringFind(bench, "NFShmHashMap(ToString hash)", N, *pMap, hit, miss);
+            }
+            {
+                typedef NFShmHashMap<NFShmBenchStrKey, int, N> NewMap;
+                std::unique_ptr<NewMap> pMap(new NewMap());
+                for (int i = 0; i < N; i++)
+                {
+                    pMap->insert(std::make_pair(hit[i], i));
+                }
+                NFShmBenchStringFind(bench, "NFShmHashMap", N, *pMap, hit, miss);
+                //异构查找: 拿std::string_view直接查, 不构造NFShmString
+                std::vector<std::string_view> missView(missStr.begin(), missStr.end());
+                NFShmBenchStringFind(bench, "NFShmHashMap(string_view)", N, *pMap, hitView, missView);
+            }
+            {
+                std::unordered_map<std::string, int> map;
+                map.reserve(N);
+                for (int i = 0; i < N; i++)
+                {
+                    map.insert(std::make_pair(hitStr[i], i));
+                }
+                NFShmBenchStringFind(bench, "std::unordered_map<std::string>", N, map, hitStr, missStr);
+            }
+        }
+    }
+};
+
+NFSHM_BENCH_SUITE(string_hash)
+{
+    NFShmBenchForEachSize<NFShmBenchStringHashSize>(bench);
+}
@@ -0,0 +1,136 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmBenchStringInit.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmVector.h"
+#include "NFComm/NFShmStl/NFShmString.h"
+
+/**
+ * @brief 字符串较多的结构, 和线上的道具/邮件结构差不多大
+ */
+struct NFShmBenchItem
+{
+    //有自己的构造函数, 和共享内存里的结构一样; 否则push_back()的值初始化会先把整个对象清零, 测不出字符串构造的差别
+    NFShmBenchItem() : m_id(0)
+    {
+    }
+
+    int m_id;
+    NFShmString<32> m_name;
+    NFShmString<256> m_desc;
+    NFShmString<64> m_tag;
+};
+
+/**
+ * @brief 模拟改之前的构造: 每个NFShmString构造时清零整个缓冲区(等价于定义NF_SHM_STRING_ZERO_TAIL=1).
+ * 宏是全局的, 同一个程序里不能两种都编, 这里构造后对空串调用zero_tail(), 写的字节数和原来的memset一样
+ */
+struct NFShmBenchItemZeroed : public NFShmBenchItem
+{
+    NFShmBenchItemZeroed()
+    {
+        m_name.zero_tail();
+        m_desc.zero_tail();
+        m_tag.zero_tail();
+    }
+};
+
+template<class Item, int N>
+void NFShmBenchItemFill(NFShmBench& bench, const char* vecName, const char* mapName)
+{
+    int passes = std::max(1, NFShmBench::Passes(N) / 8);
+    uint64_t ops = (uint64_t) passes * N;
+    uint64_t sum = 0;
+    uint64_t ns = 0;
+
+    //vector: push_back()原地默认构造, 再写短的名字
+    {
+        std::unique_ptr<NFShmVector<Item, N> > pVec(new NFShmVector<Item, N>());
+        //先不计时地填一遍, 把页面都碰过, 只测构造和写入
+        for (int i = 0; i < N; i++)
+        {
+            pVec->push_back();
+        }
+        for (int p = 0; p < passes; p++)
+        {
+            pVec->clear();
+            uint64_t start = NFShmBench::Now();
+            for (int i = 0; i < N; i++)
+            {
+                pVec->push_back();
+                Item& item = pVec->back();
+                item.m_id = i;
+                item.m_name = "item";
+            }
+            ns += NFShmBench::Now() - start;
+            sum += pVec->size();
+        }
+        bench.Report(vecName, "fill", N, ns, ops);
+    }
+
+    //hash map: insert(make_pair(id, Item()))要构造一个临时对象, 再拷贝进节点
+    {
+        std::unique_ptr<NFShmHashMap<int, Item, N> > pMap(new NFShmHashMap<int, Item, N>());
+        for (int i = 0; i < N; i++)
+        {
+            pMap->insert(std::make_pair(i, Item()));
+        }
+        ns = 0;
+        for (int p = 0; p < passes; p++)
+        {
+            pMap->clear();
+            uint64_t start = NFShmBench::Now();
+            for (int i = 0; i < N; i++)
+            {
+                Item item;
+                item.m_id = i;
+                item.m_name = "item";
+                pMap->insert(std::make_pair(i, item));
+            }
+            ns += NFShmBench::Now() - start;
+            sum += pMap->size();
+        }
+        bench.Report(mapName, "fill", N, ns, ops);
+    }
+
+    //单独的默认构造, 比如函数里的临时变量
+    NFSHM_BENCH_TIME(bench, vecName, "construct", N, ops, for (int p = 0; p < passes; p++)
+                     {
+                         for (int i = 0; i < N; i++)
+                         {
+                             Item item;
+                             NFShmBench::Keep(item);
+                         }
+                     });
+    NFShmBench::Keep(sum);
+}
+
+template<int N>
+struct NFShmBenchStringInitSize
+{
+    static void Run(NFShmBench& bench)
+    {
+        if (N > 1000000)
+        {
+            bench.Note("string_init: skip 10M, the vector and map of 360 byte items would need about 8GB");
+            return;
+        }
+        for (int r = 0; r < bench.Repeat(); r++)
+        {
+            NFShmBenchItemFill<NFShmBenchItemZeroed, N>(bench, "NFShmVector<Item>(zeroed)", "NFShmHashMap<int,Item>(zeroed)");
+            NFShmBenchItemFill<NFShmBenchItem, N>(bench, "NFShmVector<Item>", "NFShmHashMap<int,Item>");
+        }
+    }
+};
+
+NFSHM_BENCH_SUITE(string_init)
+{
+    NFShmBenchForEachSize<NFShmBenchStringInitSize>(bench);
+}
@@ -0,0 +1,253 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmCheck.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFComm/NFShmCore/NFShmMgr.h"
+#include "NFComm/NFShmStl/NFShmMultiIndex.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmHashMapWithList.h"
+#include "NFComm/NFShmStl/NFShmBloomFilter.h"
+#include <atomic>
+#include <thread>
+#include <map>
+#include <memory>
+#include <random>
+#include <cstdio>
+
+/**
+ * @brief 回归检查, 和bench一起由ctest跑, 只放性能测试顺带发现过的bug的最小复现
+ */
+static int s_checkFailed = 0;
+
+#define NFSHM_CHECK(expr) \
+    do { \
+        if (!(expr)) \
+        { \
+            fprintf(stderr, "%s:%d: CHECK %s failed\n", __FILE__, __LINE__, #expr); \
+            ++s_checkFailed; \
+        } \
+    } while (0)
+
+/**
+ * @brief 共享内存布局: 不开统计时hash表的大小必须和加StatsPolicy之前一样, 否则升级前后的段热恢复对不上.
+ * 数值是加统计之前的版本在x86_64上量出来的
+ */
+#if defined(__x86_64__)
+static_assert(sizeof(NFShmHashMap<int, int, 100>) == 4448, "NFShmHashMap layout changed with NFShmHashTableNoStats");
+static_assert(sizeof(NFShmHashMap<int64_t, std::string, 1000>) == 76048, "NFShmHashMap layout changed with NFShmHashTableNoStats");
+static_assert(sizeof(NFShmHashMapWithList<int, int, 100>) == 8520, "NFShmHashMapWithList layout changed with NFShmHashTableNoStats");
+#endif
+
+struct NFShmCheckPlayer
+{
+    int m_id;
+    int m_level;
+};
+
+typedef NFShmMultiIndex<NFShmCheckPlayer, 16,
+        NFShmHashedUnique<NFShmMemberKey<NFShmCheckPlayer, int, &NFShmCheckPlayer::m_id> >,
+        NFShmOrderedUnique<NFShmMemberKey<NFShmCheckPlayer, int, &NFShmCheckPlayer::m_level> > > NFShmCheckPlayerTable;
+
+typedef NFShmCheckPlayerTable::nth_index<0>::type NFShmCheckIdIndex;
+
+/**
+ * @brief 和id落在同一个桶里的第nth个(从0开始)更大的id
+ */
+static int NFShmCheckSameBucket(int id, int nth)
+{
+    for (int i = id + 1; i < 100000; i++)
+    {
+        if (NFShmCheckIdIndex::_M_bucket(i) == NFShmCheckIdIndex::_M_bucket(id) && nth-- == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief modify把key改成同一个桶里已有的key: 自己还挂在链上, 冲突的节点在链上的前面或后面都必须被发现
+ */
+static void NFShmCheckMultiIndexModifySameBucket()
+{
+    int other = NFShmCheckSameBucket(0, 0);
+    int free = NFShmCheckSameBucket(0, 1);
+    NFSHM_CHECK(other > 0 && free > 0);
+
+    for (int order = 0; order < 2; order++)
+    {
+        std::unique_ptr<NFShmCheckPlayerTable> pTable(new NFShmCheckPlayerTable());
+        if (order == 0)
+        {
+            pTable->insert(NFShmCheckPlayer{0, 100});
+            pTable->insert(NFShmCheckPlayer{other, 200});
+        }
+        else
+        {
+            pTable->insert(NFShmCheckPlayer{other, 200});
+            pTable->insert(NFShmCheckPlayer{0, 100});
+        }
+
+        //replace冲突时什么都不改
+        NFSHM_CHECK(!pTable->replace(pTable->get<0>().find(other), NFShmCheckPlayer{0, 300}));
+        NFSHM_CHECK(pTable->size() == 2);
+        NFSHM_CHECK(pTable->get<0>().find(other)->m_level == 200);
+        NFSHM_CHECK(pTable->verify());
+
+        //同桶但没有冲突的key可以改
+        NFSHM_CHECK(pTable->modify(pTable->get<0>().find(other), [free](NFShmCheckPlayer& p) { p.m_id = free; }));
+        NFSHM_CHECK(pTable->get<0>().count(free) == 1);
+        NFSHM_CHECK(pTable->verify());
+
+        //modify冲突时元素被删除, 打一条错误日志
+        uint64_t errors = NFLogErrorCount();
+        NFSHM_CHECK(!pTable->modify(pTable->get<0>().find(free), [](NFShmCheckPlayer& p) { p.m_id = 0; }));
+        NFSHM_CHECK(NFLogErrorCount() == errors + 1);
+        NFSHM_CHECK(pTable->size() == 1);
+        NFSHM_CHECK(pTable->get<0>().count(0) == 1);
+        NFSHM_CHECK(pTable->get<0>().find(0)->m_level == 100);
+        NFSHM_CHECK(pTable->verify());
+    }
+}
+
+/**
+ * @brief 有序唯一索引: 改成相邻元素的key, 自己的位置不变, 也必须检查出冲突
+ */
+static void NFShmCheckMultiIndexModifyOrdered()
+{
+    std::unique_ptr<NFShmCheckPlayerTable> pTable(new NFShmCheckPlayerTable());
+    pTable->insert(NFShmCheckPlayer{1, 5});
+    pTable->insert(NFShmCheckPlayer{2, 6});
+    NFSHM_CHECK(!pTable->modify(pTable->get<0>().find(1), [](NFShmCheckPlayer& p) { p.m_level = 6; }));
+    NFSHM_CHECK(pTable->get<1>().count(6) == 1);
+    NFSHM_CHECK(pTable->size() == 1);
+    NFSHM_CHECK(pTable->verify());
+}
+
+/**
+ * @brief 随机insert/modify/erase, 和std::map对比, id只有24个, 16个槽, 同桶冲突很频繁
+ */
+static void NFShmCheckMultiIndexRandom()
+{
+    std::mt19937 rng(20261017);
+    std::unique_ptr<NFShmCheckPlayerTable> pTable(new NFShmCheckPlayerTable());
+    std::map<int, int> ref;
+    //冲突的modify/insert每次都打错误日志, 这里是预期的, 只计数
+    NFLogQuiet() = true;
+    for (int step = 0; step < 200000; step++)
+    {
+        int id = (int) (rng() % 24);
+        int level = (int) (rng() % 24);
+        int op = (int) (rng() % 3);
+        bool levelUsed = false;
+        for (auto it = ref.begin(); it != ref.end(); ++it)
+        {
+            levelUsed |= it->first != id && it->second == level;
+        }
+        if (op == 0)
+        {
+            bool expect = !ref.count(id) && !levelUsed && ref.size() < 16;
+            bool got = pTable->insert(NFShmCheckPlayer{id, level}).second;
+            NFSHM_CHECK(got == expect);
+            if (got)
+            {
+                ref[id] = level;
+            }
+        }
+        else if (op == 1)
+        {
+            auto it = pTable->get<0>().find(id);
+            if (it == pTable->end())
+            {
+                continue;
+            }
+            int newId = (int) (rng() % 24);
+            bool expect = !(newId != id && ref.count(newId)) && !levelUsed;
+            bool got = pTable->modify(it, [newId, level](NFShmCheckPlayer& p) {
+                p.m_id = newId;
+                p.m_level = level;
+            });
+            NFSHM_CHECK(got == expect);
+            ref.erase(id);
+            if (got)
+            {
+                ref[newId] = level;
+            }
+        }
+        else
+        {
+            pTable->get<0>().erase(id);
+            ref.erase(id);
+        }
+
+        if (pTable->size() != ref.size() || !pTable->verify())
+        {
+            fprintf(stderr, "multi_index random: diverged at step %d\n", step);
+            ++s_checkFailed;
+            break;
+        }
+    }
+    NFLogQuiet() = false;
+}
+
+static uint64_t NFShmCheckKey64(uint64_t i, int round)
+{
+    return i * 0x9E3779B97F4A7C15ull + (uint64_t) round;
+}
+
+/**
+ * @brief 布谷鸟过滤器一直插到满, 另一个线程同时查已经插入完成的key, 踢出搬动指纹的过程中不能查不到
+ */
+static void NFShmCheckCuckooFilterConcurrentRead()
+{
+    typedef NFShmCuckooFilter<1 << 16> NFShmCheckFilter;
+    long misses = 0;
+    for (int round = 0; round < 8; round++)
+    {
+        std::unique_ptr<NFShmCheckFilter> pFilter(new NFShmCheckFilter());
+        std::atomic<int> published(0);
+        std::atomic<bool> done(false);
+        std::thread reader([&]() {
+            std::mt19937 rng(round);
+            while (!done.load(std::memory_order_relaxed))
+            {
+                int n = published.load(std::memory_order_acquire);
+                for (int k = 0; k < 64 && n > 0; k++)
+                {
+                    misses += !pFilter->contains_hash(NFShmCheckKey64(rng() % n, round));
+                }
+            }
+        });
+        for (int i = 0; i < (int) NFShmCheckFilter::slot_count() && pFilter->insert_hash(NFShmCheckKey64(i, round)); i++)
+        {
+            published.store(i + 1, std::memory_order_release);
+        }
+        done = true;
+        reader.join();
+        NFSHM_CHECK(pFilter->load_factor() > 0.9);
+    }
+    NFSHM_CHECK(misses == 0);
+}
+
+int main()
+{
+    NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_INIT);
+
+    NFShmCheckMultiIndexModifySameBucket();
+    NFShmCheckMultiIndexModifyOrdered();
+    NFShmCheckMultiIndexRandom();
+    NFShmCheckCuckooFilterConcurrentRead();
+
+    if (s_checkFailed > 0)
+    {
+        fprintf(stderr, "%d checks failed\n", s_checkFailed);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
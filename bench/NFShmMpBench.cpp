@@ -0,0 +1,846 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmMpBench.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmHashMapWithList.h"
+#include "NFComm/NFShmStl/NFShmRobinHoodMap.h"
+#include "NFComm/NFShmStl/NFShmSkipList.h"
+#include "NFComm/NFShmStl/NFShmCountMinSketch.h"
+#include "NFComm/NFShmStl/NFShmHyperLogLog.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <random>
+#include <unordered_set>
+
+/**
+ * @brief 多进程压测: 父进程shm_open/mmap一段共享内存, 用EN_OBJ_MODE_INIT构造容器并预先填好key,
+ * 再fork出若干读进程和写进程. 子进程先放掉继承来的映射, 重新shm_open/mmap(地址和父进程不同),
+ * 切到EN_OBJ_MODE_RECOVER在原地placement new, 走一遍ResumeInit, 和进程重启后attach一样.
+ * 所有子进程attach完以后一起开始跑, 每个操作单独计时记进直方图, 结束后父进程汇总p50/p99/p999, 吞吐和缺页次数,
+ * 最后检查容器的不变量(verify)以及和操作记录对得上的结果(更新次数, 计数总和, 基数).
+ *
+ * 哈希表和跳表只能单写, 读写都用段里的进程间读写锁(写优先); sketch的add_atomic/add本身是多进程安全的, 不加锁.
+ * --lock=none可以去掉锁, 用来确认verify能发现并发写坏的容器.
+ * Dy系列容器保存了缓冲区指针, 不能在不同地址attach, 不在这里测.
+ *
+ * 输出每个容器一组行: create(父进程CreateInit+填数据, 一个样本), attach(每个子进程的ResumeInit, 一个进程一个样本),
+ * read/write/all(每个操作一个样本). 延迟包含加锁等锁的时间; 进程数多于CPU数时, p999和max里有调度的时间片.
+ *
+ * 用法: nfshm_mpbench --container=hash_map --readers=4 --writers=1 --ops=200000 --keys=100000
+ */
+
+#define NFSHM_MP_MAGIC 0x4E46534D50424E43ull
+#define NFSHM_MP_MAX_PROCS 64
+#define NFSHM_MP_CAPACITY (1 << 20)
+
+/**
+ * @brief 对数-线性直方图: 每个2的幂区间分16格, 相对误差不超过1/16, 固定8KB, 可以直接放在共享内存里
+ */
+struct NFShmMpHistogram
+{
+    enum
+    {
+        SUB_BITS = 4,
+        SUB_COUNT = 1 << SUB_BITS,
+        BUCKETS = 64 * SUB_COUNT,
+    };
+
+    static int Index(uint64_t v)
+    {
+        if (v < SUB_COUNT)
+        {
+            return (int) v;
+        }
+        int msb = 63 - __builtin_clzll(v);
+        return (msb - SUB_BITS + 1) * SUB_COUNT + (int) ((v >> (msb - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    /**
+     * @brief 格子的上界, 百分位数按上界报, 宁可偏大
+     */
+    static uint64_t Upper(int idx)
+    {
+        if (idx < SUB_COUNT)
+        {
+            return (uint64_t) idx;
+        }
+        int msb = idx / SUB_COUNT + SUB_BITS - 1;
+        uint64_t sub = (uint64_t) (idx % SUB_COUNT);
+        return ((SUB_COUNT + sub + 1) << (msb - SUB_BITS)) - 1;
+    }
+
+    void Add(uint64_t v)
+    {
+        ++m_count[Index(v)];
+        ++m_total;
+        if (v > m_max)
+        {
+            m_max = v;
+        }
+    }
+
+    void Merge(const NFShmMpHistogram& x)
+    {
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            m_count[i] += x.m_count[i];
+        }
+        m_total += x.m_total;
+        m_max = std::max(m_max, x.m_max);
+    }
+
+    uint64_t Percentile(double q) const
+    {
+        if (m_total == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = (uint64_t) ceil(q * (double) m_total);
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += m_count[i];
+            if (seen >= rank && m_count[i] > 0)
+            {
+                return std::min(Upper(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    uint64_t m_count[BUCKETS];
+    uint64_t m_total;
+    uint64_t m_max;
+};
+
+enum NFShmMpRole
+{
+    NFSHM_MP_READER = 0,
+    NFSHM_MP_WRITER = 1,
+};
+
+/**
+ * @brief 每个子进程的结果槽, 子进程写, 父进程在它退出后读
+ */
+struct NFShmMpSlot
+{
+    int m_role;
+    int m_ok;
+    uint64_t m_ops;
+    uint64_t m_updates;     //!<写进程做的原地更新次数, 用来和容器里的值对账
+    uint64_t m_attachNs;
+    uint64_t m_attachMinflt;
+    uint64_t m_minflt;
+    uint64_t m_majflt;
+    uint64_t m_sum;
+    NFShmMpHistogram m_hist;
+};
+
+struct NFShmMpHeader
+{
+    uint64_t m_magic;
+    pthread_rwlock_t m_lock;
+    int m_attached;
+    int m_go;
+    NFShmMpSlot m_slots[NFSHM_MP_MAX_PROCS];
+};
+
+struct NFShmMpOptions
+{
+    NFShmMpOptions() : m_readers(2), m_writers(1), m_ops(200000), m_keys(100000), m_hit(90), m_churn(20), m_lock(true),
+                       m_seed(20261017), m_timeout(300), m_json(false)
+    {
+    }
+
+    std::string m_container;
+    int m_readers;
+    int m_writers;
+    uint64_t m_ops;         //!<每个子进程的操作次数
+    int m_keys;
+    int m_hit;              //!<读进程查找命中的百分比
+    int m_churn;            //!<写进程的操作里删除再插入(移动节点)的百分比, 其余是原地更新
+    bool m_lock;
+    uint64_t m_seed;
+    int m_timeout;          //!<秒, 超时还没跑完的子进程被kill, 这次运行算失败(比如不加锁写坏了链表, 查找死循环)
+    bool m_json;
+    std::string m_out;
+};
+
+/**
+ * @brief 写进程的key和操作序列只由种子决定, 父进程verify时按同样的种子重放
+ */
+struct NFShmMpWriterOp
+{
+    uint64_t m_key;
+    bool m_churn;
+};
+
+inline NFShmMpWriterOp NFShmMpNextWrite(std::mt19937_64& rng, const NFShmMpOptions& opt)
+{
+    NFShmMpWriterOp op;
+    op.m_key = rng() % (uint64_t) opt.m_keys;
+    op.m_churn = (int) (rng() % 100) < opt.m_churn;
+    return op;
+}
+
+inline uint64_t NFShmMpProcSeed(const NFShmMpOptions& opt, int proc)
+{
+    return opt.m_seed + (uint64_t) proc * 7919;
+}
+
+/**
+ * @brief 哈希表/跳表: 预先插入keys个key, 值为0. 写进程原地更新是值+1, 删除再插入时带着原来的值,
+ * 所以结束时所有值的和必须等于所有写进程原地更新次数的和, 丢了更新或者节点就对不上
+ */
+template<class Map>
+struct NFShmMpMapWorkload
+{
+    static const bool LOCK_FREE = false;
+    typedef typename Map::value_type value_type;
+
+    static int MapKey(uint64_t k)
+    {
+        return (int) NFShmBench::Key(k);
+    }
+
+    static bool Fill(Map& m, const NFShmMpOptions& opt)
+    {
+        for (int i = 0; i < opt.m_keys; i++)
+        {
+            m.insert(value_type(MapKey(i), 0));
+        }
+        return m.size() == (size_t) opt.m_keys;
+    }
+
+    static uint64_t Read(Map& m, uint64_t k)
+    {
+        auto it = m.find(MapKey(k));
+        return it != m.end() ? (uint64_t) it->second + 1 : 0;
+    }
+
+    static bool Write(Map& m, const NFShmMpWriterOp& op)
+    {
+        int key = MapKey(op.m_key);
+        auto it = m.find(key);
+        if (it == m.end())
+        {
+            return false;
+        }
+        if (op.m_churn)
+        {
+            int64_t value = it->second;
+            m.erase(key);
+            m.insert(value_type(key, value));
+            return false;
+        }
+        ++it->second;
+        return true;
+    }
+
+    static bool Verify(const Map& m, const NFShmMpOptions& opt, uint64_t updates)
+    {
+        if (!m.verify())
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "mpbench verify() failed");
+            return false;
+        }
+        uint64_t sum = 0;
+        size_t count = 0;
+        for (auto it = m.begin(); it != m.end(); ++it)
+        {
+            sum += (uint64_t) it->second;
+            ++count;
+        }
+        CHECK_EXPR(count == (size_t) opt.m_keys, false, "mpbench size:{} keys:{}", count, opt.m_keys);
+        CHECK_EXPR(sum == updates, false, "mpbench value sum:{} updates:{}", sum, updates);
+        return true;
+    }
+};
+
+/**
+ * @brief Count-Min Sketch: 写进程add_atomic, 读进程estimate. 结束时total等于所有写次数, 每个key的估计值不小于重放得到的真实次数
+ */
+template<class Sketch>
+struct NFShmMpCmsWorkload
+{
+    static const bool LOCK_FREE = true;
+
+    static bool Fill(Sketch&, const NFShmMpOptions&)
+    {
+        return true;
+    }
+
+    static uint64_t Read(Sketch& s, uint64_t k)
+    {
+        return s.estimate(k);
+    }
+
+    static bool Write(Sketch& s, const NFShmMpWriterOp& op)
+    {
+        s.add_atomic(op.m_key);
+        return true;
+    }
+
+    static bool Verify(const Sketch& s, const NFShmMpOptions& opt, uint64_t updates)
+    {
+        CHECK_EXPR(s.total() == updates, false, "mpbench cms total:{} adds:{}", s.total(), updates);
+        std::vector<uint32_t> truth(opt.m_keys, 0);
+        for (int w = 0; w < opt.m_writers; w++)
+        {
+            std::mt19937_64 rng(NFShmMpProcSeed(opt, opt.m_readers + w));
+            for (uint64_t i = 0; i < opt.m_ops; i++)
+            {
+                ++truth[NFShmMpNextWrite(rng, opt).m_key];
+            }
+        }
+        for (int k = 0; k < opt.m_keys; k++)
+        {
+            CHECK_EXPR(s.estimate((uint64_t) k) >= truth[k], false, "mpbench cms key:{} estimate:{} below count:{}", k,
+                       s.estimate((uint64_t) k), truth[k]);
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief HyperLogLog: 写进程add, 读进程estimate. 结束时估计值和重放得到的精确基数相差不超过5倍标准误差
+ */
+template<class Hll>
+struct NFShmMpHllWorkload
+{
+    static const bool LOCK_FREE = true;
+
+    static bool Fill(Hll&, const NFShmMpOptions&)
+    {
+        return true;
+    }
+
+    static uint64_t Read(Hll& h, uint64_t)
+    {
+        return (uint64_t) h.estimate();
+    }
+
+    static bool Write(Hll& h, const NFShmMpWriterOp& op)
+    {
+        h.template add<uint64_t>(op.m_key);
+        return true;
+    }
+
+    static bool Verify(const Hll& h, const NFShmMpOptions& opt, uint64_t)
+    {
+        std::unordered_set<uint64_t> distinct;
+        for (int w = 0; w < opt.m_writers; w++)
+        {
+            std::mt19937_64 rng(NFShmMpProcSeed(opt, opt.m_readers + w));
+            for (uint64_t i = 0; i < opt.m_ops; i++)
+            {
+                distinct.insert(NFShmMpNextWrite(rng, opt).m_key);
+            }
+        }
+        double exact = (double) distinct.size();
+        double err = exact > 0 ? fabs(h.estimate() / exact - 1.0) : h.estimate();
+        CHECK_EXPR(err <= 5 * Hll::relative_error(), false, "mpbench hll estimate:{} exact:{}", h.estimate(), exact);
+        return true;
+    }
+};
+
+static uint64_t NFShmMpMinflt()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t) ru.ru_minflt;
+}
+
+static uint64_t NFShmMpMajflt()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t) ru.ru_majflt;
+}
+
+static size_t NFShmMpSegmentSize(size_t containerBytes)
+{
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t offset = (sizeof(NFShmMpHeader) + 63) & ~(size_t) 63;
+    return (offset + containerBytes + page - 1) / page * page;
+}
+
+static size_t NFShmMpContainerOffset()
+{
+    return (sizeof(NFShmMpHeader) + 63) & ~(size_t) 63;
+}
+
+/**
+ * @brief 子进程: 重新attach, ResumeInit, 等开始信号, 跑完把结果写进自己的槽
+ */
+template<class Container, class Workload>
+static int NFShmMpChild(const NFShmMpOptions& opt, const char* name, void* inherited, size_t size, int proc, int role)
+{
+    munmap(inherited, size);
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return 2;
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return 2;
+    }
+    NFShmMpHeader* pHeader = static_cast<NFShmMpHeader*>(base);
+    NFShmMpSlot& slot = pHeader->m_slots[proc];
+    slot.m_role = role;
+
+    //ResumeInit可能会写, 所有进程开始跑之前一个一个attach
+    pthread_rwlock_wrlock(&pHeader->m_lock);
+    uint64_t minflt = NFShmMpMinflt();
+    uint64_t start = NFShmBench::Now();
+    NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_RECOVER);
+    Container* pContainer = new(static_cast<char*>(base) + NFShmMpContainerOffset()) Container();
+    slot.m_attachNs = NFShmBench::Now() - start;
+    slot.m_attachMinflt = NFShmMpMinflt() - minflt;
+    pthread_rwlock_unlock(&pHeader->m_lock);
+
+    __atomic_add_fetch(&pHeader->m_attached, 1, __ATOMIC_SEQ_CST);
+    while (!__atomic_load_n(&pHeader->m_go, __ATOMIC_ACQUIRE))
+    {
+        sched_yield();
+    }
+
+    bool lock = opt.m_lock && !Workload::LOCK_FREE;
+    std::mt19937_64 rng(NFShmMpProcSeed(opt, proc));
+    uint64_t sum = 0;
+    uint64_t updates = 0;
+    minflt = NFShmMpMinflt();
+    uint64_t majflt = NFShmMpMajflt();
+    for (uint64_t i = 0; i < opt.m_ops; i++)
+    {
+        if (role == NFSHM_MP_READER)
+        {
+            uint64_t r = rng();
+            uint64_t k = (int) (r % 100) < opt.m_hit ? (r >> 8) % (uint64_t) opt.m_keys : opt.m_keys + (r >> 8) % (uint64_t) opt.m_keys;
+            uint64_t t0 = NFShmBench::Now();
+            if (lock)
+            {
+                pthread_rwlock_rdlock(&pHeader->m_lock);
+            }
+            sum += Workload::Read(*pContainer, k);
+            if (lock)
+            {
+                pthread_rwlock_unlock(&pHeader->m_lock);
+            }
+            slot.m_hist.Add(NFShmBench::Now() - t0);
+        }
+        else
+        {
+            NFShmMpWriterOp op = NFShmMpNextWrite(rng, opt);
+            uint64_t t0 = NFShmBench::Now();
+            if (lock)
+            {
+                pthread_rwlock_wrlock(&pHeader->m_lock);
+            }
+            updates += Workload::Write(*pContainer, op);
+            if (lock)
+            {
+                pthread_rwlock_unlock(&pHeader->m_lock);
+            }
+            slot.m_hist.Add(NFShmBench::Now() - t0);
+        }
+    }
+    slot.m_minflt = NFShmMpMinflt() - minflt;
+    slot.m_majflt = NFShmMpMajflt() - majflt;
+    slot.m_ops = opt.m_ops;
+    slot.m_updates = updates;
+    slot.m_sum = sum;
+    __atomic_store_n(&slot.m_ok, 1, __ATOMIC_RELEASE);
+    munmap(base, size);
+    return 0;
+}
+
+struct NFShmMpRow
+{
+    std::string m_container;
+    std::string m_role;
+    int m_procs;
+    uint64_t m_ops;
+    double m_opsPerSec;
+    uint64_t m_p50;
+    uint64_t m_p99;
+    uint64_t m_p999;
+    uint64_t m_max;
+    uint64_t m_minflt;
+    uint64_t m_majflt;
+    bool m_verify;
+};
+
+static NFShmMpRow NFShmMpMakeRow(const std::string& container, const char* role, int procs, const NFShmMpHistogram& hist, double seconds,
+                                 uint64_t minflt, uint64_t majflt)
+{
+    NFShmMpRow row;
+    row.m_container = container;
+    row.m_role = role;
+    row.m_procs = procs;
+    row.m_ops = hist.m_total;
+    row.m_opsPerSec = seconds > 0 ? (double) hist.m_total / seconds : 0;
+    row.m_p50 = hist.Percentile(0.5);
+    row.m_p99 = hist.Percentile(0.99);
+    row.m_p999 = hist.Percentile(0.999);
+    row.m_max = hist.m_max;
+    row.m_minflt = minflt;
+    row.m_majflt = majflt;
+    row.m_verify = true;
+    return row;
+}
+
+/**
+ * @brief 父进程: 建段, CreateInit, 填数据, fork, 汇总, verify. 返回false表示verify失败或者有子进程出错
+ */
+template<class Container, class Workload>
+static bool NFShmMpRun(const NFShmMpOptions& opt, const std::string& container, std::vector<NFShmMpRow>& rows)
+{
+    int procs = opt.m_readers + opt.m_writers;
+    char name[64];
+    snprintf(name, sizeof(name), "/nfshm_mpbench.%d", (int) getpid());
+    size_t size = NFShmMpSegmentSize(sizeof(Container));
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    CHECK_EXPR(fd >= 0, false, "shm_open {} failed: {}", name, strerror(errno));
+    if (ftruncate(fd, (off_t) size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        CHECK_EXPR(false, false, "ftruncate {} to {} failed: {}", name, size, strerror(errno));
+    }
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(name);
+        CHECK_EXPR(false, false, "mmap {} bytes failed: {}", size, strerror(errno));
+    }
+
+    NFShmMpHeader* pHeader = static_cast<NFShmMpHeader*>(base);
+    memset(pHeader, 0, sizeof(NFShmMpHeader));
+    pHeader->m_magic = NFSHM_MP_MAGIC;
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&pHeader->m_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+
+    NFShmMpHistogram create;
+    memset(&create, 0, sizeof(create));
+    uint64_t minflt = NFShmMpMinflt();
+    uint64_t majflt = NFShmMpMajflt();
+    uint64_t start = NFShmBench::Now();
+    NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_INIT);
+    Container* pContainer = new(static_cast<char*>(base) + NFShmMpContainerOffset()) Container();
+    bool ok = Workload::Fill(*pContainer, opt);
+    create.Add(NFShmBench::Now() - start);
+    rows.push_back(NFShmMpMakeRow(container, "create", 1, create, 0, NFShmMpMinflt() - minflt, NFShmMpMajflt() - majflt));
+    if (!ok)
+    {
+        NFLogError(NF_LOG_SYSTEMLOG, 0, "mpbench {} fill {} keys failed", container, opt.m_keys);
+    }
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < procs && ok; p++)
+    {
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int role = p < opt.m_readers ? NFSHM_MP_READER : NFSHM_MP_WRITER;
+            _exit(NFShmMpChild<Container, Workload>(opt, name, base, size, p, role));
+        }
+        if (pid < 0)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "fork failed: {}", strerror(errno));
+            ok = false;
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    //全部attach以后一起开始
+    while (ok && __atomic_load_n(&pHeader->m_attached, __ATOMIC_ACQUIRE) < procs)
+    {
+        int status = 0;
+        if (waitpid(-1, &status, WNOHANG) > 0)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "mpbench child exited before the start");
+            ok = false;
+        }
+        sched_yield();
+    }
+    //都attach上了, 名字可以先删掉, 映射还在; 这样父进程中途被kill也不会留下段
+    shm_unlink(name);
+    start = NFShmBench::Now();
+    __atomic_store_n(&pHeader->m_go, 1, __ATOMIC_RELEASE);
+    uint64_t deadline = start + (uint64_t) opt.m_timeout * 1000000000ull;
+    size_t running = children.size();
+    while (running > 0)
+    {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0)
+        {
+            --running;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                NFLogError(NF_LOG_SYSTEMLOG, 0, "mpbench child {} failed, status:{}", (int) pid, status);
+                ok = false;
+            }
+            continue;
+        }
+        if (pid < 0)
+        {
+            break;
+        }
+        if (NFShmBench::Now() > deadline)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "mpbench {} did not finish in {}s, killing {} children", container, opt.m_timeout, running);
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                kill(children[i], SIGKILL);
+            }
+            while (waitpid(-1, NULL, 0) > 0)
+            {
+            }
+            ok = false;
+            break;
+        }
+        usleep(1000);
+    }
+    double seconds = (double) (NFShmBench::Now() - start) / 1e9;
+
+    NFShmMpHistogram read, write, all, attach;
+    memset(&read, 0, sizeof(read));
+    memset(&write, 0, sizeof(write));
+    memset(&all, 0, sizeof(all));
+    memset(&attach, 0, sizeof(attach));
+    uint64_t readFlt[2] = {0, 0};
+    uint64_t writeFlt[2] = {0, 0};
+    uint64_t attachFlt = 0;
+    uint64_t updates = 0;
+    for (int p = 0; p < procs; p++)
+    {
+        const NFShmMpSlot& slot = pHeader->m_slots[p];
+        if (!slot.m_ok)
+        {
+            ok = false;
+            continue;
+        }
+        NFShmMpHistogram& hist = slot.m_role == NFSHM_MP_READER ? read : write;
+        uint64_t* flt = slot.m_role == NFSHM_MP_READER ? readFlt : writeFlt;
+        hist.Merge(slot.m_hist);
+        all.Merge(slot.m_hist);
+        flt[0] += slot.m_minflt;
+        flt[1] += slot.m_majflt;
+        attach.Add(slot.m_attachNs);
+        attachFlt += slot.m_attachMinflt;
+        updates += slot.m_updates;
+    }
+    size_t first = rows.size();
+    rows.push_back(NFShmMpMakeRow(container, "attach", procs, attach, 0, attachFlt, 0));
+    if (opt.m_readers > 0)
+    {
+        rows.push_back(NFShmMpMakeRow(container, "read", opt.m_readers, read, seconds, readFlt[0], readFlt[1]));
+    }
+    if (opt.m_writers > 0)
+    {
+        rows.push_back(NFShmMpMakeRow(container, "write", opt.m_writers, write, seconds, writeFlt[0], writeFlt[1]));
+    }
+    rows.push_back(NFShmMpMakeRow(container, "all", procs, all, seconds, readFlt[0] + writeFlt[0], readFlt[1] + writeFlt[1]));
+
+    //父进程的映射一直在, 子进程都退出后直接检查
+    if (ok)
+    {
+        ok = Workload::Verify(*pContainer, opt, updates);
+    }
+    for (size_t i = first - 1; i < rows.size(); i++)
+    {
+        rows[i].m_verify = ok;
+    }
+
+    pthread_rwlock_destroy(&pHeader->m_lock);
+    munmap(base, size);
+    return ok;
+}
+
+typedef NFShmHashMap<int, int64_t, NFSHM_MP_CAPACITY> NFShmMpHashMap;
+typedef NFShmHashMapWithList<int, int64_t, NFSHM_MP_CAPACITY> NFShmMpHashMapWithList;
+typedef NFShmRobinHoodMap<int, int64_t, NFSHM_MP_CAPACITY> NFShmMpRobinHoodMap;
+typedef NFShmSkipList<int, int64_t, NFSHM_MP_CAPACITY> NFShmMpSkipList;
+typedef NFShmCountMinSketch<uint64_t, 2720, 5, 16> NFShmMpCountMinSketch;
+typedef NFShmHyperLogLog<14> NFShmMpHyperLogLog;
+
+static const char* s_mpContainers[] = {"hash_map", "hash_map_list", "robin_hood", "skip_list", "cms", "hll"};
+
+static bool NFShmMpRunContainer(const NFShmMpOptions& opt, const std::string& c, std::vector<NFShmMpRow>& rows)
+{
+    if (c == "hash_map")
+    {
+        return NFShmMpRun<NFShmMpHashMap, NFShmMpMapWorkload<NFShmMpHashMap> >(opt, c, rows);
+    }
+    if (c == "hash_map_list")
+    {
+        return NFShmMpRun<NFShmMpHashMapWithList, NFShmMpMapWorkload<NFShmMpHashMapWithList> >(opt, c, rows);
+    }
+    if (c == "robin_hood")
+    {
+        return NFShmMpRun<NFShmMpRobinHoodMap, NFShmMpMapWorkload<NFShmMpRobinHoodMap> >(opt, c, rows);
+    }
+    if (c == "skip_list")
+    {
+        return NFShmMpRun<NFShmMpSkipList, NFShmMpMapWorkload<NFShmMpSkipList> >(opt, c, rows);
+    }
+    if (c == "cms")
+    {
+        return NFShmMpRun<NFShmMpCountMinSketch, NFShmMpCmsWorkload<NFShmMpCountMinSketch> >(opt, c, rows);
+    }
+    if (c == "hll")
+    {
+        return NFShmMpRun<NFShmMpHyperLogLog, NFShmMpHllWorkload<NFShmMpHyperLogLog> >(opt, c, rows);
+    }
+    fprintf(stderr, "unknown container: %s\n", c.c_str());
+    return false;
+}
+
+static void NFShmMpWrite(const NFShmMpOptions& opt, const std::vector<NFShmMpRow>& rows, FILE* fp)
+{
+    if (opt.m_json)
+    {
+        fprintf(fp, "[\n");
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            const NFShmMpRow& r = rows[i];
+            fprintf(fp, "  {\"container\": \"%s\", \"role\": \"%s\", \"procs\": %d, \"ops\": %llu, \"ops_per_sec\": %.0f, "
+                        "\"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, \"minflt\": %llu, \"majflt\": %llu, "
+                        "\"verify\": %s}%s\n", r.m_container.c_str(), r.m_role.c_str(), r.m_procs, (unsigned long long) r.m_ops,
+                    r.m_opsPerSec, (unsigned long long) r.m_p50, (unsigned long long) r.m_p99, (unsigned long long) r.m_p999,
+                    (unsigned long long) r.m_max, (unsigned long long) r.m_minflt, (unsigned long long) r.m_majflt,
+                    r.m_verify ? "true" : "false", i + 1 < rows.size() ? "," : "");
+        }
+        fprintf(fp, "]\n");
+        return;
+    }
+    fprintf(fp, "container,role,procs,ops,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns,minflt,majflt,verify\n");
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        const NFShmMpRow& r = rows[i];
+        fprintf(fp, "%s,%s,%d,%llu,%.0f,%llu,%llu,%llu,%llu,%llu,%llu,%s\n", r.m_container.c_str(), r.m_role.c_str(), r.m_procs,
+                (unsigned long long) r.m_ops, r.m_opsPerSec, (unsigned long long) r.m_p50, (unsigned long long) r.m_p99,
+                (unsigned long long) r.m_p999, (unsigned long long) r.m_max, (unsigned long long) r.m_minflt,
+                (unsigned long long) r.m_majflt, r.m_verify ? "ok" : "failed");
+    }
+}
+
+static void NFShmMpUsage()
+{
+    fprintf(stderr, "usage: nfshm_mpbench [--container=all|hash_map|hash_map_list|robin_hood|skip_list|cms|hll]\n"
+                    "                     [--readers=2] [--writers=1] [--ops=200000] [--keys=100000] [--hit=90] [--churn=20]\n"
+                    "                     [--lock=rwlock|none] [--timeout=300] [--seed=N] [--format=csv|json] [--out=file]\n");
+}
+
+static bool NFShmMpParse(int argc, char** argv, NFShmMpOptions& opt)
+{
+    opt.m_container = "all";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--container")
+            opt.m_container = value;
+        else if (key == "--readers")
+            opt.m_readers = atoi(value.c_str());
+        else if (key == "--writers")
+            opt.m_writers = atoi(value.c_str());
+        else if (key == "--ops")
+            opt.m_ops = strtoull(value.c_str(), NULL, 10);
+        else if (key == "--keys")
+            opt.m_keys = atoi(value.c_str());
+        else if (key == "--hit")
+            opt.m_hit = atoi(value.c_str());
+        else if (key == "--churn")
+            opt.m_churn = atoi(value.c_str());
+        else if (key == "--lock")
+            opt.m_lock = value != "none";
+        else if (key == "--timeout")
+            opt.m_timeout = atoi(value.c_str());
+        else if (key == "--seed")
+            opt.m_seed = strtoull(value.c_str(), NULL, 10);
+        else if (key == "--format")
+            opt.m_json = value == "json";
+        else if (key == "--out")
+            opt.m_out = value;
+        else
+            return false;
+    }
+    //robin hood装到80%以内, 见bench的robin_hood
+    int procs = opt.m_readers + opt.m_writers;
+    return procs > 0 && procs <= NFSHM_MP_MAX_PROCS && opt.m_keys > 0 && opt.m_keys <= NFSHM_MP_CAPACITY / 10 * 8 && opt.m_hit >= 0 &&
+           opt.m_hit <= 100 && opt.m_churn >= 0 && opt.m_churn <= 100;
+}
+
+int main(int argc, char** argv)
+{
+    NFShmMpOptions opt;
+    if (!NFShmMpParse(argc, argv, opt))
+    {
+        NFShmMpUsage();
+        return 2;
+    }
+    if (!opt.m_lock)
+    {
+        fprintf(stderr, "  note: --lock=none, hash tables and the skip list are single-writer, verify is expected to fail with writers\n");
+    }
+
+    std::vector<NFShmMpRow> rows;
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(s_mpContainers) / sizeof(s_mpContainers[0]); i++)
+    {
+        if (opt.m_container == "all" || opt.m_container == s_mpContainers[i])
+        {
+            fprintf(stderr, "container %s ...\n", s_mpContainers[i]);
+            ok &= NFShmMpRunContainer(opt, s_mpContainers[i], rows);
+        }
+    }
+    if (rows.empty())
+    {
+        NFShmMpUsage();
+        return 2;
+    }
+
+    NFShmMpWrite(opt, rows, stdout);
+    if (!opt.m_out.empty())
+    {
+        FILE* fp = fopen(opt.m_out.c_str(), "w");
+        if (fp)
+        {
+            NFShmMpWrite(opt, rows, fp);
+            fclose(fp);
+        }
+    }
+    return ok ? 0 : 1;
+}
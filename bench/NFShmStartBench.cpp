@@ -0,0 +1,708 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmStartBench.cpp
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#include "NFShmBench.h"
+#include "NFComm/NFShmStl/NFShmVector.h"
+#include "NFComm/NFShmStl/NFShmList.h"
+#include "NFComm/NFShmStl/NFShmHashMap.h"
+#include "NFComm/NFShmStl/NFShmHashMapWithList.h"
+#include "NFComm/NFShmStl/NFShmDyVector.h"
+#include "NFComm/NFShmStl/NFShmDyList.h"
+#include "NFComm/NFShmStl/NFShmDyHashMap.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <climits>
+#include <random>
+
+/**
+ * @brief 启动耗时压测: 每种容器在给定的段大小下
+ * create: 父进程新建shm段, EN_OBJ_MODE_INIT构造(冷启动, CreateInit), 记耗时, 缺页, 本进程映射的共享内存RSS;
+ * fill: 填入fill%的元素;
+ * resume: fork一个新进程重新mmap这个段, EN_OBJ_MODE_RECOVER构造(热恢复, ResumeInit), 相当于进程重启;
+ * first_ops: 恢复后紧接着做lookups次随机查找, 热恢复不碰元素内存时缺页推迟到这里.
+ * --advise对Dy容器传给Init的iAdvise, 对定长容器在恢复前对整段调用NFShmAdvise, 和NFShmMgr建段后做的一样.
+ *
+ * 定长容器的容量是模板参数, 段大小只能从256M/1G/2G/4G/8G/16G里选, 按每个元素实际占的字节数换算容量;
+ * Dy容器Init的bufSize是int, 2G及以上不跑.
+ *
+ * 用法: nfshm_startbench --sizes=256M,1G --fill=10 --advise=none,populate
+ *
+ * 实测(6G内存的机器, /dev/shm 5.9G, 只跑了256M/1G/2G, 4G以上超过可用内存, 没跑), fill=10%:
+ * create: vector/dy_vector不碰元素内存, 约0.05ms; list/hash_map要串空闲链, 整段缺页, 1G约0.5-0.7s, 2G约1.4-1.7s;
+ * resume(advise=none): vector 3ms, list 25-58ms, hash_map 1G 118ms / 2G 192ms(ResumeInit走一遍已用节点, 缺页约等于已用的10%);
+ * advise=populate把整段(包括从没用过的容量)在resume里一次缺完, 2G vector 1.4s, hash_map 0.3s, 之后first_ops不再缺页.
+ */
+
+/**
+ * @brief 一条cache line大小的元素, 带构造函数, 和业务里常见的结构体一样
+ */
+struct NFShmStartElem
+{
+    NFShmStartElem()
+    {
+        if (EN_OBJ_MODE_INIT == NFShmMgr::Instance()->GetCreateMode())
+        {
+            m_id = 0;
+        }
+    }
+
+    explicit NFShmStartElem(int64_t id) : m_id(id)
+    {
+    }
+
+    int64_t m_id;
+    char m_data[56];
+};
+
+struct NFShmStartSample
+{
+    uint64_t m_ns;
+    uint64_t m_minflt;
+    uint64_t m_rssKb;
+};
+
+/**
+ * @brief 段头, 子进程把resume和first_ops的结果写在这里
+ */
+struct NFShmStartHeader
+{
+    NFShmStartSample m_resume;
+    NFShmStartSample m_first;
+    uint64_t m_sum;
+    int m_ok;
+};
+
+static const size_t NFSHM_START_HEADER = 4096;
+
+struct NFShmStartOptions
+{
+    NFShmStartOptions() : m_fill(10), m_lookups(100000), m_json(false)
+    {
+    }
+
+    std::vector<uint64_t> m_sizes;
+    std::vector<std::string> m_containers;
+    std::vector<int> m_advise;
+    int m_fill;
+    int m_lookups;
+    bool m_json;
+    std::string m_out;
+};
+
+struct NFShmStartRow
+{
+    std::string m_container;
+    uint64_t m_bytes;
+    std::string m_phase;
+    std::string m_advise;
+    NFShmStartSample m_sample;
+};
+
+static uint64_t NFShmStartMinflt()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (uint64_t) ru.ru_minflt;
+}
+
+/**
+ * @brief 本进程映射的共享内存里已经有物理页的部分(/proc/self/status的RssShmem), kB
+ */
+static uint64_t NFShmStartRssShmem()
+{
+    FILE* fp = fopen("/proc/self/status", "r");
+    if (!fp)
+    {
+        return 0;
+    }
+    char line[256];
+    uint64_t kb = 0;
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (strncmp(line, "RssShmem:", 9) == 0)
+        {
+            kb = strtoull(line + 9, NULL, 10);
+            break;
+        }
+    }
+    fclose(fp);
+    return kb;
+}
+
+struct NFShmStartProbe
+{
+    NFShmStartProbe() : m_start(NFShmBench::Now()), m_minflt(NFShmStartMinflt()), m_rssKb(NFShmStartRssShmem())
+    {
+    }
+
+    NFShmStartSample Stop() const
+    {
+        NFShmStartSample s;
+        s.m_ns = NFShmBench::Now() - m_start;
+        s.m_minflt = NFShmStartMinflt() - m_minflt;
+        s.m_rssKb = NFShmStartRssShmem() - m_rssKb;
+        return s;
+    }
+
+    uint64_t m_start;
+    uint64_t m_minflt;
+    uint64_t m_rssKb;
+};
+
+static const char* NFShmStartAdviseName(int advise)
+{
+    switch (advise)
+    {
+        case NFSHM_ADVISE_WILLNEED:
+            return "willneed";
+        case NFSHM_ADVISE_POPULATE:
+            return "populate";
+        case NFSHM_ADVISE_HUGEPAGE:
+            return "hugepage";
+        default:
+            return "none";
+    }
+}
+
+/**
+ * @brief 顺序容器: push_back填充, 恢复后随机下标读
+ */
+struct NFShmStartVectorOps
+{
+    template<class C>
+    static void Fill(C& c, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            c.push_back(NFShmStartElem(i));
+        }
+    }
+
+    template<class C>
+    static uint64_t Lookup(C& c, std::mt19937_64& rng, int count)
+    {
+        uint64_t sum = 0;
+        for (int i = 0; i < count && !c.empty(); i++)
+        {
+            sum += c[rng() % c.size()].m_id;
+        }
+        return sum;
+    }
+};
+
+/**
+ * @brief 链表没有随机访问, 恢复后从头走count个元素
+ */
+struct NFShmStartListOps
+{
+    template<class C>
+    static void Fill(C& c, int count)
+    {
+        NFShmStartVectorOps::Fill(c, count);
+    }
+
+    template<class C>
+    static uint64_t Lookup(C& c, std::mt19937_64&, int count)
+    {
+        uint64_t sum = 0;
+        int n = 0;
+        for (auto it = c.begin(); it != c.end() && n < count; ++it, ++n)
+        {
+            sum += it->m_id;
+        }
+        return sum;
+    }
+};
+
+struct NFShmStartMapOps
+{
+    template<class C>
+    static void Fill(C& c, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            c.insert(std::make_pair((int64_t) NFShmBench::Key(i), NFShmStartElem(i)));
+        }
+    }
+
+    template<class C>
+    static uint64_t Lookup(C& c, std::mt19937_64& rng, int count)
+    {
+        uint64_t sum = 0;
+        size_t n = c.size();
+        for (int i = 0; i < count && n > 0; i++)
+        {
+            auto it = c.find((int64_t) NFShmBench::Key(rng() % n));
+            sum += it != c.end() ? it->second.m_id : 0;
+        }
+        return sum;
+    }
+};
+
+/**
+ * @brief 定长容器: 对象本身就在段里, 建段和恢复都是placement new
+ */
+template<class C, class Ops>
+class NFShmStartFixed
+{
+public:
+    NFShmStartFixed() : m_pObj(NULL)
+    {
+    }
+
+    static bool Supported(uint64_t)
+    {
+        return true;
+    }
+
+    static size_t Bytes(uint64_t)
+    {
+        return sizeof(C);
+    }
+
+    void Create(char* buf, size_t, int)
+    {
+        NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_INIT);
+        m_pObj = new(buf) C();
+    }
+
+    void Resume(char* buf, size_t bytes, int advise)
+    {
+        if (advise != NFSHM_ADVISE_NONE)
+        {
+            NFShmAdvise(buf, bytes, advise);
+        }
+        NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_RECOVER);
+        m_pObj = new(buf) C();
+    }
+
+    int Capacity() const
+    {
+        return (int) m_pObj->max_size();
+    }
+
+    void Fill(int count)
+    {
+        Ops::Fill(*m_pObj, count);
+    }
+
+    uint64_t Lookup(std::mt19937_64& rng, int count)
+    {
+        return Ops::Lookup(*m_pObj, rng, count);
+    }
+
+private:
+    C* m_pObj;
+};
+
+/**
+ * @brief Dy容器: 对象在进程自己的内存里, 段是它Init的缓冲区; 析构时缓冲区必须还在
+ */
+template<class C, class Ops>
+class NFShmStartDy
+{
+public:
+    NFShmStartDy() : m_count(0)
+    {
+    }
+
+    static bool Supported(uint64_t target)
+    {
+        return target < (uint64_t) INT_MAX;
+    }
+
+    /**
+     * @brief 按每个元素实际占的字节换算出不超过target的元素个数
+     */
+    static int Count(uint64_t target)
+    {
+        const int probe = 1 << 16;
+        uint64_t per = (uint64_t) C::CountSize(probe) / probe + 1;
+        return (int) std::min<uint64_t>(target / per, INT_MAX / 2);
+    }
+
+    static size_t Bytes(uint64_t target)
+    {
+        return C::CountSize(Count(target));
+    }
+
+    void Create(char* buf, size_t bytes, int advise)
+    {
+        m_count = Count(bytes);
+        NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_INIT);
+        m_obj.Init(buf, (int) bytes, m_count, true, advise);
+    }
+
+    void Resume(char* buf, size_t bytes, int advise)
+    {
+        m_count = Count(bytes);
+        NFShmMgr::Instance()->SetCreateMode(EN_OBJ_MODE_RECOVER);
+        m_obj.Init(buf, (int) bytes, m_count, false, advise);
+    }
+
+    int Capacity() const
+    {
+        return m_count;
+    }
+
+    void Fill(int count)
+    {
+        Ops::Fill(m_obj, count);
+    }
+
+    uint64_t Lookup(std::mt19937_64& rng, int count)
+    {
+        return Ops::Lookup(m_obj, rng, count);
+    }
+
+private:
+    C m_obj;
+    int m_count;
+};
+
+/**
+ * @brief 建段, create, fill, fork子进程resume + first_ops, 结果追加到rows
+ */
+template<class Impl>
+static bool NFShmStartRun(const NFShmStartOptions& opt, const std::string& container, uint64_t target, int advise,
+                          std::vector<NFShmStartRow>& rows)
+{
+    size_t bytes = Impl::Bytes(target);
+    size_t size = NFSHM_START_HEADER + bytes;
+    char name[64];
+    snprintf(name, sizeof(name), "/nfshm_startbench.%d", (int) getpid());
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    CHECK_EXPR(fd >= 0, false, "shm_open {} failed: {}", name, strerror(errno));
+    if (ftruncate(fd, (off_t) size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        CHECK_EXPR(false, false, "ftruncate {} to {} failed: {}", name, size, strerror(errno));
+    }
+    char* base = static_cast<char*>(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        shm_unlink(name);
+        CHECK_EXPR(false, false, "mmap {} bytes failed: {}", size, strerror(errno));
+    }
+
+    NFShmStartRow row;
+    row.m_container = container;
+    row.m_bytes = bytes;
+    row.m_advise = NFShmStartAdviseName(advise);
+    NFShmStartHeader* pHeader = reinterpret_cast<NFShmStartHeader*>(base);
+    memset(pHeader, 0, sizeof(NFShmStartHeader));
+    char* buf = base + NFSHM_START_HEADER;
+    bool ok = true;
+    {
+        Impl impl;
+        NFShmStartProbe create;
+        impl.Create(buf, bytes, advise);
+        row.m_phase = "create";
+        row.m_sample = create.Stop();
+        rows.push_back(row);
+
+        NFShmStartProbe fill;
+        impl.Fill((int) ((int64_t) impl.Capacity() * opt.m_fill / 100));
+        row.m_phase = "fill";
+        row.m_sample = fill.Stop();
+        rows.push_back(row);
+
+        fflush(stdout);
+        fflush(stderr);
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            //新进程重新attach, 不带父进程已经建好的页表
+            munmap(base, size);
+            int cfd = shm_open(name, O_RDWR, 0);
+            char* cbase = cfd >= 0 ? static_cast<char*>(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, cfd, 0)) : (char*) MAP_FAILED;
+            if (cbase == MAP_FAILED)
+            {
+                _exit(2);
+            }
+            close(cfd);
+            NFShmStartHeader* pChild = reinterpret_cast<NFShmStartHeader*>(cbase);
+            Impl* pResumed = new Impl();
+            NFShmStartProbe resume;
+            pResumed->Resume(cbase + NFSHM_START_HEADER, bytes, advise);
+            pChild->m_resume = resume.Stop();
+            std::mt19937_64 rng(20261017);
+            NFShmStartProbe first;
+            pChild->m_sum = pResumed->Lookup(rng, opt.m_lookups);
+            pChild->m_first = first.Stop();
+            pChild->m_ok = 1;
+            //不析构pResumed, Dy容器析构会写回缓冲区, 这里只量恢复
+            _exit(0);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || !pHeader->m_ok)
+        {
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "startbench {} resume child failed, status:{}", container, status);
+            ok = false;
+        }
+        else
+        {
+            row.m_phase = "resume";
+            row.m_sample = pHeader->m_resume;
+            rows.push_back(row);
+            row.m_phase = "first_ops";
+            row.m_sample = pHeader->m_first;
+            rows.push_back(row);
+        }
+    }
+    munmap(base, size);
+    shm_unlink(name);
+    return ok;
+}
+
+template<int N> using NFShmStartVector = NFShmVector<NFShmStartElem, N>;
+template<int N> using NFShmStartList = NFShmList<NFShmStartElem, N>;
+template<int N> using NFShmStartHashMap = NFShmHashMap<int64_t, NFShmStartElem, N>;
+template<int N> using NFShmStartHashMapWithList = NFShmHashMapWithList<int64_t, NFShmStartElem, N>;
+
+/**
+ * @brief 容量为N时每个元素平均占的字节数, 用它把段大小换算成模板参数
+ */
+template<template<int> class C>
+constexpr uint64_t NFShmStartPerElem()
+{
+    return sizeof(C<1 << 16>) / (1 << 16) + 1;
+}
+
+template<template<int> class C, class Ops, uint64_t BYTES>
+static bool NFShmStartRunFixedSize(const NFShmStartOptions& opt, const std::string& container, uint64_t target, int advise,
+                                   std::vector<NFShmStartRow>& rows)
+{
+    if (target != BYTES)
+    {
+        return true;
+    }
+    return NFShmStartRun<NFShmStartFixed<C<(int) (BYTES / NFShmStartPerElem<C>())>, Ops> >(opt, container, target, advise, rows);
+}
+
+static const uint64_t NFSHM_START_MB = 1024ull * 1024;
+static const uint64_t NFSHM_START_GB = 1024ull * NFSHM_START_MB;
+
+/**
+ * @brief 定长容器只能跑这几个编译期的大小
+ */
+template<template<int> class C, class Ops>
+static bool NFShmStartRunFixed(const NFShmStartOptions& opt, const std::string& container, uint64_t target, int advise,
+                               std::vector<NFShmStartRow>& rows)
+{
+    if (target != 256 * NFSHM_START_MB && target != NFSHM_START_GB && target != 2 * NFSHM_START_GB && target != 4 * NFSHM_START_GB &&
+        target != 8 * NFSHM_START_GB && target != 16 * NFSHM_START_GB)
+    {
+        fprintf(stderr, "  note: %s: fixed-size containers only run at 256M/1G/2G/4G/8G/16G, skip %llu bytes\n", container.c_str(),
+                (unsigned long long) target);
+        return true;
+    }
+    bool ok = true;
+    ok &= NFShmStartRunFixedSize<C, Ops, 256 * NFSHM_START_MB>(opt, container, target, advise, rows);
+    ok &= NFShmStartRunFixedSize<C, Ops, NFSHM_START_GB>(opt, container, target, advise, rows);
+    ok &= NFShmStartRunFixedSize<C, Ops, 2 * NFSHM_START_GB>(opt, container, target, advise, rows);
+    ok &= NFShmStartRunFixedSize<C, Ops, 4 * NFSHM_START_GB>(opt, container, target, advise, rows);
+    ok &= NFShmStartRunFixedSize<C, Ops, 8 * NFSHM_START_GB>(opt, container, target, advise, rows);
+    ok &= NFShmStartRunFixedSize<C, Ops, 16 * NFSHM_START_GB>(opt, container, target, advise, rows);
+    return ok;
+}
+
+template<class C, class Ops>
+static bool NFShmStartRunDy(const NFShmStartOptions& opt, const std::string& container, uint64_t target, int advise,
+                            std::vector<NFShmStartRow>& rows)
+{
+    if (!NFShmStartDy<C, Ops>::Supported(target))
+    {
+        fprintf(stderr, "  note: %s: Dy Init takes an int bufSize, skip %llu bytes\n", container.c_str(), (unsigned long long) target);
+        return true;
+    }
+    return NFShmStartRun<NFShmStartDy<C, Ops> >(opt, container, target, advise, rows);
+}
+
+static const char* s_startContainers[] = {"vector", "list", "hash_map", "hash_map_list", "dy_vector", "dy_list", "dy_hash_map"};
+
+static bool NFShmStartRunContainer(const NFShmStartOptions& opt, const std::string& c, uint64_t target, int advise,
+                                   std::vector<NFShmStartRow>& rows)
+{
+    if (c == "vector")
+        return NFShmStartRunFixed<NFShmStartVector, NFShmStartVectorOps>(opt, c, target, advise, rows);
+    if (c == "list")
+        return NFShmStartRunFixed<NFShmStartList, NFShmStartListOps>(opt, c, target, advise, rows);
+    if (c == "hash_map")
+        return NFShmStartRunFixed<NFShmStartHashMap, NFShmStartMapOps>(opt, c, target, advise, rows);
+    if (c == "hash_map_list")
+        return NFShmStartRunFixed<NFShmStartHashMapWithList, NFShmStartMapOps>(opt, c, target, advise, rows);
+    if (c == "dy_vector")
+        return NFShmStartRunDy<NFShmDyVector<NFShmStartElem>, NFShmStartVectorOps>(opt, c, target, advise, rows);
+    if (c == "dy_list")
+        return NFShmStartRunDy<NFShmDyList<NFShmStartElem>, NFShmStartListOps>(opt, c, target, advise, rows);
+    if (c == "dy_hash_map")
+        return NFShmStartRunDy<NFShmDyHashMap<int64_t, NFShmStartElem>, NFShmStartMapOps>(opt, c, target, advise, rows);
+    fprintf(stderr, "unknown container: %s\n", c.c_str());
+    return false;
+}
+
+static void NFShmStartWrite(const NFShmStartOptions& opt, const std::vector<NFShmStartRow>& rows, FILE* fp)
+{
+    if (opt.m_json)
+    {
+        fprintf(fp, "[\n");
+        for (size_t i = 0; i < rows.size(); i++)
+        {
+            const NFShmStartRow& r = rows[i];
+            fprintf(fp, "  {\"container\": \"%s\", \"bytes\": %llu, \"phase\": \"%s\", \"advise\": \"%s\", \"ns\": %llu, \"minflt\": %llu, "
+                        "\"rss_shmem_kb\": %llu}%s\n", r.m_container.c_str(), (unsigned long long) r.m_bytes, r.m_phase.c_str(),
+                    r.m_advise.c_str(), (unsigned long long) r.m_sample.m_ns, (unsigned long long) r.m_sample.m_minflt,
+                    (unsigned long long) r.m_sample.m_rssKb, i + 1 < rows.size() ? "," : "");
+        }
+        fprintf(fp, "]\n");
+        return;
+    }
+    fprintf(fp, "container,bytes,phase,advise,ns,minflt,rss_shmem_kb\n");
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        const NFShmStartRow& r = rows[i];
+        fprintf(fp, "%s,%llu,%s,%s,%llu,%llu,%llu\n", r.m_container.c_str(), (unsigned long long) r.m_bytes, r.m_phase.c_str(),
+                r.m_advise.c_str(), (unsigned long long) r.m_sample.m_ns, (unsigned long long) r.m_sample.m_minflt,
+                (unsigned long long) r.m_sample.m_rssKb);
+    }
+}
+
+static void NFShmStartUsage()
+{
+    fprintf(stderr, "usage: nfshm_startbench [--sizes=256M,1G] [--containers=all|vector,list,hash_map,hash_map_list,dy_vector,dy_list,dy_hash_map]\n"
+                    "                        [--advise=none,willneed,populate,hugepage] [--fill=10] [--lookups=100000]\n"
+                    "                        [--format=csv|json] [--out=file]\n");
+}
+
+static void NFShmStartSplit(const std::string& str, std::vector<std::string>& out)
+{
+    size_t start = 0;
+    while (start <= str.size())
+    {
+        size_t end = str.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = str.size();
+        }
+        if (end > start)
+        {
+            out.push_back(str.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+}
+
+static bool NFShmStartParse(int argc, char** argv, NFShmStartOptions& opt)
+{
+    std::string sizes = "256M,1G";
+    std::string containers = "all";
+    std::string advise = "none";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--sizes")
+            sizes = value;
+        else if (key == "--containers")
+            containers = value;
+        else if (key == "--advise")
+            advise = value;
+        else if (key == "--fill")
+            opt.m_fill = atoi(value.c_str());
+        else if (key == "--lookups")
+            opt.m_lookups = atoi(value.c_str());
+        else if (key == "--format")
+            opt.m_json = value == "json";
+        else if (key == "--out")
+            opt.m_out = value;
+        else
+            return false;
+    }
+
+    std::vector<std::string> items;
+    NFShmStartSplit(sizes, items);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        char* end = NULL;
+        uint64_t v = strtoull(items[i].c_str(), &end, 10);
+        if (end && (*end == 'G' || *end == 'g'))
+            v *= NFSHM_START_GB;
+        else if (end && (*end == 'M' || *end == 'm'))
+            v *= NFSHM_START_MB;
+        if (v == 0)
+            return false;
+        opt.m_sizes.push_back(v);
+    }
+    if (containers == "all")
+    {
+        opt.m_containers.assign(s_startContainers, s_startContainers + sizeof(s_startContainers) / sizeof(s_startContainers[0]));
+    }
+    else
+    {
+        NFShmStartSplit(containers, opt.m_containers);
+    }
+    items.clear();
+    NFShmStartSplit(advise, items);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        int mode = items[i] == "willneed" ? NFSHM_ADVISE_WILLNEED : items[i] == "populate" ? NFSHM_ADVISE_POPULATE :
+                   items[i] == "hugepage" ? NFSHM_ADVISE_HUGEPAGE : NFSHM_ADVISE_NONE;
+        if (mode == NFSHM_ADVISE_NONE && items[i] != "none")
+            return false;
+        opt.m_advise.push_back(mode);
+    }
+    return !opt.m_sizes.empty() && !opt.m_advise.empty() && opt.m_fill >= 0 && opt.m_fill <= 100 && opt.m_lookups >= 0;
+}
+
+int main(int argc, char** argv)
+{
+    NFShmStartOptions opt;
+    if (!NFShmStartParse(argc, argv, opt))
+    {
+        NFShmStartUsage();
+        return 2;
+    }
+
+    std::vector<NFShmStartRow> rows;
+    bool ok = true;
+    for (size_t s = 0; s < opt.m_sizes.size(); s++)
+    {
+        for (size_t c = 0; c < opt.m_containers.size(); c++)
+        {
+            for (size_t a = 0; a < opt.m_advise.size(); a++)
+            {
+                fprintf(stderr, "%s %lluM advise=%s ...\n", opt.m_containers[c].c_str(), (unsigned long long) (opt.m_sizes[s] / NFSHM_START_MB),
+                        NFShmStartAdviseName(opt.m_advise[a]));
+                ok &= NFShmStartRunContainer(opt, opt.m_containers[c], opt.m_sizes[s], opt.m_advise[a], rows);
+            }
+        }
+    }
+
+    NFShmStartWrite(opt, rows, stdout);
+    if (!opt.m_out.empty())
+    {
+        FILE* fp = fopen(opt.m_out.c_str(), "w");
+        if (fp)
+        {
+            NFShmStartWrite(opt, rows, fp);
+            fclose(fp);
+        }
+    }
+    return ok ? 0 : 1;
+}
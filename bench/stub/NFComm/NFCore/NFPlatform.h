@@ -0,0 +1,47 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFPlatform.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+/**
+ * @brief 压测用的最小平台头, 只提供NFShmStl实际用到的部分, 不依赖框架的其他模块
+ */
+
+#define NF_PLATFORM_WIN 1
+#define NF_PLATFORM_LINUX 2
+
+#if defined(_WIN32) || defined(_WIN64)
+#define NF_PLATFORM NF_PLATFORM_WIN
+#else
+#define NF_PLATFORM NF_PLATFORM_LINUX
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <string>
+#include <memory>
+#include <list>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#if NF_PLATFORM == NF_PLATFORM_LINUX
+//NFShmStl.h在linux下直接用libstdc++的std::_Construct/std::_Destroy/std::_Select1st
+#include <bits/stl_construct.h>
+#include <bits/stl_function.h>
+#include <bits/stl_tree.h>
+#endif
+
+using namespace std;
+
+#ifndef INVALID_ID
+#define INVALID_ID -1
+#endif
@@ -0,0 +1,49 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFCheck.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFPluginModule/NFLogMgr.h"
+
+#define CHECK_NULL(ptr) \
+    do { \
+        if ((ptr) == NULL) \
+        { \
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "{} is NULL", #ptr); \
+            return -1; \
+        } \
+    } while (0)
+
+#define CHECK_EXPR(expr, ret, my_fmt, ...) \
+    do { \
+        if (!(expr)) \
+        { \
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "CHECK {} failed:" my_fmt, #expr, ##__VA_ARGS__); \
+            return ret; \
+        } \
+    } while (0)
+
+#define CHECK_EXPR_ASSERT(expr, ret, my_fmt, ...) \
+    do { \
+        if (!(expr)) \
+        { \
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "CHECK {} failed:" my_fmt, #expr, ##__VA_ARGS__); \
+            assert(0); \
+            return ret; \
+        } \
+    } while (0)
+
+#define CHECK_EXPR_NOT_RET(expr, my_fmt, ...) \
+    do { \
+        if (!(expr)) \
+        { \
+            NFLogError(NF_LOG_SYSTEMLOG, 0, "CHECK {} failed:" my_fmt, #expr, ##__VA_ARGS__); \
+            return; \
+        } \
+    } while (0)
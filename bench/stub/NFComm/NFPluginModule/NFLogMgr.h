@@ -0,0 +1,71 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFLogMgr.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFCore/NFPlatform.h"
+#include <stdio.h>
+#include <fmt/format.h>
+
+/**
+ * @brief 压测用的日志替身, 和框架一样用fmt格式化; 错误和警告打到stderr, Info丢掉, 避免干扰计时和机器可读的输出
+ */
+enum NF_LOG_ID
+{
+    NF_LOG_DEFAULT = 0,
+    NF_LOG_SYSTEMLOG = 1,
+};
+
+enum NF_LOG_LEVEL
+{
+    NLL_INFO_NORMAL = 2,
+    NLL_WARING_NORMAL = 3,
+    NLL_ERROR_NORMAL = 4,
+};
+
+/**
+ * @brief 记下打出过的错误条数, 检查程序用它判断某个操作有没有走到出错分支
+ */
+inline uint64_t& NFLogErrorCount()
+{
+    static uint64_t s_count = 0;
+    return s_count;
+}
+
+/**
+ * @brief 为true时错误只计数不打印, 检查程序故意大量走出错分支时用
+ */
+inline bool& NFLogQuiet()
+{
+    static bool s_quiet = false;
+    return s_quiet;
+}
+
+template<class... Args>
+inline void NFLogPrint(int level, const char* func, int line, const char* my_fmt, const Args&... args)
+{
+    if (level >= NLL_ERROR_NORMAL)
+    {
+        ++NFLogErrorCount();
+    }
+    if (level < NLL_WARING_NORMAL || NFLogQuiet())
+    {
+        return;
+    }
+    fprintf(stderr, "[%s] %s:%d | %s\n", level >= NLL_ERROR_NORMAL ? "error" : "warn", func, line, fmt::format(fmt::runtime(my_fmt), args...).c_str());
+}
+
+#define NF_FORMAT(my_fmt, ...) fmt::format(my_fmt, ##__VA_ARGS__)
+
+#define NFLogInfo(logID, guid, my_fmt, ...) NFLogPrint(NLL_INFO_NORMAL, __FUNCTION__, __LINE__, my_fmt, ##__VA_ARGS__)
+#define NFLogWarning(logID, guid, my_fmt, ...) NFLogPrint(NLL_WARING_NORMAL, __FUNCTION__, __LINE__, my_fmt, ##__VA_ARGS__)
+#define NFLogError(logID, guid, my_fmt, ...) NFLogPrint(NLL_ERROR_NORMAL, __FUNCTION__, __LINE__, my_fmt, ##__VA_ARGS__)
+
+#define NF_ASSERT(condition) assert(condition)
+#define NF_ASSERT_MSG(condition, my_fmt, ...) assert(condition)
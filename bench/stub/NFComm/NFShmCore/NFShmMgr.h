@@ -0,0 +1,49 @@
+// -------------------------------------------------------------------------
+//    @FileName         :    NFShmMgr.h
+//    @Author           :    gaoyi
+//    @Date             :    26-10-17
+//    @Email			:    445267987@qq.com
+//    @Module           :    NFShmStlBench
+//
+// -------------------------------------------------------------------------
+
+#pragma once
+
+#include "NFComm/NFCore/NFPlatform.h"
+
+enum EN_OBJ_MODE
+{
+    EN_OBJ_MODE_INIT = 1,
+    EN_OBJ_MODE_RECOVER = 2,
+};
+
+/**
+ * @brief 压测用的NFShmMgr替身, 只保留容器构造时读的创建模式.
+ * 多进程压测里, 建段的进程用EN_OBJ_MODE_INIT构造, attach的进程切到EN_OBJ_MODE_RECOVER再placement new
+ */
+class NFShmMgr
+{
+public:
+    static NFShmMgr* Instance()
+    {
+        static NFShmMgr s_instance;
+        return &s_instance;
+    }
+
+    int GetCreateMode() const
+    {
+        return m_iCreateMode;
+    }
+
+    void SetCreateMode(int iMode)
+    {
+        m_iCreateMode = iMode;
+    }
+
+private:
+    NFShmMgr() : m_iCreateMode(EN_OBJ_MODE_INIT)
+    {
+    }
+
+    int m_iCreateMode;
+};